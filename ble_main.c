@@ -61,6 +61,7 @@
 
 /* Application header */
 #include "src/ble/app.h"
+#include "src/ble/app_conn.h"
 
 /*
  *********************************************************************************************************
@@ -183,17 +184,15 @@
  */
 
 /*
- * Bluetooth stack configuration
+ * Bluetooth stack configuration, MAX_CONNECTIONS comes from app_conn.h
  */
 
-#define MAX_CONNECTIONS 1
-
 uint8_t bluetooth_stack_heap[DEFAULT_BLUETOOTH_HEAP(MAX_CONNECTIONS)];
 /* Gecko configuration parameters (see gecko_configuration.h) */
 static const gecko_configuration_t bluetooth_config =
 {
   .config_flags = GECKO_CONFIG_FLAG_RTOS,
-#if defined(FEATURE_LFXO)
+#if defined(FEATURE_LFXO) && (DISABLE_SLEEP == 0)
   .sleep.flags = SLEEP_FLAGS_DEEP_SLEEP_ENABLE,
 #else
   .sleep.flags = 0,
@@ -53,7 +53,7 @@ public:
     Event(EventQueue *q, F f)
     {
         _event = static_cast<struct event *>(
-                     equeue_alloc(&q->_equeue, sizeof(struct event) + sizeof(F)));
+                     EventQueue::function_alloc<F>(&q->_equeue, sizeof(struct event)));
 
         if (_event) {
             _event->equeue = &q->_equeue;
@@ -214,7 +214,7 @@ private:
     static int event_post(struct event *e)
     {
         typedef EventQueue::context00<F> C;
-        void *p = equeue_alloc(e->equeue, sizeof(C));
+        void *p = EventQueue::function_alloc<C>(e->equeue);
         if (!p) {
             return 0;
         }
@@ -222,7 +222,7 @@ private:
         new (p) C(*(F *)(e + 1));
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
-        equeue_event_dtor(p, &EventQueue::function_dtor<C>);
+        EventQueue::function_attach_dtor<C>(p);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
 
@@ -505,7 +505,7 @@ public:
     Event(EventQueue *q, F f)
     {
         _event = static_cast<struct event *>(
-                     equeue_alloc(&q->_equeue, sizeof(struct event) + sizeof(F)));
+                     EventQueue::function_alloc<F>(&q->_equeue, sizeof(struct event)));
 
         if (_event) {
             _event->equeue = &q->_equeue;
@@ -670,7 +670,7 @@ private:
     static int event_post(struct event *e, A0 a0)
     {
         typedef EventQueue::context10<F, A0> C;
-        void *p = equeue_alloc(e->equeue, sizeof(C));
+        void *p = EventQueue::function_alloc<C>(e->equeue);
         if (!p) {
             return 0;
         }
@@ -678,7 +678,7 @@ private:
         new (p) C(*(F *)(e + 1), a0);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
-        equeue_event_dtor(p, &EventQueue::function_dtor<C>);
+        EventQueue::function_attach_dtor<C>(p);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
 
@@ -961,7 +961,7 @@ public:
     Event(EventQueue *q, F f)
     {
         _event = static_cast<event *>(
-                     equeue_alloc(&q->_equeue, sizeof(event) + sizeof(F)));
+                     EventQueue::function_alloc<F>(&q->_equeue, sizeof(struct event)));
 
         if (_event) {
             _event->equeue = &q->_equeue;
@@ -1126,7 +1126,7 @@ private:
     static int event_post(struct event *e, A0 a0, A1 a1)
     {
         typedef EventQueue::context20<F, A0, A1> C;
-        void *p = equeue_alloc(e->equeue, sizeof(C));
+        void *p = EventQueue::function_alloc<C>(e->equeue);
         if (!p) {
             return 0;
         }
@@ -1134,7 +1134,7 @@ private:
         new (p) C(*(F *)(e + 1), a0, a1);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
-        equeue_event_dtor(p, &EventQueue::function_dtor<C>);
+        EventQueue::function_attach_dtor<C>(p);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
 
@@ -1417,7 +1417,7 @@ public:
     Event(EventQueue *q, F f)
     {
         _event = static_cast< event *>(
-                     equeue_alloc(&q->_equeue, sizeof( event) + sizeof(F)));
+                     EventQueue::function_alloc<F>(&q->_equeue, sizeof(struct event)));
 
         if (_event) {
             _event->equeue = &q->_equeue;
@@ -1582,7 +1582,7 @@ private:
     static int event_post(struct event *e, A0 a0, A1 a1, A2 a2)
     {
         typedef EventQueue::context30<F, A0, A1, A2> C;
-        void *p = equeue_alloc(e->equeue, sizeof(C));
+        void *p = EventQueue::function_alloc<C>(e->equeue);
         if (!p) {
             return 0;
         }
@@ -1590,7 +1590,7 @@ private:
         new (p) C(*(F *)(e + 1), a0, a1, a2);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
-        equeue_event_dtor(p, &EventQueue::function_dtor<C>);
+        EventQueue::function_attach_dtor<C>(p);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
 
@@ -1873,7 +1873,7 @@ public:
     Event(EventQueue *q, F f)
     {
         _event = static_cast< event *>(
-                     equeue_alloc(&q->_equeue, (sizeof( event) + sizeof(F))));
+                     EventQueue::function_alloc<F>(&q->_equeue, sizeof(struct event)));
 
         if (_event) {
             _event->equeue = &q->_equeue;
@@ -2038,7 +2038,7 @@ private:
     static int event_post(struct event *e, A0 a0, A1 a1, A2 a2, A3 a3)
     {
         typedef EventQueue::context40<F, A0, A1, A2, A3> C;
-        void *p = equeue_alloc(e->equeue, sizeof(C));
+        void *p = EventQueue::function_alloc<C>(e->equeue);
         if (!p) {
             return 0;
         }
@@ -2046,7 +2046,7 @@ private:
         new (p) C(*(F *)(e + 1), a0, a1, a2, a3);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
-        equeue_event_dtor(p, &EventQueue::function_dtor<C>);
+        EventQueue::function_attach_dtor<C>(p);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
 
@@ -2332,7 +2332,7 @@ public:
 
     	size_t size = sizeof( event);
     	_event = static_cast<event *>(
-                     equeue_alloc(&q->_equeue, sizeof(event) + sizeof(F)));
+                     EventQueue::function_alloc<F>(&q->_equeue, sizeof(struct event)));
 
         if (_event) {
             _event->equeue = &q->_equeue;
@@ -2498,7 +2498,7 @@ private:
     static int event_post(struct event *e, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
     {
         typedef EventQueue::context50<F, A0, A1, A2, A3, A4> C;
-        void *p = equeue_alloc(e->equeue, sizeof(C));
+        void *p = EventQueue::function_alloc<C>(e->equeue);
         if (!p) {
             return 0;
         }
@@ -2506,7 +2506,7 @@ private:
         new (p) C(*(F *)(e + 1), a0, a1, a2, a3, a4);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
-        equeue_event_dtor(p, &EventQueue::function_dtor<C>);
+        EventQueue::function_attach_dtor<C>(p);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
 
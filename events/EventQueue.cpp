@@ -60,6 +60,16 @@ int EventQueue::time_left(int id)
     return equeue_timeleft(&_equeue, id);
 }
 
+void EventQueue::wakeup_stats(unsigned *wakeups, unsigned *coalesced)
+{
+    return equeue_wakeup_stats(&_equeue, wakeups, coalesced);
+}
+
+int EventQueue::next_wakeup()
+{
+    return equeue_next_wakeup(&_equeue);
+}
+
 void EventQueue::background(Callback<void(int)> update)
 {
     _update = update;
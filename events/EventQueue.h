@@ -23,6 +23,7 @@
 #include "../platform/NonCopyable.h"
 #include <cstddef>
 #include <new>
+#include <type_traits>
 
 namespace events {
 /** \addtogroup events */
@@ -39,6 +40,20 @@ namespace events {
  */
 #define EVENTS_QUEUE_SIZE (32*EVENTS_EVENT_SIZE)
 
+/** MBED_CONF_EVENTS_MAX_CAPTURE_SIZE
+ *  Fixed-capacity mode for posted function objects
+ *
+ *  When non-zero, every function object posted with call, call_in,
+ *  call_every or Event::post must fit in this many bytes, checked at
+ *  compile time, and is stored in a chunk of exactly this size, behind
+ *  the event header for an Event. All events then share one chunk
+ *  size, which keeps the equeue allocator constant-time and free of
+ *  fragmentation.
+ */
+#ifndef MBED_CONF_EVENTS_MAX_CAPTURE_SIZE
+#define MBED_CONF_EVENTS_MAX_CAPTURE_SIZE 0
+#endif
+
 // Predeclared classes
 template <typename F>
 class Event;
@@ -149,6 +164,30 @@ public:
      */
     int time_left(int id);
 
+    /** Query wakeup statistics
+     *
+     *  Events posted with slack are coalesced so that all events whose
+     *  dispatch windows overlap run from a single wakeup of the dispatch
+     *  loop. These counters quantify the saving.
+     *
+     *  @param wakeups      Number of timed wakeups of the dispatch loop,
+     *                      may be NULL
+     *  @param coalesced    Number of wakeups avoided by coalescing events,
+     *                      may be NULL
+     */
+    void wakeup_stats(unsigned *wakeups, unsigned *coalesced);
+
+    /** Time until the dispatching thread wakes up
+     *
+     *  Lock free, meant for the idle hook to find how long the system may
+     *  sleep without delaying an event.
+     *
+     *  @return         Milliseconds until the blocked dispatch loop times
+     *                  out, or -1 if it waits indefinitely or is not
+     *                  blocked
+     */
+    int next_wakeup();
+
     /** Background an event queue onto a single-shot timer-interrupt
      *
      *  When updated, the event queue will call the provided update function
@@ -624,13 +663,13 @@ public:
     template <typename F>
     int call(F f)
     {
-        void *p = equeue_alloc(&_equeue, sizeof(F));
+        void *p = function_alloc<F>(&_equeue);
         if (!p) {
             return 0;
         }
 
         F *e = new (p) F(f);
-        equeue_event_dtor(e, &EventQueue::function_dtor<F>);
+        function_attach_dtor<F>(e);
         return equeue_post(&_equeue, &EventQueue::function_call<F>, e);
     }
 
@@ -696,7 +735,7 @@ public:
     template <typename T, typename R>
     int call(T *obj, R(T::*method)())
     {
-        return call(mbed::callback(obj, method));
+        return call(method_context(obj, method));
     }
 
     /** Calls an event on the queue
@@ -705,7 +744,7 @@ public:
     template <typename T, typename R>
     int call(const T *obj, R(T::*method)() const)
     {
-        return call(mbed::callback(obj, method));
+        return call(method_context(obj, method));
     }
 
     /** Calls an event on the queue
@@ -714,7 +753,7 @@ public:
     template <typename T, typename R>
     int call(volatile T *obj, R(T::*method)() volatile)
     {
-        return call(mbed::callback(obj, method));
+        return call(method_context(obj, method));
     }
 
     /** Calls an event on the queue
@@ -723,7 +762,7 @@ public:
     template <typename T, typename R>
     int call(const volatile T *obj, R(T::*method)() const volatile)
     {
-        return call(mbed::callback(obj, method));
+        return call(method_context(obj, method));
     }
 
     /** Calls an event on the queue
@@ -732,7 +771,7 @@ public:
     template <typename T, typename R, typename A0>
     int call(T *obj, R(T::*method)(A0), A0 a0)
     {
-        return call(mbed::callback(obj, method), a0);
+        return call(method_context(obj, method), a0);
     }
 
     /** Calls an event on the queue
@@ -741,7 +780,7 @@ public:
     template <typename T, typename R, typename A0>
     int call(const T *obj, R(T::*method)(A0) const, A0 a0)
     {
-        return call(mbed::callback(obj, method), a0);
+        return call(method_context(obj, method), a0);
     }
 
     /** Calls an event on the queue
@@ -750,7 +789,7 @@ public:
     template <typename T, typename R, typename A0>
     int call(volatile T *obj, R(T::*method)(A0) volatile, A0 a0)
     {
-        return call(mbed::callback(obj, method), a0);
+        return call(method_context(obj, method), a0);
     }
 
     /** Calls an event on the queue
@@ -759,7 +798,7 @@ public:
     template <typename T, typename R, typename A0>
     int call(const volatile T *obj, R(T::*method)(A0) const volatile, A0 a0)
     {
-        return call(mbed::callback(obj, method), a0);
+        return call(method_context(obj, method), a0);
     }
 
     /** Calls an event on the queue
@@ -768,7 +807,7 @@ public:
     template <typename T, typename R, typename A0, typename A1>
     int call(T *obj, R(T::*method)(A0, A1), A0 a0, A1 a1)
     {
-        return call(mbed::callback(obj, method), a0, a1);
+        return call(method_context(obj, method), a0, a1);
     }
 
     /** Calls an event on the queue
@@ -777,7 +816,7 @@ public:
     template <typename T, typename R, typename A0, typename A1>
     int call(const T *obj, R(T::*method)(A0, A1) const, A0 a0, A1 a1)
     {
-        return call(mbed::callback(obj, method), a0, a1);
+        return call(method_context(obj, method), a0, a1);
     }
 
     /** Calls an event on the queue
@@ -786,7 +825,7 @@ public:
     template <typename T, typename R, typename A0, typename A1>
     int call(volatile T *obj, R(T::*method)(A0, A1) volatile, A0 a0, A1 a1)
     {
-        return call(mbed::callback(obj, method), a0, a1);
+        return call(method_context(obj, method), a0, a1);
     }
 
     /** Calls an event on the queue
@@ -795,7 +834,7 @@ public:
     template <typename T, typename R, typename A0, typename A1>
     int call(const volatile T *obj, R(T::*method)(A0, A1) const volatile, A0 a0, A1 a1)
     {
-        return call(mbed::callback(obj, method), a0, a1);
+        return call(method_context(obj, method), a0, a1);
     }
 
     /** Calls an event on the queue
@@ -804,7 +843,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2>
     int call(T *obj, R(T::*method)(A0, A1, A2), A0 a0, A1 a1, A2 a2)
     {
-        return call(mbed::callback(obj, method), a0, a1, a2);
+        return call(method_context(obj, method), a0, a1, a2);
     }
 
     /** Calls an event on the queue
@@ -813,7 +852,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2>
     int call(const T *obj, R(T::*method)(A0, A1, A2) const, A0 a0, A1 a1, A2 a2)
     {
-        return call(mbed::callback(obj, method), a0, a1, a2);
+        return call(method_context(obj, method), a0, a1, a2);
     }
 
     /** Calls an event on the queue
@@ -822,7 +861,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2>
     int call(volatile T *obj, R(T::*method)(A0, A1, A2) volatile, A0 a0, A1 a1, A2 a2)
     {
-        return call(mbed::callback(obj, method), a0, a1, a2);
+        return call(method_context(obj, method), a0, a1, a2);
     }
 
     /** Calls an event on the queue
@@ -831,7 +870,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2>
     int call(const volatile T *obj, R(T::*method)(A0, A1, A2) const volatile, A0 a0, A1 a1, A2 a2)
     {
-        return call(mbed::callback(obj, method), a0, a1, a2);
+        return call(method_context(obj, method), a0, a1, a2);
     }
 
     /** Calls an event on the queue
@@ -840,7 +879,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3>
     int call(T *obj, R(T::*method)(A0, A1, A2, A3), A0 a0, A1 a1, A2 a2, A3 a3)
     {
-        return call(mbed::callback(obj, method), a0, a1, a2, a3);
+        return call(method_context(obj, method), a0, a1, a2, a3);
     }
 
     /** Calls an event on the queue
@@ -849,7 +888,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3>
     int call(const T *obj, R(T::*method)(A0, A1, A2, A3) const, A0 a0, A1 a1, A2 a2, A3 a3)
     {
-        return call(mbed::callback(obj, method), a0, a1, a2, a3);
+        return call(method_context(obj, method), a0, a1, a2, a3);
     }
 
     /** Calls an event on the queue
@@ -858,7 +897,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3>
     int call(volatile T *obj, R(T::*method)(A0, A1, A2, A3) volatile, A0 a0, A1 a1, A2 a2, A3 a3)
     {
-        return call(mbed::callback(obj, method), a0, a1, a2, a3);
+        return call(method_context(obj, method), a0, a1, a2, a3);
     }
 
     /** Calls an event on the queue
@@ -867,7 +906,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3>
     int call(const volatile T *obj, R(T::*method)(A0, A1, A2, A3) const volatile, A0 a0, A1 a1, A2 a2, A3 a3)
     {
-        return call(mbed::callback(obj, method), a0, a1, a2, a3);
+        return call(method_context(obj, method), a0, a1, a2, a3);
     }
 
     /** Calls an event on the queue
@@ -876,7 +915,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3, typename A4>
     int call(T *obj, R(T::*method)(A0, A1, A2, A3, A4), A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
     {
-        return call(mbed::callback(obj, method), a0, a1, a2, a3, a4);
+        return call(method_context(obj, method), a0, a1, a2, a3, a4);
     }
 
     /** Calls an event on the queue
@@ -885,7 +924,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3, typename A4>
     int call(const T *obj, R(T::*method)(A0, A1, A2, A3, A4) const, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
     {
-        return call(mbed::callback(obj, method), a0, a1, a2, a3, a4);
+        return call(method_context(obj, method), a0, a1, a2, a3, a4);
     }
 
     /** Calls an event on the queue
@@ -894,7 +933,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3, typename A4>
     int call(volatile T *obj, R(T::*method)(A0, A1, A2, A3, A4) volatile, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
     {
-        return call(mbed::callback(obj, method), a0, a1, a2, a3, a4);
+        return call(method_context(obj, method), a0, a1, a2, a3, a4);
     }
 
     /** Calls an event on the queue
@@ -903,7 +942,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3, typename A4>
     int call(const volatile T *obj, R(T::*method)(A0, A1, A2, A3, A4) const volatile, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
     {
-        return call(mbed::callback(obj, method), a0, a1, a2, a3, a4);
+        return call(method_context(obj, method), a0, a1, a2, a3, a4);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -923,14 +962,14 @@ public:
     template <typename F>
     int call_in(int ms, F f)
     {
-        void *p = equeue_alloc(&_equeue, sizeof(F));
+        void *p = function_alloc<F>(&_equeue);
         if (!p) {
             return 0;
         }
 
         F *e = new (p) F(f);
         equeue_event_delay(e, ms);
-        equeue_event_dtor(e, &EventQueue::function_dtor<F>);
+        function_attach_dtor<F>(e);
         return equeue_post(&_equeue, &EventQueue::function_call<F>, e);
     }
 
@@ -994,13 +1033,106 @@ public:
         return call_in(ms, context50<F, A0, A1, A2, A3, A4>(f, a0, a1, a2, a3, a4));
     }
 
+    /** Calls an event on the queue after a specified delay with a dispatch tolerance
+     *
+     *  The event may be dispatched up to slack milliseconds late, which lets
+     *  the dispatch loop serve it from the same wakeup as other events whose
+     *  windows overlap. Events posted without slack are never delayed.
+     *
+     *  @param ms       Time to delay in milliseconds
+     *  @param slack    Maximum dispatch delay in milliseconds
+     *  @param f        Function to execute in the context of the dispatch loop
+     *  @return         A unique id that represents the posted event and can
+     *                  be passed to cancel, or an id of 0 if there is not
+     *                  enough memory to allocate the event.
+     */
+    template <typename F>
+    int call_in_coalesced(int ms, int slack, F f)
+    {
+        void *p = function_alloc<F>(&_equeue);
+        if (!p) {
+            return 0;
+        }
+
+        F *e = new (p) F(f);
+        equeue_event_delay(e, ms);
+        equeue_event_slack(e, slack);
+        function_attach_dtor<F>(e);
+        return equeue_post(&_equeue, &EventQueue::function_call<F>, e);
+    }
+
+    /** Calls an event on the queue after a specified delay with a dispatch tolerance
+     *  @see                        EventQueue::call_in_coalesced
+     *  @param ms                   Time to delay in milliseconds
+     *  @param slack                Maximum dispatch delay in milliseconds
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0                   Arguments to pass to the callback
+     */
+    template <typename F, typename A0>
+    int call_in_coalesced(int ms, int slack, F f, A0 a0)
+    {
+        return call_in_coalesced(ms, slack, context10<F, A0>(f, a0));
+    }
+
+    /** Calls an event on the queue after a specified delay with a dispatch tolerance
+     *  @see                        EventQueue::call_in_coalesced
+     *  @param ms                   Time to delay in milliseconds
+     *  @param slack                Maximum dispatch delay in milliseconds
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0,a1                Arguments to pass to the callback
+     */
+    template <typename F, typename A0, typename A1>
+    int call_in_coalesced(int ms, int slack, F f, A0 a0, A1 a1)
+    {
+        return call_in_coalesced(ms, slack, context20<F, A0, A1>(f, a0, a1));
+    }
+
+    /** Calls an event on the queue after a specified delay with a dispatch tolerance
+     *  @see                        EventQueue::call_in_coalesced
+     *  @param ms                   Time to delay in milliseconds
+     *  @param slack                Maximum dispatch delay in milliseconds
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0,a1,a2             Arguments to pass to the callback
+     */
+    template <typename F, typename A0, typename A1, typename A2>
+    int call_in_coalesced(int ms, int slack, F f, A0 a0, A1 a1, A2 a2)
+    {
+        return call_in_coalesced(ms, slack, context30<F, A0, A1, A2>(f, a0, a1, a2));
+    }
+
+    /** Calls an event on the queue after a specified delay with a dispatch tolerance
+     *  @see                        EventQueue::call_in_coalesced
+     *  @param ms                   Time to delay in milliseconds
+     *  @param slack                Maximum dispatch delay in milliseconds
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0,a1,a2,a3          Arguments to pass to the callback
+     */
+    template <typename F, typename A0, typename A1, typename A2, typename A3>
+    int call_in_coalesced(int ms, int slack, F f, A0 a0, A1 a1, A2 a2, A3 a3)
+    {
+        return call_in_coalesced(ms, slack, context40<F, A0, A1, A2, A3>(f, a0, a1, a2, a3));
+    }
+
+    /** Calls an event on the queue after a specified delay with a dispatch tolerance
+     *  @see                        EventQueue::call_in_coalesced
+     *  @param ms                   Time to delay in milliseconds
+     *  @param slack                Maximum dispatch delay in milliseconds
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0,a1,a2,a3,a4       Arguments to pass to the callback
+     */
+    template <typename F, typename A0, typename A1, typename A2, typename A3, typename A4>
+    int call_in_coalesced(int ms, int slack, F f, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
+    {
+        return call_in_coalesced(ms, slack, context50<F, A0, A1, A2, A3, A4>(f, a0, a1, a2, a3, a4));
+    }
+
     /** Calls an event on the queue after a specified delay
      *  @see EventQueue::call_in
      */
     template <typename T, typename R>
     int call_in(int ms, T *obj, R(T::*method)())
     {
-        return call_in(ms, mbed::callback(obj, method));
+        return call_in(ms, method_context(obj, method));
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1009,7 +1141,7 @@ public:
     template <typename T, typename R>
     int call_in(int ms, const T *obj, R(T::*method)() const)
     {
-        return call_in(ms, mbed::callback(obj, method));
+        return call_in(ms, method_context(obj, method));
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1018,7 +1150,7 @@ public:
     template <typename T, typename R>
     int call_in(int ms, volatile T *obj, R(T::*method)() volatile)
     {
-        return call_in(ms, mbed::callback(obj, method));
+        return call_in(ms, method_context(obj, method));
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1027,7 +1159,7 @@ public:
     template <typename T, typename R>
     int call_in(int ms, const volatile T *obj, R(T::*method)() const volatile)
     {
-        return call_in(ms, mbed::callback(obj, method));
+        return call_in(ms, method_context(obj, method));
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1036,7 +1168,7 @@ public:
     template <typename T, typename R, typename A0>
     int call_in(int ms, T *obj, R(T::*method)(A0), A0 a0)
     {
-        return call_in(ms, mbed::callback(obj, method), a0);
+        return call_in(ms, method_context(obj, method), a0);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1045,7 +1177,7 @@ public:
     template <typename T, typename R, typename A0>
     int call_in(int ms, const T *obj, R(T::*method)(A0) const, A0 a0)
     {
-        return call_in(ms, mbed::callback(obj, method), a0);
+        return call_in(ms, method_context(obj, method), a0);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1054,7 +1186,7 @@ public:
     template <typename T, typename R, typename A0>
     int call_in(int ms, volatile T *obj, R(T::*method)(A0) volatile, A0 a0)
     {
-        return call_in(ms, mbed::callback(obj, method), a0);
+        return call_in(ms, method_context(obj, method), a0);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1063,7 +1195,7 @@ public:
     template <typename T, typename R, typename A0>
     int call_in(int ms, const volatile T *obj, R(T::*method)(A0) const volatile, A0 a0)
     {
-        return call_in(ms, mbed::callback(obj, method), a0);
+        return call_in(ms, method_context(obj, method), a0);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1072,7 +1204,7 @@ public:
     template <typename T, typename R, typename A0, typename A1>
     int call_in(int ms, T *obj, R(T::*method)(A0, A1), A0 a0, A1 a1)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1);
+        return call_in(ms, method_context(obj, method), a0, a1);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1081,7 +1213,7 @@ public:
     template <typename T, typename R, typename A0, typename A1>
     int call_in(int ms, const T *obj, R(T::*method)(A0, A1) const, A0 a0, A1 a1)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1);
+        return call_in(ms, method_context(obj, method), a0, a1);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1090,7 +1222,7 @@ public:
     template <typename T, typename R, typename A0, typename A1>
     int call_in(int ms, volatile T *obj, R(T::*method)(A0, A1) volatile, A0 a0, A1 a1)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1);
+        return call_in(ms, method_context(obj, method), a0, a1);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1099,7 +1231,7 @@ public:
     template <typename T, typename R, typename A0, typename A1>
     int call_in(int ms, const volatile T *obj, R(T::*method)(A0, A1) const volatile, A0 a0, A1 a1)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1);
+        return call_in(ms, method_context(obj, method), a0, a1);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1108,7 +1240,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2>
     int call_in(int ms, T *obj, R(T::*method)(A0, A1, A2), A0 a0, A1 a1, A2 a2)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1, a2);
+        return call_in(ms, method_context(obj, method), a0, a1, a2);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1117,7 +1249,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2>
     int call_in(int ms, const T *obj, R(T::*method)(A0, A1, A2) const, A0 a0, A1 a1, A2 a2)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1, a2);
+        return call_in(ms, method_context(obj, method), a0, a1, a2);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1126,7 +1258,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2>
     int call_in(int ms, volatile T *obj, R(T::*method)(A0, A1, A2) volatile, A0 a0, A1 a1, A2 a2)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1, a2);
+        return call_in(ms, method_context(obj, method), a0, a1, a2);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1135,7 +1267,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2>
     int call_in(int ms, const volatile T *obj, R(T::*method)(A0, A1, A2) const volatile, A0 a0, A1 a1, A2 a2)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1, a2);
+        return call_in(ms, method_context(obj, method), a0, a1, a2);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1144,7 +1276,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3>
     int call_in(int ms, T *obj, R(T::*method)(A0, A1, A2, A3), A0 a0, A1 a1, A2 a2, A3 a3)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1, a2, a3);
+        return call_in(ms, method_context(obj, method), a0, a1, a2, a3);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1153,7 +1285,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3>
     int call_in(int ms, const T *obj, R(T::*method)(A0, A1, A2, A3) const, A0 a0, A1 a1, A2 a2, A3 a3)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1, a2, a3);
+        return call_in(ms, method_context(obj, method), a0, a1, a2, a3);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1162,7 +1294,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3>
     int call_in(int ms, volatile T *obj, R(T::*method)(A0, A1, A2, A3) volatile, A0 a0, A1 a1, A2 a2, A3 a3)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1, a2, a3);
+        return call_in(ms, method_context(obj, method), a0, a1, a2, a3);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1171,7 +1303,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3>
     int call_in(int ms, const volatile T *obj, R(T::*method)(A0, A1, A2, A3) const volatile, A0 a0, A1 a1, A2 a2, A3 a3)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1, a2, a3);
+        return call_in(ms, method_context(obj, method), a0, a1, a2, a3);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1180,7 +1312,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3, typename A4>
     int call_in(int ms, T *obj, R(T::*method)(A0, A1, A2, A3, A4), A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1, a2, a3, a4);
+        return call_in(ms, method_context(obj, method), a0, a1, a2, a3, a4);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1189,7 +1321,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3, typename A4>
     int call_in(int ms, const T *obj, R(T::*method)(A0, A1, A2, A3, A4) const, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1, a2, a3, a4);
+        return call_in(ms, method_context(obj, method), a0, a1, a2, a3, a4);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1198,7 +1330,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3, typename A4>
     int call_in(int ms, volatile T *obj, R(T::*method)(A0, A1, A2, A3, A4) volatile, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1, a2, a3, a4);
+        return call_in(ms, method_context(obj, method), a0, a1, a2, a3, a4);
     }
 
     /** Calls an event on the queue after a specified delay
@@ -1207,7 +1339,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3, typename A4>
     int call_in(int ms, const volatile T *obj, R(T::*method)(A0, A1, A2, A3, A4) const volatile, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
     {
-        return call_in(ms, mbed::callback(obj, method), a0, a1, a2, a3, a4);
+        return call_in(ms, method_context(obj, method), a0, a1, a2, a3, a4);
     }
 
     /** Calls an event on the queue periodically
@@ -1230,7 +1362,7 @@ public:
     template <typename F>
     int call_every(int ms, F f)
     {
-        void *p = equeue_alloc(&_equeue, sizeof(F));
+        void *p = function_alloc<F>(&_equeue);
         if (!p) {
             return 0;
         }
@@ -1238,7 +1370,7 @@ public:
         F *e = new (p) F(f);
         equeue_event_delay(e, ms);
         equeue_event_period(e, ms);
-        equeue_event_dtor(e, &EventQueue::function_dtor<F>);
+        function_attach_dtor<F>(e);
         return equeue_post(&_equeue, &EventQueue::function_call<F>, e);
     }
 
@@ -1302,13 +1434,107 @@ public:
         return call_every(ms, context50<F, A0, A1, A2, A3, A4>(f, a0, a1, a2, a3, a4));
     }
 
+    /** Calls an event on the queue periodically with a dispatch tolerance
+     *
+     *  The event may be dispatched up to slack milliseconds late, which lets
+     *  the dispatch loop serve it from the same wakeup as other events whose
+     *  windows overlap. Events posted without slack are never delayed.
+     *
+     *  @param ms       Period of the event in milliseconds
+     *  @param slack    Maximum dispatch delay in milliseconds
+     *  @param f        Function to execute in the context of the dispatch loop
+     *  @return         A unique id that represents the posted event and can
+     *                  be passed to cancel, or an id of 0 if there is not
+     *                  enough memory to allocate the event.
+     */
+    template <typename F>
+    int call_every_coalesced(int ms, int slack, F f)
+    {
+        void *p = function_alloc<F>(&_equeue);
+        if (!p) {
+            return 0;
+        }
+
+        F *e = new (p) F(f);
+        equeue_event_delay(e, ms);
+        equeue_event_period(e, ms);
+        equeue_event_slack(e, slack);
+        function_attach_dtor<F>(e);
+        return equeue_post(&_equeue, &EventQueue::function_call<F>, e);
+    }
+
+    /** Calls an event on the queue periodically with a dispatch tolerance
+     *  @see                        EventQueue::call_every_coalesced
+     *  @param ms                   Period of the event in milliseconds
+     *  @param slack                Maximum dispatch delay in milliseconds
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0                   Arguments to pass to the callback
+     */
+    template <typename F, typename A0>
+    int call_every_coalesced(int ms, int slack, F f, A0 a0)
+    {
+        return call_every_coalesced(ms, slack, context10<F, A0>(f, a0));
+    }
+
+    /** Calls an event on the queue periodically with a dispatch tolerance
+     *  @see                        EventQueue::call_every_coalesced
+     *  @param ms                   Period of the event in milliseconds
+     *  @param slack                Maximum dispatch delay in milliseconds
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0,a1                Arguments to pass to the callback
+     */
+    template <typename F, typename A0, typename A1>
+    int call_every_coalesced(int ms, int slack, F f, A0 a0, A1 a1)
+    {
+        return call_every_coalesced(ms, slack, context20<F, A0, A1>(f, a0, a1));
+    }
+
+    /** Calls an event on the queue periodically with a dispatch tolerance
+     *  @see                        EventQueue::call_every_coalesced
+     *  @param ms                   Period of the event in milliseconds
+     *  @param slack                Maximum dispatch delay in milliseconds
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0,a1,a2             Arguments to pass to the callback
+     */
+    template <typename F, typename A0, typename A1, typename A2>
+    int call_every_coalesced(int ms, int slack, F f, A0 a0, A1 a1, A2 a2)
+    {
+        return call_every_coalesced(ms, slack, context30<F, A0, A1, A2>(f, a0, a1, a2));
+    }
+
+    /** Calls an event on the queue periodically with a dispatch tolerance
+     *  @see                        EventQueue::call_every_coalesced
+     *  @param ms                   Period of the event in milliseconds
+     *  @param slack                Maximum dispatch delay in milliseconds
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0,a1,a2,a3          Arguments to pass to the callback
+     */
+    template <typename F, typename A0, typename A1, typename A2, typename A3>
+    int call_every_coalesced(int ms, int slack, F f, A0 a0, A1 a1, A2 a2, A3 a3)
+    {
+        return call_every_coalesced(ms, slack, context40<F, A0, A1, A2, A3>(f, a0, a1, a2, a3));
+    }
+
+    /** Calls an event on the queue periodically with a dispatch tolerance
+     *  @see                        EventQueue::call_every_coalesced
+     *  @param ms                   Period of the event in milliseconds
+     *  @param slack                Maximum dispatch delay in milliseconds
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0,a1,a2,a3,a4       Arguments to pass to the callback
+     */
+    template <typename F, typename A0, typename A1, typename A2, typename A3, typename A4>
+    int call_every_coalesced(int ms, int slack, F f, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
+    {
+        return call_every_coalesced(ms, slack, context50<F, A0, A1, A2, A3, A4>(f, a0, a1, a2, a3, a4));
+    }
+
     /** Calls an event on the queue periodically
      *  @see EventQueue::call_every
      */
     template <typename T, typename R>
     int call_every(int ms, T *obj, R(T::*method)())
     {
-        return call_every(ms, mbed::callback(obj, method));
+        return call_every(ms, method_context(obj, method));
     }
 
     /** Calls an event on the queue periodically
@@ -1317,7 +1543,7 @@ public:
     template <typename T, typename R>
     int call_every(int ms, const T *obj, R(T::*method)() const)
     {
-        return call_every(ms, mbed::callback(obj, method));
+        return call_every(ms, method_context(obj, method));
     }
 
     /** Calls an event on the queue periodically
@@ -1326,7 +1552,7 @@ public:
     template <typename T, typename R>
     int call_every(int ms, volatile T *obj, R(T::*method)() volatile)
     {
-        return call_every(ms, mbed::callback(obj, method));
+        return call_every(ms, method_context(obj, method));
     }
 
     /** Calls an event on the queue periodically
@@ -1335,7 +1561,7 @@ public:
     template <typename T, typename R>
     int call_every(int ms, const volatile T *obj, R(T::*method)() const volatile)
     {
-        return call_every(ms, mbed::callback(obj, method));
+        return call_every(ms, method_context(obj, method));
     }
 
     /** Calls an event on the queue periodically
@@ -1344,7 +1570,7 @@ public:
     template <typename T, typename R, typename A0>
     int call_every(int ms, T *obj, R(T::*method)(A0), A0 a0)
     {
-        return call_every(ms, mbed::callback(obj, method), a0);
+        return call_every(ms, method_context(obj, method), a0);
     }
 
     /** Calls an event on the queue periodically
@@ -1353,7 +1579,7 @@ public:
     template <typename T, typename R, typename A0>
     int call_every(int ms, const T *obj, R(T::*method)(A0) const, A0 a0)
     {
-        return call_every(ms, mbed::callback(obj, method), a0);
+        return call_every(ms, method_context(obj, method), a0);
     }
 
     /** Calls an event on the queue periodically
@@ -1362,7 +1588,7 @@ public:
     template <typename T, typename R, typename A0>
     int call_every(int ms, volatile T *obj, R(T::*method)(A0) volatile, A0 a0)
     {
-        return call_every(ms, mbed::callback(obj, method), a0);
+        return call_every(ms, method_context(obj, method), a0);
     }
 
     /** Calls an event on the queue periodically
@@ -1371,7 +1597,7 @@ public:
     template <typename T, typename R, typename A0>
     int call_every(int ms, const volatile T *obj, R(T::*method)(A0) const volatile, A0 a0)
     {
-        return call_every(ms, mbed::callback(obj, method), a0);
+        return call_every(ms, method_context(obj, method), a0);
     }
 
     /** Calls an event on the queue periodically
@@ -1380,7 +1606,7 @@ public:
     template <typename T, typename R, typename A0, typename A1>
     int call_every(int ms, T *obj, R(T::*method)(A0, A1), A0 a0, A1 a1)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1);
+        return call_every(ms, method_context(obj, method), a0, a1);
     }
 
     /** Calls an event on the queue periodically
@@ -1389,7 +1615,7 @@ public:
     template <typename T, typename R, typename A0, typename A1>
     int call_every(int ms, const T *obj, R(T::*method)(A0, A1) const, A0 a0, A1 a1)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1);
+        return call_every(ms, method_context(obj, method), a0, a1);
     }
 
     /** Calls an event on the queue periodically
@@ -1398,7 +1624,7 @@ public:
     template <typename T, typename R, typename A0, typename A1>
     int call_every(int ms, volatile T *obj, R(T::*method)(A0, A1) volatile, A0 a0, A1 a1)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1);
+        return call_every(ms, method_context(obj, method), a0, a1);
     }
 
     /** Calls an event on the queue periodically
@@ -1407,7 +1633,7 @@ public:
     template <typename T, typename R, typename A0, typename A1>
     int call_every(int ms, const volatile T *obj, R(T::*method)(A0, A1) const volatile, A0 a0, A1 a1)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1);
+        return call_every(ms, method_context(obj, method), a0, a1);
     }
 
     /** Calls an event on the queue periodically
@@ -1416,7 +1642,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2>
     int call_every(int ms, T *obj, R(T::*method)(A0, A1, A2), A0 a0, A1 a1, A2 a2)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1, a2);
+        return call_every(ms, method_context(obj, method), a0, a1, a2);
     }
 
     /** Calls an event on the queue periodically
@@ -1425,7 +1651,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2>
     int call_every(int ms, const T *obj, R(T::*method)(A0, A1, A2) const, A0 a0, A1 a1, A2 a2)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1, a2);
+        return call_every(ms, method_context(obj, method), a0, a1, a2);
     }
 
     /** Calls an event on the queue periodically
@@ -1434,7 +1660,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2>
     int call_every(int ms, volatile T *obj, R(T::*method)(A0, A1, A2) volatile, A0 a0, A1 a1, A2 a2)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1, a2);
+        return call_every(ms, method_context(obj, method), a0, a1, a2);
     }
 
     /** Calls an event on the queue periodically
@@ -1443,7 +1669,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2>
     int call_every(int ms, const volatile T *obj, R(T::*method)(A0, A1, A2) const volatile, A0 a0, A1 a1, A2 a2)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1, a2);
+        return call_every(ms, method_context(obj, method), a0, a1, a2);
     }
 
     /** Calls an event on the queue periodically
@@ -1452,7 +1678,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3>
     int call_every(int ms, T *obj, R(T::*method)(A0, A1, A2, A3), A0 a0, A1 a1, A2 a2, A3 a3)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1, a2, a3);
+        return call_every(ms, method_context(obj, method), a0, a1, a2, a3);
     }
 
     /** Calls an event on the queue periodically
@@ -1461,7 +1687,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3>
     int call_every(int ms, const T *obj, R(T::*method)(A0, A1, A2, A3) const, A0 a0, A1 a1, A2 a2, A3 a3)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1, a2, a3);
+        return call_every(ms, method_context(obj, method), a0, a1, a2, a3);
     }
 
     /** Calls an event on the queue periodically
@@ -1470,7 +1696,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3>
     int call_every(int ms, volatile T *obj, R(T::*method)(A0, A1, A2, A3) volatile, A0 a0, A1 a1, A2 a2, A3 a3)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1, a2, a3);
+        return call_every(ms, method_context(obj, method), a0, a1, a2, a3);
     }
 
     /** Calls an event on the queue periodically
@@ -1479,7 +1705,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3>
     int call_every(int ms, const volatile T *obj, R(T::*method)(A0, A1, A2, A3) const volatile, A0 a0, A1 a1, A2 a2, A3 a3)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1, a2, a3);
+        return call_every(ms, method_context(obj, method), a0, a1, a2, a3);
     }
 
     /** Calls an event on the queue periodically
@@ -1488,7 +1714,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3, typename A4>
     int call_every(int ms, T *obj, R(T::*method)(A0, A1, A2, A3, A4), A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1, a2, a3, a4);
+        return call_every(ms, method_context(obj, method), a0, a1, a2, a3, a4);
     }
 
     /** Calls an event on the queue periodically
@@ -1497,7 +1723,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3, typename A4>
     int call_every(int ms, const T *obj, R(T::*method)(A0, A1, A2, A3, A4) const, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1, a2, a3, a4);
+        return call_every(ms, method_context(obj, method), a0, a1, a2, a3, a4);
     }
 
     /** Calls an event on the queue periodically
@@ -1506,7 +1732,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3, typename A4>
     int call_every(int ms, volatile T *obj, R(T::*method)(A0, A1, A2, A3, A4) volatile, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1, a2, a3, a4);
+        return call_every(ms, method_context(obj, method), a0, a1, a2, a3, a4);
     }
 
     /** Calls an event on the queue periodically
@@ -1515,7 +1741,7 @@ public:
     template <typename T, typename R, typename A0, typename A1, typename A2, typename A3, typename A4>
     int call_every(int ms, const volatile T *obj, R(T::*method)(A0, A1, A2, A3, A4) const volatile, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
     {
-        return call_every(ms, mbed::callback(obj, method), a0, a1, a2, a3, a4);
+        return call_every(ms, method_context(obj, method), a0, a1, a2, a3, a4);
     }
 
     /** Creates an event bound to the event queue
@@ -2841,6 +3067,82 @@ protected:
         ((F *)p)->~F();
     }
 
+    // Allocate event storage for a function object, behind header bytes
+    // of its own, as an Event keeps its struct event in front of it
+    template <typename F>
+    static void *function_alloc(equeue_t *q, size_t header = 0)
+    {
+#if MBED_CONF_EVENTS_MAX_CAPTURE_SIZE
+        static_assert(sizeof(F) <= MBED_CONF_EVENTS_MAX_CAPTURE_SIZE,
+                      "Event captures exceed MBED_CONF_EVENTS_MAX_CAPTURE_SIZE");
+        return equeue_alloc(q, header + MBED_CONF_EVENTS_MAX_CAPTURE_SIZE);
+#else
+        return equeue_alloc(q, header + sizeof(F));
+#endif
+    }
+
+    // Register the destructor of a posted function object, plain function
+    // pointers and member contexts need none and skip the dtor thunk
+    template <typename F>
+    static void function_attach_dtor(void *p)
+    {
+        if (!std::is_trivially_destructible<F>::value) {
+            equeue_event_dtor(p, &EventQueue::function_dtor<F>);
+        }
+    }
+
+    // Member function bound to an object, dispatched without going
+    // through the type-erased operations of mbed::Callback
+    template <typename T, typename M>
+    struct method_context_t {
+        T *obj;
+        M method;
+
+        method_context_t(T *obj, M method)
+            : obj(obj), method(method) {}
+
+        void operator()()
+        {
+            (obj->*method)();
+        }
+
+        template <typename A0>
+        void operator()(A0 a0)
+        {
+            (obj->*method)(a0);
+        }
+
+        template <typename A0, typename A1>
+        void operator()(A0 a0, A1 a1)
+        {
+            (obj->*method)(a0, a1);
+        }
+
+        template <typename A0, typename A1, typename A2>
+        void operator()(A0 a0, A1 a1, A2 a2)
+        {
+            (obj->*method)(a0, a1, a2);
+        }
+
+        template <typename A0, typename A1, typename A2, typename A3>
+        void operator()(A0 a0, A1 a1, A2 a2, A3 a3)
+        {
+            (obj->*method)(a0, a1, a2, a3);
+        }
+
+        template <typename A0, typename A1, typename A2, typename A3, typename A4>
+        void operator()(A0 a0, A1 a1, A2 a2, A3 a3, A4 a4)
+        {
+            (obj->*method)(a0, a1, a2, a3, a4);
+        }
+    };
+
+    template <typename T, typename M>
+    static method_context_t<T, M> method_context(T *obj, M method)
+    {
+        return method_context_t<T, M>(obj, method);
+    }
+
     // Context structures
     template <typename F>
     struct context00 {
@@ -50,6 +50,22 @@ static inline void equeue_incid(equeue_t *q, struct equeue_event *e)
 }
 
 
+#if MBED_CONF_EVENTS_TRACE_ENABLED
+static void ecallback_dispatch(void *p);
+
+// identify the user callback behind an event, looking through the
+// ecallback wrapper used by the equeue_call functions
+static uint32_t equeue_trace_cb(struct equeue_event *e)
+{
+    if (e->cb == ecallback_dispatch) {
+        return (uint32_t)(uintptr_t)*(void (**)(void *))(e + 1);
+    }
+
+    return (uint32_t)(uintptr_t)e->cb;
+}
+#endif
+
+
 // equeue lifetime management
 int equeue_create(equeue_t *q, size_t size)
 {
@@ -92,6 +108,11 @@ int equeue_create_inplace(equeue_t *q, size_t size, void *buffer)
     q->background.update = 0;
     q->background.timer = 0;
 
+    q->wakeups = 0;
+    q->coalesced = 0;
+    q->sleeping = false;
+    q->sleep_target = 0;
+
     RTOS_ERR  error;
     // initialize platform resources
     OSSemCreate(&q->eventsema, "Enqueue Semaphore", 0, &error);
@@ -212,6 +233,7 @@ void *equeue_alloc(equeue_t *q, size_t size)
 
     e->target = 0;
     e->period = -1;
+    e->slack = 0;
     e->dtor = 0;
 
     return e + 1;
@@ -237,6 +259,11 @@ static int equeue_enqueue(equeue_t *q, struct equeue_event *e, unsigned tick)
     e->target = tick + equeue_clampdiff(e->target, tick);
     e->generation = q->generation;
 
+#if MBED_CONF_EVENTS_TRACE_ENABLED
+    e->trace_ts = equeue_trace_ts();
+    e->trace_delay = e->target - tick;
+#endif
+
     equeue_mutex_lock(&q->queuelock);
 
     // find the event slot
@@ -367,6 +394,37 @@ static struct equeue_event *equeue_dequeue(equeue_t *q, unsigned target)
     return head;
 }
 
+// find the latest tick the dispatch loop may sleep until without running
+// any event past its slack window, counting the extra slots that get
+// dispatched from that single wakeup
+static unsigned equeue_coalesce(equeue_t *q, int *merged)
+{
+    struct equeue_event *es = q->queue;
+    unsigned wakeup = es->target;
+    *merged = 0;
+
+    for (; es && equeue_tickdiff(es->target, wakeup) <= 0; es = es->next) {
+        // events sharing a slot are limited by the strictest sibling
+        int slack = es->slack;
+        for (struct equeue_event *e = es->sibling; e; e = e->sibling) {
+            if (e->slack < slack) {
+                slack = e->slack;
+            }
+        }
+
+        if (es == q->queue) {
+            wakeup = es->target + slack;
+        } else {
+            if (equeue_tickdiff(es->target + slack, wakeup) < 0) {
+                wakeup = es->target + slack;
+            }
+            *merged += 1;
+        }
+    }
+
+    return wakeup;
+}
+
 int equeue_post(equeue_t *q, void (*cb)(void *), void *p)
 {
     struct equeue_event *e = (struct equeue_event *)p - 1;
@@ -441,7 +499,16 @@ void equeue_dispatch(equeue_t *q, int ms)
             // actually dispatch the callbacks
             void (*cb)(void *) = e->cb;
             if (cb) {
+#if MBED_CONF_EVENTS_TRACE_ENABLED
+                uint32_t start = equeue_trace_ts();
+                uint32_t cycles = equeue_trace_cycles();
+                cb(e + 1);
+                equeue_trace_record(equeue_trace_cb(e), e->trace_ts,
+                                    e->trace_delay, start,
+                                    equeue_trace_cycles() - cycles);
+#else
                 cb(e + 1);
+#endif
             }
 
             // reenqueue periodic events or deallocate
@@ -476,12 +543,15 @@ void equeue_dispatch(equeue_t *q, int ms)
             }
         }
 
-        // find closest deadline
+        // find closest deadline, letting events with slack share a wakeup
+        int merged = 0;
         equeue_mutex_lock(&q->queuelock);
         if (q->queue) {
-            int diff = equeue_clampdiff(q->queue->target, tick);
+            int diff = equeue_clampdiff(equeue_coalesce(q, &merged), tick);
             if ((unsigned)diff < (unsigned)deadline) {
                 deadline = diff;
+            } else {
+                merged = 0;
             }
         }
         equeue_mutex_unlock(&q->queuelock);
@@ -496,7 +566,16 @@ void equeue_dispatch(equeue_t *q, int ms)
         // wait for events
         RTOS_ERR  error;
         CPU_TS ts;
+        q->sleep_target = tick + deadline;
+        q->sleeping = (ticks != 0);
         OSSemPend(&q->eventsema, ticks, OS_OPT_PEND_BLOCKING, &ts, &error);
+        q->sleeping = false;
+
+        // only a timed out wait actually dispatches the merged slots
+        if (RTOS_ERR_CODE_GET(error) == RTOS_ERR_TIMEOUT) {
+            q->wakeups += 1;
+            q->coalesced += merged;
+        }
 
         // check if we were notified to break out of dispatch
         if (q->break_requested) {
@@ -528,6 +607,12 @@ void equeue_event_period(void *p, int ms)
     e->period = ms;
 }
 
+void equeue_event_slack(void *p, int ms)
+{
+    struct equeue_event *e = (struct equeue_event *)p - 1;
+    e->slack = ms;
+}
+
 void equeue_event_dtor(void *p, void (*dtor)(void *))
 {
     struct equeue_event *e = (struct equeue_event *)p - 1;
@@ -587,6 +672,28 @@ int equeue_call_every(equeue_t *q, int ms, void (*cb)(void *), void *data)
 }
 
 
+void equeue_wakeup_stats(equeue_t *q, unsigned *wakeups, unsigned *coalesced)
+{
+    equeue_mutex_lock(&q->queuelock);
+    if (wakeups) {
+        *wakeups = q->wakeups;
+    }
+    if (coalesced) {
+        *coalesced = q->coalesced;
+    }
+    equeue_mutex_unlock(&q->queuelock);
+}
+
+int equeue_next_wakeup(equeue_t *q)
+{
+    if (!q->sleeping) {
+        return -1;
+    }
+
+    return equeue_clampdiff(q->sleep_target, equeue_tick());
+}
+
+
 // backgrounding
 void equeue_background(equeue_t *q,
                        void (*update)(void *timer, int ms), void *timer)
@@ -27,6 +27,7 @@ extern "C" {
 
 // Platform specific files
 #include "equeue_platform.h"
+#include "equeue_trace.h"
 #include  <kernel/include/os.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -48,9 +49,15 @@ struct equeue_event {
 
     unsigned target;
     int period;
+    int slack;
     void (*dtor)(void *);
 
     void (*cb)(void *);
+
+#if MBED_CONF_EVENTS_TRACE_ENABLED
+    uint32_t trace_ts;
+    uint32_t trace_delay;
+#endif
     // data follows
 };
 
@@ -77,6 +84,12 @@ typedef struct equeue {
         void *timer;
     } background;
 
+    unsigned wakeups;
+    unsigned coalesced;
+
+    volatile bool sleeping;
+    volatile unsigned sleep_target;
+
     OS_SEM eventsema;
     OS_MUTEX queuelock;
     OS_MUTEX memlock;
@@ -155,9 +168,14 @@ void equeue_dealloc(equeue_t *queue, void *event);
 //
 // equeue_event_delay  - Millisecond delay before dispatching an event
 // equeue_event_period - Millisecond period for repeating dispatching an event
+// equeue_event_slack  - Milliseconds the event may be dispatched late so
+//                       it can share a wakeup with other events, 0 (the
+//                       default) dispatches the event as close to its
+//                       deadline as possible
 // equeue_event_dtor   - Destructor to run when the event is deallocated
 void equeue_event_delay(void *event, int ms);
 void equeue_event_period(void *event, int ms);
+void equeue_event_slack(void *event, int ms);
 void equeue_event_dtor(void *event, void (*dtor)(void *));
 
 // Post an event onto the event queue
@@ -196,6 +214,25 @@ void equeue_cancel(equeue_t *queue, int id);
 //
 int equeue_timeleft(equeue_t *q, int id);
 
+// Query wakeup statistics
+//
+// The dispatch loop sleeps until the latest time that still honours the
+// slack of every event due before it, so events whose windows overlap are
+// dispatched from a single wakeup. wakeups counts the number of times the
+// dispatch loop woke on a timeout, coalesced counts the wakeups that were
+// avoided by merging events into an earlier or later one.
+//
+// Either pointer may be null.
+void equeue_wakeup_stats(equeue_t *q, unsigned *wakeups, unsigned *coalesced);
+
+// Time until the dispatch loop wakes up
+//
+// Returns the milliseconds left until the thread blocked in equeue_dispatch
+// times out, or -1 if it waits without a timeout or is not blocked at all.
+// Does not take any lock so that it can be called from the idle hook, where
+// no task can be in the middle of a dispatch.
+int equeue_next_wakeup(equeue_t *q);
+
 // Background an event queue onto a single-shot timer
 //
 // The provided update function will be called to indicate when the queue
@@ -0,0 +1,135 @@
+/*
+ * Event queue tracing
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "equeue_trace.h"
+
+#if MBED_CONF_EVENTS_TRACE_ENABLED
+#include  <cpu/include/cpu.h>
+#include  <common/include/rtos_utils.h>
+#include "rtcdriver.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "platform/mbed_critical.h"
+
+struct equeue_trace_buffer equeue_trace_buffer = {
+    EQUEUE_TRACE_MAGIC,
+    0,
+    0,
+    MBED_CONF_EVENTS_TRACE_BUFFER_SIZE,
+    0,
+};
+
+uint32_t equeue_trace_ts(void)
+{
+    return RTCDRV_GetWallClockTicks32();
+}
+
+uint32_t equeue_trace_cycles(void)
+{
+    return CPU_TS_Get32();
+}
+
+void equeue_trace_record(uint32_t cb, uint32_t post_ts, uint32_t delay_ms,
+                         uint32_t dispatch_ts, uint32_t duration)
+{
+    if (!equeue_trace_buffer.ts_freq) {
+        RTOS_ERR err;
+        equeue_trace_buffer.ts_freq = (uint32_t)RTCDRV_MsecsToTicks(1000);
+        equeue_trace_buffer.cycle_freq = CPU_TS_TmrFreqGet(&err);
+    }
+
+    struct equeue_trace_record *r = &equeue_trace_buffer.records[
+            equeue_trace_buffer.head % MBED_CONF_EVENTS_TRACE_BUFFER_SIZE];
+
+    r->cb = cb;
+    r->post_ts = post_ts;
+    r->delay_ms = delay_ms;
+    r->dispatch_ts = dispatch_ts;
+    r->duration = duration;
+
+    equeue_trace_buffer.head += 1;
+}
+
+void equeue_trace_reset(void)
+{
+    core_util_critical_section_enter();
+    equeue_trace_buffer.head = 0;
+    core_util_critical_section_exit();
+}
+
+size_t equeue_trace_read(struct equeue_trace_record *records, size_t count)
+{
+    core_util_critical_section_enter();
+    uint32_t head = equeue_trace_buffer.head;
+    uint32_t avail = head < MBED_CONF_EVENTS_TRACE_BUFFER_SIZE ?
+                     head : MBED_CONF_EVENTS_TRACE_BUFFER_SIZE;
+    if (count > avail) {
+        count = avail;
+    }
+
+    // copy the newest count records, oldest first
+    for (size_t i = 0; i < count; i++) {
+        uint32_t slot = (head - count + i) % MBED_CONF_EVENTS_TRACE_BUFFER_SIZE;
+        records[i] = equeue_trace_buffer.records[slot];
+    }
+    core_util_critical_section_exit();
+
+    return count;
+}
+
+void equeue_trace_dump(void)
+{
+    struct equeue_trace_record r[8];
+
+    // snapshot the record count so that records dispatched while dumping
+    // do not shift the window being printed
+    uint32_t head = equeue_trace_buffer.head;
+    uint32_t avail = head < MBED_CONF_EVENTS_TRACE_BUFFER_SIZE ?
+                     head : MBED_CONF_EVENTS_TRACE_BUFFER_SIZE;
+
+    printf("EQTRACE 2 %lu %lu %lu %lu\r\n",
+           (unsigned long)equeue_trace_buffer.ts_freq,
+           (unsigned long)equeue_trace_buffer.cycle_freq,
+           (unsigned long)avail,
+           (unsigned long)head);
+
+    for (uint32_t i = 0; i < avail; i += sizeof(r) / sizeof(r[0])) {
+        size_t n = avail - i;
+        if (n > sizeof(r) / sizeof(r[0])) {
+            n = sizeof(r) / sizeof(r[0]);
+        }
+
+        core_util_critical_section_enter();
+        for (size_t j = 0; j < n; j++) {
+            uint32_t slot = (head - avail + i + j) % MBED_CONF_EVENTS_TRACE_BUFFER_SIZE;
+            r[j] = equeue_trace_buffer.records[slot];
+        }
+        core_util_critical_section_exit();
+
+        for (size_t j = 0; j < n; j++) {
+            printf("EQT %08lx %lu %lu %lu %lu\r\n",
+                   (unsigned long)r[j].cb,
+                   (unsigned long)r[j].post_ts,
+                   (unsigned long)r[j].delay_ms,
+                   (unsigned long)r[j].dispatch_ts,
+                   (unsigned long)r[j].duration);
+        }
+    }
+
+    printf("EQTRACE END\r\n");
+}
+
+#endif
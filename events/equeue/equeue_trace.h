@@ -0,0 +1,109 @@
+/** \addtogroup events */
+/** @{*/
+/*
+ * Event queue tracing
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EQUEUE_TRACE_H
+#define EQUEUE_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../../mbed_config.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MBED_CONF_EVENTS_TRACE_ENABLED
+#define MBED_CONF_EVENTS_TRACE_ENABLED 0
+#endif
+
+#ifndef MBED_CONF_EVENTS_TRACE_BUFFER_SIZE
+#define MBED_CONF_EVENTS_TRACE_BUFFER_SIZE 64
+#endif
+
+// Marks the start of the trace buffer in a raw RAM dump ("EQTR")
+#define EQUEUE_TRACE_MAGIC 0x52545145u
+
+// Single dispatched event
+//
+// Timestamps are RTCDRV wall clock ticks (see RTCDRV_GetWallClockTicks32),
+// which keep counting in EM2 while the dispatch loop sleeps and wrap only
+// after more than a day at 32768 Hz. The latency an event spent waiting
+// in the queue is
+//   dispatch_ts - post_ts - delay_ms * ts_freq / 1000
+//
+// The callback runs without sleeping, so its duration is measured in the
+// finer CPU timestamp ticks (see CPU_TS_Get32) at cycle_freq.
+struct equeue_trace_record {
+    uint32_t cb;            // address of the dispatched callback
+    uint32_t post_ts;       // timestamp when the event was enqueued
+    uint32_t delay_ms;      // requested delay at enqueue time
+    uint32_t dispatch_ts;   // timestamp when the callback was entered
+    uint32_t duration;      // callback execution time in CPU ticks
+};
+
+// Ring buffer layout, kept fixed so it can be decoded from a raw dump
+struct equeue_trace_buffer {
+    uint32_t magic;
+    uint32_t ts_freq;       // of post_ts and dispatch_ts
+    uint32_t cycle_freq;    // of duration
+    uint32_t capacity;
+    uint32_t head;          // total number of records written
+    struct equeue_trace_record records[MBED_CONF_EVENTS_TRACE_BUFFER_SIZE];
+};
+
+extern struct equeue_trace_buffer equeue_trace_buffer;
+
+// Trace timestamp
+//
+// Returns the current wall clock tick used for post and dispatch times.
+uint32_t equeue_trace_ts(void);
+
+// Trace cycle count
+//
+// Returns the current CPU timestamp used for callback durations.
+uint32_t equeue_trace_cycles(void);
+
+// Record a dispatched event
+//
+// Called from the dispatch loop after each callback returns, with the
+// callback duration in CPU timestamp ticks. Only the dispatching thread
+// writes records, so no locking is performed.
+void equeue_trace_record(uint32_t cb, uint32_t post_ts, uint32_t delay_ms,
+                         uint32_t dispatch_ts, uint32_t duration);
+
+// Clear all collected records
+void equeue_trace_reset(void);
+
+// Copy the most recent records out of the ring buffer
+//
+// Copies at most count records, oldest first, and returns the number
+// of records copied.
+size_t equeue_trace_read(struct equeue_trace_record *records, size_t count);
+
+// Dump the ring buffer over stdout
+//
+// stdout is retargeted to SWO, so the dump can be captured with any SWO
+// viewer and fed to tools/equeue_trace_decode.py.
+void equeue_trace_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/** @}*/
@@ -0,0 +1,226 @@
+/*
+ * Host benchmark of EventQueue call / call_in throughput
+ *
+ * Posts batches of events of the kinds the stack uses, plain functions with
+ * and without bound arguments, member functions, mbed::Callback objects and
+ * Event<>::post, then dispatches them, and reports the cost per event of
+ * posting and of dispatching, with the chunk size each kind takes and
+ * whether it registers a destructor thunk. See the Makefile in this
+ * directory for how to build and run it.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifdef EVENTS_HOST
+
+#include <stdio.h>
+#include <time.h>
+#include "events/EventQueue.h"
+#include "events/Event.h"
+
+using namespace events;
+
+#define BENCH_BATCH         64
+#define BENCH_ROUNDS        20000
+#define BENCH_QUEUE_SIZE    (BENCH_BATCH * 128)
+
+// call_in batches wait for their delay, fewer of them are run
+#define BENCH_ROUNDS_DELAY  500
+
+static volatile unsigned sink;
+
+static void plain0()
+{
+    sink++;
+}
+
+static void plain3(int a, int b, int c)
+{
+    sink += a + b + c;
+}
+
+struct Target {
+    unsigned count;
+
+    void member0()
+    {
+        count++;
+    }
+
+    void member1(int a)
+    {
+        count += a;
+    }
+};
+
+static Target target;
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Waits for the delay of a call_in batch to run out
+static void wait_ticks(unsigned ms)
+{
+    unsigned start = equeue_tick();
+
+    while (equeue_tick() - start <= ms) {
+    }
+}
+
+struct result_t {
+    uint64_t post_ns;
+    uint64_t dispatch_ns;
+    unsigned events;
+    unsigned failed;
+};
+
+template <typename Post>
+static result_t run(EventQueue &queue, Post post, int delay)
+{
+    result_t r = { 0, 0, 0, 0 };
+
+    unsigned rounds = delay ? BENCH_ROUNDS_DELAY : BENCH_ROUNDS;
+
+    for (unsigned round = 0; round < rounds; round++) {
+        uint64_t t0 = now_ns();
+        for (unsigned i = 0; i < BENCH_BATCH; i++) {
+            if (!post(queue)) {
+                r.failed++;
+            }
+        }
+        uint64_t t1 = now_ns();
+
+        if (delay) {
+            wait_ticks(delay);
+        }
+
+        uint64_t t2 = now_ns();
+        queue.dispatch(0);
+        r.dispatch_ns += now_ns() - t2;
+        r.post_ns += t1 - t0;
+        r.events += BENCH_BATCH;
+    }
+
+    return r;
+}
+
+// Gives the benchmark the function object types call() stores
+class BenchQueue : public EventQueue {
+public:
+    BenchQueue(unsigned size)
+        : EventQueue(size) {}
+
+    typedef void (*plain0_t)();
+    typedef context30<void (*)(int, int, int), int, int, int> plain3_t;
+    typedef method_context_t<Target, void (Target::*)()> member0_t;
+    typedef context10<method_context_t<Target, void (Target::*)(int)>, int> member1_t;
+    typedef mbed::Callback<void()> callback_t;
+
+    // Chunk size taken by a stored F, the equeue event header aside
+    template <typename F>
+    static size_t chunk()
+    {
+#if MBED_CONF_EVENTS_MAX_CAPTURE_SIZE
+        return MBED_CONF_EVENTS_MAX_CAPTURE_SIZE;
+#else
+        return sizeof(F);
+#endif
+    }
+
+    template <typename F>
+    static bool dtor()
+    {
+        return !std::is_trivially_destructible<F>::value;
+    }
+};
+
+template <typename F>
+static void report(const char *name, const result_t &r)
+{
+    printf("%-28s %5u %5s %10.1f %10.1f %7u\n", name,
+           (unsigned)BenchQueue::chunk<F>(), BenchQueue::dtor<F>() ? "yes" : "no",
+           (double)r.post_ns / r.events, (double)r.dispatch_ns / r.events,
+           r.failed);
+}
+
+// Every kind gets a queue of its own, chunks freed by one kind are not
+// reused for a larger one unless max-capture-size is set
+template <typename F, typename Post>
+static void bench(const char *name, Post post, int delay)
+{
+    BenchQueue queue(BENCH_QUEUE_SIZE);
+
+    report<F>(name, run(queue, post, delay));
+}
+
+static bool post_plain0(EventQueue &q)
+{
+    return q.call(plain0) != 0;
+}
+
+static bool post_plain3(EventQueue &q)
+{
+    return q.call(plain3, 1, 2, 3) != 0;
+}
+
+static bool post_member0(EventQueue &q)
+{
+    return q.call(&target, &Target::member0) != 0;
+}
+
+static bool post_member1(EventQueue &q)
+{
+    return q.call(&target, &Target::member1, 1) != 0;
+}
+
+static bool post_callback(EventQueue &q)
+{
+    return q.call(mbed::callback(&target, &Target::member0)) != 0;
+}
+
+static bool post_in_plain0(EventQueue &q)
+{
+    return q.call_in(1, plain0) != 0;
+}
+
+static bool post_in_member0(EventQueue &q)
+{
+    return q.call_in(1, &target, &Target::member0) != 0;
+}
+
+static Event<void()> *event0;
+
+static bool post_event(EventQueue &q)
+{
+    (void)q;
+    return event0->post() != 0;
+}
+
+int main()
+{
+    printf("max-capture-size %u, %u events per batch, %u batches\n\n",
+           (unsigned)MBED_CONF_EVENTS_MAX_CAPTURE_SIZE, BENCH_BATCH, BENCH_ROUNDS);
+    printf("%-28s %5s %5s %10s %10s %7s\n", "event", "chunk", "dtor",
+           "post ns", "disp ns", "failed");
+
+    bench<BenchQueue::plain0_t>("call(f)", post_plain0, 0);
+    bench<BenchQueue::plain3_t>("call(f, a, b, c)", post_plain3, 0);
+    bench<BenchQueue::member0_t>("call(obj, method)", post_member0, 0);
+    bench<BenchQueue::member1_t>("call(obj, method, a)", post_member1, 0);
+    bench<BenchQueue::callback_t>("call(callback(obj, method))", post_callback, 0);
+    bench<BenchQueue::plain0_t>("call_in(1, f)", post_in_plain0, 1);
+    bench<BenchQueue::member0_t>("call_in(1, obj, method)", post_in_member0, 1);
+
+    BenchQueue queue(BENCH_QUEUE_SIZE);
+    Event<void()> event(&queue, plain0);
+    event0 = &event;
+    report<BenchQueue::plain0_t>("Event<void()>::post", run(queue, post_event, 0));
+
+    return sink == 0;
+}
+
+#endif /* EVENTS_HOST */
@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the Micrium OS assertion macros used by equeue
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef EVENTS_HOST_RTOS_UTILS_H
+#define EVENTS_HOST_RTOS_UTILS_H
+
+#include <assert.h>
+
+#define APP_RTOS_ASSERT_DBG(cond, ret_val)  assert(cond)
+
+#endif
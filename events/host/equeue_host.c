@@ -0,0 +1,51 @@
+/*
+ * Host platform functions of equeue, see kernel/include/os.h
+ *
+ * Built instead of equeue_mbed.cpp for the benchmark in this directory.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifdef EVENTS_HOST
+
+#include <time.h>
+#include "../equeue/equeue_platform.h"
+
+unsigned equeue_tick(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+int equeue_mutex_create(OS_MUTEX *m)
+{
+    RTOS_ERR error;
+
+    OSMutexCreate(m, "Enqueue Mutex", &error);
+    return 0;
+}
+
+void equeue_mutex_destroy(OS_MUTEX *m)
+{
+    RTOS_ERR error;
+
+    OSMutexDel(m, OS_OPT_DEL_ALWAYS, &error);
+}
+
+void equeue_mutex_lock(OS_MUTEX *m)
+{
+    RTOS_ERR error;
+    CPU_TS ts;
+
+    OSMutexPend(m, 0, OS_OPT_PEND_BLOCKING, &ts, &error);
+}
+
+void equeue_mutex_unlock(OS_MUTEX *m)
+{
+    RTOS_ERR error;
+
+    OSMutexPost(m, OS_OPT_POST_NONE, &error);
+}
+
+#endif /* EVENTS_HOST */
@@ -0,0 +1,117 @@
+/*
+ * Host stand-in for the Micrium OS kernel API used by equeue
+ *
+ * Only what equeue.c and equeue.h need to build on a Linux host, for the
+ * single-threaded benchmark in this directory: the mutexes do nothing and
+ * a pend on the event semaphore returns at once, timing out if nothing was
+ * posted, so dispatch(0) drains the queue without sleeping.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef EVENTS_HOST_OS_H
+#define EVENTS_HOST_OS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t OS_TICK;
+typedef uint32_t CPU_TS;
+typedef uint32_t OS_OPT;
+
+typedef enum {
+    RTOS_ERR_NONE,
+    RTOS_ERR_TIMEOUT,
+} RTOS_ERR_CODE;
+
+typedef struct {
+    RTOS_ERR_CODE Code;
+} RTOS_ERR;
+
+#define RTOS_ERR_CODE_GET(err)          ((err).Code)
+
+typedef struct {
+    unsigned count;
+} OS_SEM;
+
+typedef struct {
+    unsigned locked;
+} OS_MUTEX;
+
+#define OSCfg_TickRate_Hz               1000u
+
+#define OS_OPT_POST_NONE                0x0000u
+#define OS_OPT_POST_1                   0x0000u
+#define OS_OPT_POST_ALL                 0x0200u
+#define OS_OPT_PEND_BLOCKING            0x0000u
+#define OS_OPT_DEL_ALWAYS               0x0001u
+
+static inline void OSSemCreate(OS_SEM *sem, const char *name, unsigned cnt, RTOS_ERR *err)
+{
+    (void)name;
+    sem->count = cnt;
+    err->Code = RTOS_ERR_NONE;
+}
+
+static inline void OSSemDel(OS_SEM *sem, OS_OPT opt, RTOS_ERR *err)
+{
+    (void)sem;
+    (void)opt;
+    err->Code = RTOS_ERR_NONE;
+}
+
+static inline void OSSemPost(OS_SEM *sem, OS_OPT opt, RTOS_ERR *err)
+{
+    (void)opt;
+    sem->count = 1;
+    err->Code = RTOS_ERR_NONE;
+}
+
+static inline void OSSemPend(OS_SEM *sem, OS_TICK timeout, OS_OPT opt,
+                             CPU_TS *ts, RTOS_ERR *err)
+{
+    (void)timeout;
+    (void)opt;
+    *ts = 0;
+    err->Code = sem->count ? RTOS_ERR_NONE : RTOS_ERR_TIMEOUT;
+    sem->count = 0;
+}
+
+static inline void OSMutexCreate(OS_MUTEX *mutex, const char *name, RTOS_ERR *err)
+{
+    (void)name;
+    mutex->locked = 0;
+    err->Code = RTOS_ERR_NONE;
+}
+
+static inline void OSMutexDel(OS_MUTEX *mutex, OS_OPT opt, RTOS_ERR *err)
+{
+    (void)mutex;
+    (void)opt;
+    err->Code = RTOS_ERR_NONE;
+}
+
+static inline void OSMutexPend(OS_MUTEX *mutex, OS_TICK timeout, OS_OPT opt,
+                               CPU_TS *ts, RTOS_ERR *err)
+{
+    (void)timeout;
+    (void)opt;
+    *ts = 0;
+    mutex->locked++;
+    err->Code = RTOS_ERR_NONE;
+}
+
+static inline void OSMutexPost(OS_MUTEX *mutex, OS_OPT opt, RTOS_ERR *err)
+{
+    (void)opt;
+    mutex->locked--;
+    err->Code = RTOS_ERR_NONE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
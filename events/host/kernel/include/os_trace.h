@@ -0,0 +1,9 @@
+/*
+ * Host stand-in for the Micrium OS kernel trace header, see os.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef EVENTS_HOST_OS_TRACE_H
+#define EVENTS_HOST_OS_TRACE_H
+
+#endif
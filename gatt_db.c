@@ -51,11 +51,118 @@ GATT_DATA(const uint8_t bg_gattdb_data_uuidtable_128_map [])=
 0xbe, 0xa4, 0xa9, 0x39, 0xc5, 0xf5, 0xe0, 0x9b, 0xa1, 0x4d, 0xe3, 0xde, 0xd6, 0x3d, 0xb7, 0x47, 
 0x18, 0x77, 0xc6, 0x2b, 0xfe, 0x5f, 0x81, 0x91, 0x06, 0x41, 0x8a, 0xcd, 0xe1, 0x6b, 0x6b, 0xbe, 
 0x1b, 0x29, 0xcc, 0xa6, 0x03, 0xb9, 0xeb, 0x9e, 0x0c, 0x40, 0x0f, 0xb0, 0x27, 0x22, 0xf3, 0xad, 
+0x20, 0x1e, 0x7f, 0x6b, 0x4c, 0x8a, 0x3e, 0x9d, 0x1a, 0x4c, 0x4e, 0x2f, 0x01, 0x00, 0x3a, 0x5b, 
+0x20, 0x1e, 0x7f, 0x6b, 0x4c, 0x8a, 0x3e, 0x9d, 0x1a, 0x4c, 0x4e, 0x2f, 0x02, 0x00, 0x3a, 0x5b, 
+0x20, 0x1e, 0x7f, 0x6b, 0x4c, 0x8a, 0x3e, 0x9d, 0x1a, 0x4c, 0x4e, 0x2f, 0x03, 0x00, 0x3a, 0x5b, 
+0x20, 0x1e, 0x7f, 0x6b, 0x4c, 0x8a, 0x3e, 0x9d, 0x1a, 0x4c, 0x4e, 0x2f, 0x04, 0x00, 0x3a, 0x5b, 
+0x20, 0x1e, 0x7f, 0x6b, 0x4c, 0x8a, 0x3e, 0x9d, 0x1a, 0x4c, 0x4e, 0x2f, 0x05, 0x00, 0x3a, 0x5b, 
+0x60, 0x7f, 0x8d, 0x2e, 0x4b, 0x0c, 0x31, 0x9a, 0x5e, 0x4f, 0x2b, 0x6d, 0x00, 0xe1, 0xc0, 0xa7, 
+0x60, 0x7f, 0x8d, 0x2e, 0x4b, 0x0c, 0x31, 0x9a, 0x5e, 0x4f, 0x2b, 0x6d, 0x01, 0xe1, 0xc0, 0xa7, 
+0x60, 0x7f, 0x8d, 0x2e, 0x4b, 0x0c, 0x31, 0x9a, 0x5e, 0x4f, 0x2b, 0x6d, 0x02, 0xe1, 0xc0, 0xa7, 
 };
 
 
 
 
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_59 ) = {
+	.len=18,
+	.data={0x54,0x68,0x72,0x6f,0x75,0x67,0x68,0x70,0x75,0x74,0x20,0x73,0x61,0x6d,0x70,0x6c,0x65,0x73,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_58 ) = {
+	.properties=0x02,
+	.index=14,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_57 ) = {
+	.len=19,
+	.data={0x02,0x3b,0x00,0x60,0x7f,0x8d,0x2e,0x4b,0x0c,0x31,0x9a,0x5e,0x4f,0x2b,0x6d,0x02,0xe1,0xc0,0xa7,}
+};
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_56 ) = {
+	.len=21,
+	.data={0x54,0x68,0x72,0x6f,0x75,0x67,0x68,0x70,0x75,0x74,0x20,0x73,0x74,0x61,0x74,0x69,0x73,0x74,0x69,0x63,0x73,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_55 ) = {
+	.properties=0x02,
+	.index=13,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_54 ) = {
+	.len=19,
+	.data={0x02,0x38,0x00,0x60,0x7f,0x8d,0x2e,0x4b,0x0c,0x31,0x9a,0x5e,0x4f,0x2b,0x6d,0x01,0xe1,0xc0,0xa7,}
+};
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_53 ) = {
+	.len=16,
+	.data={0x60,0x7f,0x8d,0x2e,0x4b,0x0c,0x31,0x9a,0x5e,0x4f,0x2b,0x6d,0x00,0xe1,0xc0,0xa7,}
+};
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_52 ) = {
+	.len=14,
+	.data={0x55,0x70,0x6c,0x69,0x6e,0x6b,0x20,0x6c,0x61,0x74,0x65,0x6e,0x63,0x79,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_51 ) = {
+	.properties=0x02,
+	.index=12,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_50 ) = {
+	.len=19,
+	.data={0x02,0x34,0x00,0x20,0x1e,0x7f,0x6b,0x4c,0x8a,0x3e,0x9d,0x1a,0x4c,0x4e,0x2f,0x05,0x00,0x3a,0x5b,}
+};
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_49 ) = {
+	.len=16,
+	.data={0x42,0x75,0x66,0x66,0x65,0x72,0x20,0x6f,0x63,0x63,0x75,0x70,0x61,0x6e,0x63,0x79,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_48 ) = {
+	.properties=0x02,
+	.index=11,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_47 ) = {
+	.len=19,
+	.data={0x02,0x31,0x00,0x20,0x1e,0x7f,0x6b,0x4c,0x8a,0x3e,0x9d,0x1a,0x4c,0x4e,0x2f,0x04,0x00,0x3a,0x5b,}
+};
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_46 ) = {
+	.len=12,
+	.data={0x46,0x6c,0x6f,0x77,0x20,0x63,0x6f,0x6e,0x74,0x72,0x6f,0x6c,}
+};
+uint8_t bg_gattdb_data_attribute_field_44_data[1]={0x00,};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_44 ) = {
+	.properties=0x12,
+	.index=10,
+	.max_len=1,
+	.data=bg_gattdb_data_attribute_field_44_data,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_43 ) = {
+	.len=19,
+	.data={0x12,0x2d,0x00,0x20,0x1e,0x7f,0x6b,0x4c,0x8a,0x3e,0x9d,0x1a,0x4c,0x4e,0x2f,0x03,0x00,0x3a,0x5b,}
+};
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_42 ) = {
+	.len=20,
+	.data={0x53,0x65,0x6e,0x73,0x6f,0x72,0x20,0x72,0x65,0x63,0x6f,0x72,0x64,0x20,0x69,0x6e,0x67,0x65,0x73,0x74,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_41 ) = {
+	.properties=0x04,
+	.index=9,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_40 ) = {
+	.len=19,
+	.data={0x04,0x2a,0x00,0x20,0x1e,0x7f,0x6b,0x4c,0x8a,0x3e,0x9d,0x1a,0x4c,0x4e,0x2f,0x02,0x00,0x3a,0x5b,}
+};
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_39 ) = {
+	.len=16,
+	.data={0x20,0x1e,0x7f,0x6b,0x4c,0x8a,0x3e,0x9d,0x1a,0x4c,0x4e,0x2f,0x01,0x00,0x3a,0x5b,}
+};
 GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_38 ) = {
 	.len=17,
 	.data={0x54,0x68,0x72,0x6f,0x75,0x67,0x68,0x70,0x75,0x74,0x20,0x72,0x65,0x73,0x75,0x6c,0x74,}
@@ -271,6 +378,27 @@ GATT_DATA(const struct bg_gattdb_attribute bg_gattdb_data_attributes_map[])={
     {.uuid=0x8006,.permissions=0x805,.caps=0xffff,.datatype=0x01,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_36},
     {.uuid=0x000f,.permissions=0x807,.caps=0xffff,.datatype=0x03,.min_key_size=0x00,.configdata={.flags=0x02,.index=0x08,.clientconfig_index=0x03}},
     {.uuid=0x000a,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_38},
+    {.uuid=0x0000,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_39},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_40},
+    {.uuid=0x8008,.permissions=0x804,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_41},
+    {.uuid=0x000a,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_42},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_43},
+    {.uuid=0x8009,.permissions=0x801,.caps=0xffff,.datatype=0x01,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_44},
+    {.uuid=0x000f,.permissions=0x807,.caps=0xffff,.datatype=0x03,.min_key_size=0x00,.configdata={.flags=0x01,.index=0x0a,.clientconfig_index=0x04}},
+    {.uuid=0x000a,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_46},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_47},
+    {.uuid=0x800a,.permissions=0x801,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_48},
+    {.uuid=0x000a,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_49},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_50},
+    {.uuid=0x800b,.permissions=0x801,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_51},
+    {.uuid=0x000a,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_52},
+    {.uuid=0x0000,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_53},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_54},
+    {.uuid=0x800d,.permissions=0x801,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_55},
+    {.uuid=0x000a,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_56},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_57},
+    {.uuid=0x800e,.permissions=0x801,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_58},
+    {.uuid=0x000a,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_59},
 };
 
 GATT_DATA(const uint16_t bg_gattdb_data_attributes_dynamic_mapping_map[])={
@@ -283,18 +411,24 @@ GATT_DATA(const uint16_t bg_gattdb_data_attributes_dynamic_mapping_map[])={
 	0x001e,
 	0x0022,
 	0x0025,
+	0x002a,
+	0x002d,
+	0x0031,
+	0x0034,
+	0x0038,
+	0x003b,
 };
 
 GATT_DATA(const uint8_t bg_gattdb_data_adv_uuid16_map[])={0x0};
 GATT_DATA(const uint8_t bg_gattdb_data_adv_uuid128_map[])={0x0};
 GATT_HEADER(const struct bg_gattdb_def bg_gattdb_data)={
     .attributes=bg_gattdb_data_attributes_map,
-    .attributes_max=39,
+    .attributes_max=60,
     .uuidtable_16_size=16,
     .uuidtable_16=bg_gattdb_data_uuidtable_16_map,
-    .uuidtable_128_size=7,
+    .uuidtable_128_size=15,
     .uuidtable_128=bg_gattdb_data_uuidtable_128_map,
-    .attributes_dynamic_max=9,
+    .attributes_dynamic_max=15,
     .attributes_dynamic_mapping=bg_gattdb_data_attributes_dynamic_mapping_map,
     .adv_uuid16=bg_gattdb_data_adv_uuid16_map,
     .adv_uuid16_num=0,
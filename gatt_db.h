@@ -22,5 +22,11 @@ extern const struct bg_gattdb_def bg_gattdb_data;
 #define gattdb_throughput_notifications         30
 #define gattdb_transmission_on                 34
 #define gattdb_throughput_result               37
+#define gattdb_bridge_ingest                   42
+#define gattdb_bridge_flow                     45
+#define gattdb_bridge_occupancy                49
+#define gattdb_bridge_latency                  52
+#define gattdb_throughput_stats                56
+#define gattdb_throughput_samples              59
 
 #endif
@@ -48,6 +48,7 @@ extern "C" {
 #define DISPLAY_EMSTATUS_INVALID_PARAMETER (DISPLAY_EMSTATUS_BASE | 3) /**< Invalid parameter. */
 #define DISPLAY_EMSTATUS_NOT_SUPPORTED     (DISPLAY_EMSTATUS_BASE | 4) /**< Feature/option not supported. */
 #define DISPLAY_EMSTATUS_NOT_INITIALIZED   (DISPLAY_EMSTATUS_BASE | 5) /**< Feature/option not supported. */
+#define DISPLAY_EMSTATUS_BUSY              (DISPLAY_EMSTATUS_BASE | 6) /**< Previous transfer still running. */
 
 /*******************************************************************************
  ********************************   ENUMS   ************************************
@@ -77,6 +78,9 @@ typedef enum DISPLAY_AddressMode_t{
 /** Pixel matrix handle. */
 typedef void* DISPLAY_PixelMatrix_t;
 
+/** Called from interrupt context once an asynchronous draw is done. */
+typedef void (*DISPLAY_DrawDone_t)(void* argument);
+
 /*******************************************************************************
  *******************************   STRUCTS   ***********************************
  ******************************************************************************/
@@ -89,6 +93,12 @@ typedef struct DISPLAY_Geometry_t{
   unsigned int   height;  /**< Pixel height of display. */
 } DISPLAY_Geometry_t;
 
+/** Range of consecutive rows of a pixel matrix. */
+typedef struct DISPLAY_RowRange_t{
+  unsigned int   startRow;  /**< First row of the range. */
+  unsigned int   height;    /**< Number of rows. */
+} DISPLAY_RowRange_t;
+
 /* Forward declaration of struct DISPLAY_Device_t in order to reference it
    inside the typdef. */
 struct DISPLAY_Device_t;
@@ -134,6 +144,17 @@ typedef struct DISPLAY_Device_t{
                                unsigned int startRow,
                                unsigned int height);
 
+  /** Starts moving the given row ranges of a full display sized pixelMatrix
+      buffer to the display device and returns before the transfer is done.
+      The buffer must not be written until done is called. NULL if the device
+      can only draw synchronously. */
+  EMSTATUS (*pPixelMatrixDrawAsync)(struct DISPLAY_Device_t* device,
+                                    DISPLAY_PixelMatrix_t pixelMatrix,
+                                    const DISPLAY_RowRange_t* ranges,
+                                    unsigned int count,
+                                    DISPLAY_DrawDone_t done,
+                                    void* argument);
+
   /** Clears a pixelMatrix buffer by setting all pixels to black. */
   EMSTATUS (*pPixelMatrixClear)(struct DISPLAY_Device_t* device,
                                 DISPLAY_PixelMatrix_t pixelMatrix,
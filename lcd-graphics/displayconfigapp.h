@@ -30,10 +30,20 @@
  */
 #define USE_STATIC_PIXEL_MATRIX_POOL
 
-/* Specify the size of the static pixel matrix pool. For the weatherstation demo
-   we need one pixel matrix (framebuffer) covering the whole display.
+/* Flush the framebuffer to the display with the LDMA instead of writing the
+   USART from the CPU, see DMD_updateDisplayAsync(). */
+#define PAL_SPI_DMA
+
+/* Keep the two control bytes (dummy byte and next line address) of every
+   line in the pixel matrix, so that a range of dirty lines is one contiguous
+   block for the DMA. */
+#define USE_CONTROL_BYTES
+
+/* Specify the size of the static pixel matrix pool. Asynchronous updates
+   draw into a second framebuffer while the first one is sent, so we need
+   two pixel matrices covering the whole display, control bytes included.
  */
-#define PIXEL_MATRIX_POOL_SIZE   (DISPLAY0_HEIGHT * DISPLAY0_WIDTH / 8)
+#define PIXEL_MATRIX_POOL_SIZE   (2 * DISPLAY0_HEIGHT * (DISPLAY0_WIDTH / 8 + 2))
 
 /* On EFM32ZG_STK3200, the DISPLAY driver Platform Abstraction Layer (PAL)
    uses the RTC to time and toggle the EXTCOMIN pin of the Sharp memory
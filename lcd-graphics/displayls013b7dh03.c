@@ -66,6 +66,20 @@
 
 #endif /*  PIXEL_MATRIX_ALLOC_SUPPORT  */
 
+/* Asynchronous drawing needs the line addresses inside the pixel matrix, so
+   that a range of rows is one contiguous block for the DMA. */
+#if defined(PAL_SPI_DMA) && defined(USE_CONTROL_BYTES) && !defined(EMWIN_WORKAROUND)
+#define LS013B7DH03_ASYNC_DRAW
+
+/* Row ranges sent in one transfer, more are merged into a single span. */
+#ifndef LS013B7DH03_ASYNC_RANGES
+#define LS013B7DH03_ASYNC_RANGES  (4)
+#endif
+
+#define LS013B7DH03_BYTES_PER_ROW \
+  (LS013B7DH03_WIDTH / 8 + LS013B7DH03_CONTROL_BYTES)
+#endif
+
 /*******************************************************************************
  *********************************  TYPEDEFS  **********************************
  ******************************************************************************/
@@ -93,6 +107,15 @@ typedef uint32_t PixelMatrixAlign_t;
 /* Static variables: */
 static uint8_t        lcdPolarity = 0;
 
+#ifdef LS013B7DH03_ASYNC_DRAW
+/* State of the running asynchronous draw, read by the DMA. */
+static uint16_t            asyncCmd;
+static const uint8_t*      asyncBlocks[LS013B7DH03_ASYNC_RANGES + 1];
+static unsigned int        asyncLens[LS013B7DH03_ASYNC_RANGES + 1];
+static DISPLAY_DrawDone_t  asyncDone;
+static void*               asyncDoneArg;
+#endif
+
 #ifdef PIXEL_MATRIX_ALLOC_SUPPORT
 #ifdef USE_STATIC_PIXEL_MATRIX_POOL
 #define PIXEL_MATRIX_POOL_ELEMENTS                     \
@@ -134,6 +157,14 @@ static EMSTATUS PixelMatrixDraw(DISPLAY_Device_t*     device,
 #endif
                                 unsigned int          startRow,
                                 unsigned int          height);
+#ifdef LS013B7DH03_ASYNC_DRAW
+static EMSTATUS PixelMatrixDrawAsync(DISPLAY_Device_t*         device,
+                                     DISPLAY_PixelMatrix_t     pixelMatrix,
+                                     const DISPLAY_RowRange_t* ranges,
+                                     unsigned int              count,
+                                     DISPLAY_DrawDone_t        done,
+                                     void*                     argument);
+#endif
 static EMSTATUS PixelMatrixClear(DISPLAY_Device_t*      device,
                                  DISPLAY_PixelMatrix_t  pixelMatrix,
                                  unsigned int           width,
@@ -219,6 +250,11 @@ EMSTATUS DISPLAY_Ls013b7dh03Init(void)
   display.pPixelMatrixFree      = NULL;
 #endif
   display.pPixelMatrixDraw      = PixelMatrixDraw;
+#ifdef LS013B7DH03_ASYNC_DRAW
+  display.pPixelMatrixDrawAsync = PixelMatrixDrawAsync;
+#else
+  display.pPixelMatrixDrawAsync = NULL;
+#endif
   display.pPixelMatrixClear     = PixelMatrixClear;
   display.pDriverRefresh        = DriverRefresh;
 
@@ -313,6 +349,11 @@ static EMSTATUS DisplayClear(void)
 {
   uint16_t cmd;
 
+#ifdef LS013B7DH03_ASYNC_DRAW
+  /* Let a running asynchronous draw finish. */
+  while (PAL_SpiBusy()) ;
+#endif
+
   /* Set SCS */
   PAL_GpioPinOutSet(LCD_PORT_SCS, LCD_PIN_SCS);
 
@@ -352,6 +393,14 @@ static EMSTATUS DisplayPolarityInverse(void)
 #endif
 #else /* POLARITY_INVERSION_EXTCOMIN */
 
+#ifdef LS013B7DH03_ASYNC_DRAW
+  /* Called from interrupt context, the SPI is in use by an asynchronous
+     draw. Skip this inversion, the next one follows soon enough. */
+  if (PAL_SpiBusy()) {
+    return DISPLAY_EMSTATUS_OK;
+  }
+#endif
+
   /* Send a packet with inverted com */
   PAL_GpioPinOutSet(LCD_PORT_SCS, LCD_PIN_SCS);
 
@@ -648,6 +697,11 @@ static EMSTATUS PixelMatrixDraw(DISPLAY_Device_t*      device,
                    );
 #endif
 
+#ifdef LS013B7DH03_ASYNC_DRAW
+  /* Let a running asynchronous draw finish. */
+  while (PAL_SpiBusy()) ;
+#endif
+
   /* Assert SCS */
   PAL_GpioPinOutSet(LCD_PORT_SCS, LCD_PIN_SCS);
 
@@ -688,4 +742,111 @@ static EMSTATUS PixelMatrixDraw(DISPLAY_Device_t*      device,
   return DISPLAY_EMSTATUS_OK;
 }
 
+#ifdef LS013B7DH03_ASYNC_DRAW
+/**************************************************************************//**
+ * @brief   SPI completion callback of PixelMatrixDrawAsync.
+ *
+ * @param[in] argument  Not used.
+ *****************************************************************************/
+static void PixelMatrixDrawAsyncDone(void* argument)
+{
+  (void) argument; /* Suppress compiler warning: unused parameter. */
+
+  /* SCS hold time: min 2us */
+  PAL_TimerMicroSecondsDelay(2);
+
+  /* De-assert SCS */
+  PAL_GpioPinOutClear(LCD_PORT_SCS, LCD_PIN_SCS);
+
+  if (asyncDone != NULL) {
+    asyncDone(asyncDoneArg);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Start moving row ranges of a pixel matrix buffer onto the display.
+ *
+ * @detail All ranges go out in a single multiple line update: the address
+ *         of the line following the last row of a range is replaced by the
+ *         first row of the next range, and the DMA walks the ranges in the
+ *         pixel matrix without copying them.
+ *
+ * @param[in] device       Display device pointer.
+ * @param[in] pixelMatrix  Full display sized pixel matrix buffer.
+ * @param[in] ranges       Row ranges to draw, in ascending order.
+ * @param[in] count        Number of row ranges.
+ * @param[in] done         Called from interrupt context when done, or NULL.
+ * @param[in] argument     Argument given to done.
+ *
+ * @return  DISPLAY_EMSTATUS_BUSY if the previous draw is still running.
+ *****************************************************************************/
+static EMSTATUS PixelMatrixDrawAsync(DISPLAY_Device_t*         device,
+                                     DISPLAY_PixelMatrix_t     pixelMatrix,
+                                     const DISPLAY_RowRange_t* ranges,
+                                     unsigned int              count,
+                                     DISPLAY_DrawDone_t        done,
+                                     void*                     argument)
+{
+  DISPLAY_RowRange_t span;
+  uint8_t*           pStartRow;
+  unsigned int       blocks = 1;
+  unsigned int       i;
+  EMSTATUS           status;
+
+  (void) device; /* Suppress compiler warning: unused parameter. */
+
+  if (0 == count) {
+    return DISPLAY_EMSTATUS_INVALID_PARAMETER;
+  }
+  if (PAL_SpiBusy()) {
+    return DISPLAY_EMSTATUS_BUSY;
+  }
+
+  /* Rewriting the clean rows in between costs less than a longer chain. */
+  if (count > LS013B7DH03_ASYNC_RANGES) {
+    span.startRow = ranges[0].startRow;
+    span.height   = ranges[count - 1].startRow + ranges[count - 1].height
+                    - span.startRow;
+    ranges = &span;
+    count  = 1;
+  }
+
+  for (i = 0; i < count; i++) {
+    pStartRow = (uint8_t*) pixelMatrix
+                + ranges[i].startRow * LS013B7DH03_BYTES_PER_ROW;
+
+    /* LS013B7DH03 starts counting lines from 1. */
+    pixelMatrixSetup(pStartRow, ranges[i].startRow + 1, ranges[i].height);
+    if (i + 1 < count) {
+      pStartRow[ranges[i].height * LS013B7DH03_BYTES_PER_ROW - 1] =
+        ranges[i + 1].startRow + 1;
+    }
+
+    asyncBlocks[blocks] = pStartRow;
+    asyncLens[blocks++] = ranges[i].height * LS013B7DH03_BYTES_PER_ROW;
+  }
+
+  asyncCmd       = LS013B7DH03_CMD_UPDATE | ((ranges[0].startRow + 1) << 8);
+  asyncBlocks[0] = (const uint8_t*) &asyncCmd;
+  asyncLens[0]   = sizeof(asyncCmd);
+  asyncDone      = done;
+  asyncDoneArg   = argument;
+
+  /* Assert SCS */
+  PAL_GpioPinOutSet(LCD_PORT_SCS, LCD_PIN_SCS);
+
+  /* SCS setup time: min 6us */
+  PAL_TimerMicroSecondsDelay(6);
+
+  status = PAL_SpiTransmitAsync(asyncBlocks, asyncLens, blocks,
+                                PixelMatrixDrawAsyncDone, NULL);
+  if (PAL_EMSTATUS_OK != status) {
+    PAL_GpioPinOutClear(LCD_PORT_SCS, LCD_PIN_SCS);
+    return (PAL_EMSTATUS_BUSY == status) ? DISPLAY_EMSTATUS_BUSY : status;
+  }
+
+  return DISPLAY_EMSTATUS_OK;
+}
+#endif /* LS013B7DH03_ASYNC_DRAW */
+
 /** @endcond */
@@ -18,6 +18,8 @@
 #ifndef _DISPLAY_PAL_H_
 #define _DISPLAY_PAL_H_
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "emstatus.h"
 
 #ifdef __cplusplus
@@ -32,6 +34,15 @@ extern "C" {
 #define PAL_EMSTATUS_OK                                  (0) /**< Operation successful. */
 #define PAL_EMSTATUS_INVALID_PARAM (PAL_EMSTATUS_BASE   | 1) /**< Invalid parameter. */
 #define PAL_EMSTATUS_REPEAT_FAILED (PAL_EMSTATUS_BASE   | 2) /**< Repeat failed. */
+#define PAL_EMSTATUS_BUSY          (PAL_EMSTATUS_BASE   | 3) /**< Transfer in progress. */
+#define PAL_EMSTATUS_DMA_FAILED    (PAL_EMSTATUS_BASE   | 4) /**< DMA setup failed. */
+
+#ifdef PAL_SPI_DMA
+/** Maximum number of LDMA descriptors of one asynchronous SPI transfer. */
+#ifndef PAL_SPI_DMA_DESCRIPTORS
+#define PAL_SPI_DMA_DESCRIPTORS    (12)
+#endif
+#endif
 
 /** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
 
@@ -186,6 +197,41 @@ EMSTATUS PAL_SpiShutdown (void);
  *****************************************************************************/
 EMSTATUS PAL_SpiTransmit (uint8_t* data, unsigned int len);
 
+#ifdef PAL_SPI_DMA
+/** Called from interrupt context once an asynchronous SPI transfer is done. */
+typedef void (*PAL_SpiDone_t)(void* argument);
+
+/**************************************************************************//**
+ * @brief      Start transmitting a list of memory blocks on the SPI interface.
+ *
+ * @detail     The blocks are sent back to back by a chain of LDMA
+ *             descriptors and must stay untouched until the callback is
+ *             called, which happens after the last bit has left the USART.
+ *
+ * @param[in]  blocks    Pointers to the blocks to transmit.
+ * @param[in]  lens      Length of each block.
+ * @param[in]  count     Number of blocks.
+ * @param[in]  callback  Function called once the transfer is done, or NULL.
+ * @param[in]  argument  Argument given to the callback.
+ *
+ * @return     PAL_EMSTATUS_BUSY if the previous transfer is still running,
+ *             PAL_EMSTATUS_INVALID_PARAM if the blocks need more than
+ *             PAL_SPI_DMA_DESCRIPTORS descriptors.
+ *****************************************************************************/
+EMSTATUS PAL_SpiTransmitAsync (const uint8_t* const* blocks,
+                               const unsigned int*   lens,
+                               unsigned int          count,
+                               PAL_SpiDone_t         callback,
+                               void*                 argument);
+
+/**************************************************************************//**
+ * @brief   Check for a running asynchronous SPI transfer.
+ *
+ * @return  true until the callback of the last transfer has been called.
+ *****************************************************************************/
+bool PAL_SpiBusy (void);
+#endif
+
 /**************************************************************************//**
  * @brief   Initialize the PAL Timer interface
  *
@@ -231,6 +277,43 @@ EMSTATUS PAL_TimerRepeat (void(*pFunction)(void*),
                           unsigned int frequency);
 #endif
 
+#ifdef PAL_HOST
+/** What the display would have received, counted by the host simulator. */
+typedef struct {
+  uint32_t spiBytes;        /**< Bytes sent on the SPI interface. */
+  uint32_t frames;          /**< SCS assertions, i.e. commands sent. */
+  uint32_t lineUpdates;     /**< Display lines written. */
+  uint32_t clears;          /**< All clear commands. */
+  uint32_t errors;          /**< Frames that could not be decoded. */
+  uint32_t delayUs;         /**< Micro seconds the driver asked to wait. */
+} PAL_HostStats_t;
+
+/**************************************************************************//**
+ * @brief   Get the simulated state of a display pixel.
+ *
+ * @return  true if the pixel is white (reflective), false if it is black.
+ *****************************************************************************/
+bool PAL_HostPixelGet (unsigned int x, unsigned int y);
+
+/**************************************************************************//**
+ * @brief   Write the simulated display as a raw (P4) PBM file.
+ *
+ * @param[in] path   File name.
+ *
+ * @return  EMSTATUS code of the operation.
+ *****************************************************************************/
+EMSTATUS PAL_HostWritePbm (const char* path);
+
+/**************************************************************************//**
+ * @brief   Call the function given to PAL_TimerRepeat() once, as if its
+ *          period had elapsed.
+ *****************************************************************************/
+void PAL_HostTimerFire (void);
+
+void PAL_HostStatsGet (PAL_HostStats_t* stats);
+void PAL_HostStatsReset (void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,6 +16,9 @@
  *
  ******************************************************************************/
 
+/* A host build uses displaypalhost.c instead */
+#ifndef PAL_HOST
+
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -32,6 +35,12 @@
 #include "displayconfigall.h"
 #include "displaypal.h"
 
+#ifdef PAL_SPI_DMA
+#include "em_ldma.h"
+#include "dmadrv.h"
+#include "sleep.h"
+#endif
+
 #ifdef INCLUDE_PAL_GPIO_PIN_AUTO_TOGGLE
 
 #if defined(RTCC_PRESENT) && (RTCC_COUNT > 0) && !defined(PAL_CLOCK_RTC)
@@ -54,6 +63,30 @@
  ********************************  STATICS  ************************************
  ******************************************************************************/
 
+#ifdef PAL_SPI_DMA
+/* Longest transfer of a single LDMA descriptor. */
+#define PAL_SPI_DMA_MAX_XFER   (2048)
+
+#if (PAL_SPI_USART_INDEX == 0)
+#define PAL_SPI_DMA_SIGNAL     ldmaPeripheralSignal_USART0_TXBL
+#elif (PAL_SPI_USART_INDEX == 1)
+#define PAL_SPI_DMA_SIGNAL     ldmaPeripheralSignal_USART1_TXBL
+#elif (PAL_SPI_USART_INDEX == 2)
+#define PAL_SPI_DMA_SIGNAL     ldmaPeripheralSignal_USART2_TXBL
+#elif (PAL_SPI_USART_INDEX == 3)
+#define PAL_SPI_DMA_SIGNAL     ldmaPeripheralSignal_USART3_TXBL
+#else
+#error "Display config: no LDMA signal for this USART"
+#endif
+
+static LDMA_Descriptor_t spiDescriptors[PAL_SPI_DMA_DESCRIPTORS];
+static unsigned int      spiDmaChannel;
+static bool              spiDmaAllocated = false;
+static volatile bool     spiBusy = false;
+static PAL_SpiDone_t     spiCallback;
+static void*             spiCallbackArg;
+#endif
+
 #ifdef INCLUDE_PAL_GPIO_PIN_AUTO_TOGGLE
 #ifndef INCLUDE_PAL_GPIO_PIN_AUTO_TOGGLE_HW_ONLY
 /* GPIO port and pin used for the PAL_GpioPinAutoToggle function. */
@@ -120,6 +153,18 @@ EMSTATUS PAL_SpiInit(void)
   PAL_SPI_USART_UNIT->ROUTE = (USART_ROUTE_CLKPEN | USART_ROUTE_TXPEN | PAL_SPI_USART_LOCATION);
 #endif
 
+#ifdef PAL_SPI_DMA
+  /* The LDMA is shared with other drivers through DMADRV, which tolerates
+     repeated initialization. */
+  if (!spiDmaAllocated) {
+    DMADRV_Init();
+    if (DMADRV_AllocateChannel(&spiDmaChannel, NULL) != ECODE_EMDRV_DMADRV_OK) {
+      return PAL_EMSTATUS_DMA_FAILED;
+    }
+    spiDmaAllocated = true;
+  }
+#endif
+
   return status;
 }
 
@@ -176,6 +221,120 @@ EMSTATUS PAL_SpiTransmit(uint8_t* data, unsigned int len)
   return status;
 }
 
+#ifdef PAL_SPI_DMA
+/**************************************************************************//**
+ * @brief   LDMA completion callback of PAL_SpiTransmitAsync.
+ *
+ * @detail  The LDMA is done once the last byte is in the USART TX buffer,
+ *          which takes at most two more byte times to shift out. Lifts the
+ *          EM2 block of PAL_SpiTransmitAsync.
+ *****************************************************************************/
+static bool spiDmaDone(unsigned int channel,
+                       unsigned int sequenceNo,
+                       void*        userParam)
+{
+  (void) channel;
+  (void) sequenceNo;
+  (void) userParam;
+
+  while (!(PAL_SPI_USART_UNIT->STATUS & USART_STATUS_TXC)) ;
+
+  spiBusy = false;
+  SLEEP_SleepBlockEnd(sleepEM2);
+  if (spiCallback != NULL) {
+    spiCallback(spiCallbackArg);
+  }
+
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief      Start transmitting a list of memory blocks on the SPI interface.
+ *
+ * @param[in]  blocks    Pointers to the blocks to transmit.
+ * @param[in]  lens      Length of each block.
+ * @param[in]  count     Number of blocks.
+ * @param[in]  callback  Function called once the transfer is done, or NULL.
+ * @param[in]  argument  Argument given to the callback.
+ *
+ * @detail     The USART and the LDMA stop in EM2, so EM2 is blocked until
+ *             the transfer is done.
+ *
+ * @return     EMSTATUS code of the operation.
+ *****************************************************************************/
+EMSTATUS PAL_SpiTransmitAsync(const uint8_t* const* blocks,
+                              const unsigned int*   lens,
+                              unsigned int          count,
+                              PAL_SpiDone_t         callback,
+                              void*                 argument)
+{
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(PAL_SPI_DMA_SIGNAL);
+  unsigned int       n   = 0;
+  unsigned int       i;
+
+  if (!spiDmaAllocated) {
+    return PAL_EMSTATUS_DMA_FAILED;
+  }
+  if (spiBusy) {
+    return PAL_EMSTATUS_BUSY;
+  }
+
+  /* One linked descriptor per block, blocks longer than a descriptor can
+     move are split. Only the last descriptor raises the done interrupt. */
+  for (i = 0; i < count; i++) {
+    const uint8_t* src = blocks[i];
+    unsigned int   len = lens[i];
+
+    while (len > 0) {
+      unsigned int chunk = (len > PAL_SPI_DMA_MAX_XFER) ? PAL_SPI_DMA_MAX_XFER : len;
+      LDMA_Descriptor_t desc =
+        LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(src,
+                                         &PAL_SPI_USART_UNIT->TXDATA,
+                                         chunk,
+                                         1);
+
+      if (n == PAL_SPI_DMA_DESCRIPTORS) {
+        return PAL_EMSTATUS_INVALID_PARAM;
+      }
+      desc.xfer.doneIfs = 0;
+      spiDescriptors[n++] = desc;
+      src += chunk;
+      len -= chunk;
+    }
+  }
+
+  if (n == 0) {
+    return PAL_EMSTATUS_INVALID_PARAM;
+  }
+  spiDescriptors[n - 1].xfer.link    = 0;
+  spiDescriptors[n - 1].xfer.doneIfs = 1;
+
+  spiCallback    = callback;
+  spiCallbackArg = argument;
+  spiBusy        = true;
+  SLEEP_SleepBlockBegin(sleepEM2);
+
+  if (DMADRV_LdmaStartTransfer(spiDmaChannel, &cfg, spiDescriptors,
+                               spiDmaDone, NULL) != ECODE_EMDRV_DMADRV_OK) {
+    SLEEP_SleepBlockEnd(sleepEM2);
+    spiBusy = false;
+    return PAL_EMSTATUS_DMA_FAILED;
+  }
+
+  return PAL_EMSTATUS_OK;
+}
+
+/**************************************************************************//**
+ * @brief   Check for a running asynchronous SPI transfer.
+ *
+ * @return  true until the callback of the last transfer has been called.
+ *****************************************************************************/
+bool PAL_SpiBusy(void)
+{
+  return spiBusy;
+}
+#endif /* PAL_SPI_DMA */
+
 /**************************************************************************//**
  * @brief   Initialize the PAL Timer interface
  *
@@ -622,3 +781,5 @@ static void rtccSetup(unsigned int frequency)
 #endif /* INCLUDE_PAL_GPIO_PIN_AUTO_TOGGLE */
 
 /** @endcond */
+
+#endif /* PAL_HOST */
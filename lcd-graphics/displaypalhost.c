@@ -0,0 +1,325 @@
+/***************************************************************************//**
+ * @file
+ * @brief Platform Abstraction Layer (PAL) for DISPLAY driver simulated on a
+ *        host computer.
+ *******************************************************************************
+ *
+ * Built instead of displaypalemlib.c when PAL_HOST is defined, e.g. to run
+ * glib, DMD and the LS013B7DH03 driver on Linux. The bytes the driver sends
+ * between assertion and de-assertion of SCS are decoded like the memory LCD
+ * would do, into a bitmap that can be read back or written as a PBM file,
+ * and the SPI traffic is counted.
+ *
+ ******************************************************************************/
+
+#ifdef PAL_HOST
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+/* DISPLAY driver inclustions */
+#include "displayconfigall.h"
+#include "displaypal.h"
+
+/** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
+
+/*******************************************************************************
+ ********************************  DEFINES  ************************************
+ ******************************************************************************/
+
+/* Memory LCD commands, see displayls013b7dh03.c */
+#define HOST_CMD_UPDATE      (0x01)
+#define HOST_CMD_ALL_CLEAR   (0x04)
+
+#define HOST_BYTES_PER_LINE  (DISPLAY0_WIDTH / 8)
+
+/* Update command, every line with its address and dummy byte, trailer */
+#define HOST_FRAME_MAX       (2 + DISPLAY0_HEIGHT * (HOST_BYTES_PER_LINE + 2) + 2)
+
+/*******************************************************************************
+ ********************************  STATICS  ************************************
+ ******************************************************************************/
+
+/* Display memory, 1 is white, bit 0 of a byte is the leftmost pixel */
+static uint8_t         pixels[DISPLAY0_HEIGHT][HOST_BYTES_PER_LINE];
+
+/* Bytes received while SCS is asserted */
+static uint8_t         frame[HOST_FRAME_MAX];
+static unsigned int    frameLen;
+static bool            frameOverflow;
+static bool            scs;
+
+static PAL_HostStats_t stats;
+
+static void          (*repeatFunction)(void*);
+static void*           repeatArgument;
+
+/*******************************************************************************
+ ************************   STATIC FUNCTION DEFINITIONS   **********************
+ ******************************************************************************/
+
+/* Applies a complete frame to the display memory. */
+static void frameDecode(void)
+{
+  unsigned int pos = 1;
+  unsigned int address;
+
+  stats.frames++;
+
+  if (frameOverflow || frameLen < 2) {
+    stats.errors++;
+    return;
+  }
+
+  if (frame[0] & HOST_CMD_ALL_CLEAR) {
+    memset(pixels, 0xff, sizeof(pixels));
+    stats.clears++;
+  }
+
+  if (0 == (frame[0] & HOST_CMD_UPDATE)) {
+    return;
+  }
+
+  /* Lines are an address from 1, the pixels and a dummy byte. The address
+     after the last line is a dummy byte too. */
+  while (pos < frameLen) {
+    address = frame[pos++];
+    if (address == 0xff) {
+      return;
+    }
+    if ((address == 0) || (address > DISPLAY0_HEIGHT)
+        || (pos + HOST_BYTES_PER_LINE > frameLen)) {
+      stats.errors++;
+      return;
+    }
+
+    memcpy(pixels[address - 1], &frame[pos], HOST_BYTES_PER_LINE);
+    pos += HOST_BYTES_PER_LINE + 1;
+    stats.lineUpdates++;
+  }
+
+  /* Missing trailer */
+  stats.errors++;
+}
+
+/*******************************************************************************
+ **************************     GLOBAL FUNCTIONS      **************************
+ ******************************************************************************/
+
+EMSTATUS PAL_SpiInit(void)
+{
+  return PAL_EMSTATUS_OK;
+}
+
+EMSTATUS PAL_SpiShutdown(void)
+{
+  return PAL_EMSTATUS_OK;
+}
+
+EMSTATUS PAL_SpiTransmit(uint8_t* data, unsigned int len)
+{
+  stats.spiBytes += len;
+
+  if (!scs) {
+    /* The display ignores data without SCS */
+    return PAL_EMSTATUS_OK;
+  }
+
+  if (len > HOST_FRAME_MAX - frameLen) {
+    frameOverflow = true;
+    return PAL_EMSTATUS_OK;
+  }
+
+  memcpy(&frame[frameLen], data, len);
+  frameLen += len;
+
+  return PAL_EMSTATUS_OK;
+}
+
+#ifdef PAL_SPI_DMA
+/**************************************************************************//**
+ * @brief   Transmit the blocks right away and call the callback before
+ *          returning, the simulated transfer is never busy.
+ *****************************************************************************/
+EMSTATUS PAL_SpiTransmitAsync(const uint8_t* const* blocks,
+                              const unsigned int*   lens,
+                              unsigned int          count,
+                              PAL_SpiDone_t         callback,
+                              void*                 argument)
+{
+  unsigned int i;
+
+  for (i = 0; i < count; i++) {
+    PAL_SpiTransmit((uint8_t*) blocks[i], lens[i]);
+  }
+
+  if (callback != NULL) {
+    callback(argument);
+  }
+
+  return PAL_EMSTATUS_OK;
+}
+
+bool PAL_SpiBusy(void)
+{
+  return false;
+}
+#endif /* PAL_SPI_DMA */
+
+EMSTATUS PAL_TimerInit(void)
+{
+  return PAL_EMSTATUS_OK;
+}
+
+EMSTATUS PAL_TimerShutdown(void)
+{
+  return PAL_EMSTATUS_OK;
+}
+
+/**************************************************************************//**
+ * @brief   Count the delay instead of waiting.
+ *****************************************************************************/
+EMSTATUS PAL_TimerMicroSecondsDelay(unsigned int usecs)
+{
+  stats.delayUs += usecs;
+  return PAL_EMSTATUS_OK;
+}
+
+#ifdef PAL_TIMER_REPEAT_FUNCTION
+/**************************************************************************//**
+ * @brief   Remember the function, PAL_HostTimerFire() calls it.
+ *****************************************************************************/
+EMSTATUS PAL_TimerRepeat(void(*pFunction)(void*),
+                         void* argument,
+                         unsigned int frequency)
+{
+  (void) frequency; /* Suppress compiler warning: unused parameter. */
+
+  repeatFunction = pFunction;
+  repeatArgument = argument;
+  return PAL_EMSTATUS_OK;
+}
+#endif
+
+void PAL_HostTimerFire(void)
+{
+  if (repeatFunction != NULL) {
+    repeatFunction(repeatArgument);
+  }
+}
+
+EMSTATUS PAL_GpioInit(void)
+{
+  return PAL_EMSTATUS_OK;
+}
+
+EMSTATUS PAL_GpioShutdown(void)
+{
+  return PAL_EMSTATUS_OK;
+}
+
+EMSTATUS PAL_GpioPinModeSet(unsigned int   port,
+                            unsigned int   pin,
+                            PAL_GpioMode_t mode,
+                            unsigned int   platformSpecific)
+{
+  (void) mode;             /* Suppress compiler warning: unused parameter. */
+  (void) platformSpecific; /* Suppress compiler warning: unused parameter. */
+
+  if ((port == LCD_PORT_SCS) && (pin == LCD_PIN_SCS)) {
+    scs = false;
+  }
+  return PAL_EMSTATUS_OK;
+}
+
+EMSTATUS PAL_GpioPinOutSet(unsigned int port, unsigned int pin)
+{
+  if ((port == LCD_PORT_SCS) && (pin == LCD_PIN_SCS) && !scs) {
+    scs           = true;
+    frameLen      = 0;
+    frameOverflow = false;
+  }
+  return PAL_EMSTATUS_OK;
+}
+
+EMSTATUS PAL_GpioPinOutClear(unsigned int port, unsigned int pin)
+{
+  if ((port == LCD_PORT_SCS) && (pin == LCD_PIN_SCS) && scs) {
+    scs = false;
+    frameDecode();
+  }
+  return PAL_EMSTATUS_OK;
+}
+
+EMSTATUS PAL_GpioPinOutToggle(unsigned int port, unsigned int pin)
+{
+  if ((port == LCD_PORT_SCS) && (pin == LCD_PIN_SCS)) {
+    return scs ? PAL_GpioPinOutClear(port, pin) : PAL_GpioPinOutSet(port, pin);
+  }
+  return PAL_EMSTATUS_OK;
+}
+
+EMSTATUS PAL_GpioPinAutoToggle(unsigned int gpioPort,
+                               unsigned int gpioPin,
+                               unsigned int frequency)
+{
+  (void) gpioPort;  /* Suppress compiler warning: unused parameter. */
+  (void) gpioPin;   /* Suppress compiler warning: unused parameter. */
+  (void) frequency; /* Suppress compiler warning: unused parameter. */
+
+  return PAL_EMSTATUS_OK;
+}
+
+bool PAL_HostPixelGet(unsigned int x, unsigned int y)
+{
+  if ((x >= DISPLAY0_WIDTH) || (y >= DISPLAY0_HEIGHT)) {
+    return false;
+  }
+  return (pixels[y][x >> 3] >> (x & 0x7)) & 0x1;
+}
+
+EMSTATUS PAL_HostWritePbm(const char* path)
+{
+  FILE*        file;
+  unsigned int x;
+  unsigned int y;
+  uint8_t      byte;
+
+  file = fopen(path, "wb");
+  if (file == NULL) {
+    return PAL_EMSTATUS_INVALID_PARAM;
+  }
+
+  /* Raw PBM: 1 is black, most significant bit first */
+  fprintf(file, "P4\n%d %d\n", DISPLAY0_WIDTH, DISPLAY0_HEIGHT);
+  for (y = 0; y < DISPLAY0_HEIGHT; y++) {
+    for (x = 0; x < DISPLAY0_WIDTH; x += 8) {
+      byte = pixels[y][x >> 3];
+      byte = (byte & 0xf0) >> 4 | (byte & 0x0f) << 4;
+      byte = (byte & 0xcc) >> 2 | (byte & 0x33) << 2;
+      byte = (byte & 0xaa) >> 1 | (byte & 0x55) << 1;
+      fputc(~byte & 0xff, file);
+    }
+  }
+
+  if (fclose(file) != 0) {
+    return PAL_EMSTATUS_INVALID_PARAM;
+  }
+  return PAL_EMSTATUS_OK;
+}
+
+void PAL_HostStatsGet(PAL_HostStats_t* out)
+{
+  *out = stats;
+}
+
+void PAL_HostStatsReset(void)
+{
+  memset(&stats, 0, sizeof(stats));
+}
+
+/** @endcond */
+
+#endif /* PAL_HOST */
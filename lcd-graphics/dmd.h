@@ -74,6 +74,8 @@
 #define DMD_ERROR_NOT_SUPPORTED                 (ECODE_DMD_BASE | 0x000a)
 /** Not enough memory.  */
 #define DMD_ERROR_NOT_ENOUGH_MEMORY             (ECODE_DMD_BASE | 0x000b)
+/** Previous display update still running */
+#define DMD_ERROR_BUSY                          (ECODE_DMD_BASE | 0x000c)
 
 /* Tests */
 /** Device code test */
@@ -126,6 +128,9 @@ typedef struct __DMD_MemoryError{
   uint8_t  readColor[3];
 } DMD_MemoryError; /**< Typedef for memory error information */
 
+/** Called from interrupt context once an asynchronous display update is done. */
+typedef void (*DMD_UpdateDone_t)(void *argument);
+
 /* Module prototypes */
 EMSTATUS DMD_init(DMD_InitConfig *initConfig);
 EMSTATUS DMD_getDisplayGeometry(DMD_DisplayGeometry **geometry);
@@ -142,6 +147,9 @@ EMSTATUS DMD_readData(uint16_t x, uint16_t y,
                       uint8_t data[], uint32_t numPixels);
 EMSTATUS DMD_writeColor(uint16_t x, uint16_t y, uint8_t red,
                         uint8_t green, uint8_t blue, uint32_t numPixels);
+EMSTATUS DMD_writeGlyph(uint16_t x, uint16_t y, const uint32_t rows[],
+                        uint16_t width, uint16_t height,
+                        uint8_t foreground, uint8_t background, int opaque);
 EMSTATUS DMD_sleep(void);
 EMSTATUS DMD_wakeUp(void);
 EMSTATUS DMD_flipDisplay(int horizontal, int vertical);
@@ -149,6 +157,7 @@ EMSTATUS DMD_flipDisplay(int horizontal, int vertical);
 EMSTATUS DMD_selectFramebuffer (void *framebuffer);
 EMSTATUS DMD_getFrameBuffer (void **framebuffer);
 EMSTATUS DMD_updateDisplay (void);
+EMSTATUS DMD_updateDisplayAsync (DMD_UpdateDone_t done, void *argument);
 
 /** @cond DO_NOT_INCLUDE_WITH_DOXYGEN */
 /* Test functions */
@@ -42,6 +42,10 @@ static bool  moduleInitialized = false;
 static DISPLAY_Device_t      displayDevice;
 static DISPLAY_PixelMatrix_t pixelMatrixBuffer = NULL;
 
+/* Framebuffer last handed to an asynchronous display update, the DMA may
+   still read it. Allocated on the first asynchronous update. */
+static DISPLAY_PixelMatrix_t flushBuffer = NULL;
+
 /* Dimensions of the display */
 static DMD_DisplayGeometry dimensions;
 
@@ -51,6 +55,71 @@ static DMD_DisplayGeometry dimensions;
    having been updated on the display. */
 uint32_t dirtyRows[DISPLAY0_WIDTH / sizeof(uint32_t) / 8];
 
+/**************************************************************************//**
+*  @brief
+*  Sets or clears a run of pixels on a monochrome pixelMatrix row
+*
+*  @details
+*  The partial bytes at both ends are masked, the bytes in between are
+*  written a 32 bit word at a time where they are word aligned.
+*
+*  @param pRow
+*  First byte of the row
+*  @param x
+*  First pixel of the run
+*  @param numPixels
+*  Number of pixels in the run
+*  @param pixelData
+*  0x00 to clear the pixels, 0xff to set them
+******************************************************************************/
+static void writeSpan(uint8_t *pRow, unsigned int x, unsigned int numPixels,
+                      uint8_t pixelData)
+{
+  uint8_t  *pDst     = pRow + (x >> 3);
+  uint32_t *pWord;
+  uint32_t  wordData = pixelData ? 0xffffffffUL : 0;
+  unsigned int bits;
+  uint8_t   pixelMask;
+
+  /* Leading pixels up to the next byte boundary */
+  if (x & 0x7) {
+    bits = 8 - (x & 0x7);
+    if (bits > numPixels) {
+      bits = numPixels;
+    }
+    pixelMask  = ((1 << bits) - 1) << (x & 0x7);
+    *pDst      = (*pDst & ~pixelMask) | (pixelData & pixelMask);
+    pDst++;
+    numPixels -= bits;
+  }
+
+  /* Whole bytes up to the next word boundary */
+  while ((numPixels >= 8) && ((uintptr_t) pDst & 0x3)) {
+    *pDst++    = pixelData;
+    numPixels -= 8;
+  }
+
+  /* 32 pixels per store */
+  pWord = (uint32_t *) pDst;
+  while (numPixels >= 32) {
+    *pWord++   = wordData;
+    numPixels -= 32;
+  }
+  pDst = (uint8_t *) pWord;
+
+  /* Whole bytes left */
+  while (numPixels >= 8) {
+    *pDst++    = pixelData;
+    numPixels -= 8;
+  }
+
+  /* Trailing pixels */
+  if (numPixels) {
+    pixelMask = (1 << numPixels) - 1;
+    *pDst     = (*pDst & ~pixelMask) | (pixelData & pixelMask);
+  }
+}
+
 /* To become API functions later. */
 EMSTATUS DMD_allocateFramebuffer(void **framebuffer);
 EMSTATUS DMD_freeFramebuffer(void *framebuffer);
@@ -481,10 +550,6 @@ EMSTATUS DMD_writeColor(uint16_t x, uint16_t y, uint8_t red,
     case DISPLAY_ADDRESSING_BY_ROWS_ONLY:
     {
       unsigned int rowPixels;
-      int          byteOffset;
-      int          numBytesToCopy;
-      uint8_t      pixelMask;
-      uint8_t      matrixByte;
       uint8_t     *pStartRow;
       uint8_t     *pDst;
       int          rows = 0;
@@ -511,8 +576,9 @@ EMSTATUS DMD_writeColor(uint16_t x, uint16_t y, uint8_t red,
 
         switch (displayDevice.colourMode) {
         #if defined(DISPLAY_COLOUR_MODE_IS_RGB_3BIT)
-          int pixelByte;
-          int pixelBit;
+          int     pixelByte;
+          int     pixelBit;
+          uint8_t matrixByte;
 
           case DISPLAY_COLOUR_MODE_RGB_3BIT:
 
@@ -574,57 +640,7 @@ EMSTATUS DMD_writeColor(uint16_t x, uint16_t y, uint8_t red,
               pixelData = ~pixelData;
             }
             /* Write pixel data to the pixelMatrix buffer. */
-            if (rowPixels < 8) {
-              rowPixels += x;
-              if (pixelData) {
-                for (; x < rowPixels; x++) {
-                  pDst[x >> 3] |= 1 << (x & 0x7);
-                }
-              } else {
-                for (; x < rowPixels; x++) {
-                  pDst[x >> 3] &= ~(1 << (x & 0x7));
-                }
-              }
-            } else {
-              byteOffset = x & 0x7;
-
-              pDst += x >> 3;
-
-              if (byteOffset) {
-                /* Copy the pixels into first byte of the pixelMatrix buffer. */
-                matrixByte = *pDst;
-                pixelMask = (1 << byteOffset) - 1;
-                matrixByte &= pixelMask;
-                matrixByte |= pixelData & ~pixelMask;
-                *pDst = matrixByte;
-                pDst++;
-                rowPixels -= 8 - byteOffset;
-              }
-
-              /* Now, remaining pixels start is 8-bit aligned. Copy the corresponding
-                 number of bytes, then if there are remaining bits, copy them correctly
-                 into the last byte. */
-              numBytesToCopy = rowPixels >> 3;
-
-              if (numBytesToCopy) {
-                /* We can copy data continuosly from start to end. */
-                memset(pDst, pixelData, numBytesToCopy);
-                rowPixels  -= numBytesToCopy << 3;
-                pDst       += numBytesToCopy;
-              }
-
-              /* If there are remaining pixels on this row,
-                 write them into the last byte. */
-              if (rowPixels) {
-                /* Copy the remaining pixels into last byte of pixelMatrix buffer. */
-                matrixByte = *pDst;
-                pixelMask = (1 << rowPixels) - 1;
-                matrixByte &= ~pixelMask;
-                matrixByte |= pixelData & pixelMask;
-                *pDst = matrixByte;
-              }
-            }
-
+            writeSpan(pDst, x, rowPixels, pixelData);
             break;
           default:
             break;
@@ -655,6 +671,132 @@ EMSTATUS DMD_writeColor(uint16_t x, uint16_t y, uint8_t red,
   return DMD_OK;
 }
 
+/**************************************************************************//**
+*  @brief
+*  Draws a 1 bit per pixel glyph of up to 32 pixels width to the display
+*
+*  @details
+*  Each row of the glyph is masked and shifted into the pixelMatrix buffer
+*  in one go, bit 0 of a row is the leftmost pixel. The glyph must lie
+*  entirely inside the clipping area, it is not clipped.
+*
+*  @param x
+*  X coordinate of the upper left pixel, relative to the clipping area
+*  @param y
+*  Y coordinate of the upper left pixel, relative to the clipping area
+*  @param rows
+*  Array of height rows, a set bit is drawn with the foreground color
+*  @param width
+*  Width of the glyph in pixels, 1 to 32
+*  @param height
+*  Height of the glyph in pixels
+*  @param foreground
+*  Green component of the foreground color, selects the pixel value the same
+*  way as DMD_writeColor() does on monochrome displays
+*  @param background
+*  Green component of the background color
+*  @param opaque
+*  If non-zero, the clear bits are drawn with the background color, otherwise
+*  the pixels are left as they are
+*
+*  @return
+*  DMD_OK on success, DMD_ERROR_NOT_SUPPORTED on colour displays,
+*  otherwise error code
+******************************************************************************/
+EMSTATUS DMD_writeGlyph(uint16_t x, uint16_t y, const uint32_t rows[],
+                        uint16_t width, uint16_t height,
+                        uint8_t foreground, uint8_t background, int opaque)
+{
+  uint32_t     widthMask;
+  uint32_t     bits;
+  uint32_t     pixelData;
+  uint64_t     rowMask;
+  uint64_t     rowData;
+  bool         foregroundSet;
+  bool         backgroundSet;
+  uint8_t     *pDst;
+  unsigned int numBytes;
+  unsigned int i;
+  int          row;
+  int          bytesPerRow = displayDevice.geometry.stride / 8;
+
+  if (!moduleInitialized) {
+    return DMD_ERROR_DRIVER_NOT_INITIALIZED;
+  }
+
+  if (NULL == pixelMatrixBuffer) {
+    return DMD_ERROR_DRIVER_NOT_INITIALIZED;
+  }
+
+  if ((DISPLAY_ADDRESSING_BY_ROWS_ONLY != displayDevice.addressMode)
+      || ((DISPLAY_COLOUR_MODE_MONOCHROME != displayDevice.colourMode)
+          && (DISPLAY_COLOUR_MODE_MONOCHROME_INVERSE
+              != displayDevice.colourMode))
+      || (0 == width) || (width > 32)) {
+    return DMD_ERROR_NOT_SUPPORTED;
+  }
+
+  /* Check that the glyph is inside the clipping area */
+  if ((x + width > dimensions.clipWidth)
+      || (y + height > dimensions.clipHeight)) {
+    return DMD_ERROR_PIXEL_OUT_OF_BOUNDS;
+  }
+
+  /* Same pixel values as written by DMD_writeColor() */
+  foregroundSet = ((0 == foreground)
+                   == (DISPLAY_COLOUR_MODE_MONOCHROME == displayDevice.colourMode));
+  backgroundSet = ((0 == background)
+                   == (DISPLAY_COLOUR_MODE_MONOCHROME == displayDevice.colourMode));
+
+  widthMask = (width < 32) ? ((1UL << width) - 1) : 0xffffffffUL;
+
+  /* Adjust x and y to account for clipping. */
+  x += dimensions.xClipStart;
+  y += dimensions.yClipStart;
+
+  numBytes = ((x & 0x7) + width + 7) >> 3;
+  pDst     = (uint8_t*) pixelMatrixBuffer + y * bytesPerRow + (x >> 3);
+
+  for (row = 0; row < height; row++, pDst += bytesPerRow) {
+    bits      = rows[row] & widthMask;
+    pixelData = foregroundSet ? bits : 0;
+    if (opaque && backgroundSet) {
+      pixelData |= ~bits & widthMask;
+    }
+
+    rowMask = (uint64_t) (opaque ? widthMask : bits) << (x & 0x7);
+    rowData = (uint64_t) pixelData << (x & 0x7);
+
+    /* Nothing drawn on this row, like DMD_writeColor() it stays clean */
+    if (0 == rowMask) {
+      continue;
+    }
+
+    for (i = 0; i < numBytes; i++) {
+      pDst[i] = (pDst[i] & ~(uint8_t) rowMask)
+                | ((uint8_t) rowData & (uint8_t) rowMask);
+      rowMask >>= 8;
+      rowData >>= 8;
+    }
+
+    /* Mark row/line as dirty */
+    dirtyRows[(y + row) >> DIRTY_WORD_BITS_LOG2] |=
+      1 << ((y + row) & DIRTY_WORD_BITS_LOG2_MASK);
+  }
+
+#ifdef UPDATE_PER_WRITE_CALL
+  /* Update the display device now. */
+  displayDevice.pPixelMatrixDraw(&displayDevice,
+                                 (uint8_t*) pixelMatrixBuffer + y * bytesPerRow,
+                                 0,
+                                 displayDevice.geometry.width,
+                                 y,
+                                 height);
+#endif
+
+  return DMD_OK;
+}
+
 /**************************************************************************//**
 *  @brief
 *  Turns off the display and puts it into sleep mode
@@ -881,6 +1023,104 @@ EMSTATUS DMD_updateDisplay(void)
   return DMD_OK;
 }
 
+/**************************************************************************//**
+*  @brief
+*  Start updating the display device with the dirty rows/lines of the active
+*  framebuffer and return before the transfer is done.
+*
+*  @details
+*  The rows/lines are sent by the display driver from the active framebuffer,
+*  which is then copied to a second framebuffer that becomes the active one,
+*  so drawing can go on while the transfer runs. The next update is refused
+*  until the transfer is done and the dirty rows/lines are kept for it.
+*  Devices without asynchronous drawing are updated synchronously.
+*
+*  @param done
+*  Called from interrupt context once the display is updated, or NULL.
+*
+*  @param argument
+*  Argument given to done.
+*
+*  @return
+*  Returns DMD_OK is successful, DMD_ERROR_BUSY if the previous update is
+*  still running, error otherwise.
+******************************************************************************/
+EMSTATUS DMD_updateDisplayAsync(DMD_UpdateDone_t done, void *argument)
+{
+  static DISPLAY_RowRange_t ranges[DISPLAY0_HEIGHT / 2 + 1];
+  unsigned int              count = 0;
+  unsigned int              row;
+  DISPLAY_PixelMatrix_t     front;
+  EMSTATUS                  status;
+
+  if (NULL == displayDevice.pPixelMatrixDrawAsync) {
+    status = DMD_updateDisplay();
+    if (DMD_OK == status && NULL != done) {
+      done(argument);
+    }
+    return status;
+  }
+
+  if (NULL == flushBuffer) {
+    /* Allocating selects the new framebuffer, keep drawing in the current
+       one. All rows/lines are marked dirty once. */
+    front = pixelMatrixBuffer;
+    status = DMD_allocateFramebuffer(&flushBuffer);
+    pixelMatrixBuffer = front;
+    if (DMD_OK != status) {
+      flushBuffer = NULL;
+      return status;
+    }
+  }
+
+  for (row = 0; row < displayDevice.geometry.height; row++) {
+    if (dirtyRows[row >> DIRTY_WORD_BITS_LOG2]
+        & (1 << (row & DIRTY_WORD_BITS_LOG2_MASK))) {
+      if (count > 0
+          && ranges[count - 1].startRow + ranges[count - 1].height == row) {
+        ranges[count - 1].height++;
+      } else {
+        ranges[count].startRow = row;
+        ranges[count].height   = 1;
+        count++;
+      }
+    }
+  }
+
+  if (0 == count) {
+    if (NULL != done) {
+      done(argument);
+    }
+    return DMD_OK;
+  }
+
+  status = displayDevice.pPixelMatrixDrawAsync(&displayDevice,
+                                               pixelMatrixBuffer,
+                                               ranges,
+                                               count,
+                                               done,
+                                               argument);
+  if (DISPLAY_EMSTATUS_BUSY == status) {
+    return DMD_ERROR_BUSY;
+  }
+  if (DISPLAY_EMSTATUS_OK != status) {
+    return status;
+  }
+
+  /* The previous transfer is over since the driver accepted this one, so
+     the other framebuffer is free to draw in. */
+  front             = pixelMatrixBuffer;
+  memcpy(flushBuffer, front,
+         displayDevice.geometry.stride / 8 * displayDevice.geometry.height);
+  pixelMatrixBuffer = flushBuffer;
+  flushBuffer       = front;
+
+  /* Clear dirty rows flags. */
+  memset(dirtyRows, 0x0, sizeof(dirtyRows));
+
+  return DMD_OK;
+}
+
 /***************************************************************************//**
  * @brief
  *    Get current framebuffer used by DMD for drawing (backbuffer).
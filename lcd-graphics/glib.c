@@ -393,6 +393,71 @@ EMSTATUS GLIB_drawPixel(GLIB_Context_t *pContext, int32_t x, int32_t y)
   return DMD_writeColor(x, y, red, green, blue, 1);
 }
 
+/**************************************************************************//**
+*  @brief
+*  Draws a horizontal run of pixels using foregroundColor defined in the
+*  GLIB_Context_t, the same pixels as GLIB_drawPixel() for each of them
+*
+*  @param pContext
+*  Pointer to a GLIB_Context_t which holds the foreground color and clipping region
+*  @param x
+*  X-coordinate of the leftmost pixel
+*  @param y
+*  Y-coordinate
+*  @param length
+*  Number of pixels
+*
+*  @return
+*  Returns GLIB_OK on success, or else error code
+******************************************************************************/
+EMSTATUS GLIB_drawPixelSpan(GLIB_Context_t *pContext, int32_t x, int32_t y,
+                            uint32_t length)
+{
+  EMSTATUS status;
+  int32_t xEnd;
+  uint8_t red;
+  uint8_t green;
+  uint8_t blue;
+
+  /* Check arguments */
+  if (pContext == NULL) {
+    return GLIB_ERROR_INVALID_ARGUMENT;
+  }
+  if ((length == 0)
+      || (y < pContext->clippingRegion.yMin)
+      || (y > pContext->clippingRegion.yMax)) {
+    return GLIB_ERROR_NOTHING_TO_DRAW;
+  }
+
+  /* Clip the run */
+  xEnd = x + (int32_t)length - 1;
+  if (x < pContext->clippingRegion.xMin) {
+    x = pContext->clippingRegion.xMin;
+  }
+  if (xEnd > pContext->clippingRegion.xMax) {
+    xEnd = pContext->clippingRegion.xMax;
+  }
+  if (x > xEnd) {
+    return GLIB_ERROR_NOTHING_TO_DRAW;
+  }
+
+  GLIB_colorTranslate24bppInl(pContext->foregroundColor, &red, &green, &blue);
+
+  /* A single write as long as the run does not wrap around the end of the
+     display driver clipping area */
+  if (xEnd < pContext->pDisplayGeometry->clipWidth) {
+    return DMD_writeColor(x, y, red, green, blue, xEnd - x + 1);
+  }
+
+  for (; x <= xEnd; x++) {
+    status = DMD_writeColor(x, y, red, green, blue, 1);
+    if (status != DMD_OK) {
+      return status;
+    }
+  }
+  return DMD_OK;
+}
+
 /**************************************************************************//**
 *  @brief
 *  Draws a pixel at x, y using the color parameter
@@ -117,6 +117,8 @@
  * @li @ref GLIB_drawPixel(). Draw a pixel using the foreground color.
  * @li @ref GLIB_drawPixelRGB(). Draw a single pixel using a specific color.
  * @li @ref GLIB_drawPixelColor(). Draw a single pixel using a specific color.
+ * @li @ref GLIB_drawPixelSpan(). Draw a horizontal run of pixels using the
+ *   foreground color.
  *
  * @n @section glib_font Font rendering
  *
@@ -355,6 +357,9 @@ EMSTATUS GLIB_drawPixelRGB(GLIB_Context_t *pContext, int32_t x, int32_t y,
 
 EMSTATUS GLIB_drawPixel(GLIB_Context_t *pContext, int32_t x, int32_t y);
 
+EMSTATUS GLIB_drawPixelSpan(GLIB_Context_t *pContext, int32_t x, int32_t y,
+                            uint32_t length);
+
 EMSTATUS GLIB_drawPixelColor(GLIB_Context_t *pContext, int32_t x, int32_t y,
                              uint32_t color);
 
@@ -343,6 +343,7 @@ EMSTATUS GLIB_drawLine(GLIB_Context_t *pContext, int32_t x1, int32_t y1,
   int32_t deltaY;
   int32_t yMotion;
   int32_t xMotion;
+  int32_t spanStart;
   bool steepLine = false;
   int32_t yStep = 1;
 
@@ -409,20 +410,26 @@ EMSTATUS GLIB_drawLine(GLIB_Context_t *pContext, int32_t x1, int32_t y1,
   }
 
   /* Loop through all points along the x-axis */
-  for (; x1 <= x2; x1++) {
+  for (spanStart = x1; x1 <= x2; x1++) {
     if (steepLine) {
       /* If steep, swap x and y coordinates */
       status = GLIB_drawPixel(pContext, y1, x1);
-    } else {
-      status = GLIB_drawPixel(pContext, x1, y1);
-    }
-
-    if (status != GLIB_OK) {
-      return status;
+      if (status != GLIB_OK) {
+        return status;
+      }
     }
 
     error += deltaY;
 
+    /* If not steep, the points up to a step in y are drawn as one span */
+    if (!steepLine && ((error > 0) || (x1 == x2))) {
+      status = GLIB_drawPixelSpan(pContext, spanStart, y1, x1 - spanStart + 1);
+      if (status != GLIB_OK) {
+        return status;
+      }
+      spanStart = x1 + 1;
+    }
+
     if (error > 0) {
       y1    += yStep;
       error -= deltaX;
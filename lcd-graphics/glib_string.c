@@ -26,6 +26,106 @@
 #include "glib.h"
 #include "glib_color.h"
 
+/* Tallest glyph drawn with DMD_writeGlyph(), taller ones go pixel by pixel */
+#define GLIB_GLYPH_MAX_HEIGHT  32
+
+/**************************************************************************//**
+*  @brief
+*  Draws a char that lies entirely inside the clipping region with one
+*  DMD_writeGlyph() call instead of pixel by pixel.
+*
+*  @param pContext
+*  Pointer to the GLIB_Context_t
+*
+*  @param fontIdx
+*  Index of the first row of the char in the font pixel map
+*
+*  @param x
+*  Start x-coordinate for the char (Upper left corner)
+*
+*  @param y
+*  Start y-coordinate for the char (Upper left corner)
+*
+*  @param opaque
+*  Determines whether to color the background with the background color.
+*
+*  @param pStatus
+*  Result of the drawing, valid if the char was drawn.
+*
+*  @return
+*  Returns false if the char must be drawn pixel by pixel
+******************************************************************************/
+static bool GLIB_blitChar(GLIB_Context_t *pContext, uint16_t fontIdx,
+                          int32_t x, int32_t y, bool opaque, EMSTATUS *pStatus)
+{
+  uint32_t rows[GLIB_GLYPH_MAX_HEIGHT];
+  uint32_t drawn = 0;
+  uint32_t width;
+  uint16_t row;
+  uint8_t red;
+  uint8_t green;
+  uint8_t blue;
+  uint8_t background;
+  EMSTATUS status;
+
+  /* Character spacing is only drawn on an opaque background */
+  width = pContext->font.fontWidth + (opaque ? pContext->font.charSpacing : 0);
+
+  /* Clip once per char: the char is either wholly drawn here or left to
+     the pixel by pixel drawing */
+  if ((width == 0) || (width > 32)
+      || (pContext->font.fontHeight > GLIB_GLYPH_MAX_HEIGHT)
+      || (x < pContext->clippingRegion.xMin)
+      || (y < pContext->clippingRegion.yMin)
+      || (x + (int32_t)width - 1 > pContext->clippingRegion.xMax)
+      || (y + pContext->font.fontHeight - 1 > pContext->clippingRegion.yMax)) {
+    return false;
+  }
+
+  /* The font rows already have the leftmost pixel in bit 0, like the
+     display rows */
+  for (row = 0; row < pContext->font.fontHeight; row++) {
+    switch (pContext->font.sizeOfMapElement) {
+      case 1:
+        rows[row] = ((const uint8_t *)pContext->font.pFontPixMap)[fontIdx];
+        break;
+
+      case 2:
+        rows[row] = ((const uint16_t *)pContext->font.pFontPixMap)[fontIdx];
+        break;
+
+      default:
+        /* Truncated to 16 bits like in GLIB_drawChar() */
+        rows[row] = (uint16_t)((const uint32_t *)pContext->font.pFontPixMap)[fontIdx];
+    }
+    if (pContext->font.fontWidth < 32) {
+      rows[row] &= (1UL << pContext->font.fontWidth) - 1;
+    }
+    drawn |= rows[row];
+
+    fontIdx += pContext->font.fontRowOffset;
+  }
+
+  if (!opaque && (drawn == 0)) {
+    *pStatus = GLIB_ERROR_NOTHING_TO_DRAW;
+    return true;
+  }
+
+  GLIB_colorTranslate24bpp(pContext->backgroundColor, &red, &green, &blue);
+  background = green;
+  GLIB_colorTranslate24bpp(pContext->foregroundColor, &red, &green, &blue);
+
+  status = DMD_writeGlyph(x, y, rows, width, pContext->font.fontHeight,
+                          green, background, opaque);
+  if ((status == DMD_ERROR_NOT_SUPPORTED)
+      || (status == DMD_ERROR_PIXEL_OUT_OF_BOUNDS)) {
+    return false;
+  }
+
+  *pStatus = status;
+  return true;
+}
+
 /**************************************************************************//**
 *  @brief
 *  Draws a char using the font supplied with the library.
@@ -89,6 +189,11 @@ EMSTATUS GLIB_drawChar(GLIB_Context_t *pContext, char myChar, int32_t x, int32_t
     return GLIB_ERROR_INVALID_CHAR;
   }
 
+  /* Whole rows at a time where the char is not clipped */
+  if (GLIB_blitChar(pContext, fontIdx, x, y, opaque, &status)) {
+    return status;
+  }
+
   /* Loop through the rows and draw the font */
   pPixMap8 = (uint8_t *)pContext->font.pFontPixMap;
   pPixMap16 = (uint16_t *)pContext->font.pFontPixMap;
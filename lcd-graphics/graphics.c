@@ -29,16 +29,24 @@
 #define X_BORDER 5
 #define Y_BORDER 2
 
+// Text lines remembered for redrawing only what changed
+#define MAX_LINES       16
+#define MAX_LINE_LENGTH 31
+
 // Globals
-static uint32_t xOffset, yOffset;
 static GLIB_Context_t glibContext;
 
+// Text shown on each line, without trailing spaces, and the line appended next
+static char lines[MAX_LINES][MAX_LINE_LENGTH + 1];
+static unsigned int nextLine;
+
 // Macros
 #define X(index) (2 * (index))
 #define Y(index) (2 * (index) + 1)
 
 // Declarations
-static bool pointInTriangle(int x, int y, int32_t *polyPoints);
+static bool triangleSpan(int y, int32_t *polyPoints, int *start, int *stop);
+static void setLine(unsigned int line, const char *str, size_t len);
 
 /**************************************************************************//**
  * @brief Initializes the graphics stack.
@@ -85,31 +93,99 @@ void GRAPHICS_Wakeup(void)
 }
 
 /**************************************************************************//**
- * @brief This function draws the initial display screen
+ * @brief Sends the display rows changed since the last update
  *****************************************************************************/
 void GRAPHICS_Update(void)
 {
-  DMD_updateDisplay();
+  // Erase the lines of the previous frame that were not appended again
+  for (unsigned int line = nextLine; line < MAX_LINES; line++) {
+    if (lines[line][0] != '\0') {
+      setLine(line, "", 0);
+    }
+  }
+
+  /* The LDMA moves the frame while the caller goes on, a frame refused
+     because the previous one is still being sent stays dirty for the next
+     update. */
+  DMD_updateDisplayAsync(NULL, NULL);
 }
 
 void GRAPHICS_Clear(void)
 {
   GLIB_clear(&glibContext);
+  memset(lines, 0, sizeof(lines));
+
+  GRAPHICS_Home();
+}
+
+/**************************************************************************//**
+ * @brief Starts a new frame of text lines without clearing the display.
+ *
+ * The lines appended next are compared with the text already shown and only
+ * the characters that differ are drawn again, so that GRAPHICS_Update() only
+ * sends the display rows of the lines that changed. Lines that are not
+ * appended again before the update are erased.
+ *****************************************************************************/
+void GRAPHICS_Home(void)
+{
+  nextLine = 0;
+}
+
+/**************************************************************************//**
+ * @brief Replaces the text of a line, drawing only the changed characters.
+ *****************************************************************************/
+static void setLine(unsigned int line, const char *str, size_t len)
+{
+  char *shown = lines[line];
+  size_t shownLen = strlen(shown);
+  int32_t charWidth = glibContext.font.fontWidth + glibContext.font.charSpacing;
+  int32_t y = Y_BORDER
+              + line * (glibContext.font.fontHeight + glibContext.font.lineSpacing);
+  size_t i;
+  char c;
+
+  if (len > MAX_LINE_LENGTH) {
+    len = MAX_LINE_LENGTH;
+  }
+
+  for (i = 0; (i < len) || (i < shownLen); i++) {
+    c = (i < len) ? str[i] : ' ';
+    if ((c < ' ') || (c > '~')) {
+      c = ' ';
+    }
+
+    // Past the end of a line the display shows the background, like a space.
+    // Opaque drawing paints over the old character.
+    if (c != ((i < shownLen) ? shown[i] : ' ')) {
+      GLIB_drawChar(&glibContext, c, X_BORDER + i * charWidth, y, true);
+    }
+    shown[i] = c;
+  }
 
-  // Reset the offset values to their defaults
-  xOffset = X_BORDER;
-  yOffset = Y_BORDER;
+  while ((i > 0) && (shown[i - 1] == ' ')) {
+    i--;
+  }
+  shown[i] = '\0';
 }
 
 void GRAPHICS_AppendString(char *str)
 {
-  GLIB_drawString(&glibContext,
-                  str,
-                  strlen(str),
-                  xOffset,
-                  yOffset,
-                  0);
-  yOffset += glibContext.font.fontHeight + glibContext.font.lineSpacing;
+  const char *end;
+
+  // One line per newline, like GLIB_drawString()
+  do {
+    end = strchr(str, '\n');
+    if (end == NULL) {
+      end = str + strlen(str);
+    }
+
+    if (nextLine < MAX_LINES) {
+      setLine(nextLine, str, end - str);
+    }
+    nextLine++;
+
+    str = (char *)end + 1;
+  } while ((*end != '\0') && (*str != '\0'));
 }
 
 /**************************************************************************//**
@@ -176,63 +252,66 @@ void GRAPHICS_InsertTriangle(uint32_t x,
       fillStopY  = y + (size * fillPercent) / 100;
     }
 
-    for (int i = fillStartX; i < fillStopX; i++) {
-      for (int j = fillStartY; j < fillStopY; j++) {
-        // If this point is within the triangle draw a point
-        if (pointInTriangle(i, j, polyPoints)) {
-          GLIB_drawPixel(&glibContext, i, j);
-        }
+    for (int j = fillStartY; j < fillStopY; j++) {
+      // Draw the points of this row that are within the triangle as a span
+      int spanStart = fillStartX;
+      int spanStop  = fillStopX - 1;
+
+      if (triangleSpan(j, polyPoints, &spanStart, &spanStop)) {
+        GLIB_drawPixelSpan(&glibContext, spanStart, j, spanStop - spanStart + 1);
       }
     }
   }
 }
 
-// Helper function to take the cross product of the vectors P0P1 and P1P2
-// where the points P0, P1, and P2 are stored in the points array as P0x, P0y,
-// P1x, ...
-static int crossProduct(int32_t *points)
+// Helper function to divide rounding towards minus infinity, d > 0
+static int floorDiv(int n, int d)
 {
-  return ((points[X(1)] - points[X(0)]) * (points[Y(2)] - points[Y(0)])
-          - (points[Y(1)] - points[Y(0)]) * (points[X(2)] - points[X(0)]));
-}
+  int q = n / d;
 
-// Helper function to tell you if a point (x,y) lies within the triangle with
-// the verticies passed in in polyPoints. This assumes a clockwise definition
-// of the verticies in the array.
-static bool pointInTriangle(int x, int y, int32_t *polyPoints)
-{
-  int32_t points[3 * 2];
-
-  // Make sure we're on the right side of line AB
-  points[X(0)] = polyPoints[X(0)];
-  points[Y(0)] = polyPoints[Y(0)];
-  points[X(1)] = polyPoints[X(1)];
-  points[Y(1)] = polyPoints[Y(1)];
-  points[X(2)] = x;
-  points[Y(2)] = y;
-  if (crossProduct(points) < 0) {
-    return false;
-  }
-
-  // Make sure we're on the right side of line BC
-  points[X(0)] = polyPoints[X(1)];
-  points[Y(0)] = polyPoints[Y(1)];
-  points[X(1)] = polyPoints[X(2)];
-  points[Y(1)] = polyPoints[Y(2)];
-  if (crossProduct(points) < 0) {
-    return false;
+  if ((n % d != 0) && (n < 0)) {
+    q--;
   }
+  return q;
+}
 
-  // Make sure we're on the right side of line CA
-  points[X(0)] = polyPoints[X(2)];
-  points[Y(0)] = polyPoints[Y(2)];
-  points[X(1)] = polyPoints[X(0)];
-  points[Y(1)] = polyPoints[Y(0)];
-  if (crossProduct(points) < 0) {
+// Helper function to narrow [*start, *stop] on row y to the points on the
+// right side of the edge from (x0,y0) to (x1,y1), i.e. the points where the
+// cross product of the edge and the vector to the point is not negative.
+static bool edgeSpan(int y, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                     int *start, int *stop)
+{
+  // The cross product is a * x + b along the row
+  int a = y0 - y1;
+  int b = (x1 - x0) * (y - y0) + (y1 - y0) * x0;
+
+  if (a > 0) {
+    int first = -floorDiv(b, a);
+    if (first > *start) {
+      *start = first;
+    }
+  } else if (a < 0) {
+    int last = floorDiv(b, -a);
+    if (last < *stop) {
+      *stop = last;
+    }
+  } else if (b < 0) {
     return false;
   }
+  return *start <= *stop;
+}
 
-  return true;
+// Helper function to narrow [*start, *stop] on row y to the points within
+// the triangle with the verticies passed in in polyPoints. This assumes a
+// clockwise definition of the verticies in the array.
+static bool triangleSpan(int y, int32_t *polyPoints, int *start, int *stop)
+{
+  return edgeSpan(y, polyPoints[X(0)], polyPoints[Y(0)],
+                  polyPoints[X(1)], polyPoints[Y(1)], start, stop)
+         && edgeSpan(y, polyPoints[X(1)], polyPoints[Y(1)],
+                     polyPoints[X(2)], polyPoints[Y(2)], start, stop)
+         && edgeSpan(y, polyPoints[X(2)], polyPoints[Y(2)],
+                     polyPoints[X(0)], polyPoints[Y(0)], start, stop);
 }
 
 /**************************************************************************//**
@@ -35,6 +35,7 @@ void GRAPHICS_Wakeup(void);
 void GRAPHICS_Update(void);
 void GRAPHICS_AppendString(char *str);
 void GRAPHICS_Clear(void);
+void GRAPHICS_Home(void);
 void GRAPHICS_InsertTriangle(uint32_t x,
                              uint32_t y,
                              uint32_t size,
@@ -0,0 +1,267 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host benchmark of the glib primitives.
+ *******************************************************************************
+ *
+ * Runs glib, DMD and the LS013B7DH03 driver on the simulated display of
+ * displaypalhost.c. For lines, circles, filled polygons and strings it
+ * reports the drawing time per primitive and the SPI bytes one frame of
+ * such primitives costs once DMD_updateDisplay() sends it, and checks that
+ * the simulated display shows the framebuffer. See the Makefile in this
+ * directory for how to build and run it.
+ *
+ ******************************************************************************/
+
+#ifdef PAL_HOST
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "display.h"
+#include "displaypal.h"
+#include "dmd.h"
+#include "glib.h"
+
+/*******************************************************************************
+ ********************************  DEFINES  ************************************
+ ******************************************************************************/
+
+/* Shapes drawn per kind, cycled through BENCH_ROUNDS times */
+#define BENCH_SHAPES          (256)
+#define BENCH_ROUNDS          (200)
+
+/* Shapes per frame sent to the display */
+#define BENCH_FRAME_SHAPES    (8)
+#define BENCH_FRAMES          (64)
+
+#define BENCH_POLYGON_POINTS  (5)
+#define BENCH_STRING_LEN      (16)
+
+/*******************************************************************************
+ ********************************  STATICS  ************************************
+ ******************************************************************************/
+
+typedef struct {
+  int32_t x[2];
+  int32_t y[2];
+  int32_t r;
+  int32_t points[2 * BENCH_POLYGON_POINTS];
+  char    text[BENCH_STRING_LEN + 1];
+  bool    black;
+} BenchShape_t;
+
+typedef EMSTATUS (*BenchDraw_t)(GLIB_Context_t *pContext,
+                                const BenchShape_t *shape);
+
+typedef struct {
+  const char  *name;
+  BenchDraw_t draw;
+} BenchKind_t;
+
+static GLIB_Context_t context;
+static BenchShape_t   shapes[BENCH_SHAPES];
+static uint32_t       frameErrors;
+
+/*******************************************************************************
+ ************************   STATIC FUNCTION DEFINITIONS   **********************
+ ******************************************************************************/
+
+static uint64_t nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int32_t randomIn(int32_t min, int32_t max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/* Shapes reach a little past the display, so clipping is part of the cost */
+static void shapesInit(void)
+{
+  unsigned int i;
+  unsigned int j;
+
+  srand(1);
+  for (i = 0; i < BENCH_SHAPES; i++) {
+    BenchShape_t *s = &shapes[i];
+
+    for (j = 0; j < 2; j++) {
+      s->x[j] = randomIn(-16, DISPLAY0_WIDTH + 16);
+      s->y[j] = randomIn(-16, DISPLAY0_HEIGHT + 16);
+    }
+    s->r = randomIn(1, DISPLAY0_WIDTH / 4);
+    for (j = 0; j < 2 * BENCH_POLYGON_POINTS; j++) {
+      s->points[j] = randomIn(-16, DISPLAY0_WIDTH + 16);
+    }
+    for (j = 0; j < BENCH_STRING_LEN; j++) {
+      s->text[j] = (char)randomIn(' ', '~');
+    }
+    s->text[BENCH_STRING_LEN] = '\0';
+    s->black = rand() & 1;
+  }
+}
+
+static EMSTATUS drawLine(GLIB_Context_t *pContext, const BenchShape_t *s)
+{
+  return GLIB_drawLine(pContext, s->x[0], s->y[0], s->x[1], s->y[1]);
+}
+
+static EMSTATUS drawCircle(GLIB_Context_t *pContext, const BenchShape_t *s)
+{
+  return GLIB_drawCircle(pContext, s->x[0], s->y[0], s->r);
+}
+
+static EMSTATUS drawCircleFilled(GLIB_Context_t *pContext, const BenchShape_t *s)
+{
+  return GLIB_drawCircleFilled(pContext, s->x[0], s->y[0], s->r);
+}
+
+static EMSTATUS drawPolygonFilled(GLIB_Context_t *pContext, const BenchShape_t *s)
+{
+  return GLIB_drawPolygonFilled(pContext, BENCH_POLYGON_POINTS, s->points);
+}
+
+static EMSTATUS drawString(GLIB_Context_t *pContext, const BenchShape_t *s)
+{
+  return GLIB_drawString(pContext, s->text, BENCH_STRING_LEN,
+                         s->x[0], s->y[0], s->black);
+}
+
+static const BenchKind_t kinds[] = {
+  { "line",           drawLine },
+  { "circle",         drawCircle },
+  { "circle filled",  drawCircleFilled },
+  { "polygon filled", drawPolygonFilled },
+  { "string 16",      drawString },
+};
+
+static void clearDisplay(void)
+{
+  context.foregroundColor = Black;
+  context.backgroundColor = White;
+  GLIB_clear(&context);
+  DMD_updateDisplay();
+}
+
+static double drawTime(const BenchKind_t *kind)
+{
+  uint64_t     start;
+  unsigned int round;
+  unsigned int i;
+
+  start = nowNs();
+  for (round = 0; round < BENCH_ROUNDS; round++) {
+    for (i = 0; i < BENCH_SHAPES; i++) {
+      context.foregroundColor = shapes[i].black ? Black : White;
+      kind->draw(&context, &shapes[i]);
+    }
+  }
+
+  return (double)(nowNs() - start) / (BENCH_ROUNDS * BENCH_SHAPES);
+}
+
+static double frameBytes(const BenchKind_t *kind)
+{
+  PAL_HostStats_t stats;
+  uint64_t        bytes = 0;
+  unsigned int    frame;
+  unsigned int    i;
+
+  for (frame = 0; frame < BENCH_FRAMES; frame++) {
+    clearDisplay();
+    for (i = 0; i < BENCH_FRAME_SHAPES; i++) {
+      const BenchShape_t *s = &shapes[(frame * BENCH_FRAME_SHAPES + i) % BENCH_SHAPES];
+
+      context.foregroundColor = s->black ? Black : White;
+      kind->draw(&context, s);
+    }
+
+    PAL_HostStatsReset();
+    DMD_updateDisplay();
+    PAL_HostStatsGet(&stats);
+    bytes       += stats.spiBytes;
+    frameErrors += stats.errors;
+  }
+
+  return (double)bytes / BENCH_FRAMES;
+}
+
+/* Pixels where the simulated display differs from the framebuffer */
+static unsigned int displayMismatch(void)
+{
+  DISPLAY_Device_t device;
+  uint8_t          *frameBuffer;
+  unsigned int     mismatch = 0;
+  unsigned int     x;
+  unsigned int     y;
+  bool             white;
+
+  DISPLAY_DeviceGet(0, &device);
+  DMD_getFrameBuffer((void**) &frameBuffer);
+  for (y = 0; y < DISPLAY0_HEIGHT; y++) {
+    for (x = 0; x < DISPLAY0_WIDTH; x++) {
+      white = (frameBuffer[y * (device.geometry.stride / 8) + x / 8] >> (x & 0x7)) & 0x1;
+      if (white != PAL_HostPixelGet(x, y)) {
+        mismatch++;
+      }
+    }
+  }
+
+  return mismatch;
+}
+
+/*******************************************************************************
+ **************************     GLOBAL FUNCTIONS      **************************
+ ******************************************************************************/
+
+int main(void)
+{
+  PAL_HostStats_t stats;
+  unsigned int    i;
+  unsigned int    mismatch = 0;
+  double          full;
+
+  if ((DISPLAY_Init() != DISPLAY_EMSTATUS_OK) || (DMD_init(0) != DMD_OK)
+      || (GLIB_contextInit(&context) != GLIB_OK)) {
+    fprintf(stderr, "display init failed\n");
+    return 1;
+  }
+  GLIB_setFont(&context, (GLIB_Font_t *)&GLIB_FontNormal8x8);
+  shapesInit();
+
+  /* A frame with every line changed, for reference */
+  clearDisplay();
+  context.foregroundColor = Black;
+  GLIB_drawLineV(&context, 0, 0, DISPLAY0_HEIGHT - 1);
+  PAL_HostStatsReset();
+  DMD_updateDisplay();
+  PAL_HostStatsGet(&stats);
+  full = stats.spiBytes;
+
+  printf("%-16s %12s %14s  (%u per frame, full frame %.0f bytes)\n",
+         "primitive", "ns/primitive", "bytes/frame", BENCH_FRAME_SHAPES, full);
+  for (i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+    double ns    = drawTime(&kinds[i]);
+    double bytes = frameBytes(&kinds[i]);
+
+    mismatch += displayMismatch();
+    printf("%-16s %12.1f %14.1f\n", kinds[i].name, ns, bytes);
+  }
+
+  if (frameErrors != 0 || mismatch != 0) {
+    printf("FAILED: %u frame errors, %u pixels differ from the framebuffer\n",
+           (unsigned) frameErrors, mismatch);
+    return 1;
+  }
+
+  return 0;
+}
+
+#endif /* PAL_HOST */
@@ -0,0 +1,25 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host stand-in of the kit display configuration (SLSTK3402A,
+ *        Sharp LS013B7DH03 128x128), for the harness in this directory.
+ ******************************************************************************/
+
+#ifndef DISPLAYCONFIG_H
+#define DISPLAYCONFIG_H
+
+#include "displayconfigapp.h"
+
+#define INCLUDE_DISPLAY_SHARP_LS013B7DH03
+
+#define DISPLAY_DEVICES_MAX                 (1)
+
+#define DISPLAY0_WIDTH                      (128)
+#define DISPLAY0_HEIGHT                     (128)
+#define SHARP_MEMLCD_DEVICE_NAME            "Sharp LS013B7DH03 #1"
+
+#include "emstatus.h"
+EMSTATUS DISPLAY_Ls013b7dh03Init(void);
+#define DISPLAY_DEVICE_DRIVER_INIT_FUNCTIONS \
+  { DISPLAY_Ls013b7dh03Init, NULL }
+
+#endif /* DISPLAYCONFIG_H */
@@ -0,0 +1,11 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host stand-in of the Sharp LS013B7DH03 driver configuration.
+ ******************************************************************************/
+
+#ifndef DISPLAYLS013B7DH03CONFIG_H
+#define DISPLAYLS013B7DH03CONFIG_H
+
+#define LS013B7DH03_POLARITY_INVERSION_EXTCOMIN
+
+#endif /* DISPLAYLS013B7DH03CONFIG_H */
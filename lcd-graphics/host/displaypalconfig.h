@@ -0,0 +1,21 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host stand-in of the display PAL pin configuration. The simulated
+ *        display only looks at SCS, the numbers are those of the kit.
+ ******************************************************************************/
+
+#ifndef DISPLAYPALCONFIG_H
+#define DISPLAYPALCONFIG_H
+
+#define LCD_PORT_SCLK        (2)
+#define LCD_PIN_SCLK         (8)
+#define LCD_PORT_SI          (2)
+#define LCD_PIN_SI           (6)
+#define LCD_PORT_SCS         (3)
+#define LCD_PIN_SCS          (14)
+#define LCD_PORT_EXTCOMIN    (3)
+#define LCD_PIN_EXTCOMIN     (13)
+#define LCD_PORT_DISP_SEL    (3)
+#define LCD_PIN_DISP_SEL     (15)
+
+#endif /* DISPLAYPALCONFIG_H */
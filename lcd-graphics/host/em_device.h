@@ -0,0 +1,12 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host stand-in of the CMSIS device header, only what the display
+ *        driver and glib use.
+ ******************************************************************************/
+
+#ifndef EM_DEVICE_H
+#define EM_DEVICE_H
+
+#define __INLINE    inline
+
+#endif /* EM_DEVICE_H */
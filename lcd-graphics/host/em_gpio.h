@@ -0,0 +1,10 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host stand-in of the emlib GPIO header, the display driver only
+ *        reaches the GPIOs through the PAL.
+ ******************************************************************************/
+
+#ifndef EM_GPIO_H
+#define EM_GPIO_H
+
+#endif /* EM_GPIO_H */
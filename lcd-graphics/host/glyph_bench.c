@@ -0,0 +1,362 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check and benchmark of the glyph row drawing of GLIB_drawChar.
+ *******************************************************************************
+ *
+ * Draws random strings in all three fonts, opaque and transparent, in both
+ * colours and with random glib and DMD clipping, once with GLIB_drawString()
+ * and once with the pixel by pixel drawing GLIB_drawChar() did before it
+ * used DMD_writeGlyph(), kept below as refDrawChar(). The framebuffers, the
+ * return codes and the display lines sent by DMD_updateDisplay() must be
+ * identical. Then times a screen of text both ways. See the Makefile in
+ * this directory for how to build and run it.
+ *
+ ******************************************************************************/
+
+#ifdef PAL_HOST
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "display.h"
+#include "displaypal.h"
+#include "dmd.h"
+#include "glib.h"
+
+/*******************************************************************************
+ ********************************  DEFINES  ************************************
+ ******************************************************************************/
+
+#define CHECK_CASES         (20000)
+#define CHECK_STRING_MAX    (24)
+
+/* A screen of text is BENCH_LINES strings of BENCH_TEXT */
+#define BENCH_TEXT          "Throughput: 123 kbps"
+#define BENCH_LINES         (12)
+#define BENCH_SCREENS       (2000)
+
+/*******************************************************************************
+ ********************************  STATICS  ************************************
+ ******************************************************************************/
+
+typedef EMSTATUS (*DrawString_t)(GLIB_Context_t *pContext, const char* pString,
+                                 uint32_t sLength, int32_t x0, int32_t y0,
+                                 bool opaque);
+
+static const GLIB_Font_t *fonts[] = {
+  &GLIB_FontNormal8x8,
+  &GLIB_FontNarrow6x8,
+  &GLIB_FontNumber16x20,
+};
+
+static GLIB_Context_t context;
+static uint8_t        *frameBuffer;
+static unsigned int   frameStride;
+
+/* Pixels of the framebuffer, without the control bytes the DMD keeps at
+   the end of each line */
+static uint8_t        before[DISPLAY0_HEIGHT][DISPLAY0_WIDTH / 8];
+static uint8_t        after[DISPLAY0_HEIGHT][DISPLAY0_WIDTH / 8];
+static uint8_t        reference[DISPLAY0_HEIGHT][DISPLAY0_WIDTH / 8];
+
+/*******************************************************************************
+ ************************   STATIC FUNCTION DEFINITIONS   **********************
+ ******************************************************************************/
+
+/* GLIB_drawChar() as it was before DMD_writeGlyph(): every pixel through
+   GLIB_drawPixel() or GLIB_drawPixelColor() */
+static EMSTATUS refDrawChar(GLIB_Context_t *pContext, char myChar, int32_t x,
+                            int32_t y, bool opaque)
+{
+  EMSTATUS status;
+  uint16_t fontIdx;
+  uint8_t *pPixMap8;
+  uint16_t *pPixMap16;
+  uint32_t *pPixMap32;
+  uint16_t row;
+  uint16_t currentRow;
+  uint16_t xOffset;
+  uint32_t drawnElements = 0;
+
+  if ((myChar < ' ') || (myChar > '~')) {
+    return GLIB_ERROR_INVALID_CHAR;
+  }
+
+  if (pContext->font.class == NumbersOnlyFont) {
+    fontIdx = (myChar - '0');
+    if (myChar == ':') {
+      fontIdx = 10;
+    }
+    if (myChar == ' ') {
+      fontIdx = 11;
+    }
+  } else {
+    fontIdx = myChar - ' ';
+  }
+
+  if (fontIdx > (pContext->font.cntOfMapElements - 1)) {
+    return GLIB_ERROR_INVALID_CHAR;
+  }
+
+  pPixMap8 = (uint8_t *)pContext->font.pFontPixMap;
+  pPixMap16 = (uint16_t *)pContext->font.pFontPixMap;
+  pPixMap32 = (uint32_t *)pContext->font.pFontPixMap;
+
+  for (row = 0; row < pContext->font.fontHeight; row++) {
+    switch (pContext->font.sizeOfMapElement) {
+      case 1:
+        currentRow = pPixMap8[fontIdx];
+        break;
+
+      case 2:
+        currentRow = pPixMap16[fontIdx];
+        break;
+
+      default:
+        currentRow = pPixMap32[fontIdx];
+    }
+
+    for (xOffset = 0; xOffset < pContext->font.fontWidth; ++xOffset) {
+      if (currentRow & 0x1) {
+        status = GLIB_drawPixel(pContext, x + xOffset, y + row);
+        if (status > GLIB_ERROR_NOTHING_TO_DRAW) {
+          return status;
+        }
+        if (status == GLIB_OK) {
+          drawnElements++;
+        }
+      } else if (opaque) {
+        status = GLIB_drawPixelColor(pContext, x + xOffset, y + row, pContext->backgroundColor);
+        if (status > GLIB_ERROR_NOTHING_TO_DRAW) {
+          return status;
+        }
+        if (status == GLIB_OK) {
+          drawnElements++;
+        }
+      }
+      currentRow >>= 1;
+    }
+
+    for (; xOffset < pContext->font.fontWidth + pContext->font.charSpacing; ++xOffset) {
+      if (opaque) {
+        status = GLIB_drawPixelColor(pContext, x + xOffset, y + row, pContext->backgroundColor);
+        if (status > GLIB_ERROR_NOTHING_TO_DRAW) {
+          return status;
+        }
+        if (status == GLIB_OK) {
+          drawnElements++;
+        }
+      }
+    }
+
+    fontIdx += pContext->font.fontRowOffset;
+  }
+  return ((drawnElements == 0) ? GLIB_ERROR_NOTHING_TO_DRAW : GLIB_OK);
+}
+
+/* GLIB_drawString() on top of refDrawChar() */
+static EMSTATUS refDrawString(GLIB_Context_t *pContext, const char* pString,
+                              uint32_t sLength, int32_t x0, int32_t y0,
+                              bool opaque)
+{
+  EMSTATUS status;
+  uint32_t drawnElements = 0;
+  uint32_t stringIndex;
+  int32_t x = x0;
+  int32_t y = y0;
+
+  for (stringIndex = 0; stringIndex < sLength; stringIndex++) {
+    if (pString[stringIndex] == '\n') {
+      x = x0;
+      y = y + pContext->font.fontHeight + pContext->font.lineSpacing;
+      continue;
+    }
+
+    status = refDrawChar(pContext, pString[stringIndex], x, y, opaque);
+    if (status > GLIB_ERROR_NOTHING_TO_DRAW) {
+      return status;
+    }
+    if (status == GLIB_OK) {
+      drawnElements++;
+    }
+
+    x += (pContext->font.fontWidth + pContext->font.charSpacing);
+  }
+  return ((drawnElements == 0) ? GLIB_ERROR_NOTHING_TO_DRAW : GLIB_OK);
+}
+
+static void pixelsGet(uint8_t pixels[DISPLAY0_HEIGHT][DISPLAY0_WIDTH / 8])
+{
+  unsigned int y;
+
+  for (y = 0; y < DISPLAY0_HEIGHT; y++) {
+    memcpy(pixels[y], &frameBuffer[y * frameStride], DISPLAY0_WIDTH / 8);
+  }
+}
+
+static void pixelsSet(uint8_t pixels[DISPLAY0_HEIGHT][DISPLAY0_WIDTH / 8])
+{
+  unsigned int y;
+
+  for (y = 0; y < DISPLAY0_HEIGHT; y++) {
+    memcpy(&frameBuffer[y * frameStride], pixels[y], DISPLAY0_WIDTH / 8);
+  }
+}
+
+static int32_t randomIn(int32_t min, int32_t max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/* Draws the string and sends the frame, returns the lines sent */
+static uint32_t drawAndUpdate(DrawString_t draw, const char *text,
+                              uint32_t len, int32_t x, int32_t y,
+                              bool opaque, EMSTATUS *pStatus)
+{
+  PAL_HostStats_t stats;
+
+  *pStatus = draw(&context, text, len, x, y, opaque);
+  PAL_HostStatsReset();
+  DMD_updateDisplay();
+  PAL_HostStatsGet(&stats);
+
+  return (stats.errors != 0) ? UINT32_MAX : stats.lineUpdates;
+}
+
+static unsigned int checkCases(void)
+{
+  unsigned int failures = 0;
+  unsigned int n;
+
+  /* Start from a display that shows the framebuffer */
+  DMD_updateDisplay();
+
+  srand(1);
+  for (n = 0; n < CHECK_CASES; n++) {
+    const GLIB_Font_t *font = fonts[rand() % (sizeof(fonts) / sizeof(fonts[0]))];
+    char              text[CHECK_STRING_MAX];
+    uint32_t          len = randomIn(1, CHECK_STRING_MAX);
+    int32_t           x   = randomIn(-24, DISPLAY0_WIDTH + 8);
+    int32_t           y   = randomIn(-24, DISPLAY0_HEIGHT + 8);
+    bool              opaque = rand() & 1;
+    GLIB_Rectangle_t  clip;
+    EMSTATUS          newStatus;
+    EMSTATUS          refStatus;
+    uint32_t          newLines;
+    uint32_t          refLines;
+    uint32_t          i;
+
+    for (i = 0; i < len; i++) {
+      /* Mostly digits so the numbers font draws something, some newlines */
+      switch (rand() % 8) {
+        case 0:
+          text[i] = '\n';
+          break;
+        case 1:
+        case 2:
+          text[i] = (char)randomIn(' ', '~');
+          break;
+        default:
+          text[i] = (char)randomIn('0', ':');
+      }
+    }
+
+    GLIB_setFont(&context, (GLIB_Font_t *)font);
+    context.foregroundColor = (rand() & 1) ? Black : White;
+    context.backgroundColor = (context.foregroundColor == Black) ? White : Black;
+
+    /* Half the cases clipped by glib, a quarter by the DMD */
+    if (rand() & 1) {
+      clip.xMin = randomIn(0, DISPLAY0_WIDTH / 2);
+      clip.yMin = randomIn(0, DISPLAY0_HEIGHT / 2);
+      clip.xMax = randomIn(DISPLAY0_WIDTH / 2, DISPLAY0_WIDTH - 1);
+      clip.yMax = randomIn(DISPLAY0_HEIGHT / 2, DISPLAY0_HEIGHT - 1);
+      GLIB_setClippingRegion(&context, &clip);
+    } else {
+      GLIB_resetClippingRegion(&context);
+    }
+    if (rand() % 4 == 0) {
+      DMD_setClippingArea(randomIn(0, 40), randomIn(0, 40),
+                          randomIn(40, 88), randomIn(40, 88));
+    } else {
+      DMD_setClippingArea(0, 0, DISPLAY0_WIDTH, DISPLAY0_HEIGHT);
+    }
+
+    pixelsGet(before);
+    newLines = drawAndUpdate(GLIB_drawString, text, len, x, y, opaque, &newStatus);
+    pixelsGet(after);
+
+    pixelsSet(before);
+    refLines = drawAndUpdate(refDrawString, text, len, x, y, opaque, &refStatus);
+    pixelsGet(reference);
+
+    if ((newStatus != refStatus) || (newLines != refLines)
+        || (memcmp(after, reference, sizeof(after)) != 0)) {
+      if (failures++ < 10) {
+        printf("case %u: status %d/%d, lines %u/%u, framebuffer %s\n", n,
+               (int) newStatus, (int) refStatus, (unsigned) newLines,
+               (unsigned) refLines,
+               memcmp(after, reference, sizeof(after)) ? "differs" : "same");
+      }
+    }
+  }
+
+  GLIB_resetClippingRegion(&context);
+  DMD_setClippingArea(0, 0, DISPLAY0_WIDTH, DISPLAY0_HEIGHT);
+
+  return failures;
+}
+
+static double screenTime(DrawString_t draw)
+{
+  struct timespec start;
+  struct timespec end;
+  unsigned int    screen;
+  unsigned int    line;
+
+  GLIB_setFont(&context, (GLIB_Font_t *)&GLIB_FontNarrow6x8);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (screen = 0; screen < BENCH_SCREENS; screen++) {
+    for (line = 0; line < BENCH_LINES; line++) {
+      draw(&context, BENCH_TEXT, strlen(BENCH_TEXT), 0, line * 10, true);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec))
+         / BENCH_SCREENS / 1000.0;
+}
+
+/*******************************************************************************
+ **************************     GLOBAL FUNCTIONS      **************************
+ ******************************************************************************/
+
+int main(void)
+{
+  DISPLAY_Device_t device;
+  unsigned int     failures;
+
+  if ((DISPLAY_Init() != DISPLAY_EMSTATUS_OK) || (DMD_init(0) != DMD_OK)
+      || (GLIB_contextInit(&context) != GLIB_OK)) {
+    fprintf(stderr, "display init failed\n");
+    return 1;
+  }
+  DISPLAY_DeviceGet(0, &device);
+  DMD_getFrameBuffer((void **) &frameBuffer);
+  frameStride = device.geometry.stride / 8;
+
+  failures = checkCases();
+  printf("%u random strings, %u differ from the pixel by pixel drawing\n",
+         CHECK_CASES, failures);
+
+  printf("screen of %u x \"%s\": glyph rows %.2f us, pixel by pixel %.2f us\n",
+         BENCH_LINES, BENCH_TEXT, screenTime(GLIB_drawString),
+         screenTime(refDrawString));
+
+  return (failures == 0) ? 0 : 1;
+}
+
+#endif /* PAL_HOST */
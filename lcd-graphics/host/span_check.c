@@ -0,0 +1,508 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host check of the span drawing of lines, runs and the gauge triangle.
+ *******************************************************************************
+ *
+ * Draws random pixel runs, lines and gauge triangles, in both colours and
+ * with random glib and DMD clipping, once with the span drawing and once the
+ * way it was done pixel by pixel before:
+ *
+ * - GLIB_drawPixelSpan() against GLIB_drawPixel() for each pixel of the run
+ * - GLIB_drawLine() against refDrawLine(), the previous Bresenham loop with
+ *   one GLIB_drawPixel() per point
+ * - GRAPHICS_InsertTriangle() against refInsertTriangle(), which fills the
+ *   triangle by testing every pixel of the bounding box against its edges
+ *
+ * The framebuffer pixels and the return codes must be identical. Then times
+ * lines and triangles both ways. See the Makefile in this directory for how
+ * to build and run it.
+ *
+ ******************************************************************************/
+
+#ifdef PAL_HOST
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "display.h"
+#include "dmd.h"
+#include "glib.h"
+#include "graphics.h"
+
+/*******************************************************************************
+ ********************************  DEFINES  ************************************
+ ******************************************************************************/
+
+#define CHECK_CASES      (200000)
+
+#define BENCH_ROUNDS     (2000)
+#define BENCH_LINES      (64)
+
+/* Vertex access of a polyPoints array, as in graphics.c */
+#define X(index)         (2 * (index))
+#define Y(index)         (2 * (index) + 1)
+
+/*******************************************************************************
+ ********************************  STATICS  ************************************
+ ******************************************************************************/
+
+typedef enum {
+  CHECK_SPAN,
+  CHECK_LINE,
+  CHECK_TRIANGLE,
+  CHECK_KINDS
+} CheckKind_t;
+
+static const char *kindNames[CHECK_KINDS] = { "span", "line", "triangle" };
+
+/* Same defaults as the context graphics.c draws the triangle with */
+static GLIB_Context_t context;
+static uint8_t        *frameBuffer;
+static unsigned int   frameStride;
+
+/* Pixels of the framebuffer, without the control bytes the DMD keeps at
+   the end of each line */
+static uint8_t        before[DISPLAY0_HEIGHT][DISPLAY0_WIDTH / 8];
+static uint8_t        after[DISPLAY0_HEIGHT][DISPLAY0_WIDTH / 8];
+static uint8_t        reference[DISPLAY0_HEIGHT][DISPLAY0_WIDTH / 8];
+
+/*******************************************************************************
+ ************************   STATIC FUNCTION DEFINITIONS   **********************
+ ******************************************************************************/
+
+/* A run pixel by pixel, stopping at the first pixel the DMD rejects like
+   GLIB_drawPixelSpan() does */
+static EMSTATUS refDrawPixelRun(GLIB_Context_t *pContext, int32_t x, int32_t y,
+                                uint32_t length)
+{
+  EMSTATUS status;
+  int32_t  xEnd = x + (int32_t)length - 1;
+  uint32_t drawn = 0;
+
+  for (; x <= xEnd; x++) {
+    status = GLIB_drawPixel(pContext, x, y);
+    if (status > GLIB_ERROR_NOTHING_TO_DRAW) {
+      return status;
+    }
+    if (status == GLIB_OK) {
+      drawn++;
+    }
+  }
+  return (drawn == 0) ? GLIB_ERROR_NOTHING_TO_DRAW : GLIB_OK;
+}
+
+/* GLIB_getClipCode() and GLIB_clipLine() of glib_line.c */
+static uint8_t refClipCode(GLIB_Context_t *pContext, int32_t x, int32_t y)
+{
+  uint8_t code = 0;
+
+  if (x < pContext->clippingRegion.xMin) {
+    code |= 1;
+  }
+  if (x > pContext->clippingRegion.xMax) {
+    code |= 2;
+  }
+  if (y > pContext->clippingRegion.yMax) {
+    code |= 4;
+  }
+  if (y < pContext->clippingRegion.yMin) {
+    code |= 8;
+  }
+  return code;
+}
+
+static bool refClipLine(GLIB_Context_t *pContext, int32_t *pX1,
+                        int32_t *pY1, int32_t *pX2, int32_t *pY2)
+{
+  uint8_t currentCode, code1, code2;
+  int32_t x = 0, y = 0;
+
+  code1 = refClipCode(pContext, *pX1, *pY1);
+  code2 = refClipCode(pContext, *pX2, *pY2);
+
+  while (true) {
+    if ((code1 | code2) == 0) {
+      return true;
+    }
+    if (code1 & code2) {
+      return false;
+    }
+
+    currentCode = code1 ? code1 : code2;
+
+    if (currentCode & 1) {
+      y = *pY1 + ((*pY2 - *pY1) * (pContext->clippingRegion.xMin - *pX1)) / (*pX2 - *pX1);
+      x = pContext->clippingRegion.xMin;
+    } else if (currentCode & 2) {
+      x = pContext->clippingRegion.xMax;
+      y = *pY1 + ((*pY2 - *pY1) * (pContext->clippingRegion.xMax - *pX1)) / (*pX2 - *pX1);
+    } else if (currentCode & 4) {
+      y = pContext->clippingRegion.yMax;
+      x = *pX1 + ((*pX2 - *pX1) * (pContext->clippingRegion.yMax - *pY1)) / (*pY2 - *pY1);
+    } else if (currentCode & 8) {
+      y = pContext->clippingRegion.yMin;
+      x = *pX1 + ((*pX2 - *pX1) * (pContext->clippingRegion.yMin - *pY1)) / (*pY2 - *pY1);
+    }
+
+    if (code1) {
+      *pX1 = x;
+      *pY1 = y;
+      code1 = refClipCode(pContext, x, y);
+    } else {
+      *pX2 = x;
+      *pY2 = y;
+      code2 = refClipCode(pContext, x, y);
+    }
+  }
+}
+
+/* GLIB_drawLine() as it was before the spans: one pixel per point */
+static EMSTATUS refDrawLine(GLIB_Context_t *pContext, int32_t x1, int32_t y1,
+                            int32_t x2, int32_t y2)
+{
+  EMSTATUS status;
+  int32_t error;
+  int32_t deltaX;
+  int32_t deltaY;
+  int32_t yMotion;
+  int32_t xMotion;
+  bool steepLine = false;
+  int32_t yStep = 1;
+
+  if (x1 == x2) {
+    return GLIB_drawLineV(pContext, x1, y1, y2);
+  }
+  if (y1 == y2) {
+    return GLIB_drawLineH(pContext, x1, y1, x2);
+  }
+  if (!refClipLine(pContext, &x1, &y1, &x2, &y2)) {
+    return GLIB_ERROR_NOTHING_TO_DRAW;
+  }
+
+  yMotion = (y2 > y1) ? (y2 - y1) : (y1 - y2);
+  xMotion = (x2 > x1) ? (x2 - x1) : (x1 - x2);
+  if (yMotion > xMotion) {
+    steepLine = true;
+    error = x1;
+    x1    = y1;
+    y1    = error;
+    error = x2;
+    x2    = y2;
+    y2    = error;
+  }
+
+  if (x2 < x1) {
+    error = x1;
+    x1    = x2;
+    x2    = error;
+    error = y1;
+    y1    = y2;
+    y2    = error;
+  }
+
+  deltaX = x2 - x1;
+  deltaY = (y2 > y1) ? (y2 - y1) : (y1 - y2);
+  error = -deltaX / 2;
+  if (y2 < y1) {
+    yStep = -1;
+  }
+
+  for (; x1 <= x2; x1++) {
+    if (steepLine) {
+      status = GLIB_drawPixel(pContext, y1, x1);
+    } else {
+      status = GLIB_drawPixel(pContext, x1, y1);
+    }
+    if (status != GLIB_OK) {
+      return status;
+    }
+
+    error += deltaY;
+    if (error > 0) {
+      y1    += yStep;
+      error -= deltaX;
+    }
+  }
+
+  return GLIB_OK;
+}
+
+/* crossProduct() and pointInTriangle() of graphics.c before the spans */
+static int refCrossProduct(int32_t *points)
+{
+  return ((points[X(1)] - points[X(0)]) * (points[Y(2)] - points[Y(0)])
+          - (points[Y(1)] - points[Y(0)]) * (points[X(2)] - points[X(0)]));
+}
+
+static bool refPointInTriangle(int x, int y, int32_t *polyPoints)
+{
+  int32_t points[3 * 2];
+  int     edge;
+
+  points[X(2)] = x;
+  points[Y(2)] = y;
+  for (edge = 0; edge < 3; edge++) {
+    points[X(0)] = polyPoints[X(edge)];
+    points[Y(0)] = polyPoints[Y(edge)];
+    points[X(1)] = polyPoints[X((edge + 1) % 3)];
+    points[Y(1)] = polyPoints[Y((edge + 1) % 3)];
+    if (refCrossProduct(points) < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* GRAPHICS_InsertTriangle() as it was before the spans. The outline goes
+   through GLIB_drawPolygon() like there, its lines are checked on their own. */
+static void refInsertTriangle(uint32_t x, uint32_t y, uint32_t size, bool up,
+                              int8_t fillPercent)
+{
+  int32_t polyPoints[2 * 3];
+
+  if (up) {
+    polyPoints[X(0)] = x + size / 2;
+    polyPoints[Y(0)] = y;
+    polyPoints[X(1)] = x + size;
+    polyPoints[Y(1)] = y + size;
+    polyPoints[X(2)] = x;
+    polyPoints[Y(2)] = y + size;
+  } else {
+    polyPoints[X(0)] = x;
+    polyPoints[Y(0)] = y;
+    polyPoints[X(1)] = x + size;
+    polyPoints[Y(1)] = y;
+    polyPoints[X(2)] = x + size / 2;
+    polyPoints[Y(2)] = y + size;
+  }
+
+  GLIB_drawPolygon(&context, 3, polyPoints);
+
+  if ((fillPercent != 0) && (fillPercent >= -100) && (fillPercent <= 100)) {
+    int fillStartX = x;
+    int fillStopX  = fillStartX + size;
+    int fillStartY, fillStopY;
+
+    if (fillPercent < 0) {
+      fillPercent = -fillPercent;
+      fillStopY  = y + size;
+      fillStartY = fillStopY - (size * fillPercent) / 100;
+    } else {
+      fillStartY = y;
+      fillStopY  = y + (size * fillPercent) / 100;
+    }
+
+    for (int i = fillStartX; i < fillStopX; i++) {
+      for (int j = fillStartY; j < fillStopY; j++) {
+        if (refPointInTriangle(i, j, polyPoints)) {
+          GLIB_drawPixel(&context, i, j);
+        }
+      }
+    }
+  }
+}
+
+static void pixelsGet(uint8_t pixels[DISPLAY0_HEIGHT][DISPLAY0_WIDTH / 8])
+{
+  unsigned int y;
+
+  for (y = 0; y < DISPLAY0_HEIGHT; y++) {
+    memcpy(pixels[y], &frameBuffer[y * frameStride], DISPLAY0_WIDTH / 8);
+  }
+}
+
+static void pixelsSet(uint8_t pixels[DISPLAY0_HEIGHT][DISPLAY0_WIDTH / 8])
+{
+  unsigned int y;
+
+  for (y = 0; y < DISPLAY0_HEIGHT; y++) {
+    memcpy(&frameBuffer[y * frameStride], pixels[y], DISPLAY0_WIDTH / 8);
+  }
+}
+
+static int32_t randomIn(int32_t min, int32_t max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/* Random glib and DMD clipping, the triangle is drawn by graphics.c with
+   the whole display */
+static void clippingSet(CheckKind_t kind)
+{
+  GLIB_Rectangle_t clip;
+
+  if ((kind != CHECK_TRIANGLE) && (rand() & 1)) {
+    clip.xMin = randomIn(0, DISPLAY0_WIDTH / 2);
+    clip.yMin = randomIn(0, DISPLAY0_HEIGHT / 2);
+    clip.xMax = randomIn(DISPLAY0_WIDTH / 2, DISPLAY0_WIDTH - 1);
+    clip.yMax = randomIn(DISPLAY0_HEIGHT / 2, DISPLAY0_HEIGHT - 1);
+    GLIB_setClippingRegion(&context, &clip);
+  } else {
+    GLIB_resetClippingRegion(&context);
+  }
+
+  if ((kind != CHECK_TRIANGLE) && (rand() % 4 == 0)) {
+    DMD_setClippingArea(randomIn(0, 40), randomIn(0, 40),
+                        randomIn(40, 88), randomIn(40, 88));
+  } else {
+    DMD_setClippingArea(0, 0, DISPLAY0_WIDTH, DISPLAY0_HEIGHT);
+  }
+}
+
+static unsigned int checkCases(unsigned int failures[CHECK_KINDS])
+{
+  unsigned int n;
+  unsigned int total = 0;
+
+  srand(1);
+  for (n = 0; n < CHECK_CASES; n++) {
+    CheckKind_t kind = (CheckKind_t)(rand() % CHECK_KINDS);
+    EMSTATUS    newStatus = GLIB_OK;
+    EMSTATUS    refStatus = GLIB_OK;
+    int32_t     x1 = randomIn(-40, DISPLAY0_WIDTH + 40);
+    int32_t     y1 = randomIn(-40, DISPLAY0_HEIGHT + 40);
+    int32_t     x2 = randomIn(-40, DISPLAY0_WIDTH + 40);
+    int32_t     y2 = randomIn(-40, DISPLAY0_HEIGHT + 40);
+    uint32_t    size = randomIn(0, DISPLAY0_WIDTH / 2);
+    bool        up = rand() & 1;
+    int8_t      fill = (int8_t)randomIn(-110, 110);
+
+    /* The triangle is drawn in black by graphics.c */
+    context.foregroundColor = ((kind == CHECK_TRIANGLE) || (rand() & 1)) ? Black : White;
+    clippingSet(kind);
+
+    pixelsGet(before);
+    switch (kind) {
+      case CHECK_SPAN:
+        newStatus = GLIB_drawPixelSpan(&context, x1, y1, size);
+        break;
+      case CHECK_LINE:
+        newStatus = GLIB_drawLine(&context, x1, y1, x2, y2);
+        break;
+      default:
+        GRAPHICS_InsertTriangle(x1 & 0x7f, y1 & 0x7f, size, up, fill);
+    }
+    pixelsGet(after);
+
+    pixelsSet(before);
+    switch (kind) {
+      case CHECK_SPAN:
+        refStatus = refDrawPixelRun(&context, x1, y1, size);
+        break;
+      case CHECK_LINE:
+        refStatus = refDrawLine(&context, x1, y1, x2, y2);
+        break;
+      default:
+        refInsertTriangle(x1 & 0x7f, y1 & 0x7f, size, up, fill);
+    }
+    pixelsGet(reference);
+
+    if ((newStatus != refStatus)
+        || (memcmp(after, reference, sizeof(after)) != 0)) {
+      if (total++ < 10) {
+        printf("case %u %s: status %d/%d, framebuffer %s\n", n,
+               kindNames[kind], (int) newStatus, (int) refStatus,
+               memcmp(after, reference, sizeof(after)) ? "differs" : "same");
+      }
+      failures[kind]++;
+    }
+  }
+
+  GLIB_resetClippingRegion(&context);
+  DMD_setClippingArea(0, 0, DISPLAY0_WIDTH, DISPLAY0_HEIGHT);
+
+  return total;
+}
+
+static double nowUs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void benchLines(void)
+{
+  EMSTATUS     (*draw[2])(GLIB_Context_t*, int32_t, int32_t, int32_t, int32_t) = {
+    GLIB_drawLine, refDrawLine
+  };
+  double       us[2];
+  unsigned int way;
+  unsigned int round;
+  int32_t      k;
+
+  for (way = 0; way < 2; way++) {
+    us[way] = nowUs();
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+      for (k = 0; k < BENCH_LINES; k++) {
+        draw[way](&context, 0, k * 2, DISPLAY0_WIDTH - 1, DISPLAY0_HEIGHT - 1 - k * 2);
+      }
+    }
+    us[way] = (nowUs() - us[way]) / (BENCH_ROUNDS * BENCH_LINES);
+  }
+  printf("shallow line: spans %.2f us, pixel by pixel %.2f us\n", us[0], us[1]);
+}
+
+static void benchTriangles(void)
+{
+  double       us[2];
+  unsigned int round;
+
+  us[0] = nowUs();
+  for (round = 0; round < BENCH_ROUNDS; round++) {
+    GRAPHICS_InsertTriangle(64, 64, 60, round & 1, 100);
+  }
+  us[0] = (nowUs() - us[0]) / BENCH_ROUNDS;
+
+  us[1] = nowUs();
+  for (round = 0; round < BENCH_ROUNDS; round++) {
+    refInsertTriangle(64, 64, 60, round & 1, 100);
+  }
+  us[1] = (nowUs() - us[1]) / BENCH_ROUNDS;
+
+  printf("gauge triangle: spans %.2f us, pixel by pixel %.2f us\n", us[0], us[1]);
+}
+
+/*******************************************************************************
+ **************************     GLOBAL FUNCTIONS      **************************
+ ******************************************************************************/
+
+int main(void)
+{
+  DISPLAY_Device_t device;
+  unsigned int     failures[CHECK_KINDS] = { 0 };
+  unsigned int     total;
+  unsigned int     kind;
+
+  /* GRAPHICS_Init() brings up the display, DMD and its own glib context */
+  GRAPHICS_Init();
+  if (GLIB_contextInit(&context) != GLIB_OK) {
+    fprintf(stderr, "glib init failed\n");
+    return 1;
+  }
+  context.backgroundColor = White;
+  context.foregroundColor = Black;
+
+  DISPLAY_DeviceGet(0, &device);
+  DMD_getFrameBuffer((void **) &frameBuffer);
+  frameStride = device.geometry.stride / 8;
+
+  total = checkCases(failures);
+  printf("%u random cases, %u differ from the pixel by pixel drawing:",
+         CHECK_CASES, total);
+  for (kind = 0; kind < CHECK_KINDS; kind++) {
+    printf(" %s %u", kindNames[kind], failures[kind]);
+  }
+  printf("\n");
+
+  benchLines();
+  benchTriangles();
+
+  return (total == 0) ? 0 : 1;
+}
+
+#endif /* PAL_HOST */
@@ -234,6 +234,7 @@ void SX126X_LoRaRadio::handle_dio1_irq()
 
     if ((irq_status & IRQ_RX_DONE) == IRQ_RX_DONE) {
         if ((irq_status & IRQ_CRC_ERROR) == IRQ_CRC_ERROR) {
+            resume_rx_duty_cycle();
             if (_radio_events && _radio_events->rx_error) {
                 _radio_events->rx_error();
             }
@@ -248,6 +249,7 @@ void SX126X_LoRaRadio::handle_dio1_irq()
                 get_rx_buffer_status(&payload_len, &offset);
                 read_fifo(_data_buffer, payload_len, offset);
                 get_packet_status(&pkt_status);
+                resume_rx_duty_cycle();
                 if (pkt_status.modem_type == MODEM_FSK) {
                     rssi = pkt_status.params.gfsk.rssi_sync;
                 } else {
@@ -272,10 +274,23 @@ void SX126X_LoRaRadio::handle_dio1_irq()
             _radio_events->tx_timeout();
         } else if ((_radio_events && _radio_events->rx_timeout) && (_operation_mode == MODE_RX)) {
             _radio_events->rx_timeout();
+        } else if (_operation_mode == MODE_RX_DC) {
+            // a preamble without a frame, nothing to report
+            resume_rx_duty_cycle();
         }
     }
 }
 
+void SX126X_LoRaRadio::resume_rx_duty_cycle(void)
+{
+    // The radio leaves the duty cycle after a frame or after a detected
+    // preamble not followed by one, the preamble checks go on like a
+    // continuous reception would
+    if (_operation_mode == MODE_RX_DC) {
+        write_opmode_command(RADIO_SET_RXDUTYCYCLE, _rx_duty_cycle, 6);
+    }
+}
+
 void SX126X_LoRaRadio::set_device_ready(void)
 {
     if (_operation_mode == MODE_SLEEP) {
@@ -1007,6 +1022,49 @@ void SX126X_LoRaRadio::receive(void)
     _operation_mode = MODE_RX;
 }
 
+void SX126X_LoRaRadio::receive_duty_cycle(uint32_t rx_time, uint32_t sleep_time)
+{
+    uint32_t period[2] = {rx_time, sleep_time};
+
+    // Data-sheet 13.1.7 SetRxDutyCycle: RxPeriod and SleepPeriod, 24 bits
+    // each in steps of 15.625 us
+    for (int i = 0; i < 2; i++) {
+        uint64_t steps = ((uint64_t) period[i] * 64) / 1000;
+
+        if (steps > 0xFFFFFF) {
+            steps = 0xFFFFFF;
+        }
+        _rx_duty_cycle[3 * i] = (uint8_t) ((steps >> 16) & 0xFF);
+        _rx_duty_cycle[3 * i + 1] = (uint8_t) ((steps >> 8) & 0xFF);
+        _rx_duty_cycle[3 * i + 2] = (uint8_t) (steps & 0xFF);
+    }
+
+    if (get_modem() == MODEM_LORA) {
+        // On a detected preamble the radio restarts its timer with
+        // 2 * RxPeriod + SleepPeriod, which has to run until the header.
+        // No symbol timeout may cut the preamble check short either.
+        uint8_t stop_at_preamble = 0x00;
+        uint8_t symbols = 0;
+        write_opmode_command(RADIO_SET_STOPRXTIMERONPREAMBLE, &stop_at_preamble, 1);
+        write_opmode_command(RADIO_SET_LORASYMBTIMEOUT, &symbols, 1);
+    }
+
+    configure_dio_irq(IRQ_RX_DONE | IRQ_RX_TX_TIMEOUT | IRQ_CRC_ERROR ,
+                      IRQ_RX_DONE | IRQ_RX_TX_TIMEOUT | IRQ_CRC_ERROR ,
+                      IRQ_RADIO_NONE,
+                      IRQ_RADIO_NONE);
+    set_modulation_params(&_mod_params);
+    set_packet_params(&_packet_params);
+
+#if MBED_CONF_SX126X_LORA_DRIVER_BOOST_RX
+    write_to_register(REG_RX_GAIN, 0x96);
+#endif
+
+    write_opmode_command(RADIO_SET_RXDUTYCYCLE, _rx_duty_cycle, 6);
+
+    _operation_mode = MODE_RX_DC;
+}
+
 // check data-sheet 13.1.14.1 PA optimal settings
 void SX126X_LoRaRadio::set_tx_power(int8_t power)
 {
@@ -1229,6 +1287,12 @@ uint8_t SX126X_LoRaRadio::get_status(void)
     return 0xFF;
 }
 
+bool SX126X_LoRaRadio::is_active(void)
+{
+    return _operation_mode == MODE_TX || _operation_mode == MODE_RX
+           || _operation_mode == MODE_RX_DC || _operation_mode == MODE_CAD;
+}
+
 int8_t SX126X_LoRaRadio::get_rssi()
 {
     uint8_t buf[1];
@@ -183,6 +183,14 @@ public:
      */
     virtual void receive(void);
 
+    /**
+     * Sets the radio to receive duty cycle, see LoRaRadio
+     *
+     * Uses the preamble sniffing of the radio (data-sheet 13.1.7
+     * SetRxDutyCycle), the MCU is only woken up for a frame.
+     */
+    virtual void receive_duty_cycle(uint32_t rx_time, uint32_t sleep_time);
+
     /**
      *  Sets the carrier frequency
      *
@@ -210,6 +218,16 @@ public:
      */
     virtual uint8_t get_status(void);
 
+    /**
+     *  Check whether a transmission, reception or CAD is in progress
+     *
+     *  The end of the operation is signalled on DIO1, so the MCU may sleep
+     *  while the radio is active as long as the wakeup can be timestamped.
+     *
+     *  @return              true if the radio is in TX, RX or CAD mode
+     */
+    bool is_active(void);
+
     /**
      *  Sets the maximum payload length
      *
@@ -373,6 +391,7 @@ private:
     void configure_dio_irq(uint16_t irq_mask, uint16_t dio1_mask,
                            uint16_t dio2_mask, uint16_t dio3_mask);
     void cold_start_wakeup();
+    void resume_rx_duty_cycle(void);
 
 private:
     uint8_t _active_modem;
@@ -382,6 +401,7 @@ private:
     uint32_t _tx_timeout;
     uint32_t _rx_timeout;
     uint8_t _rx_timeout_in_symbols;
+    uint8_t _rx_duty_cycle[6];
     int8_t _tx_power;
     bool _image_calibrated;
     bool _force_image_calibration;
@@ -559,6 +559,25 @@ public:
      */
     virtual void receive(void) = 0;
 
+    /**
+     *  Sets the radio to duty-cycled reception.
+     *
+     *  Like the continuous reception configured with `set_rx_config()`, but
+     *  the receiver only checks for a preamble for `rx_time` and sleeps for
+     *  `sleep_time` in between. A detected frame is received in full and the
+     *  preamble checks resume after each reception. Radios without such a
+     *  mode receive continuously.
+     *
+     *  @param rx_time       The time the receiver checks for a preamble [us].
+     *  @param sleep_time    The time the receiver sleeps in between [us].
+     */
+    virtual void receive_duty_cycle(uint32_t rx_time, uint32_t sleep_time)
+    {
+        (void) rx_time;
+        (void) sleep_time;
+        receive();
+    }
+
     /**
      *  Sets the carrier frequency.
      *
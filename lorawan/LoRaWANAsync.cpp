@@ -0,0 +1,236 @@
+/**
+ * @file
+ *
+ * @brief      Stackless coroutines on top of LoRaWANInterface
+ *
+ * Copyright (c) 2017, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "LoRaWANAsync.h"
+#include "trace.h"
+#define TRACE_GROUP "LCOR"
+
+using namespace mbed;
+using namespace events;
+
+bool LoRaWANCo::co_send(uint8_t port, const uint8_t *data, uint16_t length, int flags)
+{
+    int16_t ret = _async->_lorawan.send(port, data, length, flags);
+    if (ret < 0) {
+        _result = ret;
+        return false;
+    }
+
+    _result = ret;
+    _wait = WAIT_TX;
+    return true;
+}
+
+bool LoRaWANCo::co_receive(uint8_t *data, uint16_t length, uint8_t *port)
+{
+    _rx_data = data;
+    _rx_length = length;
+    _rx_port = port;
+    _wait = WAIT_RX;
+    return true;
+}
+
+bool LoRaWANCo::co_join()
+{
+    if (_async->_connected) {
+        _result = LORAWAN_STATUS_OK;
+        return false;
+    }
+
+    lorawan_status_t ret = _async->_lorawan.connect();
+    if (ret == LORAWAN_STATUS_ALREADY_CONNECTED) {
+        _async->_connected = true;
+        _result = LORAWAN_STATUS_OK;
+        return false;
+    }
+
+    if (ret != LORAWAN_STATUS_OK && ret != LORAWAN_STATUS_CONNECT_IN_PROGRESS) {
+        _result = ret;
+        return false;
+    }
+
+    // ABP connects synchronously but still posts CONNECTED
+    _wait = WAIT_JOIN;
+    return true;
+}
+
+bool LoRaWANCo::co_sleep_until_tx_allowed()
+{
+    int backoff = -1;
+
+    _result = LORAWAN_STATUS_OK;
+    if (_async->_lorawan.get_backoff_metadata(backoff) != LORAWAN_STATUS_OK
+            || backoff <= 0) {
+        return false;
+    }
+
+    _timer_id = _async->_queue.call_in(backoff, _async, &LoRaWANAsync::on_timer, this);
+    if (!_timer_id) {
+        return false;
+    }
+
+    _wait = WAIT_TIMER;
+    return true;
+}
+
+LoRaWANAsync::LoRaWANAsync(LoRaWANInterface &lorawan, EventQueue &queue,
+                           Callback<void(lorawan_event_t)> events)
+    : _lorawan(lorawan),
+      _queue(queue),
+      _events(events),
+      _connected(false)
+{
+    memset(_frames, 0, sizeof(_frames));
+}
+
+LoRaWANCo *LoRaWANAsync::spawn(lorawan_co_fn fn, void *arg)
+{
+    for (uint8_t i = 0; i < MBED_CONF_LORA_CO_POOL_SIZE; i++) {
+        LoRaWANCo *co = &_frames[i];
+        if (co->_fn) {
+            continue;
+        }
+
+        memset(co, 0, sizeof(*co));
+        co->_async = this;
+        co->_fn = fn;
+        co->_arg = arg;
+        co->_wait = LoRaWANCo::WAIT_TIMER;
+
+        co->_timer_id = _queue.call(this, &LoRaWANAsync::on_timer, co);
+        if (!co->_timer_id) {
+            co->_fn = NULL;
+            return NULL;
+        }
+
+        return co;
+    }
+
+    tr_error("No free coroutine frame");
+    return NULL;
+}
+
+void LoRaWANAsync::kill(LoRaWANCo *co)
+{
+    // the frame may be handed out again before a pending timer would run
+    if (co->_timer_id) {
+        _queue.cancel(co->_timer_id);
+        co->_timer_id = 0;
+    }
+
+    co->_fn = NULL;
+    co->_wait = LoRaWANCo::WAIT_NONE;
+}
+
+uint8_t LoRaWANAsync::active() const
+{
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < MBED_CONF_LORA_CO_POOL_SIZE; i++) {
+        if (_frames[i]._fn) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+void LoRaWANAsync::resume(LoRaWANCo *co)
+{
+    co->_wait = LoRaWANCo::WAIT_NONE;
+    if (co->_fn(*co) == LORAWAN_CO_DONE) {
+        co->_fn = NULL;
+    }
+}
+
+void LoRaWANAsync::on_timer(LoRaWANCo *co)
+{
+    co->_timer_id = 0;
+    if (co->_fn && co->_wait == LoRaWANCo::WAIT_TIMER) {
+        resume(co);
+    }
+}
+
+void LoRaWANAsync::complete(uint8_t wait, lorawan_event_t event, int16_t result)
+{
+    for (uint8_t i = 0; i < MBED_CONF_LORA_CO_POOL_SIZE; i++) {
+        LoRaWANCo *co = &_frames[i];
+        if (!co->_fn || co->_wait != wait) {
+            continue;
+        }
+
+        co->_event = event;
+        if (wait == LoRaWANCo::WAIT_RX && event == RX_DONE) {
+            int flags = 0;
+            result = _lorawan.receive(co->_rx_data, co->_rx_length,
+                                      *co->_rx_port, flags);
+            co->_result = result;
+            resume(co);
+            // the stack holds a single downlink, only one receiver gets it
+            return;
+        }
+
+        // a successful send keeps the byte count returned by send()
+        if (event != TX_DONE) {
+            co->_result = result;
+        }
+
+        resume(co);
+    }
+}
+
+void LoRaWANAsync::handle_event(lorawan_event_t event)
+{
+    switch (event) {
+        case CONNECTED:
+            _connected = true;
+            complete(LoRaWANCo::WAIT_JOIN, event, LORAWAN_STATUS_OK);
+            break;
+        case JOIN_FAILURE:
+            complete(LoRaWANCo::WAIT_JOIN, event, LORAWAN_STATUS_NO_NETWORK_JOINED);
+            break;
+        case DISCONNECTED:
+            _connected = false;
+            break;
+        case TX_DONE:
+            complete(LoRaWANCo::WAIT_TX, event, LORAWAN_STATUS_OK);
+            break;
+        case TX_TIMEOUT:
+        case TX_ERROR:
+        case CRYPTO_ERROR:
+        case TX_SCHEDULING_ERROR:
+            complete(LoRaWANCo::WAIT_TX, event, LORAWAN_STATUS_NO_OP);
+            break;
+        case RX_DONE:
+            complete(LoRaWANCo::WAIT_RX, event, LORAWAN_STATUS_OK);
+            break;
+        case RX_TIMEOUT:
+        case RX_ERROR:
+            complete(LoRaWANCo::WAIT_RX, event, LORAWAN_STATUS_NO_OP);
+            break;
+        default:
+            break;
+    }
+
+    if (_events) {
+        _events(event);
+    }
+}
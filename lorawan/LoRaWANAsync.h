@@ -0,0 +1,267 @@
+/**
+ * Copyright (c) 2017, Arm Limited and affiliates.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @addtogroup LoRaWAN
+ * Mbed OS LoRaWAN Stack
+ *  @{
+ */
+
+#ifndef LORAWANASYNC_H_
+#define LORAWANASYNC_H_
+
+#include "../events/EventQueue.h"
+#include "LoRaWANInterface.h"
+#include "lorawan_types.h"
+
+#ifndef MBED_CONF_LORA_CO_POOL_SIZE
+#define MBED_CONF_LORA_CO_POOL_SIZE 2
+#endif
+
+#ifndef MBED_CONF_LORA_CO_FRAME_SIZE
+#define MBED_CONF_LORA_CO_FRAME_SIZE 32
+#endif
+
+class LoRaWANAsync;
+class LoRaWANCo;
+
+/** Coroutine body
+ *
+ * Called every time the coroutine is resumed. Must start with CO_BEGIN and
+ * end with CO_END. Local variables do not survive a CO_AWAIT, state that
+ * must be kept across suspension points belongs in LoRaWANCo::locals().
+ */
+typedef int (*lorawan_co_fn)(LoRaWANCo &co);
+
+/** Return values of a coroutine body, produced by the CO_ macros */
+enum lorawan_co_state {
+    LORAWAN_CO_DONE = 0,
+    LORAWAN_CO_SUSPENDED,
+};
+
+/** Start of a coroutine body */
+#define CO_BEGIN(co)        switch ((co).line) { case 0:
+
+/** Suspend the coroutine until the awaitable op completes
+ *
+ * op is one of the LoRaWANCo::co_ calls. Once the coroutine resumes, the
+ * outcome of the operation is available from LoRaWANCo::result().
+ */
+#define CO_AWAIT(co, op)                                    \
+    do {                                                    \
+        (co).line = __LINE__;                               \
+        if (op) {                                           \
+            return LORAWAN_CO_SUSPENDED;                    \
+        }                                                   \
+        case __LINE__:;                                     \
+    } while (0)
+
+/** End of a coroutine body */
+#define CO_END(co)          } (co).line = 0; return LORAWAN_CO_DONE
+
+/** LoRaWANCo Class
+ * Stackless coroutine frame
+ *
+ * Frames are handed out by LoRaWANAsync::spawn from a fixed pool, no
+ * memory is allocated at runtime. All coroutines run in the context of the
+ * event queue dispatching the LoRaWAN stack, so they need no stack of
+ * their own and no locking against the stack.
+ */
+class LoRaWANCo {
+public:
+    /** Resume point, managed by the CO_ macros */
+    uint16_t line;
+
+    /** Outcome of the last awaited operation
+     *
+     * @return              Number of bytes sent or received for co_send and
+     *                      co_receive, LORAWAN_STATUS_OK for co_join and
+     *                      co_sleep_until_tx_allowed, or a negative
+     *                      lorawan_status_t. Operations ended by an error
+     *                      event return LORAWAN_STATUS_NO_OP, or
+     *                      LORAWAN_STATUS_NO_NETWORK_JOINED for a failed
+     *                      join; event() tells which one.
+     */
+    int16_t result() const
+    {
+        return _result;
+    }
+
+    /** Stack event that completed the last awaited operation */
+    lorawan_event_t event() const
+    {
+        return (lorawan_event_t)_event;
+    }
+
+    /** Argument passed to LoRaWANAsync::spawn */
+    void *arg() const
+    {
+        return _arg;
+    }
+
+    /** State that survives suspension points
+     *
+     * The storage is zeroed when the coroutine is spawned.
+     */
+    template <typename T>
+    T &locals()
+    {
+        static_assert(sizeof(T) <= MBED_CONF_LORA_CO_FRAME_SIZE,
+                      "coroutine locals exceed MBED_CONF_LORA_CO_FRAME_SIZE");
+        return *reinterpret_cast<T *>(_locals);
+    }
+
+    /** Send a message and wait for the outcome
+     *
+     * Completes on TX_DONE with the number of bytes sent or on a TX error
+     * event. If the stack cannot accept the message, completes immediately
+     * with the error, LORAWAN_STATUS_WOULD_BLOCK in particular if an
+     * earlier transmission is still in progress.
+     *
+     * @return true if the coroutine must suspend, use with CO_AWAIT
+     */
+    bool co_send(uint8_t port, const uint8_t *data, uint16_t length, int flags);
+
+    /** Wait for a downlink and copy it into data
+     *
+     * Completes on RX_DONE with the number of bytes received, or on
+     * RX_TIMEOUT / RX_ERROR.
+     *
+     * @param port  receives the port the message arrived on
+     * @return true if the coroutine must suspend, use with CO_AWAIT
+     */
+    bool co_receive(uint8_t *data, uint16_t length, uint8_t *port);
+
+    /** Join the network and wait for the outcome
+     *
+     * Completes on CONNECTED or JOIN_FAILURE. Completes immediately if the
+     * device is already connected or connect() fails.
+     *
+     * @return true if the coroutine must suspend, use with CO_AWAIT
+     */
+    bool co_join();
+
+    /** Wait until the duty-cycle backoff of the stack has expired
+     *
+     * @return true if the coroutine must suspend, use with CO_AWAIT
+     */
+    bool co_sleep_until_tx_allowed();
+
+private:
+    friend class LoRaWANAsync;
+
+    enum wait_t {
+        WAIT_NONE,
+        WAIT_TX,
+        WAIT_RX,
+        WAIT_JOIN,
+        WAIT_TIMER,
+    };
+
+    LoRaWANAsync *_async;
+    lorawan_co_fn _fn;
+    void *_arg;
+    uint8_t _wait;
+    uint8_t _event;
+    int16_t _result;
+
+    // pending on_timer event, cancelled by LoRaWANAsync::kill
+    int _timer_id;
+
+    uint8_t *_rx_data;
+    uint16_t _rx_length;
+    uint8_t *_rx_port;
+
+    union {
+        uint32_t _align;
+        uint8_t _locals[MBED_CONF_LORA_CO_FRAME_SIZE];
+    };
+};
+
+/** LoRaWANAsync Class
+ * Runs stackless coroutines on top of LoRaWANInterface
+ *
+ * The application forwards the stack events to handle_event(), which
+ * resumes the coroutine waiting for them:
+ *
+ * @code
+ *     static int sender(LoRaWANCo &co)
+ *     {
+ *         CO_BEGIN(co);
+ *         CO_AWAIT(co, co.co_join());
+ *         while (co.result() == LORAWAN_STATUS_OK || co.result() > 0) {
+ *             CO_AWAIT(co, co.co_sleep_until_tx_allowed());
+ *             CO_AWAIT(co, co.co_send(15, payload, sizeof(payload),
+ *                                     MSG_UNCONFIRMED_FLAG));
+ *         }
+ *         CO_END(co);
+ *     }
+ *
+ *     callbacks.events = mbed::callback(&async, &LoRaWANAsync::handle_event);
+ *     lorawan.add_app_callbacks(&callbacks);
+ *     async.spawn(sender);
+ *     ev_queue.dispatch_forever();
+ * @endcode
+ */
+class LoRaWANAsync {
+public:
+    /** Constructs the coroutine layer
+     *
+     * @param lorawan   Initialized LoRaWANInterface
+     * @param queue     Event queue the LoRaWAN stack dispatches on
+     * @param events    Optional handler receiving every stack event after
+     *                  the waiting coroutines have been resumed
+     */
+    LoRaWANAsync(LoRaWANInterface &lorawan, events::EventQueue &queue,
+                 mbed::Callback<void(lorawan_event_t)> events = NULL);
+
+    /** Start a coroutine
+     *
+     * The coroutine body runs for the first time from the event queue.
+     *
+     * @return The coroutine frame, or NULL if all frames are in use
+     */
+    LoRaWANCo *spawn(lorawan_co_fn fn, void *arg = NULL);
+
+    /** Stop a coroutine and release its frame, cancelling a pending sleep */
+    void kill(LoRaWANCo *co);
+
+    /** Number of coroutines currently running */
+    uint8_t active() const;
+
+    /** Stack event handler
+     *
+     * Install as lorawan_app_callbacks_t::events.
+     */
+    void handle_event(lorawan_event_t event);
+
+private:
+    friend class LoRaWANCo;
+
+    void resume(LoRaWANCo *co);
+    void complete(uint8_t wait, lorawan_event_t event, int16_t result);
+    void on_timer(LoRaWANCo *co);
+
+    LoRaWANInterface &_lorawan;
+    events::EventQueue &_queue;
+    mbed::Callback<void(lorawan_event_t)> _events;
+    bool _connected;
+
+    LoRaWANCo _frames[MBED_CONF_LORA_CO_POOL_SIZE];
+};
+
+#endif /* LORAWANASYNC_H_ */
+/** @}*/
@@ -66,6 +66,21 @@ lorawan_status_t LoRaWANInterface::connect(const lorawan_connect_t &connect)
     return _lw_stack.connect(connect);
 }
 
+lorawan_status_t LoRaWANInterface::restore_session(const lorawan_session_params_t &session,
+                                                   uint32_t ul_frame_counter,
+                                                   uint32_t dl_frame_counter)
+{
+    Lock lock(*this);
+    return _lw_stack.restore_session(session, ul_frame_counter, dl_frame_counter);
+}
+
+lorawan_status_t LoRaWANInterface::set_join_state(const lorawan_join_params_t &params,
+                                                  uint16_t dev_nonce)
+{
+    Lock lock(*this);
+    return _lw_stack.set_join_state(params, dev_nonce);
+}
+
 lorawan_status_t LoRaWANInterface::disconnect()
 {
     Lock lock(*this);
@@ -96,6 +111,12 @@ lorawan_status_t LoRaWANInterface::set_confirmed_msg_retries(uint8_t count)
     return _lw_stack.set_confirmed_msg_retry(count);
 }
 
+lorawan_status_t LoRaWANInterface::set_retry_policy(const lorawan_retry_policy_t &policy)
+{
+    Lock lock(*this);
+    return _lw_stack.set_retry_policy(policy);
+}
+
 lorawan_status_t LoRaWANInterface::enable_adaptive_datarate()
 {
     Lock lock(*this);
@@ -162,6 +183,18 @@ lorawan_status_t LoRaWANInterface::get_backoff_metadata(int &backoff)
     return _lw_stack.acquire_backoff_metadata(backoff);
 }
 
+lorawan_status_t LoRaWANInterface::get_rx_sniff_metadata(lorawan_rx_sniff_metadata &metadata)
+{
+    Lock lock(*this);
+    return _lw_stack.acquire_rx_sniff_metadata(metadata);
+}
+
+uint8_t LoRaWANInterface::get_max_possible_tx_size()
+{
+    Lock lock(*this);
+    return _lw_stack.get_max_possible_tx_size();
+}
+
 int16_t LoRaWANInterface::receive(uint8_t port, uint8_t *data, uint16_t length, int flags)
 {
     Lock lock(*this);
@@ -185,3 +218,27 @@ lorawan_status_t LoRaWANInterface::set_device_class(const device_class_t device_
     Lock lock(*this);
     return _lw_stack.set_device_class(device_class);
 }
+
+lorawan_status_t LoRaWANInterface::enable_beacon_acquisition()
+{
+    Lock lock(*this);
+    return _lw_stack.enable_beacon_acquisition();
+}
+
+lorawan_status_t LoRaWANInterface::add_device_time_request()
+{
+    Lock lock(*this);
+    return _lw_stack.add_device_time_request();
+}
+
+lorawan_status_t LoRaWANInterface::add_ping_slot_info_request(uint8_t periodicity)
+{
+    Lock lock(*this);
+    return _lw_stack.add_ping_slot_info_request(periodicity);
+}
+
+lorawan_status_t LoRaWANInterface::get_last_beacon(lorawan_beacon_t &beacon)
+{
+    Lock lock(*this);
+    return _lw_stack.acquire_last_beacon(beacon);
+}
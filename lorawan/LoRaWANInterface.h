@@ -90,8 +90,9 @@ public:
      * relaxed as compared to the Join (default) channels only.
      *
      * **NOTES ON RECONNECTION:**
-     * Currently, the Mbed OS LoRaWAN implementation does not support non-volatile memory storage.
-     * Therefore, the state and frame counters cannot be restored after a power cycle. However,
+     * The stack itself does not use non-volatile memory storage. The application can keep the
+     * session handed out by the 'session' callback and bring it back with restore_session()
+     * after a power cycle. However,
      * if you use the `disconnect()` API to shut down the LoRaWAN protocol, the state and frame
      * counters are saved. Connecting again restores the previous session. According to the LoRaWAN
      * 1.0.2 specification, the frame counters are always reset to 0 for OTAA, and a new Join request
@@ -133,8 +134,9 @@ public:
      * duty cycle becomes much more relaxed as compared to the Join (default) channels only.
      *
      * **NOTES ON RECONNECTION:**
-     * Currently, the Mbed OS LoRaWAN implementation does not support non-volatile memory storage.
-     * Therefore, the state and frame counters cannot be restored after a power cycle. However,
+     * The stack itself does not use non-volatile memory storage. The application can keep the
+     * session handed out by the 'session' callback and bring it back with restore_session()
+     * after a power cycle. However,
      * if you use the `disconnect()` API to shut down the LoRaWAN protocol, the state and frame
      * counters are saved. Connecting again restores the previous session. According to the LoRaWAN
      * 1.0.2 specification, the frame counters are always reset to zero for OTAA, and a new Join
@@ -160,6 +162,42 @@ public:
      */
     lorawan_status_t connect(const lorawan_connect_t &connect);
 
+    /** Connect with a session kept from before a reset.
+     *
+     * Takes over a session the 'session' callback handed out, e.g. stored in non-volatile
+     * memory, and connects without a join, the way connect() does for ABP. The uplink frame
+     * counter must not be lower than any counter the session has used on air.
+     *
+     * @param session           session parameters from the 'session' callback
+     * @param ul_frame_counter  uplink frame counter to continue with
+     * @param dl_frame_counter  last downlink frame counter
+     *
+     * @return    LORAWAN_STATUS_OK followed by a 'CONNECTED' event,
+     *            LORAWAN_STATUS_NOT_INITIALIZED   if system is not initialized with initialize(),
+     *            LORAWAN_STATUS_PARAMETER_INVALID if the session does not fit the PHY in use,
+     *            LORAWAN_STATUS_BUSY or LORAWAN_STATUS_ALREADY_CONNECTED as for connect().
+     */
+    lorawan_status_t restore_session(const lorawan_session_params_t &session,
+                                     uint32_t ul_frame_counter,
+                                     uint32_t dl_frame_counter);
+
+    /** Set the join state kept from before a reset.
+     *
+     * Takes over the state the 'join' callback handed out, e.g. stored in non-volatile
+     * memory, before connect() joins. The next join starts on the channel and datarate
+     * that got the last join-accept, and the DevNonce counts up from the given value. The
+     * network server drops join requests with a DevNonce it has seen, so the value must
+     * not be lower than any DevNonce used on air.
+     *
+     * @param params     join parameters from the 'join' callback
+     * @param dev_nonce  DevNonce of the next join request
+     *
+     * @return    LORAWAN_STATUS_OK on success,
+     *            LORAWAN_STATUS_NOT_INITIALIZED if system is not initialized with initialize(),
+     *            LORAWAN_STATUS_BUSY            while a join is underway.
+     */
+    lorawan_status_t set_join_state(const lorawan_join_params_t &params, uint16_t dev_nonce);
+
     /** Disconnect the current session.
      *
      * @return         LORAWAN_STATUS_DEVICE_OFF on success, a negative error code on failure:
@@ -251,6 +289,27 @@ public:
      */
     lorawan_status_t set_confirmed_msg_retries(uint8_t count);
 
+    /** Sets the retransmission policy for confirmed messages.
+     *
+     * By default a confirmed message is retransmitted ACK_TIMEOUT after its receive windows,
+     * up to the count set with set_confirmed_msg_retries(). The policy adds a wait that grows
+     * with every retransmission, exponentially, at random or as a callback decides, and caps
+     * the time on air a message may take up. The retransmissions go out on a new channel as
+     * usual. The time on air a message took up is in the 'airtime' field of
+     * lorawan_tx_metadata.
+     *
+     * With latest_value_wins set, send() does not return LORAWAN_STATUS_WOULD_BLOCK while the
+     * previous message waits for its retransmission or for the duty cycle. The previous message
+     * is dropped in favour of the new one, without a TX_DONE or TX_ERROR event.
+     *
+     * @param policy    The retransmission policy.
+     *
+     * @return          LORAWAN_STATUS_OK or a negative error code on failure:
+     *                  LORAWAN_STATUS_NOT_INITIALIZED   if system is not initialized with initialize()
+     *                  LORAWAN_STATUS_PARAMETER_INVALID if a custom backoff lacks its callback
+     */
+    lorawan_status_t set_retry_policy(const lorawan_retry_policy_t &policy);
+
     /** Sets the channel plan.
      *
      * You can provide a list of channels with appropriate parameters filled in. However,
@@ -459,16 +518,74 @@ public:
 
     /** Change device class
      *
-     * Change current device class.
+     * Change current device class. Class B needs the beacon to be tracked, see
+     * enable_beacon_acquisition(). The device falls back to Class A when the beacon
+     * is lost (BEACON_LOST event).
      *
      * @param    device_class   The device class
      *
      * @return              LORAWAN_STATUS_OK on success or other negative error code if request failed:
      *                      LORAWAN_STATUS_NOT_INITIALIZED if system is not initialized with initialize(),
-     *                      LORAWAN_STATUS_UNSUPPORTED if requested class is not supported
+     *                      LORAWAN_STATUS_UNSUPPORTED if requested class is not supported,
+     *                      LORAWAN_STATUS_NO_BEACON_FOUND if Class B is requested while no beacon is tracked
      */
     lorawan_status_t set_device_class(device_class_t device_class);
 
+    /** Start looking for the Class B beacon
+     *
+     * If the network time is known, see add_device_time_request(), the receiver opens
+     * a window at the next beacon only. Otherwise it receives for up to a whole beacon
+     * period (128 s). The outcome is reported with the BEACON_FOUND or BEACON_NOT_FOUND
+     * event. Once found, the beacon is tracked with a window every beacon period, which
+     * also measures the drift of the local clock, and missed beacons are reported with
+     * BEACON_MISSED. Ping slots continue without the beacon for up to two hours.
+     *
+     * The device has to be joined and in Class A.
+     *
+     * @return              LORAWAN_STATUS_OK if the acquisition started or other negative error code:
+     *                      LORAWAN_STATUS_NOT_INITIALIZED if system is not initialized with initialize(),
+     *                      LORAWAN_STATUS_NO_NETWORK_JOINED if the device is not joined,
+     *                      LORAWAN_STATUS_UNSUPPORTED in Class C or in a region without Class B,
+     *                      LORAWAN_STATUS_BUSY if the beacon is already acquired or tracked
+     */
+    lorawan_status_t enable_beacon_acquisition();
+
+    /** Ask the network server for the network time
+     *
+     * Adds a DeviceTimeReq MAC command to the next uplink. The answer is reported with
+     * the DEVICE_TIME_SYNCHED event and shortens the beacon acquisition to a single window.
+     *
+     * @return              LORAWAN_STATUS_OK on successfully queuing a request, or
+     *                      a negative error code on failure.
+     */
+    lorawan_status_t add_device_time_request();
+
+    /** Tell the network server the Class B ping slot periodicity
+     *
+     * Adds a PingSlotInfoReq MAC command to the next uplink. The device opens a ping slot
+     * every 2^periodicity seconds once the answer is reported with the PING_SLOT_INFO_SYNCHED
+     * event, every 128 s until then.
+     *
+     * @param    periodicity    0..7
+     *
+     * @return              LORAWAN_STATUS_OK on successfully queuing a request, or
+     *                      a negative error code on failure:
+     *                      LORAWAN_STATUS_PARAMETER_INVALID if periodicity is out of range,
+     *                      LORAWAN_STATUS_UNSUPPORTED in a region without Class B
+     */
+    lorawan_status_t add_ping_slot_info_request(uint8_t periodicity);
+
+    /** Get hold of the last beacon received
+     *
+     * @param    beacon     the inbound structure that will be filled if a beacon was received.
+     *
+     * @return              LORAWAN_STATUS_OK if a beacon was received,
+     *                      otherwise other negative error code if request failed:
+     *                      LORAWAN_STATUS_NOT_INITIALIZED if system is not initialized with initialize(),
+     *                      LORAWAN_STATUS_METADATA_NOT_AVAILABLE if no beacon was received
+     */
+    lorawan_status_t get_last_beacon(lorawan_beacon_t &beacon);
+
     /** Get hold of TX meta-data
      *
      * Use this method to acquire any TX meta-data related to previous transmission.
@@ -518,6 +635,31 @@ public:
      */
     lorawan_status_t get_backoff_metadata(int &backoff);
 
+    /** Get hold of Class C reception meta-data
+     *
+     * In Class C the receiver checks for a downlink preamble and sleeps in between,
+     * instead of listening all the time, where the preamble is long enough for it
+     * at the RX2 datarate (lora.class-c-sniff-preamble-length). Use this method to
+     * see how much of the Class C time the receiver was actually on.
+     *
+     * @param    metadata   the inbound structure that will be filled with the meta-data.
+     *
+     * @return              LORAWAN_STATUS_OK if successful, otherwise
+     *                      LORAWAN_STATUS_NOT_INITIALIZED if system is not initialized with initialize()
+     */
+    lorawan_status_t get_rx_sniff_metadata(lorawan_rx_sniff_metadata &metadata);
+
+    /** Get the maximum payload size of the next uplink
+     *
+     * The size depends on the datarate the next uplink goes out on, including an ADR
+     * step, and shrinks by the MAC commands that will be piggybacked on it. Payloads
+     * longer than this are split by send() and completed over several uplinks.
+     *
+     * @return              maximum application payload in bytes, 0 if the system is
+     *                      not initialized with initialize()
+     */
+    uint8_t get_max_possible_tx_size();
+
     /** Cancel outgoing transmission
      *
      * This API is used to cancel any outstanding transmission in the TX pipe.
@@ -70,11 +70,14 @@ LoRaWANStack::LoRaWANStack()
       _rx_metadata(),
       _num_retry(1),
       _qos_cnt(1),
+      _latest_value_wins(false),
       _ctrl_flags(IDLE_FLAG),
       _app_port(INVALID_PORT),
       _link_check_requested(false),
       _automatic_uplink_ongoing(false),
-      _queue(NULL)
+      _queue(NULL),
+      _tx_timestamp(0),
+      _rx_timestamp(0)
 {
     _tx_metadata.stale = true;
     _rx_metadata.stale = true;
@@ -116,6 +119,7 @@ lorawan_status_t LoRaWANStack::initialize_mac_layer(EventQueue *queue)
 
     tr_debug("Initializing MAC layer");
     _queue = queue;
+    _loramac.set_class_b_event_callback(mbed::callback(this, &LoRaWANStack::send_event_to_application));
 
     return state_controller(DEVICE_STATE_IDLE);
 }
@@ -141,6 +145,19 @@ lorawan_status_t LoRaWANStack::set_lora_callbacks(const lorawan_app_callbacks_t
         _loramac.set_batterylevel_callback(callbacks->battery_level);
     }
 
+    if (callbacks->rx_window) {
+        _callbacks.rx_window = callbacks->rx_window;
+        _loramac.set_rx_window_callback(callbacks->rx_window);
+    }
+
+    if (callbacks->session) {
+        _callbacks.session = callbacks->session;
+    }
+
+    if (callbacks->join) {
+        _callbacks.join = callbacks->join;
+    }
+
     return LORAWAN_STATUS_OK;
 }
 
@@ -197,6 +214,51 @@ lorawan_status_t LoRaWANStack::connect(const lorawan_connect_t &connect)
     return handle_connect(is_otaa);
 }
 
+lorawan_status_t LoRaWANStack::restore_session(const lorawan_session_params_t &session,
+                                               uint32_t ul_frame_counter,
+                                               uint32_t dl_frame_counter)
+{
+    if (DEVICE_STATE_NOT_INITIALIZED == _device_current_state) {
+        return LORAWAN_STATUS_NOT_INITIALIZED;
+    }
+
+    if (_ctrl_flags & CONN_IN_PROGRESS_FLAG) {
+        return LORAWAN_STATUS_BUSY;
+    }
+
+    if (_ctrl_flags & CONNECTED_FLAG) {
+        return LORAWAN_STATUS_ALREADY_CONNECTED;
+    }
+
+    lorawan_status_t status = _loramac.restore_session(session, ul_frame_counter,
+                                                       dl_frame_counter);
+
+    if (LORAWAN_STATUS_OK != status) {
+        return status;
+    }
+
+    _lw_session.uplink_counter = ul_frame_counter;
+    _lw_session.downlink_counter = dl_frame_counter;
+
+    return handle_connect(false);
+}
+
+lorawan_status_t LoRaWANStack::set_join_state(const lorawan_join_params_t &params,
+                                              uint16_t dev_nonce)
+{
+    if (DEVICE_STATE_NOT_INITIALIZED == _device_current_state) {
+        return LORAWAN_STATUS_NOT_INITIALIZED;
+    }
+
+    if (_ctrl_flags & CONN_IN_PROGRESS_FLAG) {
+        return LORAWAN_STATUS_BUSY;
+    }
+
+    _loramac.set_join_state(params, dev_nonce);
+
+    return LORAWAN_STATUS_OK;
+}
+
 lorawan_status_t LoRaWANStack::add_channels(const lorawan_channelplan_t &channel_plan)
 {
     if (_device_current_state == DEVICE_STATE_NOT_INITIALIZED) {
@@ -248,6 +310,22 @@ lorawan_status_t LoRaWANStack::set_confirmed_msg_retry(uint8_t count)
     return LORAWAN_STATUS_OK;
 }
 
+lorawan_status_t LoRaWANStack::set_retry_policy(const lorawan_retry_policy_t &policy)
+{
+    if (_device_current_state == DEVICE_STATE_NOT_INITIALIZED) {
+        return LORAWAN_STATUS_NOT_INITIALIZED;
+    }
+
+    if (policy.backoff == LORAWAN_RETRY_BACKOFF_CUSTOM && !policy.custom) {
+        return LORAWAN_STATUS_PARAMETER_INVALID;
+    }
+
+    _latest_value_wins = policy.latest_value_wins;
+    _loramac.set_retry_policy(policy);
+
+    return LORAWAN_STATUS_OK;
+}
+
 lorawan_status_t LoRaWANStack::set_channel_data_rate(uint8_t data_rate)
 {
     if (DEVICE_STATE_NOT_INITIALIZED == _device_current_state) {
@@ -302,7 +380,11 @@ int16_t LoRaWANStack::handle_tx(const uint8_t port, const uint8_t *data,
         return LORAWAN_STATUS_NO_ACTIVE_SESSIONS;
     }
 
-    if (_loramac.tx_ongoing()) {
+    // An automatic uplink answers the network server and is never replaced,
+    // nor does it replace the message of the application
+    if (_loramac.tx_ongoing()
+            && (!_latest_value_wins || _automatic_uplink_ongoing
+                || !supersede_pending_tx())) {
         return LORAWAN_STATUS_WOULD_BLOCK;
     }
 
@@ -451,12 +533,44 @@ lorawan_status_t LoRaWANStack::set_device_class(const device_class_t &device_cla
         return LORAWAN_STATUS_NOT_INITIALIZED;
     }
 
-    if (device_class == CLASS_B) {
-        return LORAWAN_STATUS_UNSUPPORTED;
+    return _loramac.set_device_class(device_class,
+                                     mbed::callback(this, &LoRaWANStack::post_process_tx_no_reception));
+}
+
+lorawan_status_t LoRaWANStack::enable_beacon_acquisition()
+{
+    if (DEVICE_STATE_NOT_INITIALIZED == _device_current_state) {
+        return LORAWAN_STATUS_NOT_INITIALIZED;
     }
-    _loramac.set_device_class(device_class,
-                              mbed::callback(this, &LoRaWANStack::post_process_tx_no_reception));
-    return LORAWAN_STATUS_OK;
+
+    return _loramac.enable_beacon_acquisition();
+}
+
+lorawan_status_t LoRaWANStack::add_device_time_request()
+{
+    if (DEVICE_STATE_NOT_INITIALIZED == _device_current_state) {
+        return LORAWAN_STATUS_NOT_INITIALIZED;
+    }
+
+    return _loramac.setup_device_time_request();
+}
+
+lorawan_status_t LoRaWANStack::add_ping_slot_info_request(uint8_t periodicity)
+{
+    if (DEVICE_STATE_NOT_INITIALIZED == _device_current_state) {
+        return LORAWAN_STATUS_NOT_INITIALIZED;
+    }
+
+    return _loramac.setup_ping_slot_info_request(periodicity);
+}
+
+lorawan_status_t LoRaWANStack::acquire_last_beacon(lorawan_beacon_t &beacon)
+{
+    if (DEVICE_STATE_NOT_INITIALIZED == _device_current_state) {
+        return LORAWAN_STATUS_NOT_INITIALIZED;
+    }
+
+    return _loramac.get_last_beacon(beacon);
 }
 
 lorawan_status_t  LoRaWANStack::acquire_tx_metadata(lorawan_tx_metadata &tx_metadata)
@@ -506,6 +620,25 @@ lorawan_status_t LoRaWANStack::acquire_backoff_metadata(int &backoff)
     return LORAWAN_STATUS_METADATA_NOT_AVAILABLE;
 }
 
+lorawan_status_t LoRaWANStack::acquire_rx_sniff_metadata(lorawan_rx_sniff_metadata &metadata)
+{
+    if (DEVICE_STATE_NOT_INITIALIZED == _device_current_state) {
+        return LORAWAN_STATUS_NOT_INITIALIZED;
+    }
+
+    _loramac.get_rx_sniff_metadata(metadata);
+    return LORAWAN_STATUS_OK;
+}
+
+uint8_t LoRaWANStack::get_max_possible_tx_size(void)
+{
+    if (DEVICE_STATE_NOT_INITIALIZED == _device_current_state) {
+        return 0;
+    }
+
+    return _loramac.get_max_possible_tx_size();
+}
+
 /*****************************************************************************
  * Interrupt handlers                                                        *
  ****************************************************************************/
@@ -524,6 +657,7 @@ void LoRaWANStack::rx_interrupt_handler(const uint8_t *payload, uint16_t size,
         return;
     }
 
+    _rx_timestamp = _loramac.get_current_time();
     memcpy(_rx_payload, payload, size);
 
     const uint8_t *ptr = _rx_payload;
@@ -696,13 +830,22 @@ void LoRaWANStack::handle_scheduling_failure(void)
 void LoRaWANStack::process_reception(const uint8_t *const payload, uint16_t size,
                                      int16_t rssi, int8_t snr)
 {
+    rx_slot_t slot = _loramac.get_current_slot();
+
+    // A beacon is no downlink and leaves the state machine alone
+    if (slot == RX_SLOT_BEACON) {
+        _loramac.on_radio_rx_done(payload, size, rssi, snr, _rx_timestamp);
+        core_util_atomic_flag_clear(&_rx_payload_in_use);
+        return;
+    }
+
     _device_current_state = DEVICE_STATE_RECEIVING;
 
     _ctrl_flags &= ~MSG_RECVD_FLAG;
     _ctrl_flags &= ~TX_DONE_FLAG;
     _ctrl_flags &= ~RETRY_EXHAUSTED_FLAG;
 
-    _loramac.on_radio_rx_done(payload, size, rssi, snr);
+    _loramac.on_radio_rx_done(payload, size, rssi, snr, _rx_timestamp);
 
     if (_loramac.get_mlme_confirmation()->pending) {
         _loramac.post_process_mlme_request();
@@ -721,8 +864,12 @@ void LoRaWANStack::process_reception(const uint8_t *const payload, uint16_t size
 
     make_rx_metadata_available();
 
-    // Post process transmission in response to the reception
-    post_process_tx_with_reception();
+    // Post process transmission in response to the reception. A ping slot
+    // downlink answers no uplink unless it carries the ACK.
+    if (slot != RX_SLOT_WIN_PING_SLOT
+            || _loramac.get_mcps_indication()->is_ack_recvd) {
+        post_process_tx_with_reception();
+    }
 
     // handle any pending MCPS indication
     if (_loramac.get_mcps_indication()->pending) {
@@ -788,6 +935,7 @@ void LoRaWANStack::make_tx_metadata_available(void)
     _tx_metadata.tx_power = _loramac.get_mcps_confirmation()->tx_power;
     _tx_metadata.tx_toa = _loramac.get_mcps_confirmation()->tx_toa;
     _tx_metadata.nb_retries = _loramac.get_mcps_confirmation()->nb_retries;
+    _tx_metadata.airtime = _loramac.get_mcps_confirmation()->airtime;
 }
 
 void LoRaWANStack::make_rx_metadata_available(void)
@@ -847,6 +995,56 @@ void LoRaWANStack::send_event_to_application(const lorawan_event_t event) const
     }
 }
 
+void LoRaWANStack::send_session_to_application(void)
+{
+    lorawan_session_params_t session;
+    uint32_t ul_frame_counter;
+    uint32_t dl_frame_counter;
+
+    if (!_callbacks.session || !_loramac.nwk_joined()) {
+        return;
+    }
+
+    // Synchronous, the uplink counter must be saved before the next uplink
+    _loramac.get_session(session, ul_frame_counter, dl_frame_counter);
+    _callbacks.session(&session, ul_frame_counter, dl_frame_counter);
+}
+
+void LoRaWANStack::send_join_state_to_application(void)
+{
+    lorawan_join_params_t params;
+    uint16_t dev_nonce;
+
+    if (!_callbacks.join) {
+        return;
+    }
+
+    // Synchronous, the DevNonce must be saved before the join request
+    _loramac.get_join_state(params, dev_nonce);
+    _callbacks.join(&params, dev_nonce);
+}
+
+bool LoRaWANStack::supersede_pending_tx(void)
+{
+    if (!_loramac.cancel_retry()
+            && _loramac.clear_tx_pipe() != LORAWAN_STATUS_OK) {
+        return false;
+    }
+
+    tr_debug("Pending message superseded");
+
+    // The frame counter moves on as for a failed message, a new message
+    // must not go out with the counter of the one the server may have seen
+    _loramac.post_process_mcps_req();
+    make_tx_metadata_available();
+    send_session_to_application();
+
+    _ctrl_flags &= ~TX_DONE_FLAG;
+    _loramac.set_tx_ongoing(false);
+    _device_current_state = DEVICE_STATE_IDLE;
+    return true;
+}
+
 void LoRaWANStack::send_automatic_uplink_message(const uint8_t port)
 {
     // we will silently ignore the automatic uplink event if the user is already
@@ -1048,20 +1246,20 @@ void LoRaWANStack::mcps_indication_handler()
     }
 
     /*
-     * If fPending bit is set we try to generate an empty packet
+     * If fPending bit is set (Class A) we try to generate an empty packet
      * with CONFIRMED flag set. We always set a CONFIRMED flag so
      * that we could retry a certain number of times if the uplink
      * failed for some reason
      * or
-     * Class C and node received a confirmed message so we need to
+     * Class B or C and node received a confirmed message so we need to
      * send an empty packet to acknowledge the message.
      * This scenario is unspecified by LoRaWAN 1.0.2 specification,
      * but version 1.1.0 says that network SHALL not send any new
      * confirmed messages until ack has been sent
      */
-    if ((_loramac.get_device_class() != CLASS_C
+    if ((_loramac.get_device_class() == CLASS_A
             && mcps_indication->fpending_status)
-            || (_loramac.get_device_class() == CLASS_C
+            || (_loramac.get_device_class() != CLASS_A
                 && mcps_indication->type == MCPS_CONFIRMED)) {
 #if (MBED_CONF_LORA_AUTOMATIC_UPLINK_MESSAGE)
         // Do not queue an automatic uplink of there is one already outgoing
@@ -1175,6 +1373,8 @@ void LoRaWANStack::process_status_check_state()
             mcps_indication_handler();
         }
     }
+
+    send_session_to_application();
 }
 
 void LoRaWANStack::process_scheduling_state(lorawan_status_t &op_status)
@@ -1200,6 +1400,7 @@ void LoRaWANStack::process_joining_state(lorawan_status_t &op_status)
     if (_device_current_state == DEVICE_STATE_CONNECTING) {
         _device_current_state = DEVICE_STATE_JOINING;
         tr_debug("Sending Join Request ...");
+        send_join_state_to_application();
         op_status = _loramac.join(true);
         return;
     }
@@ -1208,6 +1409,7 @@ void LoRaWANStack::process_joining_state(lorawan_status_t &op_status)
             _loramac.get_current_slot() != RX_SLOT_WIN_1) {
         _device_current_state = DEVICE_STATE_JOINING;
         // retry join
+        send_join_state_to_application();
         bool can_continue = _loramac.continue_joining_process();
 
         if (!can_continue) {
@@ -1229,6 +1431,10 @@ void LoRaWANStack::process_connected_state()
     }
 
     _lw_session.active = true;
+    if (_ctrl_flags & USING_OTAA_FLAG) {
+        send_join_state_to_application();
+    }
+    send_session_to_application();
     send_event_to_application(CONNECTED);
 
     _device_current_state = DEVICE_STATE_IDLE;
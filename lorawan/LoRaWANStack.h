@@ -128,6 +128,36 @@ public:
      */
     lorawan_status_t connect(const lorawan_connect_t &connect);
 
+    /** Connect with a session kept from before
+     *
+     * Takes over a session handed out by the 'session' callback, e.g. stored in
+     * non-volatile memory before a reset, and connects like ABP without a join.
+     *
+     * @param session           the session parameters
+     * @param ul_frame_counter  uplink frame counter to continue with
+     * @param dl_frame_counter  last downlink frame counter
+     *
+     * @return    LORAWAN_STATUS_OK followed by a 'CONNECTED' event, or a negative
+     *            error code, as connect() does for ABP.
+     */
+    lorawan_status_t restore_session(const lorawan_session_params_t &session,
+                                     uint32_t ul_frame_counter,
+                                     uint32_t dl_frame_counter);
+
+    /** Sets the join state kept from before
+     *
+     * Takes over the state handed out by the 'join' callback, e.g. stored in
+     * non-volatile memory before a reset, for the next join.
+     *
+     * @param params     channel and datarate of the last join-accept
+     * @param dev_nonce  DevNonce of the next join request
+     *
+     * @return    LORAWAN_STATUS_OK, or a negative error code if not initialized
+     *            or while joining.
+     */
+    lorawan_status_t set_join_state(const lorawan_join_params_t &params,
+                                    uint16_t dev_nonce);
+
     /** Adds channels to use.
      *
      * You can provide a list of channels with appropriate parameters filled
@@ -189,6 +219,15 @@ public:
      */
     lorawan_status_t set_confirmed_msg_retry(uint8_t count);
 
+    /** Sets the retransmission policy for confirmed messages.
+     *
+     * @param policy            Backoff, airtime budget and whether a new
+     *                          message replaces a pending one.
+     *
+     * @return                  LORAWAN_STATUS_OK or a negative error code.
+     */
+    lorawan_status_t set_retry_policy(const lorawan_retry_policy_t &policy);
+
     /** Sets up the data rate.
      *
      * `set_datarate()` first verifies whether the data rate given is valid or not.
@@ -344,10 +383,55 @@ public:
      *
      * @return                  LORAWAN_STATUS_OK on success,
      *                          LORAWAN_STATUS_UNSUPPORTED is requested class is not supported,
+     *                          LORAWAN_STATUS_NO_BEACON_FOUND if Class B is requested
+     *                          while no beacon is tracked,
      *                          or other negative error code if request failed.
      */
     lorawan_status_t set_device_class(const device_class_t &device_class);
 
+    /** Start the Class B beacon acquisition
+     *
+     * The outcome is reported with the BEACON_FOUND or BEACON_NOT_FOUND event.
+     *
+     * @return                  LORAWAN_STATUS_OK if the acquisition started,
+     *                          LORAWAN_STATUS_UNSUPPORTED in a region without
+     *                          Class B or in Class C,
+     *                          or other negative error code if request failed.
+     */
+    lorawan_status_t enable_beacon_acquisition();
+
+    /** Add a DeviceTimeReq MAC command to the next uplink
+     *
+     * The answer is reported with the DEVICE_TIME_SYNCHED event.
+     *
+     * @return                  LORAWAN_STATUS_OK on successfully queuing a request, or
+     *                          a negative error code on failure.
+     */
+    lorawan_status_t add_device_time_request();
+
+    /** Add a PingSlotInfoReq MAC command to the next uplink
+     *
+     * The periodicity is used once the answer is reported with the
+     * PING_SLOT_INFO_SYNCHED event.
+     *
+     * @param    periodicity    2^periodicity seconds between ping slots, 0..7
+     *
+     * @return                  LORAWAN_STATUS_OK on successfully queuing a request, or
+     *                          a negative error code on failure.
+     */
+    lorawan_status_t add_ping_slot_info_request(uint8_t periodicity);
+
+    /** Acquire the last beacon received
+     *
+     * @param    beacon      A reference to the inbound structure which will be
+     *                       filled with the beacon.
+     *
+     * @return               LORAWAN_STATUS_OK if successful,
+     *                       LORAWAN_STATUS_METADATA_NOT_AVAILABLE if no beacon
+     *                       was received, or other negative error code
+     */
+    lorawan_status_t acquire_last_beacon(lorawan_beacon_t &beacon);
+
     /** Acquire TX meta-data
      *
      * Upon successful transmission, TX meta-data will be made available
@@ -384,6 +468,27 @@ public:
      */
     lorawan_status_t acquire_backoff_metadata(int &backoff);
 
+    /** Acquire Class C reception meta-data
+     *
+     * Statistics of the Class C reception since initialization.
+     *
+     * @param    metadata    A reference to the inbound structure which will be
+     *                       filled with the Class C reception meta-data.
+     *
+     * @return               LORAWAN_STATUS_OK if successful,
+     *                       LORAWAN_STATUS_NOT_INITIALIZED otherwise
+     */
+    lorawan_status_t acquire_rx_sniff_metadata(lorawan_rx_sniff_metadata &metadata);
+
+    /** Maximum application payload size
+     *
+     * Size of the biggest application payload the next uplink can carry
+     * without being split, given the current datarate and pending MAC commands.
+     *
+     * @return               maximum payload in bytes, 0 if not initialized
+     */
+    uint8_t get_max_possible_tx_size(void);
+
     /** Stops sending
      *
      * Stop sending any outstanding messages if they are not yet queued for
@@ -465,6 +570,27 @@ private:
      */
     void send_event_to_application(const lorawan_event_t event) const;
 
+    /** Send the session to application.
+     *
+     * Only once joined and if the application set the 'session' callback.
+     */
+    void send_session_to_application(void);
+
+    /** Send the join state to application.
+     *
+     * Only if the application set the 'join' callback.
+     */
+    void send_join_state_to_application(void);
+
+    /** Drops the pending message for a new one.
+     *
+     * Only if the message waits for its retransmission or for the duty
+     * cycle. The message is finished as if it had failed, without an event.
+     *
+     * @return true if the message was dropped
+     */
+    bool supersede_pending_tx(void);
+
     /** Send empty uplink message to network.
      *
      * Sends an empty confirmed message to gateway.
@@ -516,6 +642,7 @@ private:
     lorawan_rx_metadata _rx_metadata;
     uint8_t _num_retry;
     uint8_t _qos_cnt;
+    bool _latest_value_wins;
     uint32_t _ctrl_flags;
     uint8_t _app_port;
     bool _link_check_requested;
@@ -524,6 +651,7 @@ private:
     uint8_t _rx_payload[LORAMAC_PHY_MAXPAYLOAD];
     events::EventQueue *_queue;
     lorawan_time_t _tx_timestamp;
+    lorawan_time_t _rx_timestamp;
 };
 
 #endif /* LORAWANSTACK_H_ */
@@ -55,6 +55,13 @@ using namespace mbed;
  */
 #define BACKOFF_DC_24_HOURS                         10000
 
+/*!
+ * Tolerance in ms granted to MAC timers whose expiry is not time critical
+ * (duty-cycle backoff, ack timeout) so that they can be coalesced with
+ * other pending events. RX window timers are always started without slack.
+ */
+#define MAC_TIMER_SLACK                             100
+
 /*!
  * The frame direction definition for uplink communications.
  */
@@ -65,6 +72,17 @@ using namespace mbed;
  */
 #define DOWN_LINK                                   1
 
+/*!
+ * The radio counts at most 255 symbols for an RX timeout, wider Class B
+ * windows are cut down to it
+ */
+#define CLASS_B_MAX_RX_SYMBOLS                      255
+
+/*!
+ * Uncertainty of the network time of a DeviceTimeAns [ms]
+ */
+#define DEVICE_TIME_SYNC_ERROR                      5
+
 LoRaMac::LoRaMac()
     : _lora_time(),
       _lora_phy(NULL),
@@ -81,9 +99,30 @@ LoRaMac::LoRaMac()
       _continuous_rx2_window_open(false),
       _device_class(CLASS_A),
       _prev_qos_level(LORAWAN_DEFAULT_QOS),
-      _demod_ongoing(false)
+      _demod_ongoing(false),
+      _rx1_due(0),
+      _rx2_due(0),
+      _next_dev_nonce(0),
+      _next_dev_nonce_valid(false),
+      _retry_policy(),
+      _retry_backoff(0),
+      _retry_pending(false),
+      _class_c_rx_since(0),
+      _class_c_rx_open(false),
+      _beacon_state(BEACON_STATE_OFF),
+      _beacon_time(0),
+      _ping_slot_time(0),
+      _class_b_rx_open(false),
+      _last_beacon_valid(false),
+      _pending_ping_slot_periodicity(CLASS_B_DEFAULT_PERIODICITY),
+      _radio_tx_ongoing(false)
 {
     memset(&_params, 0, sizeof(_params));
+    memset(&_join_params, 0, sizeof(_join_params));
+    memset(&_rx_sniff, 0, sizeof(_rx_sniff));
+    memset(&_beacon_rx_config, 0, sizeof(_beacon_rx_config));
+    memset(&_ping_slot_rx_config, 0, sizeof(_ping_slot_rx_config));
+    memset(&_last_beacon, 0, sizeof(_last_beacon));
     _params.keys.dev_eui = NULL;
     _params.keys.app_eui = NULL;
     _params.keys.app_key = NULL;
@@ -271,6 +310,11 @@ void LoRaMac::handle_join_accept_frame(const uint8_t *payload, uint16_t size)
         // Size of the regular payload is 12. Plus 1 byte MHDR and 4 bytes MIC
         _lora_phy->apply_cf_list(&_params.rx_buffer[13], size - 17);
 
+        // Channel and datarate are still the ones of the join request
+        _join_params.accepted = true;
+        _join_params.channel = _params.channel;
+        _join_params.datarate = _params.sys_params.channel_data_rate;
+
         _mlme_confirmation.status = LORAMAC_EVENT_INFO_STATUS_OK;
         _is_nwk_joined = true;
         // Node joined successfully
@@ -588,6 +632,7 @@ void LoRaMac::handle_data_frame(const uint8_t *const payload,
     // Spec: 3.3.4 Receiver Activity during the receive windows
     if (get_current_slot() == RX_SLOT_WIN_1) {
         _lora_time.stop(_params.timers.rx_window2_timer);
+        notify_rx_window(RX_SLOT_WIN_2, RX_WINDOW_CLOSED, 0);
     } else {
         _lora_time.stop(_params.timers.rx_window1_timer);
         _lora_time.stop(_params.timers.rx_window2_timer);
@@ -644,8 +689,22 @@ void LoRaMac::set_batterylevel_callback(mbed::Callback<uint8_t(void)> battery_le
     _mac_commands.set_batterylevel_callback(battery_level);
 }
 
+void LoRaMac::set_rx_window_callback(mbed::Callback<void(uint8_t, lorawan_rx_window_event_t, int32_t)> rx_window)
+{
+    _rx_window_handler = rx_window;
+}
+
+void LoRaMac::notify_rx_window(rx_slot_t slot, lorawan_rx_window_event_t event, int32_t value)
+{
+    if (_rx_window_handler && (slot == RX_SLOT_WIN_1 || slot == RX_SLOT_WIN_2)) {
+        _rx_window_handler(slot, event, value);
+    }
+}
+
 void LoRaMac::on_radio_tx_done(lorawan_time_t timestamp)
 {
+    _radio_tx_ongoing = false;
+
     if (_device_class == CLASS_C) {
         // this will open a continuous RX2 window until time==RECV_DELAY1
         open_rx2_window();
@@ -669,6 +728,16 @@ void LoRaMac::on_radio_tx_done(lorawan_time_t timestamp)
         _lora_time.start(_params.timers.rx_window2_timer,
                          _params.rx_window2_delay - time_diff);
 
+        _rx1_due = timestamp + _params.rx_window1_delay;
+        _rx2_due = timestamp + _params.rx_window2_delay;
+        notify_rx_window(RX_SLOT_WIN_1, RX_WINDOW_SCHEDULED,
+                         (int32_t)(_params.rx_window1_delay - time_diff));
+        // In Class C the second window is the continuous reception
+        if (_device_class != CLASS_C) {
+            notify_rx_window(RX_SLOT_WIN_2, RX_WINDOW_SCHEDULED,
+                             (int32_t)(_params.rx_window2_delay - time_diff));
+        }
+
         // If class C and an Unconfirmed messgae is outgoing,
         // this will start a timer which will invoke rx2 would be
         // closure handler
@@ -680,10 +749,12 @@ void LoRaMac::on_radio_tx_done(lorawan_time_t timestamp)
 
         // start timer after which ack wait will timeout (for Confirmed messages)
         if (_params.is_node_ack_requested) {
+            _retry_backoff = get_retry_backoff();
             _lora_time.start(_params.timers.ack_timeout_timer,
                              (_params.rx_window2_delay - time_diff) +
                              _params.rx_window2_config.window_timeout_ms +
-                             _lora_phy->get_ack_timeout());
+                             _lora_phy->get_ack_timeout() + MAX(_retry_backoff, 0),
+                             MAC_TIMER_SLACK);
         }
     } else {
         _mcps_confirmation.status = LORAMAC_EVENT_INFO_STATUS_OK;
@@ -697,12 +768,22 @@ void LoRaMac::on_radio_tx_done(lorawan_time_t timestamp)
     _params.timers.aggregated_last_tx_time = timestamp;
 
     _mac_commands.clear_command_buffer();
+
+    resume_beacon_scan();
 }
 
 void LoRaMac::on_radio_rx_done(const uint8_t *const payload, uint16_t size,
-                               int16_t rssi, int8_t snr)
+                               int16_t rssi, int8_t snr, lorawan_time_t timestamp)
 {
+    rx_slot_t slot = _params.rx_slot;
+
+    if (slot == RX_SLOT_BEACON) {
+        handle_beacon(payload, size, rssi, snr, timestamp);
+        return;
+    }
+
     _demod_ongoing = false;
+    _class_b_rx_open = false;
     if (_device_class == CLASS_C && !_continuous_rx2_window_open) {
         _lora_time.stop(_rx2_closure_timer_for_class_c);
         open_rx2_window();
@@ -711,6 +792,17 @@ void LoRaMac::on_radio_rx_done(const uint8_t *const payload, uint16_t size,
         _lora_phy->put_radio_to_sleep();
     }
 
+    notify_rx_window(slot, RX_WINDOW_CLOSED, 1);
+
+    if (slot == RX_SLOT_WIN_CLASS_C) {
+        _rx_sniff.frames++;
+        if (_rx_sniff.rx_period != 0) {
+            // the receiver stayed on for the whole frame
+            _rx_sniff.rx_on_time += _lora_phy->get_rx_time_on_air(_params.rx_window2_config.modem_type,
+                                                                   size);
+        }
+    }
+
     loramac_mhdr_t mac_hdr;
     uint8_t pos = 0;
     mac_hdr.value = payload[pos++];
@@ -734,16 +826,20 @@ void LoRaMac::on_radio_rx_done(const uint8_t *const payload, uint16_t size,
         case FRAME_TYPE_PROPRIETARY:
 
             handle_data_frame(payload, size, pos, mac_hdr.bits.mtype, rssi, snr);
+            handle_class_b_answers();
 
             break;
 
         default:
             break;
     }
+
+    resume_beacon_scan();
 }
 
 void LoRaMac::on_radio_tx_timeout(void)
 {
+    _radio_tx_ongoing = false;
     _lora_time.stop(_params.timers.rx_window1_timer);
     _lora_time.stop(_params.timers.rx_window2_timer);
     _lora_time.stop(_rx2_closure_timer_for_class_c);
@@ -768,15 +864,34 @@ void LoRaMac::on_radio_tx_timeout(void)
 
     _mcps_confirmation.ack_received = false;
     _mcps_confirmation.tx_toa = 0;
+
+    resume_beacon_scan();
 }
 
 void LoRaMac::on_radio_rx_timeout(bool is_timeout)
 {
+    if (_params.rx_slot == RX_SLOT_BEACON
+            || _params.rx_slot == RX_SLOT_WIN_PING_SLOT) {
+        _class_b_rx_open = false;
+        _lora_phy->put_radio_to_sleep();
+
+        if (_params.rx_slot == RX_SLOT_BEACON) {
+            if (_beacon_state == BEACON_STATE_SCAN) {
+                open_beacon_scan();
+            } else {
+                handle_beacon_miss();
+            }
+        }
+        return;
+    }
+
     _demod_ongoing = false;
-    if (_device_class == CLASS_A) {
+    if (_device_class != CLASS_C) {
         _lora_phy->put_radio_to_sleep();
     }
 
+    notify_rx_window(_params.rx_slot, RX_WINDOW_CLOSED, 0);
+
     if (_params.rx_slot == RX_SLOT_WIN_1) {
         if (_params.is_node_ack_requested == true) {
             _mcps_confirmation.status = is_timeout ?
@@ -790,6 +905,7 @@ void LoRaMac::on_radio_rx_timeout(bool is_timeout)
         if (_device_class != CLASS_C) {
             if (_lora_time.get_elapsed_time(_params.timers.aggregated_last_tx_time) >= _params.rx_window2_delay) {
                 _lora_time.stop(_params.timers.rx_window2_timer);
+                notify_rx_window(RX_SLOT_WIN_2, RX_WINDOW_CLOSED, 0);
             }
         }
     } else {
@@ -803,6 +919,8 @@ void LoRaMac::on_radio_rx_timeout(bool is_timeout)
                                     LORAMAC_EVENT_INFO_STATUS_RX2_TIMEOUT :
                                     LORAMAC_EVENT_INFO_STATUS_RX2_ERROR;
     }
+
+    resume_beacon_scan();
 }
 
 bool LoRaMac::continue_joining_process()
@@ -821,24 +939,88 @@ bool LoRaMac::continue_joining_process()
 
 bool LoRaMac::continue_sending_process()
 {
-    if (_params.ack_timeout_retry_counter > _params.max_ack_timeout_retries) {
+    if (_params.ack_timeout_retry_counter > _params.max_ack_timeout_retries
+            || _retry_backoff < 0) {
         _lora_time.stop(_params.timers.ack_timeout_timer);
         return false;
     }
 
     // retransmission will be handled in on_ack_timeout() whence the ACK timeout
     // gets fired
+    _retry_pending = true;
     return true;
 }
 
+void LoRaMac::set_retry_policy(const lorawan_retry_policy_t &policy)
+{
+    _retry_policy = policy;
+}
+
+bool LoRaMac::cancel_retry(void)
+{
+    if (!_retry_pending) {
+        return false;
+    }
+
+    _lora_time.stop(_params.timers.ack_timeout_timer);
+    _retry_pending = false;
+    reset_ongoing_tx(true);
+    tr_debug("Retransmission cancelled");
+    return true;
+}
+
+int32_t LoRaMac::get_retry_backoff(void)
+{
+    uint8_t retry = _params.ack_timeout_retry_counter;
+    uint32_t next_toa = _params.timers.tx_toa;
+    uint32_t wait;
+
+    if (retry > _params.max_ack_timeout_retries) {
+        return 0;
+    }
+
+    // The retransmission goes out a datarate lower, roughly twice as long
+    if ((retry % 2) && _params.sys_params.adr_on) {
+        next_toa *= 2;
+    }
+
+    if (_retry_policy.airtime_budget_ms != 0
+            && _mcps_confirmation.airtime + next_toa > _retry_policy.airtime_budget_ms) {
+        tr_debug("Airtime budget spent: %lu ms", _mcps_confirmation.airtime);
+        return -1;
+    }
+
+    // Capped so that the shift cannot overflow, an hour is plenty anyway
+    wait = MIN(_retry_policy.base_ms, 3600000UL) << MIN(retry - 1, 8);
+
+    switch (_retry_policy.backoff) {
+        case LORAWAN_RETRY_BACKOFF_EXPONENTIAL:
+            return wait;
+        case LORAWAN_RETRY_BACKOFF_RANDOM:
+            return rand() % (wait + 1);
+        case LORAWAN_RETRY_BACKOFF_CUSTOM:
+            if (_retry_policy.custom) {
+                return _retry_policy.custom(retry, _mcps_confirmation.airtime);
+            }
+            return 0;
+        default:
+            return 0;
+    }
+}
+
 lorawan_status_t LoRaMac::send_join_request()
 {
     lorawan_status_t status = LORAWAN_STATUS_OK;
     loramac_mhdr_t mac_hdr;
     loramac_frame_ctrl_t fctrl;
 
-    _params.sys_params.channel_data_rate =
-        _lora_phy->get_alternate_DR(_params.join_request_trial_counter + 1);
+    if (_params.join_request_trial_counter == 0 && _join_params.accepted) {
+        // Start with what got the last join-accept
+        _params.sys_params.channel_data_rate = _join_params.datarate;
+    } else {
+        _params.sys_params.channel_data_rate =
+            _lora_phy->get_alternate_DR(_params.join_request_trial_counter + 1);
+    }
 
     mac_hdr.value = 0;
     mac_hdr.bits.mtype = FRAME_TYPE_JOIN_REQ;
@@ -848,7 +1030,7 @@ lorawan_status_t LoRaMac::send_join_request()
     _params.is_last_tx_join_request = true;
 
     /* In case of join request retransmissions, the stack must prepare
-     * the frame again, because the network server keeps track of the random
+     * the frame again, because the network server keeps track of the
      * LoRaMacDevNonce values to prevent reply attacks. */
     status = prepare_frame(&mac_hdr, &fctrl, 0, NULL, 0);
 
@@ -863,6 +1045,17 @@ lorawan_status_t LoRaMac::send_join_request()
     return status;
 }
 
+/**
+ * Seeds the DevNonce counter from the radio RNG unless a stored one is valid
+ */
+void LoRaMac::seed_dev_nonce()
+{
+    if (!_next_dev_nonce_valid) {
+        _next_dev_nonce = _lora_phy->get_radio_rng();
+        _next_dev_nonce_valid = true;
+    }
+}
+
 /**
  * This function handles retransmission of failed or unacknowledged
  * outgoing traffic
@@ -898,6 +1091,8 @@ void LoRaMac::open_rx1_window(void)
     _demod_ongoing = true;
     _continuous_rx2_window_open = false;
     _lora_time.stop(_params.timers.rx_window1_timer);
+    close_class_c_rx();
+    close_class_b_rx();
     _params.rx_slot = RX_SLOT_WIN_1;
 
     channel_params_t *active_channel_list = _lora_phy->get_phy_channels();
@@ -913,6 +1108,9 @@ void LoRaMac::open_rx1_window(void)
     _params.rx_window1_config.is_rx_continuous = false;
     _params.rx_window1_config.rx_slot = _params.rx_slot;
 
+    notify_rx_window(RX_SLOT_WIN_1, RX_WINDOW_OPENED,
+                     (int32_t)(_lora_time.get_current_time() - _rx1_due));
+
     if (_device_class == CLASS_C) {
         _lora_phy->put_radio_to_standby();
     }
@@ -929,6 +1127,10 @@ void LoRaMac::open_rx2_window()
 {
     if (_demod_ongoing) {
         tr_info("RX1 Demodulation ongoing, skip RX2 window opening");
+        _lora_time.stop(_params.timers.rx_window2_timer);
+        if (_device_class != CLASS_C) {
+            notify_rx_window(RX_SLOT_WIN_2, RX_WINDOW_CLOSED, 0);
+        }
         return;
     }
     Lock lock(*this);
@@ -944,20 +1146,82 @@ void LoRaMac::open_rx2_window()
         _params.rx_window2_config.is_rx_continuous = true;
     } else {
         _params.rx_window2_config.is_rx_continuous = false;
+        // Keeps the Class B windows off the radio until RX2 is done
+        _demod_ongoing = true;
+        close_class_b_rx();
     }
 
     _params.rx_window2_config.rx_slot = _params.rx_window2_config.is_rx_continuous ?
                                         RX_SLOT_WIN_CLASS_C : RX_SLOT_WIN_2;
 
+    notify_rx_window(_params.rx_window2_config.rx_slot, RX_WINDOW_OPENED,
+                     (int32_t)(_lora_time.get_current_time() - _rx2_due));
+
     _mcps_indication.rx_datarate = _params.rx_window2_config.datarate;
 
+    // Class C reception checks for a preamble and sleeps in between where the
+    // downlink preamble is long enough for it, continuous otherwise
+    if (_params.rx_window2_config.rx_slot == RX_SLOT_WIN_CLASS_C) {
+        close_class_c_rx();
+        if (!_lora_phy->compute_rx_sniff_params(_params.rx_window2_config.datarate,
+                                                 MBED_CONF_LORA_CLASS_C_SNIFF_PREAMBLE_LENGTH,
+                                                 &_rx_sniff.rx_period,
+                                                 &_rx_sniff.sleep_period)) {
+            _rx_sniff.rx_period = 0;
+            _rx_sniff.sleep_period = 0;
+        }
+        _class_c_rx_open = true;
+    }
+
     _lora_phy->rx_config(&_params.rx_window2_config);
-    _lora_phy->handle_receive();
+    if (_params.rx_window2_config.rx_slot == RX_SLOT_WIN_CLASS_C
+            && _rx_sniff.rx_period != 0) {
+        _lora_phy->handle_receive_duty_cycle(_rx_sniff.rx_period, _rx_sniff.sleep_period);
+    } else {
+        _lora_phy->handle_receive();
+    }
     _params.rx_slot = _params.rx_window2_config.rx_slot;
 
     tr_debug("RX2 slot open, Freq = %lu", _params.rx_window2_config.frequency);
 }
 
+void LoRaMac::close_class_c_rx(void)
+{
+    lorawan_time_t now = _lora_time.get_current_time();
+    uint32_t elapsed = now - _class_c_rx_since;
+
+    if (_class_c_rx_open) {
+        if (_rx_sniff.rx_period != 0) {
+            _rx_sniff.sniff_time += elapsed;
+            _rx_sniff.rx_on_time += ((uint64_t) elapsed * _rx_sniff.rx_period)
+                                    / (_rx_sniff.rx_period + _rx_sniff.sleep_period);
+        } else {
+            _rx_sniff.continuous_time += elapsed;
+            _rx_sniff.rx_on_time += elapsed;
+        }
+    }
+
+    _class_c_rx_open = false;
+    _class_c_rx_since = now;
+}
+
+void LoRaMac::get_rx_sniff_metadata(lorawan_rx_sniff_metadata &metadata)
+{
+    Lock lock(*this);
+    bool open = _class_c_rx_open;
+    uint32_t total;
+
+    close_class_c_rx();
+    _class_c_rx_open = open;
+
+    metadata = _rx_sniff;
+    total = metadata.sniff_time + metadata.continuous_time;
+    metadata.efficiency = 0;
+    if (total > metadata.rx_on_time) {
+        metadata.efficiency = ((uint64_t)(total - metadata.rx_on_time) * 1000) / total;
+    }
+}
+
 void LoRaMac::on_ack_timeout_timer_event(void)
 {
     Lock lock(*this);
@@ -968,6 +1232,7 @@ void LoRaMac::on_ack_timeout_timer_event(void)
 
     tr_debug("ACK_TIMEOUT Elapses, Retrying ...");
     _lora_time.stop(_params.timers.ack_timeout_timer);
+    _retry_pending = false;
 
     // reduce data rate on every 2nd attempt if and only if the
     // ADR is on
@@ -1018,6 +1283,306 @@ void LoRaMac::on_ack_timeout_timer_event(void)
     _params.ack_timeout_retry_counter++;
 }
 
+void LoRaMac::on_beacon_timer_event(void)
+{
+    Lock lock(*this);
+
+    _lora_time.stop(_beacon_timer);
+
+    if (_beacon_state == BEACON_STATE_SCAN) {
+        // A whole beacon period went by without a beacon
+        tr_debug("Beacon not found");
+        stop_beacon_tracking();
+        send_class_b_event(BEACON_NOT_FOUND);
+        return;
+    }
+
+    if (_beacon_state == BEACON_STATE_OFF) {
+        return;
+    }
+
+    if (class_a_exchange_ongoing()) {
+        tr_debug("Radio busy, skip beacon window");
+        handle_beacon_miss();
+        return;
+    }
+
+    _class_b_rx_open = true;
+    _params.rx_slot = RX_SLOT_BEACON;
+    _lora_phy->rx_config(&_beacon_rx_config);
+    _lora_phy->handle_receive();
+}
+
+void LoRaMac::on_ping_slot_timer_event(void)
+{
+    Lock lock(*this);
+
+    _lora_time.stop(_ping_slot_timer);
+
+    if (_device_class != CLASS_B) {
+        return;
+    }
+
+    uint64_t slot_time = _ping_slot_time;
+    rx_config_params_t rx_config = _ping_slot_rx_config;
+
+    // The next one is due a ping period later at the earliest
+    schedule_ping_slot(slot_time + 1);
+
+    if (class_a_exchange_ongoing() || _class_b_rx_open) {
+        tr_debug("Radio busy, skip ping slot");
+        return;
+    }
+
+    rx_config.frequency = _params.sys_params.ping_slot_channel.frequency;
+    rx_config.dl_dwell_time = _params.sys_params.downlink_dwell_time;
+    rx_config.is_repeater_supported = _params.is_repeater_supported;
+    rx_config.is_rx_continuous = false;
+
+    _class_b_rx_open = true;
+    _params.rx_slot = RX_SLOT_WIN_PING_SLOT;
+    _mcps_indication.rx_datarate = rx_config.datarate;
+
+    _lora_phy->rx_config(&rx_config);
+    _lora_phy->handle_receive();
+}
+
+bool LoRaMac::schedule_beacon_window(uint32_t beacon_time)
+{
+    uint64_t gps_time = beacon_time * 1000ULL;
+    int32_t delay;
+    bool fits;
+
+    _lora_time.stop(_beacon_timer);
+    _beacon_time = beacon_time;
+
+    _beacon_rx_config.rx_slot = RX_SLOT_BEACON;
+    _beacon_rx_config.frequency = _params.sys_params.beacon_frequency;
+    _beacon_rx_config.is_rx_continuous = false;
+    _lora_phy->compute_rx_win_params(_lora_phy->get_beacon_datarate(),
+                                     MBED_CONF_LORA_DOWNLINK_PREAMBLE_LENGTH,
+                                     _class_b.get_uncertainty(gps_time),
+                                     &_beacon_rx_config);
+
+    fits = _beacon_rx_config.window_timeout <= CLASS_B_MAX_RX_SYMBOLS;
+    _beacon_rx_config.window_timeout = MIN(_beacon_rx_config.window_timeout,
+                                           CLASS_B_MAX_RX_SYMBOLS);
+
+    delay = (int32_t)(_class_b.to_local_time(gps_time)
+                      + _beacon_rx_config.window_offset
+                      - _lora_time.get_current_time());
+    _lora_time.start(_beacon_timer, MAX(delay, 0));
+
+    return fits;
+}
+
+void LoRaMac::schedule_ping_slot(uint64_t gps_time)
+{
+    lorawan_time_t now = _lora_time.get_current_time();
+    int32_t delay;
+
+    _lora_time.stop(_ping_slot_timer);
+
+    while (_class_b.get_next_ping_slot(gps_time, _ping_slot_time)) {
+        _ping_slot_rx_config.rx_slot = RX_SLOT_WIN_PING_SLOT;
+        _lora_phy->compute_rx_win_params(_params.sys_params.ping_slot_channel.datarate,
+                                         MBED_CONF_LORA_DOWNLINK_PREAMBLE_LENGTH,
+                                         _class_b.get_uncertainty(_ping_slot_time),
+                                         &_ping_slot_rx_config);
+        _ping_slot_rx_config.window_timeout = MIN(_ping_slot_rx_config.window_timeout,
+                                                  CLASS_B_MAX_RX_SYMBOLS);
+
+        delay = (int32_t)(_class_b.to_local_time(_ping_slot_time)
+                          + _ping_slot_rx_config.window_offset - now);
+        if (delay >= 0) {
+            _lora_time.start(_ping_slot_timer, delay);
+            return;
+        }
+
+        // Too late to open it in time
+        gps_time = _ping_slot_time + 1;
+    }
+}
+
+void LoRaMac::open_beacon_scan(void)
+{
+    _beacon_rx_config.rx_slot = RX_SLOT_BEACON;
+    _beacon_rx_config.frequency = _params.sys_params.beacon_frequency;
+    _beacon_rx_config.is_rx_continuous = true;
+    _lora_phy->compute_rx_win_params(_lora_phy->get_beacon_datarate(),
+                                     MBED_CONF_LORA_DOWNLINK_PREAMBLE_LENGTH,
+                                     MBED_CONF_LORA_MAX_SYS_RX_ERROR,
+                                     &_beacon_rx_config);
+
+    _class_b_rx_open = true;
+    _params.rx_slot = RX_SLOT_BEACON;
+    _lora_phy->rx_config(&_beacon_rx_config);
+    _lora_phy->handle_receive();
+}
+
+void LoRaMac::handle_beacon(const uint8_t *payload, uint16_t size, int16_t rssi,
+                            int8_t snr, lorawan_time_t timestamp)
+{
+    lorawan_beacon_t beacon;
+    bool found = (_beacon_state != BEACON_STATE_TRACK);
+
+    // The radio is still set up for the beacon, timestamp is its end
+    lorawan_time_t start = timestamp - _lora_phy->get_rx_time_on_air(MODEM_LORA, size);
+
+    _class_b_rx_open = false;
+    _lora_phy->put_radio_to_sleep();
+
+    if (_beacon_state == BEACON_STATE_OFF) {
+        return;
+    }
+
+    if (!LoRaMacClassB::parse_beacon(payload, size, _lora_phy->get_beacon_rfu1_size(), beacon)
+            || (beacon.time % (CLASS_B_BEACON_PERIOD / 1000)) != 0) {
+        tr_debug("Beacon CRC failed");
+        if (_beacon_state == BEACON_STATE_SCAN) {
+            open_beacon_scan();
+        } else {
+            handle_beacon_miss();
+        }
+        return;
+    }
+
+    beacon.rssi = rssi;
+    beacon.snr = snr;
+    beacon.frequency = _params.sys_params.beacon_frequency;
+    _last_beacon = beacon;
+    _last_beacon_valid = true;
+
+    _class_b.beacon_received(beacon.time, start);
+    _beacon_state = BEACON_STATE_TRACK;
+    tr_debug("Beacon %lu, drift %ld ppb", beacon.time, _class_b.get_drift());
+
+    schedule_beacon_window(beacon.time + CLASS_B_BEACON_PERIOD / 1000);
+    start_ping_slots(beacon.time);
+
+    if (found) {
+        send_class_b_event(BEACON_FOUND);
+    }
+}
+
+void LoRaMac::handle_beacon_miss(void)
+{
+    uint32_t beacon_time = _beacon_time;
+
+    if (_beacon_state == BEACON_STATE_ACQUIRE) {
+        tr_debug("Beacon not found");
+        stop_beacon_tracking();
+        send_class_b_event(BEACON_NOT_FOUND);
+        return;
+    }
+
+    if (!_class_b.beacon_missed(beacon_time)) {
+        tr_debug("Beacon lost");
+        stop_beacon_tracking();
+        send_class_b_event(BEACON_LOST);
+        return;
+    }
+
+    // Beacon-less operation, the ping slots go on
+    tr_debug("Beacon %lu missed", beacon_time);
+    schedule_beacon_window(beacon_time + CLASS_B_BEACON_PERIOD / 1000);
+    start_ping_slots(beacon_time);
+    send_class_b_event(BEACON_MISSED);
+}
+
+void LoRaMac::start_ping_slots(uint32_t beacon_time)
+{
+    uint16_t ping_offset;
+
+    if (_lora_crypto.compute_ping_offset(beacon_time, _params.dev_addr,
+                                        _class_b.get_ping_period(),
+                                        &ping_offset) != 0) {
+        tr_error("Ping offset failed");
+        _lora_time.stop(_ping_slot_timer);
+        return;
+    }
+
+    _class_b.set_ping_offset(beacon_time, ping_offset);
+
+    if (_device_class == CLASS_B) {
+        schedule_ping_slot(_class_b.to_gps_time(_lora_time.get_current_time()));
+    }
+}
+
+void LoRaMac::stop_beacon_tracking(void)
+{
+    _lora_time.stop(_beacon_timer);
+    _lora_time.stop(_ping_slot_timer);
+
+    if (_class_b_rx_open) {
+        _class_b_rx_open = false;
+        _lora_phy->put_radio_to_sleep();
+    }
+
+    _beacon_state = BEACON_STATE_OFF;
+
+    if (_device_class == CLASS_B) {
+        tr_debug("Changing device class to -> CLASS_A");
+        _device_class = CLASS_A;
+    }
+}
+
+void LoRaMac::close_class_b_rx(void)
+{
+    if (!_class_b_rx_open) {
+        return;
+    }
+
+    _class_b_rx_open = false;
+    if (_params.rx_slot == RX_SLOT_BEACON && _beacon_state != BEACON_STATE_SCAN) {
+        handle_beacon_miss();
+    }
+}
+
+void LoRaMac::resume_beacon_scan(void)
+{
+    if (_beacon_state == BEACON_STATE_SCAN && !_class_b_rx_open
+            && !class_a_exchange_ongoing()) {
+        open_beacon_scan();
+    }
+}
+
+bool LoRaMac::class_a_exchange_ongoing(void)
+{
+    return _radio_tx_ongoing || _demod_ongoing
+           || _params.timers.rx_window1_timer.timer_id != 0
+           || _params.timers.rx_window2_timer.timer_id != 0;
+}
+
+void LoRaMac::handle_class_b_answers(void)
+{
+    uint64_t gps_time;
+
+    if (_mac_commands.get_device_time_ans(gps_time)) {
+        // The network time is that of the end of the uplink
+        _class_b.set_time(gps_time, _params.timers.aggregated_last_tx_time,
+                          DEVICE_TIME_SYNC_ERROR);
+        send_class_b_event(DEVICE_TIME_SYNCHED);
+    }
+
+    if (_mac_commands.get_ping_slot_info_ans()) {
+        _class_b.set_ping_slot_periodicity(_pending_ping_slot_periodicity);
+        if (_beacon_state == BEACON_STATE_TRACK) {
+            gps_time = _class_b.to_gps_time(_lora_time.get_current_time());
+            start_ping_slots((uint32_t)(gps_time / CLASS_B_BEACON_PERIOD)
+                             * (CLASS_B_BEACON_PERIOD / 1000));
+        }
+        send_class_b_event(PING_SLOT_INFO_SYNCHED);
+    }
+}
+
+void LoRaMac::send_class_b_event(lorawan_event_t event)
+{
+    if (_class_b_event_handler) {
+        _class_b_event_handler(event);
+    }
+}
+
 bool LoRaMac::validate_payload_length(uint16_t length,
                                       int8_t datarate,
                                       uint8_t fopts_len)
@@ -1053,7 +1618,8 @@ lorawan_status_t LoRaMac::send(loramac_mhdr_t *machdr, const uint8_t fport,
 
     fctrl.value = 0;
     fctrl.bits.fopts_len = 0;
-    fctrl.bits.fpending = 0;
+    // The FPending bit of an uplink is the ClassB bit
+    fctrl.bits.fpending = (_device_class == CLASS_B);
     fctrl.bits.ack = false;
     fctrl.bits.adr_ack_req = false;
     fctrl.bits.adr = _params.sys_params.adr_on;
@@ -1080,6 +1646,124 @@ int LoRaMac::get_backoff_timer_event_id(void)
     return _params.timers.backoff_timer.timer_id;
 }
 
+uint8_t LoRaMac::get_max_possible_tx_size(void)
+{
+    uint8_t fopts_len = _mac_commands.get_mac_cmd_length()
+                        + _mac_commands.get_repeat_commands_length();
+    int8_t datarate = _params.sys_params.channel_data_rate;
+    int8_t tx_power = _params.sys_params.channel_tx_power;
+    uint32_t adr_ack_counter = _params.adr_ack_counter;
+    uint8_t max_size;
+
+    if (_params.sys_params.adr_on) {
+        _lora_phy->get_next_ADR(false, datarate, tx_power, adr_ack_counter);
+    }
+
+    max_size = _lora_phy->get_max_payload(datarate, _params.is_repeater_supported);
+
+    // MAC commands that do not fit are dropped by the send path
+    if (max_size >= fopts_len) {
+        max_size -= fopts_len;
+    }
+
+    if (max_size > MBED_CONF_LORA_TX_MAX_SIZE) {
+        max_size = MBED_CONF_LORA_TX_MAX_SIZE;
+    }
+
+    return max_size;
+}
+
+void LoRaMac::get_session(lorawan_session_params_t &session,
+                          uint32_t &ul_frame_counter, uint32_t &dl_frame_counter)
+{
+    uint8_t nb_channels = MIN(_lora_phy->get_max_nb_channels(), LORAWAN_SESSION_MAX_CHANNELS);
+    uint8_t mask_size = MIN((_lora_phy->get_max_nb_channels() + 15) / 16, LORAWAN_SESSION_MASK_SIZE);
+
+    // Padding included, equal sessions compare equal byte by byte
+    memset(&session, 0, sizeof(session));
+
+    session.dev_addr = _params.dev_addr;
+    session.net_id = _params.net_id;
+    memcpy(session.nwk_skey, _params.keys.nwk_skey, sizeof(session.nwk_skey));
+    memcpy(session.app_skey, _params.keys.app_skey, sizeof(session.app_skey));
+    session.datarate = _params.sys_params.channel_data_rate;
+    session.tx_power = _params.sys_params.channel_tx_power;
+    session.adr_on = _params.sys_params.adr_on;
+    session.nb_trans = _params.sys_params.nb_trans;
+    session.rx1_dr_offset = _params.sys_params.rx1_dr_offset;
+    session.rx2_datarate = _params.sys_params.rx2_channel.datarate;
+    session.rx2_frequency = _params.sys_params.rx2_channel.frequency;
+    session.recv_delay1 = _params.sys_params.recv_delay1;
+    session.nb_channels = nb_channels;
+    memcpy(session.channel_mask, _lora_phy->get_channel_mask(),
+           mask_size * sizeof(uint16_t));
+    memcpy(session.channels, _lora_phy->get_phy_channels(),
+           nb_channels * sizeof(channel_params_t));
+
+    ul_frame_counter = _params.ul_frame_counter;
+    dl_frame_counter = _params.dl_frame_counter;
+}
+
+lorawan_status_t LoRaMac::restore_session(const lorawan_session_params_t &session,
+                                          uint32_t ul_frame_counter,
+                                          uint32_t dl_frame_counter)
+{
+    uint8_t mask_size = MIN((_lora_phy->get_max_nb_channels() + 15) / 16, LORAWAN_SESSION_MASK_SIZE);
+
+    if (session.dev_addr == 0
+            || session.nb_channels != MIN(_lora_phy->get_max_nb_channels(),
+                                          LORAWAN_SESSION_MAX_CHANNELS)) {
+        // Not a session of this region
+        return LORAWAN_STATUS_PARAMETER_INVALID;
+    }
+
+    _params.dev_addr = session.dev_addr;
+    _params.net_id = session.net_id;
+    memcpy(_params.keys.nwk_skey, session.nwk_skey, sizeof(_params.keys.nwk_skey));
+    memcpy(_params.keys.app_skey, session.app_skey, sizeof(_params.keys.app_skey));
+    _params.sys_params.channel_data_rate = session.datarate;
+    _params.sys_params.channel_tx_power = session.tx_power;
+    _params.sys_params.adr_on = session.adr_on;
+    _params.sys_params.nb_trans = session.nb_trans;
+    _params.sys_params.rx1_dr_offset = session.rx1_dr_offset;
+    _params.sys_params.rx2_channel.datarate = session.rx2_datarate;
+    _params.sys_params.rx2_channel.frequency = session.rx2_frequency;
+    _params.sys_params.recv_delay1 = session.recv_delay1;
+    _params.sys_params.recv_delay2 = session.recv_delay1 + 1000;
+    memcpy(_lora_phy->get_channel_mask(), session.channel_mask,
+           mask_size * sizeof(uint16_t));
+    memcpy(_lora_phy->get_phy_channels(), session.channels,
+           session.nb_channels * sizeof(channel_params_t));
+
+    _params.ul_frame_counter = ul_frame_counter;
+    _params.dl_frame_counter = dl_frame_counter;
+    _params.adr_ack_counter = 0;
+    _params.ul_nb_rep_counter = 0;
+
+    return LORAWAN_STATUS_OK;
+}
+
+void LoRaMac::get_join_state(lorawan_join_params_t &params, uint16_t &dev_nonce)
+{
+    seed_dev_nonce();
+
+    params = _join_params;
+    dev_nonce = _next_dev_nonce;
+}
+
+void LoRaMac::set_join_state(const lorawan_join_params_t &params, uint16_t dev_nonce)
+{
+    memset(&_join_params, 0, sizeof(_join_params));
+
+    if (params.accepted && params.channel < _lora_phy->get_max_nb_channels()
+            && _lora_phy->verify_tx_datarate(params.datarate)) {
+        _join_params = params;
+    }
+
+    _next_dev_nonce = dev_nonce;
+    _next_dev_nonce_valid = true;
+}
+
 lorawan_status_t LoRaMac::clear_tx_pipe(void)
 {
     if (!_can_cancel_tx) {
@@ -1137,6 +1821,12 @@ lorawan_status_t LoRaMac::schedule_tx()
     next_channel.dc_enabled = _params.is_dutycycle_on;
     next_channel.joined = _is_nwk_joined;
     next_channel.last_aggregate_tx_time = _params.timers.aggregated_last_tx_time;
+    next_channel.join_trial = _params.join_request_trial_counter;
+    next_channel.preferred_channel = -1;
+    if (!_is_nwk_joined && _params.join_request_trial_counter == 0
+            && _join_params.accepted) {
+        next_channel.preferred_channel = _join_params.channel;
+    }
 
     lorawan_status_t status = _lora_phy->set_next_channel(&next_channel,
                                                           &channel,
@@ -1155,7 +1845,8 @@ lorawan_status_t LoRaMac::schedule_tx()
             if (backoff_time != 0) {
                 tr_debug("DC enforced: Transmitting in %lu ms", backoff_time);
                 _can_cancel_tx = true;
-                _lora_time.start(_params.timers.backoff_timer, backoff_time);
+                _lora_time.start(_params.timers.backoff_timer, backoff_time,
+                                 MAC_TIMER_SLACK);
             }
             return LORAWAN_STATUS_OK;
         default:
@@ -1397,6 +2088,8 @@ lorawan_status_t LoRaMac::send_ongoing_tx()
 
     _params.ack_timeout_retry_counter = 1;
     _params.max_ack_timeout_retries = 1;
+    _retry_backoff = 0;
+    _retry_pending = false;
 
     if (MCPS_UNCONFIRMED == _ongoing_tx_msg.type) {
         machdr.bits.mtype = FRAME_TYPE_DATA_UNCONFIRMED_UP;
@@ -1431,9 +2124,19 @@ device_class_t LoRaMac::get_device_class() const
     return _device_class;
 }
 
-void LoRaMac::set_device_class(const device_class_t &device_class,
-                               mbed::Callback<void(void)>rx2_would_be_closure_handler)
+lorawan_status_t LoRaMac::set_device_class(const device_class_t &device_class,
+                                           mbed::Callback<void(void)>rx2_would_be_closure_handler)
 {
+    if (CLASS_B == device_class && _beacon_state != BEACON_STATE_TRACK) {
+        return LORAWAN_STATUS_NO_BEACON_FOUND;
+    }
+
+    close_class_c_rx();
+    if (CLASS_C == device_class) {
+        // Class C leaves no time for the beacon
+        stop_beacon_tracking();
+    }
+
     _device_class = device_class;
     _rx2_would_be_closure_for_class_c = rx2_would_be_closure_handler;
 
@@ -1441,10 +2144,17 @@ void LoRaMac::set_device_class(const device_class_t &device_class,
 
     if (CLASS_A == _device_class) {
         tr_debug("Changing device class to -> CLASS_A");
+        _lora_time.stop(_ping_slot_timer);
+        close_class_b_rx();
         _lora_phy->put_radio_to_sleep();
+        _demod_ongoing = false;
+    } else if (CLASS_B == _device_class) {
+        tr_debug("Changing device class to -> CLASS_B");
+        schedule_ping_slot(_class_b.to_gps_time(_lora_time.get_current_time()));
     } else if (CLASS_C == _device_class) {
         _params.is_node_ack_requested = false;
         _lora_phy->put_radio_to_sleep();
+        _demod_ongoing = false;
         _lora_phy->compute_rx_win_params(_params.sys_params.rx2_channel.datarate,
                                          MBED_CONF_LORA_DOWNLINK_PREAMBLE_LENGTH,
                                          MBED_CONF_LORA_MAX_SYS_RX_ERROR,
@@ -1455,6 +2165,8 @@ void LoRaMac::set_device_class(const device_class_t &device_class,
         tr_debug("Changing device class to -> CLASS_C");
         open_rx2_window();
     }
+
+    return LORAWAN_STATUS_OK;
 }
 
 void LoRaMac::setup_link_check_request()
@@ -1466,6 +2178,77 @@ void LoRaMac::setup_link_check_request()
     _mac_commands.add_link_check_req();
 }
 
+lorawan_status_t LoRaMac::setup_device_time_request(void)
+{
+    return _mac_commands.add_device_time_req();
+}
+
+lorawan_status_t LoRaMac::setup_ping_slot_info_request(uint8_t periodicity)
+{
+    if (!_lora_phy->is_class_b_supported()) {
+        return LORAWAN_STATUS_UNSUPPORTED;
+    }
+
+    if (periodicity > 7) {
+        return LORAWAN_STATUS_PARAMETER_INVALID;
+    }
+
+    _pending_ping_slot_periodicity = periodicity;
+    return _mac_commands.add_ping_slot_info_req(periodicity);
+}
+
+lorawan_status_t LoRaMac::enable_beacon_acquisition(void)
+{
+    Lock lock(*this);
+
+    if (!_is_nwk_joined) {
+        return LORAWAN_STATUS_NO_NETWORK_JOINED;
+    }
+
+    if (!_lora_phy->is_class_b_supported() || _device_class == CLASS_C) {
+        return LORAWAN_STATUS_UNSUPPORTED;
+    }
+
+    if (_beacon_state != BEACON_STATE_OFF) {
+        return LORAWAN_STATUS_BUSY;
+    }
+
+    if (_class_b.is_time_synced()) {
+        uint64_t gps_time = _class_b.to_gps_time(_lora_time.get_current_time());
+
+        // A window at the next beacon, unless the time is too far off for it
+        _beacon_state = BEACON_STATE_ACQUIRE;
+        if (schedule_beacon_window(LoRaMacClassB::get_next_beacon_time(gps_time))) {
+            return LORAWAN_STATUS_OK;
+        }
+    }
+
+    tr_debug("Searching for the beacon");
+    _beacon_state = BEACON_STATE_SCAN;
+    _lora_time.stop(_beacon_timer);
+    _lora_time.start(_beacon_timer, CLASS_B_BEACON_PERIOD + CLASS_B_BEACON_RESERVED);
+    resume_beacon_scan();
+
+    return LORAWAN_STATUS_OK;
+}
+
+lorawan_status_t LoRaMac::get_last_beacon(lorawan_beacon_t &beacon)
+{
+    Lock lock(*this);
+
+    if (!_last_beacon_valid) {
+        return LORAWAN_STATUS_METADATA_NOT_AVAILABLE;
+    }
+
+    beacon = _last_beacon;
+    return LORAWAN_STATUS_OK;
+}
+
+void LoRaMac::set_class_b_event_callback(mbed::Callback<void(lorawan_event_t)> handler)
+{
+    _class_b_event_handler = handler;
+}
+
 lorawan_status_t LoRaMac::prepare_join(const lorawan_connect_t *params, bool is_otaa)
 {
     if (params) {
@@ -1604,7 +2387,10 @@ lorawan_status_t LoRaMac::prepare_frame(loramac_mhdr_t *machdr,
                                      _params.keys.dev_eui, 8);
             _params.tx_buffer_len += 8;
 
-            _params.dev_nonce = _lora_phy->get_radio_rng();
+            // Counting up rather than drawing at random, a DevNonce the
+            // network server has seen before gets the join request dropped
+            seed_dev_nonce();
+            _params.dev_nonce = _next_dev_nonce++;
 
             _params.tx_buffer[_params.tx_buffer_len++] = _params.dev_nonce & 0xFF;
             _params.tx_buffer[_params.tx_buffer_len++] = (_params.dev_nonce >> 8) & 0xFF;
@@ -1761,12 +2547,16 @@ lorawan_status_t LoRaMac::send_frame_on_channel(uint8_t channel)
     _mcps_confirmation.channel = channel;
 
     _mcps_confirmation.tx_toa = _params.timers.tx_toa;
+    _mcps_confirmation.airtime += _params.timers.tx_toa;
     _mlme_confirmation.tx_toa = _params.timers.tx_toa;
 
     if (!_is_nwk_joined) {
         _params.join_request_trial_counter++;
     }
 
+    close_class_c_rx();
+    close_class_b_rx();
+    _radio_tx_ongoing = true;
     _lora_phy->handle_send(_params.tx_buffer, _params.tx_buffer_len);
 
     return LORAWAN_STATUS_OK;
@@ -1831,6 +2621,10 @@ lorawan_status_t LoRaMac::initialize(EventQueue *queue,
                     mbed::callback(this, &LoRaMac::open_rx2_window));
     _lora_time.init(_params.timers.ack_timeout_timer,
                     mbed::callback(this, &LoRaMac::on_ack_timeout_timer_event));
+    _lora_time.init(_beacon_timer,
+                    mbed::callback(this, &LoRaMac::on_beacon_timer_event));
+    _lora_time.init(_ping_slot_timer,
+                    mbed::callback(this, &LoRaMac::on_ping_slot_timer_event));
 
     _params.timers.mac_init_time = _lora_time.get_current_time();
 
@@ -1847,6 +2641,10 @@ void LoRaMac::disconnect()
     _lora_time.stop(_params.timers.rx_window2_timer);
     _lora_time.stop(_params.timers.ack_timeout_timer);
 
+    stop_beacon_tracking();
+    _class_b.reset();
+    _last_beacon_valid = false;
+
     _lora_phy->put_radio_to_sleep();
 
     _is_nwk_joined = false;
@@ -48,6 +48,7 @@
 #include "../../system/lorawan_data_structures.h"
 
 #include "LoRaMacChannelPlan.h"
+#include "LoRaMacClassB.h"
 #include "LoRaMacCommand.h"
 #include "LoRaMacCrypto.h"
 #if MBED_CONF_RTOS_PRESENT
@@ -300,9 +301,12 @@ public:
      * @param device_class Device class to use.
      * @param rx2_would_be_closure_handler callback function to inform about
      *        would be closure of RX2 window
+     *
+     * @return LORAWAN_STATUS_OK, or LORAWAN_STATUS_NO_BEACON_FOUND if Class B
+     *         is asked for while no beacon is tracked.
      */
-    void set_device_class(const device_class_t &device_class,
-                          mbed::Callback<void(void)>rx2_would_be_closure_handler);
+    lorawan_status_t set_device_class(const device_class_t &device_class,
+                                      mbed::Callback<void(void)>rx2_would_be_closure_handler);
 
     /**
      * @brief setup_link_check_request Adds link check request command
@@ -310,6 +314,39 @@ public:
      */
     void setup_link_check_request();
 
+    /**
+     * @brief Adds a DeviceTimeReq command to the next outgoing message,
+     *        the answer sets the network time for the beacon acquisition
+     */
+    lorawan_status_t setup_device_time_request(void);
+
+    /**
+     * @brief Adds a PingSlotInfoReq command to the next outgoing message,
+     *        the periodicity is used once the network server answered
+     *
+     * @param periodicity 2^periodicity seconds between ping slots, 0..7
+     */
+    lorawan_status_t setup_ping_slot_info_request(uint8_t periodicity);
+
+    /**
+     * @brief Starts looking for the beacon: a window at the next beacon if
+     *        the network time is known, a reception over a whole beacon
+     *        period otherwise. Reports BEACON_FOUND or BEACON_NOT_FOUND.
+     */
+    lorawan_status_t enable_beacon_acquisition(void);
+
+    /**
+     * @brief Copies the last beacon received
+     *
+     * @return LORAWAN_STATUS_METADATA_NOT_AVAILABLE if there was none
+     */
+    lorawan_status_t get_last_beacon(lorawan_beacon_t &beacon);
+
+    /**
+     * @brief Sets the handler of the Class B events (BEACON_FOUND etc.)
+     */
+    void set_class_b_event_callback(mbed::Callback<void(lorawan_event_t)> handler);
+
     /**
      * @brief prepare_join prepares arguments to be ready for join() call.
      * @param params Join parameters to use, if NULL, the default will be used.
@@ -332,10 +369,11 @@ public:
     void on_radio_tx_done(lorawan_time_t timestamp);
 
     /**
-     * MAC operations upon reception
+     * MAC operations upon reception, timestamp being the time at the end
+     * of the frame
      */
     void on_radio_rx_done(const uint8_t *const payload, uint16_t size,
-                          int16_t rssi, int8_t snr);
+                          int16_t rssi, int8_t snr, lorawan_time_t timestamp);
 
     /**
      * MAC operations upon transmission timeout
@@ -365,6 +403,19 @@ public:
      */
     bool continue_sending_process(void);
 
+    /**
+     * Sets the retransmission policy for CONFIRMED messages.
+     */
+    void set_retry_policy(const lorawan_retry_policy_t &policy);
+
+    /**
+     * Drops the ongoing CONFIRMED message if it is waiting for its
+     * retransmission.
+     *
+     * @returns true if the message was dropped
+     */
+    bool cancel_retry(void);
+
     /**
      * Read-only access to MAC primitive blocks
      */
@@ -387,11 +438,56 @@ public:
      */
     void set_batterylevel_callback(mbed::Callback<uint8_t(void)> battery_level);
 
+    /**
+     * Set receive window notification callback
+     */
+    void set_rx_window_callback(mbed::Callback<void(uint8_t, lorawan_rx_window_event_t, int32_t)> rx_window);
+
     /**
      * Returns the event ID of backoff timer.
      */
     int get_backoff_timer_event_id(void);
 
+    /**
+     * Returns the biggest FRMPayload the next uplink can carry on the datarate
+     * ADR would pick, after the MAC commands queued for piggybacking. Unlike
+     * the send path, the queued MAC commands are left untouched.
+     */
+    uint8_t get_max_possible_tx_size(void);
+
+    /**
+     * Copies the joined session and its frame counters, the uplink counter
+     * being the one of the next uplink.
+     */
+    void get_session(lorawan_session_params_t &session,
+                     uint32_t &ul_frame_counter, uint32_t &dl_frame_counter);
+
+    /**
+     * Takes over a session from get_session(), e.g. stored before a reset.
+     * The caller still has to mark the network as joined.
+     */
+    lorawan_status_t restore_session(const lorawan_session_params_t &session,
+                                     uint32_t ul_frame_counter,
+                                     uint32_t dl_frame_counter);
+
+    /**
+     * Copies the join state, the DevNonce being the one of the next join
+     * request.
+     */
+    void get_join_state(lorawan_join_params_t &params, uint16_t &dev_nonce);
+
+    /**
+     * Takes over a join state from get_join_state(), e.g. stored before a
+     * reset. Join parameters of another region are dropped.
+     */
+    void set_join_state(const lorawan_join_params_t &params, uint16_t dev_nonce);
+
+    /**
+     * Copies the Class C reception statistics, the ongoing reception
+     * counted up to now.
+     */
+    void get_rx_sniff_metadata(lorawan_rx_sniff_metadata &metadata);
+
     /**
      * Clears out the TX pipe by discarding any outgoing message if the backoff
      * timer is still running.
@@ -485,6 +581,12 @@ private:
      */
     lorawan_status_t send_join_request();
 
+    /**
+     * Seeds the DevNonce counter from the radio unless it was set with
+     * set_join_state()
+     */
+    void seed_dev_nonce();
+
     /**
      * Handles retransmissions
      */
@@ -532,12 +634,100 @@ private:
      */
     void open_rx2_window(void);
 
+    /**
+     * Adds the time since the Class C reception was opened to the
+     * statistics, the receiver having been taken over for something else.
+     */
+    void close_class_c_rx(void);
+
+    /**
+     * Passes a receive window event of a Class A slot to the application.
+     */
+    void notify_rx_window(rx_slot_t slot, lorawan_rx_window_event_t event, int32_t value);
+
     /**
      * A method to retry a CONFIRMED message after a particular time period
      * (ACK_TIMEOUT = TIME_IN_MS) if the ack was not received
      */
     void on_ack_timeout_timer_event(void);
 
+    /**
+     * Class B: the beacon timer opens the beacon window or ends the beacon
+     * search, the ping slot timer opens a ping slot
+     */
+    void on_beacon_timer_event(void);
+    void on_ping_slot_timer_event(void);
+
+    /**
+     * Starts the timer of the beacon window of beacon_time [s]
+     *
+     * @return false if the window is too narrow for the time uncertainty
+     */
+    bool schedule_beacon_window(uint32_t beacon_time);
+
+    /**
+     * Starts the timer of the first ping slot at or after gps_time [ms]
+     */
+    void schedule_ping_slot(uint64_t gps_time);
+
+    /**
+     * Opens the continuous reception of the beacon search
+     */
+    void open_beacon_scan(void);
+
+    /**
+     * Takes over a beacon, or counts it as missed if it is broken
+     */
+    void handle_beacon(const uint8_t *payload, uint16_t size, int16_t rssi,
+                       int8_t snr, lorawan_time_t timestamp);
+
+    /**
+     * Counts the expected beacon as missed, stops the tracking once the
+     * beacon-less period is over
+     */
+    void handle_beacon_miss(void);
+
+    /**
+     * Computes the ping offset of the beacon period starting at beacon_time
+     * and schedules its ping slots
+     */
+    void start_ping_slots(uint32_t beacon_time);
+
+    /**
+     * Stops the beacon tracking and the ping slots, a Class B device falls
+     * back to Class A
+     */
+    void stop_beacon_tracking(void);
+
+    /**
+     * A Class B window gives way to a Class A exchange. A beacon window
+     * closed early counts as missed.
+     */
+    void close_class_b_rx(void);
+
+    /**
+     * Picks up the beacon search again after a Class A exchange
+     */
+    void resume_beacon_scan(void);
+
+    /**
+     * Checks if an uplink or its receive windows use the radio
+     */
+    bool class_a_exchange_ongoing(void);
+
+    /**
+     * Applies DeviceTimeAns and PingSlotInfoAns of the last downlink
+     */
+    void handle_class_b_answers(void);
+
+    void send_class_b_event(lorawan_event_t event);
+
+    /**
+     * Extra wait before the next retransmission of the ongoing CONFIRMED
+     * message as the retry policy has it, negative if it gives up
+     */
+    int32_t get_retry_backoff(void);
+
     /*!
      * \brief Check if the OnAckTimeoutTimer has do be disabled. If so, the
      *        function disables it.
@@ -666,8 +856,24 @@ private:
      */
     mbed::Callback<void(void)> _scheduling_failure_handler;
 
+    /**
+     * Optional, informs the application about the Class A receive windows
+     * (see lorawan_app_callbacks_t::rx_window).
+     */
+    mbed::Callback<void(uint8_t, lorawan_rx_window_event_t, int32_t)> _rx_window_handler;
+
     timer_event_t _rx2_closure_timer_for_class_c;
 
+    /**
+     * Class B timing, events and timers
+     */
+    LoRaMacClassB _class_b;
+    mbed::Callback<void(lorawan_event_t)> _class_b_event_handler;
+    timer_event_t _beacon_timer;
+    timer_event_t _ping_slot_timer;
+    rx_config_params_t _beacon_rx_config;
+    rx_config_params_t _ping_slot_rx_config;
+
     /**
      * Structure to hold MCPS indication data.
      */
@@ -701,6 +907,67 @@ private:
     uint8_t _prev_qos_level;
 
     bool _demod_ongoing;
+
+    /**
+     * Times at which the receive windows of the last uplink are due to open
+     */
+    lorawan_time_t _rx1_due;
+    lorawan_time_t _rx2_due;
+
+    /**
+     * Channel and datarate of the last join-accept, tried first by the next
+     * join procedure
+     */
+    lorawan_join_params_t _join_params;
+
+    /**
+     * DevNonce of the next join request, counting up so that no value is
+     * used twice
+     */
+    uint16_t _next_dev_nonce;
+    bool _next_dev_nonce_valid;
+
+    lorawan_retry_policy_t _retry_policy;
+
+    /**
+     * Extra wait of the coming retransmission, negative if there is none
+     */
+    int32_t _retry_backoff;
+
+    /**
+     * Set while a CONFIRMED message waits for the ACK timeout to retransmit
+     */
+    bool _retry_pending;
+
+    /**
+     * Class C reception statistics and the current check and sleep periods,
+     * both 0 while reception is continuous
+     */
+    lorawan_rx_sniff_metadata _rx_sniff;
+    lorawan_time_t _class_c_rx_since;
+    bool _class_c_rx_open;
+
+    /**
+     * Class B state: the beacon time of the coming beacon window [s], the
+     * start of the coming ping slot [ms] and whether the radio is in one of
+     * them
+     */
+    beacon_state_t _beacon_state;
+    uint32_t _beacon_time;
+    uint64_t _ping_slot_time;
+    bool _class_b_rx_open;
+    lorawan_beacon_t _last_beacon;
+    bool _last_beacon_valid;
+
+    /**
+     * Ping slot periodicity of the PingSlotInfoReq waiting for its answer
+     */
+    uint8_t _pending_ping_slot_periodicity;
+
+    /**
+     * Set from handing a frame to the radio until the end of the transmission
+     */
+    bool _radio_tx_ongoing;
 };
 
 #endif // MBED_LORAWAN_MAC_H__
@@ -0,0 +1,276 @@
+/**
+ * \file      LoRaMacClassB.cpp
+ *
+ * \brief     Class B beacon and ping slot timing
+ *
+ * Copyright (c) 2017, Arm Limited and affiliates.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+#include "LoRaMacClassB.h"
+
+/*!
+ * How far off the start of a received beacon is taken [ms]
+ */
+#define BEACON_SYNC_ERROR               2
+
+/*!
+ * Drift left over once it has been measured [ppb]: the clock changes with
+ * temperature between the beacons it was measured from
+ */
+#define RESIDUAL_DRIFT                  2000
+
+/*!
+ * The drift is measured over at most a day, then against the next beacon
+ */
+#define DRIFT_SPAN_MAX                  86400000
+
+#define PPB                             1000000000LL
+
+LoRaMacClassB::LoRaMacClassB()
+    : _ping_slot_periodicity(CLASS_B_DEFAULT_PERIODICITY)
+{
+    reset();
+}
+
+void LoRaMacClassB::reset(void)
+{
+    _time_synced = false;
+    _gps_ref = 0;
+    _local_ref = 0;
+    _ref_error = 0;
+
+    _anchored = false;
+    _gps_anchor = 0;
+    _local_anchor = 0;
+    _drift_span = 0;
+    _drift = 0;
+
+    _beacon_locked = false;
+    _last_beacon_time = 0;
+
+    _ping_offset_valid = false;
+    _ping_beacon_time = 0;
+    _ping_offset = 0;
+}
+
+void LoRaMacClassB::set_time(uint64_t gps_time, lorawan_time_t local_time,
+                             uint32_t error)
+{
+    // A tracked beacon is the better reference
+    if (_beacon_locked) {
+        return;
+    }
+
+    _gps_ref = gps_time;
+    _local_ref = local_time;
+    _ref_error = error;
+    _time_synced = true;
+}
+
+bool LoRaMacClassB::is_time_synced(void) const
+{
+    return _time_synced;
+}
+
+uint64_t LoRaMacClassB::to_gps_time(lorawan_time_t local_time) const
+{
+    int64_t elapsed = (int32_t)(local_time - _local_ref);
+
+    return _gps_ref + elapsed - (elapsed * _drift) / PPB;
+}
+
+lorawan_time_t LoRaMacClassB::to_local_time(uint64_t gps_time) const
+{
+    int64_t elapsed = (int64_t)(gps_time - _gps_ref);
+
+    return _local_ref + (lorawan_time_t)(elapsed + (elapsed * _drift) / PPB);
+}
+
+uint32_t LoRaMacClassB::get_uncertainty(uint64_t gps_time) const
+{
+    int64_t accuracy = MBED_CONF_LORA_CLASS_B_CLOCK_ACCURACY * 1000LL;
+    int64_t residual = accuracy;
+    int64_t elapsed = (int64_t)(gps_time - _gps_ref);
+
+    if (elapsed < 0) {
+        elapsed = -elapsed;
+    }
+
+    if (_drift_span > 0) {
+        // Both beacons the drift was measured from may be off
+        residual = RESIDUAL_DRIFT + (2 * BEACON_SYNC_ERROR * PPB) / _drift_span;
+        if (residual > accuracy) {
+            residual = accuracy;
+        }
+    }
+
+    return _ref_error + (uint32_t)((elapsed * residual) / PPB) + 1;
+}
+
+int32_t LoRaMacClassB::get_drift(void) const
+{
+    return _drift;
+}
+
+uint32_t LoRaMacClassB::get_next_beacon_time(uint64_t gps_time)
+{
+    uint64_t periods = (gps_time + CLASS_B_BEACON_PERIOD - 1) / CLASS_B_BEACON_PERIOD;
+
+    return (uint32_t)(periods * (CLASS_B_BEACON_PERIOD / 1000));
+}
+
+void LoRaMacClassB::beacon_received(uint32_t beacon_time, lorawan_time_t local_time)
+{
+    uint64_t gps_time = beacon_time * 1000ULL;
+
+    if (_anchored && gps_time > _gps_anchor) {
+        uint64_t span = gps_time - _gps_anchor;
+        int64_t local_span = (int32_t)(local_time - _local_anchor);
+
+        // A measurement over a shorter span than the last one would only
+        // make the drift worse, which is the case after moving the anchor
+        if (span >= _drift_span) {
+            _drift = (int32_t)(((local_span - (int64_t)span) * PPB) / (int64_t)span);
+            _drift_span = (uint32_t)span;
+        }
+
+        if (span >= DRIFT_SPAN_MAX) {
+            _anchored = false;
+        }
+    }
+
+    if (!_anchored) {
+        _gps_anchor = gps_time;
+        _local_anchor = local_time;
+        _anchored = true;
+    }
+
+    _gps_ref = gps_time;
+    _local_ref = local_time;
+    _ref_error = BEACON_SYNC_ERROR;
+    _time_synced = true;
+
+    _beacon_locked = true;
+    _last_beacon_time = beacon_time;
+}
+
+bool LoRaMacClassB::beacon_missed(uint32_t beacon_time)
+{
+    if (!_beacon_locked) {
+        return false;
+    }
+
+    if ((beacon_time - _last_beacon_time) * 1000ULL > CLASS_B_BEACONLESS_PERIOD) {
+        _beacon_locked = false;
+        _anchored = false;
+        _drift_span = 0;
+        _ping_offset_valid = false;
+        return false;
+    }
+
+    return true;
+}
+
+bool LoRaMacClassB::is_beacon_locked(void) const
+{
+    return _beacon_locked;
+}
+
+void LoRaMacClassB::set_ping_slot_periodicity(uint8_t periodicity)
+{
+    _ping_slot_periodicity = periodicity & 0x07;
+}
+
+uint8_t LoRaMacClassB::get_ping_slot_periodicity(void) const
+{
+    return _ping_slot_periodicity;
+}
+
+uint16_t LoRaMacClassB::get_ping_period(void) const
+{
+    // 2^(7 - periodicity) ping slots in CLASS_B_PING_SLOTS
+    return 1 << (5 + _ping_slot_periodicity);
+}
+
+void LoRaMacClassB::set_ping_offset(uint32_t beacon_time, uint16_t ping_offset)
+{
+    _ping_beacon_time = beacon_time;
+    _ping_offset = ping_offset;
+    _ping_offset_valid = true;
+}
+
+bool LoRaMacClassB::get_next_ping_slot(uint64_t gps_time, uint64_t &slot_time) const
+{
+    uint64_t first;
+    uint64_t interval;
+    uint64_t slot;
+
+    if (!_ping_offset_valid) {
+        return false;
+    }
+
+    first = _ping_beacon_time * 1000ULL + CLASS_B_BEACON_RESERVED
+            + _ping_offset * CLASS_B_PING_SLOT_LENGTH;
+    interval = get_ping_period() * CLASS_B_PING_SLOT_LENGTH;
+
+    slot = 0;
+    if (gps_time > first) {
+        slot = (gps_time - first + interval - 1) / interval;
+    }
+
+    if (_ping_offset + slot * get_ping_period() >= CLASS_B_PING_SLOTS) {
+        return false;
+    }
+
+    slot_time = first + slot * interval;
+    return true;
+}
+
+uint16_t LoRaMacClassB::compute_crc(const uint8_t *buffer, uint16_t size)
+{
+    // CRC-16/CCITT, polynomial 0x1021, initial value 0
+    uint16_t crc = 0;
+
+    for (uint16_t i = 0; i < size; i++) {
+        crc ^= (uint16_t) buffer[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+bool LoRaMacClassB::parse_beacon(const uint8_t *payload, uint16_t size,
+                                 uint8_t rfu1_size, lorawan_beacon_t &beacon)
+{
+    // RFU1 | Time | CRC | GwSpecific | RFU2 | CRC
+    uint16_t common = rfu1_size + 4;
+    uint16_t gw_part = size - common - 2;
+    uint16_t crc;
+
+    if (size < common + 2 + sizeof(beacon.gw_specific) + 2) {
+        return false;
+    }
+
+    crc = payload[common] | (payload[common + 1] << 8);
+    if (crc != compute_crc(payload, common)) {
+        return false;
+    }
+
+    beacon.time = payload[rfu1_size] | (payload[rfu1_size + 1] << 8)
+                  | (payload[rfu1_size + 2] << 16)
+                  | ((uint32_t) payload[rfu1_size + 3] << 24);
+
+    payload += common + 2;
+    crc = payload[gw_part - 2] | (payload[gw_part - 1] << 8);
+    if (crc == compute_crc(payload, gw_part - 2)) {
+        memcpy(beacon.gw_specific, payload, sizeof(beacon.gw_specific));
+    } else {
+        memset(beacon.gw_specific, 0, sizeof(beacon.gw_specific));
+    }
+
+    return true;
+}
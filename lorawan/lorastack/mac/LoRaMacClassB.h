@@ -0,0 +1,211 @@
+/**
+ * \file      LoRaMacClassB.h
+ *
+ * \brief     Class B beacon and ping slot timing
+ *
+ * Keeps the network (GPS) time against the local MAC time: set from a
+ * DeviceTimeAns or a received beacon, then carried forward with the drift
+ * of the local clock as measured between beacons. Beacons and ping slots
+ * are scheduled in GPS time and converted to local time, the uncertainty of
+ * the conversion sizes the reception windows. The class holds no radio or
+ * timer state, the MAC layer does the reception.
+ *
+ * LoRaWAN Specification V1.0.3, chapters 8 to 15.
+ *
+ * Copyright (c) 2017, Arm Limited and affiliates.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef MBED_LORAWAN_LORAMACCLASSB_H__
+#define MBED_LORAWAN_LORAMACCLASSB_H__
+
+#include <stdint.h>
+#include "../../system/lorawan_data_structures.h"
+
+/*!
+ * Beacon period and the part of it reserved for the beacon [ms]
+ */
+#define CLASS_B_BEACON_PERIOD           128000
+#define CLASS_B_BEACON_RESERVED         2120
+
+/*!
+ * Ping slot length [ms] and slots per beacon window
+ */
+#define CLASS_B_PING_SLOT_LENGTH        30
+#define CLASS_B_PING_SLOTS              4096
+
+/*!
+ * One ping slot per beacon period until a PingSlotInfoReq is answered
+ */
+#define CLASS_B_DEFAULT_PERIODICITY     7
+
+/*!
+ * Beacon-less operation: how long a device goes on without a beacon [ms]
+ */
+#define CLASS_B_BEACONLESS_PERIOD       7200000
+
+/*!
+ * Beacon acquisition and tracking
+ */
+typedef enum {
+    /*!
+     * Not looking for the beacon
+     */
+    BEACON_STATE_OFF,
+    /*!
+     * Receiving continuously over a beacon period, the time is not known
+     */
+    BEACON_STATE_SCAN,
+    /*!
+     * Waiting for the first beacon in a window, the time is known
+     */
+    BEACON_STATE_ACQUIRE,
+    /*!
+     * Receiving the beacon in a window every beacon period
+     */
+    BEACON_STATE_TRACK
+} beacon_state_t;
+
+class LoRaMacClassB {
+
+public:
+    LoRaMacClassB();
+
+    /**
+     * @brief Forgets the network time, the beacon and the ping slots.
+     *        The ping slot periodicity is kept.
+     */
+    void reset(void);
+
+    /**
+     * @brief Takes over the network time, e.g. of a DeviceTimeAns
+     *
+     * @param [in] gps_time     Milliseconds since the GPS epoch at local_time
+     * @param [in] local_time   MAC time [ms]
+     * @param [in] error        Uncertainty of gps_time [ms]
+     */
+    void set_time(uint64_t gps_time, lorawan_time_t local_time, uint32_t error);
+
+    /**
+     * @brief Checks if the network time is known
+     */
+    bool is_time_synced(void) const;
+
+    /**
+     * @brief Converts between MAC time and GPS time [ms], drift compensated
+     */
+    uint64_t to_gps_time(lorawan_time_t local_time) const;
+    lorawan_time_t to_local_time(uint64_t gps_time) const;
+
+    /**
+     * @brief Gets how far off to_local_time(gps_time) can be [ms]
+     */
+    uint32_t get_uncertainty(uint64_t gps_time) const;
+
+    /**
+     * @brief Gets the clock drift measured between beacons [ppb], positive
+     *        if the local clock runs fast
+     */
+    int32_t get_drift(void) const;
+
+    /**
+     * @brief Gets the beacon time [s] of the first beacon sent at or after
+     *        gps_time [ms]
+     */
+    static uint32_t get_next_beacon_time(uint64_t gps_time);
+
+    /**
+     * @brief Takes over a received beacon
+     *
+     * @param [in] beacon_time  Time carried by the beacon [s]
+     * @param [in] local_time   MAC time at which its transmission started
+     */
+    void beacon_received(uint32_t beacon_time, lorawan_time_t local_time);
+
+    /**
+     * @brief Notes that an expected beacon was not received
+     *
+     * @param [in] beacon_time  Time the beacon would have carried [s]
+     *
+     * @return False once the beacon-less period is over, the beacon is lost
+     */
+    bool beacon_missed(uint32_t beacon_time);
+
+    /**
+     * @brief Checks if a beacon was received within the beacon-less period
+     */
+    bool is_beacon_locked(void) const;
+
+    /**
+     * @brief Sets the ping slot periodicity: 2^periodicity seconds between
+     *        ping slots, 0..7
+     */
+    void set_ping_slot_periodicity(uint8_t periodicity);
+    uint8_t get_ping_slot_periodicity(void) const;
+
+    /**
+     * @brief Gets the slots between two ping slots
+     */
+    uint16_t get_ping_period(void) const;
+
+    /**
+     * @brief Sets the ping offset of the beacon period starting at
+     *        beacon_time [s], see LoRaMacCrypto::compute_ping_offset()
+     */
+    void set_ping_offset(uint32_t beacon_time, uint16_t ping_offset);
+
+    /**
+     * @brief Gets the start of the first ping slot at or after gps_time [ms]
+     *
+     * @return False if it is not in the beacon period of the ping offset
+     */
+    bool get_next_ping_slot(uint64_t gps_time, uint64_t &slot_time) const;
+
+    /**
+     * @brief Checks both CRCs of a beacon payload and takes out its fields
+     *
+     * @param [in] payload      The beacon
+     * @param [in] size         Its size, as defined by the region
+     * @param [in] rfu1_size    Size of the RFU field in front of the time
+     * @param [out] beacon      The beacon time and gateway specific part,
+     *                          the latter zeroed if its CRC failed
+     *
+     * @return False if the CRC of the time failed
+     */
+    static bool parse_beacon(const uint8_t *payload, uint16_t size,
+                             uint8_t rfu1_size, lorawan_beacon_t &beacon);
+
+private:
+    static uint16_t compute_crc(const uint8_t *buffer, uint16_t size);
+
+    /**
+     * The time reference: GPS and MAC time of the last sync and how far off
+     * it was
+     */
+    bool _time_synced;
+    uint64_t _gps_ref;
+    lorawan_time_t _local_ref;
+    uint32_t _ref_error;
+
+    /**
+     * First beacon of the current lock, the drift is measured against it
+     */
+    bool _anchored;
+    uint64_t _gps_anchor;
+    lorawan_time_t _local_anchor;
+    uint32_t _drift_span;
+    int32_t _drift;
+
+    /**
+     * Beacon time of the last beacon received [s]
+     */
+    bool _beacon_locked;
+    uint32_t _last_beacon_time;
+
+    uint8_t _ping_slot_periodicity;
+    bool _ping_offset_valid;
+    uint32_t _ping_beacon_time;
+    uint16_t _ping_offset;
+};
+
+#endif // MBED_LORAWAN_LORAMACCLASSB_H__
@@ -131,6 +131,42 @@ public:
      */
     lorawan_status_t add_link_check_req();
 
+    /**
+     * @brief Adds a new DeviceTimeReq MAC command to be sent.
+     *
+     * @return status  Function status: LORAWAN_STATUS_OK: OK,
+     *                                  LORAWAN_STATUS_LENGTH_ERROR: Buffer full
+     */
+    lorawan_status_t add_device_time_req();
+
+    /**
+     * @brief Adds a new PingSlotInfoReq MAC command to be sent.
+     *
+     * @param [in] periodicity  Ping slot periodicity, 0..7
+     *
+     * @return status  Function status: LORAWAN_STATUS_OK: OK,
+     *                                  LORAWAN_STATUS_LENGTH_ERROR: Buffer full
+     */
+    lorawan_status_t add_ping_slot_info_req(uint8_t periodicity);
+
+    /**
+     * @brief Gets the network time of a DeviceTimeAns received since the
+     *        last call
+     *
+     * @param [out] gps_time  Milliseconds since the GPS epoch at the end of
+     *                        the uplink that carried the DeviceTimeReq
+     *
+     * @return status  True if there was a DeviceTimeAns, false otherwise
+     */
+    bool get_device_time_ans(uint64_t &gps_time);
+
+    /**
+     * @brief Checks for a PingSlotInfoAns received since the last call
+     *
+     * @return status  True if there was a PingSlotInfoAns, false otherwise
+     */
+    bool get_ping_slot_info_ans();
+
     /**
      * @brief Set battery level query callback method
      *        If callback is not set, BAT_LEVEL_NO_MEASURE is returned.
@@ -220,6 +256,26 @@ private:
      */
     lorawan_status_t add_dl_channel_ans(uint8_t status);
 
+    /**
+     * @brief Adds a new PingSlotChannelAns MAC command to be sent.
+     *
+     * @param [in] status Status bits
+     *
+     * @return status  Function status: LORAWAN_STATUS_OK: OK,
+     *                                  LORAWAN_STATUS_LENGTH_ERROR: Buffer full
+     */
+    lorawan_status_t add_ping_slot_channel_ans(uint8_t status);
+
+    /**
+     * @brief Adds a new BeaconFreqAns MAC command to be sent.
+     *
+     * @param [in] status Status bits
+     *
+     * @return status  Function status: LORAWAN_STATUS_OK: OK,
+     *                                  LORAWAN_STATUS_LENGTH_ERROR: Buffer full
+     */
+    lorawan_status_t add_beacon_freq_ans(uint8_t status);
+
 private:
     /**
       * Indicates if there are any pending sticky MAC commands
@@ -247,6 +303,13 @@ private:
      */
     uint8_t mac_cmd_buffer_to_repeat[LORA_MAC_COMMAND_MAX_LENGTH];
 
+    /**
+     * Class B answers not yet taken by the MAC
+     */
+    bool device_time_ans;
+    uint64_t device_time;
+    bool ping_slot_info_ans;
+
     mbed::Callback<uint8_t(void)> _battery_level_cb;
 };
 
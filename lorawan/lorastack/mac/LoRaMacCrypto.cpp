@@ -295,6 +295,43 @@ int LoRaMacCrypto::compute_skeys_for_join_frame(const uint8_t *key, uint32_t key
     memcpy(nonce + 7, p_dev_nonce, 2);
     ret = _mbedtls_aes_crypt_ecb(&aes_ctx, MBEDTLS_AES_ENCRYPT, nonce, app_skey);
 
+exit:
+    _mbedtls_aes_free(&aes_ctx);
+    return ret;
+}
+
+int LoRaMacCrypto::compute_ping_offset(uint32_t beacon_time, uint32_t address,
+                                       uint16_t ping_period, uint16_t *ping_offset)
+{
+    // LoRaWAN Specification V1.0.3, chapter 15.2: the key is all zero
+    const uint8_t key[16] = { 0 };
+    uint8_t block[16];
+    uint8_t rand[16];
+    int ret = 0;
+
+    _mbedtls_aes_init(&aes_ctx);
+
+    ret = _mbedtls_aes_setkey_enc(&aes_ctx, key, sizeof(key) * 8);
+    if (0 != ret) {
+        goto exit;
+    }
+
+    memset(block, 0, sizeof(block));
+    block[0] = beacon_time & 0xFF;
+    block[1] = (beacon_time >> 8) & 0xFF;
+    block[2] = (beacon_time >> 16) & 0xFF;
+    block[3] = (beacon_time >> 24) & 0xFF;
+    block[4] = address & 0xFF;
+    block[5] = (address >> 8) & 0xFF;
+    block[6] = (address >> 16) & 0xFF;
+    block[7] = (address >> 24) & 0xFF;
+    ret = _mbedtls_aes_crypt_ecb(&aes_ctx, MBEDTLS_AES_ENCRYPT, block, rand);
+    if (0 != ret) {
+        goto exit;
+    }
+
+    *ping_offset = (rand[0] + rand[1] * 256) % ping_period;
+
 exit:
     _mbedtls_aes_free(&aes_ctx);
     return ret;
@@ -366,4 +403,12 @@ int LoRaMacCrypto::compute_skeys_for_join_frame(const uint8_t *, uint32_t, const
     return LORAWAN_STATUS_CRYPTO_FAIL;
 }
 
+int LoRaMacCrypto::compute_ping_offset(uint32_t, uint32_t, uint16_t, uint16_t *)
+{
+    MBED_ASSERT(0 && "[LoRaCrypto] Must enable AES, CMAC & CIPHER from mbedTLS");
+
+    // Never actually reaches here
+    return LORAWAN_STATUS_CRYPTO_FAIL;
+}
+
 #endif
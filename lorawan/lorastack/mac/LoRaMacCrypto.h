@@ -157,6 +157,19 @@ public:
                                      const uint8_t *app_nonce, uint16_t dev_nonce,
                                      uint8_t *nwk_skey, uint8_t *app_skey);
 
+    /**
+     * Computes the Class B ping offset of a beacon period
+     *
+     * @param [in]  beacon_time      - Beacon time of the period [s]
+     * @param [in]  address          - Device address
+     * @param [in]  ping_period      - Ping period [slots]
+     * @param [out] ping_offset      - Ping offset [slots]
+     *
+     * @return                        0 if successful, or a cipher specific error code
+     */
+    int compute_ping_offset(uint32_t beacon_time, uint32_t address,
+                            uint16_t ping_period, uint16_t *ping_offset);
+
 private:
     /**
      * AES computation context variable
@@ -0,0 +1,302 @@
+/**
+ * \file      classb_sim.cpp
+ *
+ * \brief     Host simulation of the Class B beacon and ping slot timeline
+ *
+ * Runs LoRaMacClassB against a network (GPS) clock and a local clock that
+ * drifts from it, and checks every reception window the MAC would open:
+ * the window of each beacon and of each ping slot, sized by
+ * LoRaPHY::get_rx_window_params() from get_uncertainty(), must catch the
+ * preamble of the frame sent at that GPS time. Covered are
+ *
+ * - clock drifts across the whole MBED_CONF_LORA_CLASS_B_CLOCK_ACCURACY,
+ *   wandering with the temperature by as much as the drift left over once
+ *   measured (RESIDUAL_DRIFT of LoRaMacClassB.cpp),
+ * - acquisition from a DeviceTimeAns and from a beacon scan,
+ * - 55 beacons (117 minutes) missed in a row, just within the beacon-less
+ *   period, and the beacon lost once that period is over,
+ * - every ping slot periodicity, 0..7,
+ * - the beacon CRC.
+ *
+ * The local clock starts just below the wrap of lorawan_time_t. See the
+ * Makefile in this directory for how to build and run it.
+ *
+ * Copyright (c) 2017, Arm Limited and affiliates.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifdef CLASS_B_HOST
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../LoRaMacClassB.h"
+
+/*!
+ * Symbol times [ms]: the EU868 beacon at DR3 (SF9/125 kHz) and ping slots
+ * at DR6 (SF7/250 kHz), the shortest symbol and so the tightest window
+ */
+#define SIM_BEACON_SYMBOL               4.096
+#define SIM_PING_SYMBOL                 0.512
+
+/*!
+ * Reception window parameters as used by LoRaPHY
+ */
+#define SIM_PREAMBLE_LENGTH             8
+#define SIM_TICK_JITTER                 1
+#define SIM_MAX_RX_SYMBOLS              255
+
+/*!
+ * Beacon periods per run and the error of a beacon timestamp [ms]
+ */
+#define SIM_BEACONS                     700
+#define SIM_BEACON_NOISE                2
+
+/*!
+ * Error of the DeviceTimeAns [ms] and how long before the first beacon it
+ * arrives
+ */
+#define SIM_DEVICE_TIME_ERROR           3
+#define SIM_DEVICE_TIME_LEAD            10000
+
+/*!
+ * Beacons missed in a row: within the beacon-less period and past it
+ */
+#define SIM_OUTAGE                      55
+#define SIM_OUTAGE_LONG                 100
+
+/*!
+ * Ping slots must end before the beacon guard [ms]
+ */
+#define SIM_BEACON_GUARD                3000
+
+/*!
+ * The drift follows the temperature: it swings by SIM_WANDER_PPM either way
+ * around its mean, once every SIM_WANDER_PERIOD [ms]
+ */
+#define SIM_WANDER_PPM                  1.0
+#define SIM_WANDER_PERIOD               (6 * 3600000.0)
+
+/*!
+ * Mean drifts [ppm], with the wander they span the clock accuracy
+ */
+static const double drifts[] = { -39, -30, -20, 0, 20, 30, 39 };
+
+static double drift_ppm;
+static const double gps_start = 1300000000.0 * 1000;
+static const lorawan_time_t local_start = 0xFFF00000u;
+
+static int failures;
+static double worst_margin;
+
+static lorawan_time_t true_local_time(double gps_time)
+{
+    double phase = 2 * M_PI * (gps_time - gps_start) / SIM_WANDER_PERIOD;
+    double elapsed = (gps_time - gps_start) * (1 + drift_ppm * 1e-6)
+                     + SIM_WANDER_PPM * 1e-6 * SIM_WANDER_PERIOD / (2 * M_PI) * (1 - cos(phase));
+
+    return (lorawan_time_t)(local_start + (int64_t)llround(elapsed));
+}
+
+static double local_elapsed(lorawan_time_t local_time)
+{
+    return (int32_t)(local_time - local_start);
+}
+
+/*!
+ * Mirrors LoRaPHY::get_rx_window_params() for a LoRa datarate, with the
+ * window capped at SIM_MAX_RX_SYMBOLS like LoRaMac does
+ */
+static bool check_window(const char *what, const LoRaMacClassB &class_b,
+                         uint64_t gps_time, double t_symb)
+{
+    const double min_rx_symb = MBED_CONF_LORA_DOWNLINK_PREAMBLE_LENGTH;
+    const double wakeup = MBED_CONF_LORA_WAKEUP_TIME;
+    double error = class_b.get_uncertainty(gps_time);
+    double offset = floor((SIM_PREAMBLE_LENGTH - min_rx_symb) * t_symb - error - wakeup);
+    double earliest = offset - error - SIM_TICK_JITTER;
+    double length = min_rx_symb * t_symb
+                    + fmax(-earliest, fmin(t_symb, 2 * error + wakeup + SIM_TICK_JITTER));
+    double symbols = fmin(ceil(length / t_symb), SIM_MAX_RX_SYMBOLS);
+
+    double open = local_elapsed(class_b.to_local_time(gps_time)) + offset;
+    double close = open + symbols * t_symb;
+    double tx = local_elapsed(true_local_time((double)gps_time));
+
+    // Open before the last min_rx_symb symbols of the preamble and still
+    // open for min_rx_symb symbols once the transmission started
+    double early = tx + (SIM_PREAMBLE_LENGTH - min_rx_symb) * t_symb - open;
+    double late = close - (fmax(open, tx) + min_rx_symb * t_symb);
+
+    if (early < 0 || late < 0) {
+        printf("FAILED: %s at %llu ms missed, uncertainty %.0f ms, window %.1f..%.1f ms, "
+               "sent at %.1f ms\n", what, (unsigned long long)gps_time, error,
+               open, close, tx);
+        failures++;
+        return false;
+    }
+
+    worst_margin = fmin(worst_margin, fmin(early, late));
+    return true;
+}
+
+static void check_ping_slots(const LoRaMacClassB &class_b, uint32_t beacon_time,
+                             int &slots)
+{
+    uint64_t beacon_start = beacon_time * 1000ULL;
+    uint64_t gps_time = beacon_start;
+    uint64_t slot_time;
+    uint64_t last = 0;
+    int count = 0;
+    int expected = 1 << (7 - class_b.get_ping_slot_periodicity());
+
+    while (class_b.get_next_ping_slot(gps_time, slot_time)) {
+        if (slot_time < beacon_start + CLASS_B_BEACON_RESERVED
+                || slot_time + CLASS_B_PING_SLOT_LENGTH
+                   > beacon_start + CLASS_B_BEACON_PERIOD - SIM_BEACON_GUARD
+                || (count > 0 && slot_time - last
+                    != (uint64_t)(CLASS_B_PING_SLOTS / expected) * CLASS_B_PING_SLOT_LENGTH)) {
+            printf("FAILED: ping slot at %llu ms out of place, periodicity %u\n",
+                   (unsigned long long)slot_time, class_b.get_ping_slot_periodicity());
+            failures++;
+        }
+        check_window("ping slot", class_b, slot_time, SIM_PING_SYMBOL);
+        last = slot_time;
+        gps_time = slot_time + 1;
+        count++;
+    }
+
+    if (count != expected) {
+        printf("FAILED: %d ping slots instead of %d, periodicity %u\n", count,
+               expected, class_b.get_ping_slot_periodicity());
+        failures++;
+    }
+    slots += count;
+}
+
+/*!
+ * Tracks SIM_BEACONS beacon periods, the beacons from miss_from on up to
+ * miss_to are not received
+ *
+ * @return The beacon at which the beacon was lost, -1 if it never was
+ */
+static int run(double ppm, bool scan, int miss_from, int miss_to)
+{
+    LoRaMacClassB class_b;
+    uint32_t beacon_time;
+    int slots = 0;
+    int missed = 0;
+    int lost = -1;
+
+    drift_ppm = ppm;
+    worst_margin = 1e9;
+    srand(1);
+
+    beacon_time = LoRaMacClassB::get_next_beacon_time((uint64_t)gps_start + 5000);
+    if (!scan) {
+        double gps_time = beacon_time * 1000.0 - SIM_DEVICE_TIME_LEAD;
+
+        class_b.set_time((uint64_t)gps_time + SIM_DEVICE_TIME_ERROR,
+                         true_local_time(gps_time), SIM_DEVICE_TIME_ERROR);
+    }
+
+    for (int n = 0; n < SIM_BEACONS; n++, beacon_time += CLASS_B_BEACON_PERIOD / 1000) {
+        // A scan receives the first beacon whenever it comes
+        if (n > 0 || !scan) {
+            check_window("beacon", class_b, beacon_time * 1000ULL, SIM_BEACON_SYMBOL);
+        }
+
+        if (n > 0 && n >= miss_from && n < miss_to) {
+            missed++;
+            if (!class_b.beacon_missed(beacon_time)) {
+                lost = n;
+                break;
+            }
+        } else {
+            int noise = rand() % (2 * SIM_BEACON_NOISE + 1) - SIM_BEACON_NOISE;
+
+            class_b.beacon_received(beacon_time,
+                                    true_local_time(beacon_time * 1000.0) + noise);
+        }
+
+        class_b.set_ping_slot_periodicity(n % 8);
+        class_b.set_ping_offset(beacon_time, rand() % class_b.get_ping_period());
+        check_ping_slots(class_b, beacon_time, slots);
+    }
+
+    printf("  %+5.1f ppm: measured %+7.3f ppm, %6d ping slots, %3d beacons missed, "
+           "worst margin %5.1f ms\n", ppm, class_b.get_drift() / 1000.0, slots,
+           missed, worst_margin);
+
+    return lost;
+}
+
+static void expect_lost(int lost, int expected)
+{
+    if (lost != expected) {
+        printf("FAILED: beacon lost at beacon %d instead of %d\n", lost, expected);
+        failures++;
+    }
+}
+
+static void check_beacon_crc(void)
+{
+    // EU868 beacon of GPS time 1300000000 s, 2 RFU bytes
+    static const uint8_t beacon[17] = {
+        0, 0, 0x00, 0x6d, 0x7c, 0x4d, 0x67, 0x0d,
+        1, 2, 3, 4, 5, 6, 7, 0xb3, 0x26
+    };
+    uint8_t damaged[17];
+    lorawan_beacon_t parsed;
+    int i;
+
+    if (!LoRaMacClassB::parse_beacon(beacon, sizeof(beacon), 2, parsed)
+            || parsed.time != 1300000000 || parsed.gw_specific[6] != 7) {
+        printf("FAILED: beacon not taken\n");
+        failures++;
+    }
+
+    for (i = 0; i < 17; i++) {
+        damaged[i] = beacon[i];
+    }
+    damaged[3] ^= 1;
+
+    if (LoRaMacClassB::parse_beacon(damaged, sizeof(damaged), 2, parsed)) {
+        printf("FAILED: beacon with a damaged time taken\n");
+        failures++;
+    }
+}
+
+int main(void)
+{
+    // Outside of an outage the beacon must never be lost
+    const int beaconless = CLASS_B_BEACONLESS_PERIOD / CLASS_B_BEACON_PERIOD;
+    unsigned int i;
+
+    failures = 0;
+
+    printf("Acquisition from a DeviceTimeAns\n");
+    for (i = 0; i < sizeof(drifts) / sizeof(drifts[0]); i++) {
+        expect_lost(run(drifts[i], false, 0, 0), -1);
+    }
+
+    printf("Acquisition by a scan, %d beacons (%d minutes) missed in a row\n",
+           SIM_OUTAGE, SIM_OUTAGE * CLASS_B_BEACON_PERIOD / 60000);
+    for (i = 0; i < sizeof(drifts) / sizeof(drifts[0]); i++) {
+        expect_lost(run(drifts[i], true, 200, 200 + SIM_OUTAGE), -1);
+    }
+
+    printf("%d beacons missed in a row, past the beacon-less period\n",
+           SIM_OUTAGE_LONG);
+    for (i = 0; i < sizeof(drifts) / sizeof(drifts[0]); i++) {
+        expect_lost(run(drifts[i], true, 300, 300 + SIM_OUTAGE_LONG),
+                    300 + beaconless);
+    }
+
+    check_beacon_crc();
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures != 0;
+}
+
+#endif /* CLASS_B_HOST */
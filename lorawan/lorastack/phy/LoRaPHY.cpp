@@ -33,12 +33,16 @@ SPDX-License-Identifier: BSD-3-Clause
 #define BACKOFF_DC_10_HOURS     1000
 #define BACKOFF_DC_24_HOURS     10000
 #define MAX_PREAMBLE_LENGTH     8.0f
+#define BEACON_PREAMBLE_LENGTH  10
 #define TICK_GRANULARITY_JITTER 1.0f
+#define RX_SNIFF_DETECT_SYMBOLS 2.0f
+#define RX_SNIFF_WAKEUP_TIME    500.0f  // us, radio warm start to RX
 #define CHANNELS_IN_MASK        16
 
 LoRaPHY::LoRaPHY()
     : _radio(NULL),
-      _lora_time(NULL)
+      _lora_time(NULL),
+      _join_sweep(0)
 {
     memset(&phy_params, 0, sizeof(phy_params));
 }
@@ -101,6 +105,13 @@ void LoRaPHY::handle_receive(void)
     _radio->unlock();
 }
 
+void LoRaPHY::handle_receive_duty_cycle(uint32_t rx_time, uint32_t sleep_time)
+{
+    _radio->lock();
+    _radio->receive_duty_cycle(rx_time, sleep_time);
+    _radio->unlock();
+}
+
 // For DevNonce for example
 uint32_t LoRaPHY::get_radio_rng()
 {
@@ -166,6 +177,69 @@ int32_t LoRaPHY::get_random(int32_t min, int32_t max)
     return (int32_t) rand() % (max - min + 1) + min;
 }
 
+uint8_t LoRaPHY::get_channel_index(const channel_selection_params_t *params,
+                                   const uint8_t *enabled_channels,
+                                   uint8_t nb_enabled_channels)
+{
+    if (!params->joined) {
+        for (uint8_t i = 0; i < nb_enabled_channels; i++) {
+            if (enabled_channels[i] == params->preferred_channel) {
+                return i;
+            }
+        }
+    }
+
+    return get_random(0, nb_enabled_channels - 1);
+}
+
+uint8_t LoRaPHY::get_join_channel_index(const channel_selection_params_t *params,
+                                        const uint8_t *enabled_channels,
+                                        uint8_t nb_enabled_channels)
+{
+    // Channels 0-63 are the 125 kHz channels, 8 sub-bands of 8 channels,
+    // channel 64 + n is the 500 kHz channel of sub-band n
+    const bool wide = enabled_channels[0] >= 64;
+
+    if (params->joined) {
+        return get_random(0, nb_enabled_channels - 1);
+    }
+
+    if (params->join_trial == 0) {
+        // Start in the sub-band of the last join-accept, with the next
+        // channel, or in a random place so that devices spread out
+        if (params->preferred_channel >= 0 && params->preferred_channel < 64) {
+            _join_sweep = (((params->preferred_channel % 8) + 1) % 8) * 8
+                          + params->preferred_channel / 8;
+        } else if (params->preferred_channel >= 64 && params->preferred_channel < 72) {
+            _join_sweep = get_random(0, 7) * 8 + params->preferred_channel - 64;
+        } else {
+            _join_sweep = get_random(0, 63);
+        }
+    }
+
+    for (uint8_t i = 0; i < nb_enabled_channels; i++) {
+        if (enabled_channels[i] == params->preferred_channel) {
+            return i;
+        }
+    }
+
+    for (uint8_t n = 0; n < 64; n++) {
+        uint8_t pos = (_join_sweep + n) % 64;
+        uint8_t channel = wide ? 64 + pos % 8 : (pos % 8) * 8 + pos / 8;
+
+        for (uint8_t i = 0; i < nb_enabled_channels; i++) {
+            if (enabled_channels[i] == channel) {
+                if (!wide) {
+                    _join_sweep = (pos + 1) % 64;
+                }
+                return i;
+            }
+        }
+    }
+
+    return get_random(0, nb_enabled_channels - 1);
+}
+
 bool LoRaPHY::verify_channel_DR(uint16_t *channel_mask, int8_t dr)
 {
     if (val_in_range(dr, phy_params.min_tx_datarate,
@@ -563,6 +637,12 @@ void LoRaPHY::reset_to_default_values(loramac_protocol_params *params, bool init
     params->sys_params.max_eirp = phy_params.default_max_eirp;
 
     params->sys_params.antenna_gain = phy_params.default_antenna_gain;
+
+    params->sys_params.ping_slot_channel.frequency = phy_params.beacon_frequency;
+
+    params->sys_params.ping_slot_channel.datarate = phy_params.beacon_datarate;
+
+    params->sys_params.beacon_frequency = phy_params.beacon_frequency;
 }
 
 int8_t LoRaPHY::get_next_lower_tx_datarate(int8_t datarate)
@@ -643,6 +723,31 @@ uint8_t LoRaPHY::get_default_rx2_datarate()
     return phy_params.rx_window2_datarate;
 }
 
+bool LoRaPHY::is_class_b_supported()
+{
+    return phy_params.beacon_size != 0;
+}
+
+uint32_t LoRaPHY::get_default_beacon_frequency()
+{
+    return phy_params.beacon_frequency;
+}
+
+uint8_t LoRaPHY::get_beacon_datarate()
+{
+    return phy_params.beacon_datarate;
+}
+
+uint8_t LoRaPHY::get_beacon_size()
+{
+    return phy_params.beacon_size;
+}
+
+uint8_t LoRaPHY::get_beacon_rfu1_size()
+{
+    return phy_params.beacon_rfu1_size;
+}
+
 uint16_t *LoRaPHY::get_channel_mask(bool get_default)
 {
     if (get_default) {
@@ -855,6 +960,36 @@ void LoRaPHY::compute_rx_win_params(int8_t datarate, uint8_t min_rx_symbols,
                          rx_conf_params->datarate);
 }
 
+bool LoRaPHY::compute_rx_sniff_params(int8_t datarate, uint8_t preamble_len,
+                                      uint32_t *rx_time, uint32_t *sleep_time)
+{
+    datarate = MIN(datarate, phy_params.max_rx_datarate);
+
+    if (preamble_len == 0
+            || (phy_params.fsk_supported && datarate == phy_params.max_rx_datarate)) {
+        return false;
+    }
+
+    // in microseconds
+    float t_symbol = 1000 * compute_symb_timeout_lora(((uint8_t *)phy_params.datarates.table)[datarate],
+                                                      ((uint32_t *)phy_params.bandwidths.table)[datarate]);
+
+    // A check needs a few preamble symbols after the radio woke up. A
+    // preamble starting too late in one check must outlast the sleep and
+    // the whole next check, i.e. preamble >= 2 * rx + sleep.
+    float rx = RX_SNIFF_DETECT_SYMBOLS * t_symbol + RX_SNIFF_WAKEUP_TIME;
+    float sleep = preamble_len * t_symbol - 2 * rx;
+
+    if (sleep < rx) {
+        return false;
+    }
+
+    *rx_time = (uint32_t) ceil(rx);
+    *sleep_time = (uint32_t) floor(sleep);
+
+    return true;
+}
+
 uint32_t LoRaPHY::get_rx_time_on_air(uint8_t modem, uint16_t pkt_len)
 {
     uint32_t toa = 0;
@@ -883,6 +1018,19 @@ bool LoRaPHY::rx_config(rx_config_params_t *rx_conf)
 
     _radio->set_channel(rx_conf->frequency);
 
+    if (rx_conf->rx_slot == RX_SLOT_BEACON) {
+        // Beacons have no header and no PHY CRC, their payload carries its
+        // own CRCs. Unlike downlinks, IQ is not inverted.
+        rx_conf->modem_type = MODEM_LORA;
+        _radio->set_rx_config((radio_modems_t) rx_conf->modem_type, rx_conf->bandwidth, phy_dr, 1, 0,
+                              BEACON_PREAMBLE_LENGTH,
+                              rx_conf->window_timeout, true, phy_params.beacon_size, false, 0, 0,
+                              false, rx_conf->is_rx_continuous);
+        _radio->set_max_payload_length((radio_modems_t) rx_conf->modem_type, phy_params.beacon_size);
+        _radio->unlock();
+        return true;
+    }
+
     // Radio configuration
     if (dr == DR_7 && phy_params.fsk_supported) {
         rx_conf->modem_type = MODEM_FSK;
@@ -1106,6 +1254,43 @@ uint8_t LoRaPHY::accept_rx_param_setup_req(rx_param_setup_req_t *params)
     return status;
 }
 
+uint8_t LoRaPHY::accept_ping_slot_channel_req(uint32_t frequency, uint8_t datarate)
+{
+    uint8_t status = 0x03;
+
+    if (!is_class_b_supported()) {
+        return 0;
+    }
+
+    // Frequency 0 restores the default
+    if (frequency != 0 && (lookup_band_for_frequency(frequency) < 0
+                           || _radio->check_rf_frequency(frequency) == false)) {
+        status &= 0xFE; // Channel frequency KO
+    }
+
+    if (val_in_range(datarate, phy_params.min_rx_datarate,
+                     phy_params.max_rx_datarate) == 0) {
+        status &= 0xFD; // Datarate KO
+    }
+
+    return status;
+}
+
+bool LoRaPHY::accept_beacon_freq_req(uint32_t frequency)
+{
+    if (!is_class_b_supported()) {
+        return false;
+    }
+
+    // Frequency 0 restores the default
+    if (frequency == 0) {
+        return true;
+    }
+
+    return lookup_band_for_frequency(frequency) >= 0
+           && _radio->check_rf_frequency(frequency);
+}
+
 bool LoRaPHY::accept_tx_param_setup_req(uint8_t ul_dwell_time, uint8_t dl_dwell_time)
 {
     if (phy_params.accept_tx_param_setup_req) {
@@ -1304,7 +1489,8 @@ lorawan_status_t LoRaPHY::set_next_channel(channel_selection_params_t *params,
 
     if (channel_count > 0) {
         // We found a valid channel
-        *channel = enabled_channels[get_random(0, channel_count - 1)];
+        *channel = enabled_channels[get_channel_index(params, enabled_channels,
+                                                      channel_count)];
         *time = 0;
         return LORAWAN_STATUS_OK;
     }
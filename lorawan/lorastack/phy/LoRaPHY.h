@@ -83,6 +83,13 @@ public:
      */
     void handle_receive(void);
 
+    /** Puts radio in duty-cycled receive mode.
+     *
+     * Requests the radio driver to check for a preamble for rx_time and to
+     * sleep for sleep_time in between [us], see compute_rx_sniff_params().
+     */
+    void handle_receive_duty_cycle(uint32_t rx_time, uint32_t sleep_time);
+
     /** Delegates MAC layer request to transmit packet.
      *
      * @param buf    a pointer to the data which needs to be transmitted
@@ -284,6 +291,28 @@ public:
                                        uint32_t rx_error,
                                        rx_config_params_t *rx_conf_params);
 
+    /** Computes the periods of a duty-cycled continuous reception.
+     *
+     * Instead of listening all the time the receiver checks for a preamble
+     * and sleeps in between, short enough not to miss a preamble of
+     * preamble_len symbols.
+     *
+     * @param [in] datarate         The datarate of the reception.
+     *
+     * @param [in] preamble_len     The preamble symbols of the frames to
+     *                              receive.
+     *
+     * @param [out] rx_time         The time a preamble check takes [us].
+     *
+     * @param [out] sleep_time      The time to sleep in between [us].
+     *
+     * @return False if the preamble is too short at this datarate for the
+     *         receiver to sleep at least as long as it listens, reception
+     *         should be continuous then.
+     */
+    bool compute_rx_sniff_params(int8_t datarate, uint8_t preamble_len,
+                                 uint32_t *rx_time, uint32_t *sleep_time);
+
     /** Configure radio transmission.
      *
      * @param [in]  tx_config    Structure containing tx parameters.
@@ -327,6 +356,24 @@ public:
      */
     virtual uint8_t accept_rx_param_setup_req(rx_param_setup_req_t *params);
 
+    /** Accept or rejects PingSlotChannelReq MAC command
+     *
+     * @param [in] frequency    The ping slot frequency, 0 for the default.
+     *
+     * @param [in] datarate     The ping slot datarate.
+     *
+     * @return The status of the operation, according to the LoRaWAN specification.
+     */
+    uint8_t accept_ping_slot_channel_req(uint32_t frequency, uint8_t datarate);
+
+    /** Accept or rejects BeaconFreqReq MAC command
+     *
+     * @param [in] frequency    The beacon frequency, 0 for the default.
+     *
+     * @return True if the frequency is accepted.
+     */
+    bool accept_beacon_freq_req(uint32_t frequency);
+
     /**
      * @brief accept_tx_param_setup_req Makes decision whether to accept or reject TxParamSetupReq MAC command.
      *
@@ -495,6 +542,39 @@ public:
      */
     uint8_t get_default_rx2_datarate();
 
+    /**
+     * @brief is_class_b_supported Checks if the region defines a Class B beacon
+     * @return True if Class B is supported, false otherwise
+     */
+    bool is_class_b_supported();
+
+    /**
+     * @brief get_default_beacon_frequency Gets default beacon frequency, also
+     *        the default ping slot frequency
+     * @return Beacon frequency
+     */
+    uint32_t get_default_beacon_frequency();
+
+    /**
+     * @brief get_beacon_datarate Gets beacon datarate, also the default ping
+     *        slot datarate
+     * @return Beacon datarate
+     */
+    uint8_t get_beacon_datarate();
+
+    /**
+     * @brief get_beacon_size Gets the size of the beacon payload
+     * @return Beacon size in bytes
+     */
+    uint8_t get_beacon_size();
+
+    /**
+     * @brief get_beacon_rfu1_size Gets the size of the RFU field in front of
+     *        the beacon time
+     * @return RFU size in bytes
+     */
+    uint8_t get_beacon_rfu1_size();
+
     /**
      * @brief get_channel_mask Gets the channel mask
      * @param get_default If true the default mask is returned, otherwise the current mask is returned
@@ -662,6 +742,25 @@ protected:
 
     bool is_datarate_supported(const int8_t datarate) const;
 
+    /**
+     * Picks a channel out of the enabled ones, the preferred channel of a
+     * join request if it is among them, a random one otherwise. Returns the
+     * index into enabled_channels.
+     */
+    uint8_t get_channel_index(const channel_selection_params_t *params,
+                              const uint8_t *enabled_channels,
+                              uint8_t nb_enabled_channels);
+
+    /**
+     * Like get_channel_index(), for the 64 + 8 channel plans. Join requests
+     * sweep the eight sub-bands in turn instead of drawing from all 64
+     * channels: one 125 kHz channel per sub-band, the 500 kHz channels
+     * staying in the sub-band of the next 125 kHz join request.
+     */
+    uint8_t get_join_channel_index(const channel_selection_params_t *params,
+                                   const uint8_t *enabled_channels,
+                                   uint8_t nb_enabled_channels);
+
 private:
 
     /**
@@ -678,6 +777,12 @@ protected:
     LoRaRadio *_radio;
     LoRaWANTimeHandler *_lora_time;
     loraphy_params_t phy_params;
+
+    /**
+     * Next position of the join request sub-band sweep, sub-band in the
+     * lower 3 bits and channel within the sub-band in the upper 3 bits.
+     */
+    uint8_t _join_sweep;
 };
 
 #endif /* MBED_OS_LORAPHY_BASE_ */
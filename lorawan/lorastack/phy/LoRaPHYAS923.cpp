@@ -373,7 +373,9 @@ lorawan_status_t LoRaPHYAS923::set_next_channel(channel_selection_params_t *next
 
         _radio->lock();
 
-        for (uint8_t  i = 0, j = get_random(0, nb_enabled_channels - 1); i < AS923_MAX_NB_CHANNELS; i++) {
+        for (uint8_t  i = 0, j = get_channel_index(next_channel_prams, enabled_channels,
+                                                     nb_enabled_channels);
+                i < AS923_MAX_NB_CHANNELS; i++) {
             next_channel_idx = enabled_channels[j];
             j = (j + 1) % nb_enabled_channels;
 
@@ -610,7 +610,8 @@ lorawan_status_t LoRaPHYAU915::set_next_channel(channel_selection_params_t *next
 
     if (nb_enabled_channels > 0) {
         // We found a valid channel
-        *channel = enabled_channels[get_random(0, nb_enabled_channels - 1)];
+        *channel = enabled_channels[get_join_channel_index(next_chan_params, enabled_channels,
+                                                           nb_enabled_channels)];
         // Disable the channel in the mask
         disable_channel(current_channel_mask, *channel, AU915_MAX_NB_CHANNELS);
 
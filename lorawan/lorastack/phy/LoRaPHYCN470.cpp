@@ -343,7 +343,8 @@ lorawan_status_t LoRaPHYCN470::set_next_channel(channel_selection_params_t *para
 
     if (channel_count > 0) {
         // We found a valid channel
-        *channel = enabled_channels[get_random(0, channel_count - 1)];
+        *channel = enabled_channels[get_channel_index(params, enabled_channels,
+                                                      channel_count)];
         *time = 0;
         return LORAWAN_STATUS_OK;
     }
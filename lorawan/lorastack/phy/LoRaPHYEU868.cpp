@@ -178,6 +178,20 @@
  */
 #define EU868_RX_WND_2_DR          DR_0
 
+/*!
+ * Class B beacon channel, also the default ping slot channel.
+ *
+ * LoRaWAN Regional Parameters V1.0.2rB, EU863-870 Class B beacon.
+ */
+#define EU868_BEACON_FREQ          869525000
+#define EU868_BEACON_DR            DR_3
+
+/*!
+ * Class B beacon payload size and size of its first RFU field
+ */
+#define EU868_BEACON_SIZE          17
+#define EU868_BEACON_RFU1_SIZE     2
+
 /*!
  * Band 0 definition
  * { DutyCycle, TxMaxPower, LastJoinTxDoneTime, LastTxDoneTime, TimeOff }
@@ -344,6 +358,10 @@ LoRaPHYEU868::LoRaPHYEU868()
     phy_params.ack_timeout_rnd = EU868_ACK_TIMEOUT_RND;
     phy_params.rx_window2_datarate = EU868_RX_WND_2_DR;
     phy_params.rx_window2_frequency = EU868_RX_WND_2_FREQ;
+    phy_params.beacon_datarate = EU868_BEACON_DR;
+    phy_params.beacon_size = EU868_BEACON_SIZE;
+    phy_params.beacon_rfu1_size = EU868_BEACON_RFU1_SIZE;
+    phy_params.beacon_frequency = EU868_BEACON_FREQ;
 }
 
 LoRaPHYEU868::~LoRaPHYEU868()
@@ -440,7 +440,7 @@ lorawan_status_t LoRaPHYKR920::set_next_channel(channel_selection_params_t *para
 
     if (nb_enabled_channels > 0) {
 
-        for (uint8_t  i = 0, j = get_random(0, nb_enabled_channels - 1);
+        for (uint8_t  i = 0, j = get_channel_index(params, enabled_channels, nb_enabled_channels);
                 i < KR920_MAX_NB_CHANNELS; i++) {
             next_channel_idx = enabled_channels[j];
             j = (j + 1) % nb_enabled_channels;
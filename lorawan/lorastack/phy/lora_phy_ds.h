@@ -448,6 +448,14 @@ typedef struct channel_selection_params_s {
      * Set to true, if the duty cycle is enabled, otherwise false.
      */
     bool dc_enabled;
+    /**
+     * The number of join requests sent so far in this join procedure.
+     */
+    uint8_t join_trial;
+    /**
+     * A join request goes out on this channel if it is available, -1 for none.
+     */
+    int16_t preferred_channel;
 } channel_selection_params_t;
 
 /*!
@@ -547,6 +555,13 @@ typedef struct {
     uint8_t rx_window2_datarate;
     uint32_t rx_window2_frequency;
 
+    // Class B beacon, also the default ping slot channel. A region without
+    // Class B support leaves beacon_size at 0.
+    uint8_t beacon_datarate;
+    uint8_t beacon_size;
+    uint8_t beacon_rfu1_size;
+    uint32_t beacon_frequency;
+
     loraphy_table_t bands;
     loraphy_table_t bandwidths;
     loraphy_table_t datarates;
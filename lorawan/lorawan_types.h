@@ -105,7 +105,8 @@ typedef enum lorawan_status {
     LORAWAN_STATUS_NO_CHANNEL_FOUND = -1021,       /**< None of the channels is enabled at the moment*/
     LORAWAN_STATUS_NO_FREE_CHANNEL_FOUND = -1022,  /**< None of the enabled channels is ready for another TX (duty cycle limited)*/
     LORAWAN_STATUS_METADATA_NOT_AVAILABLE = -1023, /**< Meta-data after an RX or TX is stale*/
-    LORAWAN_STATUS_ALREADY_CONNECTED = -1024              /**< The device has already joined a network*/
+    LORAWAN_STATUS_ALREADY_CONNECTED = -1024,             /**< The device has already joined a network*/
+    LORAWAN_STATUS_NO_BEACON_FOUND = -1025                /**< Class B needs the beacon to be tracked*/
 } lorawan_status_t;
 
 /** The lorawan_connect_otaa structure.
@@ -205,6 +206,13 @@ typedef struct lorawan_connect {
  * UPLINK_REQUIRED      - Stack indicates application that some uplink needed
  * AUTOMATIC_UPLINK_ERROR - Stack tried automatically send uplink but some error occurred.
  *                          Application should initiate uplink as soon as possible.
+ * DEVICE_TIME_SYNCHED  - The network answered a DeviceTimeReq, the device knows the GPS time
+ * PING_SLOT_INFO_SYNCHED - The network took over the ping slot periodicity of a PingSlotInfoReq
+ * BEACON_FOUND         - Beacon acquisition succeeded, the beacon is tracked from now on
+ * BEACON_NOT_FOUND     - Beacon acquisition gave up
+ * BEACON_MISSED        - An expected beacon was not received, tracking continues without it
+ * BEACON_LOST          - No beacon for the beacon-less period, tracking stopped and
+ *                        a Class B device is back to Class A
  *
  */
 typedef enum lora_events {
@@ -222,8 +230,30 @@ typedef enum lora_events {
     JOIN_FAILURE,
     UPLINK_REQUIRED,
     AUTOMATIC_UPLINK_ERROR,
+    DEVICE_TIME_SYNCHED,
+    PING_SLOT_INFO_SYNCHED,
+    BEACON_FOUND,
+    BEACON_NOT_FOUND,
+    BEACON_MISSED,
+    BEACON_LOST,
 } lorawan_event_t;
 
+/**
+ * Receive window notifications, see 'rx_window' in lorawan_app_callbacks_t.
+ *
+ * RX_WINDOW_SCHEDULED - The window timer was started, value is the delay
+ *                       in milliseconds until the window opens
+ * RX_WINDOW_OPENED    - The radio was put into receive, value is how many
+ *                       milliseconds later than scheduled this happened
+ * RX_WINDOW_CLOSED    - The window ended, value is 1 if a frame was
+ *                       received and 0 otherwise
+ */
+typedef enum lora_rx_window_events {
+    RX_WINDOW_SCHEDULED = 0,
+    RX_WINDOW_OPENED,
+    RX_WINDOW_CLOSED,
+} lorawan_rx_window_event_t;
+
 /**
  * Stack level callback functions
  *
@@ -243,7 +273,22 @@ typedef enum lora_events {
  * 'battery_level' callback goes in the down direction, i.e., it informs
  * the stack about the battery level by calling a function provided
  * by the upper layers.
+ *
+ * 'rx_window' callback follows the Class A receive windows of every uplink so
+ * that the application can keep other load away from the radio while they
+ * are open.
+ *
+ * 'session' callback hands out the joined session whenever it may have
+ * changed, so that the application can keep it in non-volatile memory and
+ * restore it after a reset instead of joining again.
+ *
+ * 'join' callback hands out the state of the join procedure before every join
+ * request, so that the application can keep the DevNonce in non-volatile
+ * memory and give it back with LoRaWANInterface::set_join_state() after a reset.
  */
+typedef struct lorawan_session_params lorawan_session_params_t;
+typedef struct lorawan_join_params lorawan_join_params_t;
+
 typedef struct {
     /**
      * Mandatory. Event Callback must be provided
@@ -269,6 +314,35 @@ typedef struct {
      *     255     The end-device was not able to measure the battery level.
      */
     mbed::Callback<uint8_t(void)> battery_level;
+
+    /**
+     * This callback is optional
+     *
+     * The first parameter is the receive slot (rx_slot_t), the second the
+     * event and the third its value, see lorawan_rx_window_event_t. It is
+     * called from the context of the stack's event queue and must not block.
+     */
+    mbed::Callback<void(uint8_t, lorawan_rx_window_event_t, int32_t)> rx_window;
+
+    /**
+     * This callback is optional
+     *
+     * The first parameter is the session, the second the uplink frame counter
+     * of the next uplink and the third the last downlink frame counter. It is
+     * called after the join and after every uplink and downlink, before the
+     * next uplink goes out, from the context of the stack's event queue.
+     */
+    mbed::Callback<void(const lorawan_session_params_t *, uint32_t, uint32_t)> session;
+
+    /**
+     * This callback is optional
+     *
+     * The first parameter is where the last join-accept came in, the second
+     * the DevNonce of the next join request. It is called before every join
+     * request goes out and after the join, from the context of the stack's
+     * event queue.
+     */
+    mbed::Callback<void(const lorawan_join_params_t *, uint16_t)> join;
 } lorawan_app_callbacks_t;
 
 /**
@@ -351,6 +425,56 @@ typedef struct lora_channelplan {
     loramac_channel_t *channels;
 } lorawan_channelplan_t;
 
+/**
+ * Channels and channel mask words kept in lorawan_session_params_t
+ */
+#define LORAWAN_SESSION_MAX_CHANNELS                16
+#define LORAWAN_SESSION_MASK_SIZE                   6
+
+/**
+ * A joined session, see 'session' in lorawan_app_callbacks_t and
+ * LoRaWANInterface::restore_session().
+ *
+ * What the device got from the join accept and from the MAC commands of the
+ * network server, without the frame counters. Plain data that can be stored
+ * as it is and restored by the same firmware.
+ */
+struct lorawan_session_params {
+    uint32_t dev_addr;
+    uint32_t net_id;
+    uint8_t nwk_skey[16];
+    uint8_t app_skey[16];
+    int8_t datarate;
+    int8_t tx_power;
+    bool adr_on;
+    uint8_t nb_trans;
+    uint8_t rx1_dr_offset;
+    uint8_t rx2_datarate;
+    uint32_t rx2_frequency;
+    uint32_t recv_delay1;
+    /**
+     * Entries of channels[] in use, the first channels of the region
+     */
+    uint8_t nb_channels;
+    uint16_t channel_mask[LORAWAN_SESSION_MASK_SIZE];
+    channel_params_t channels[LORAWAN_SESSION_MAX_CHANNELS];
+};
+
+/**
+ * The join request that got the last join-accept, see 'join' in
+ * lorawan_app_callbacks_t and LoRaWANInterface::set_join_state().
+ *
+ * The next join procedure starts with the same channel and datarate.
+ */
+struct lorawan_join_params {
+    /**
+     * False until a join-accept was received, the other fields are invalid
+     */
+    bool accepted;
+    uint8_t channel;
+    int8_t datarate;
+};
+
 /*!
  * Region       | SF
  * ------------ | :-----:
@@ -615,6 +739,45 @@ typedef enum lorawan_connect_type {
     LORAWAN_CONNECTION_ABP          /**< Activation By Personalization */
 } lorawan_connect_type_t;
 
+/**
+ * Extra wait before the retransmission of a confirmed uplink, on top of
+ * ACK_TIMEOUT.
+ */
+typedef enum lorawan_retry_backoff {
+    LORAWAN_RETRY_BACKOFF_NONE = 0,     /**< None, as the specification has it */
+    LORAWAN_RETRY_BACKOFF_EXPONENTIAL,  /**< base_ms, doubled with every retransmission */
+    LORAWAN_RETRY_BACKOFF_RANDOM,       /**< Random, up to the exponential wait */
+    LORAWAN_RETRY_BACKOFF_CUSTOM        /**< As the 'custom' callback decides */
+} lorawan_retry_backoff_t;
+
+/**
+ * Retransmission policy for confirmed uplinks, see
+ * LoRaWANInterface::set_retry_policy().
+ */
+typedef struct lorawan_retry_policy {
+    lorawan_retry_backoff_t backoff;
+    /**
+     * Extra wait before the first retransmission, in ms
+     */
+    uint32_t base_ms;
+    /**
+     * Time on air a message may take up, retransmissions included, in ms,
+     * 0 for no limit. A retransmission that would go beyond it is not sent
+     * and the message fails as if the retries were exhausted.
+     */
+    uint32_t airtime_budget_ms;
+    /**
+     * A new message replaces one waiting for its retransmission or held back
+     * by the duty cycle. No event follows for the replaced message.
+     */
+    bool latest_value_wins;
+    /**
+     * For LORAWAN_RETRY_BACKOFF_CUSTOM, gets the number of the retransmission
+     * to come and the time on air taken so far in ms. Returns the extra wait
+     * in ms, or a negative value to give the message up.
+     */
+    mbed::Callback<int32_t(uint8_t, uint32_t)> custom;
+} lorawan_retry_policy_t;
 
 /**
  * Meta-data collection for a transmission
@@ -644,6 +807,10 @@ typedef struct {
      * A boolean to mark if the meta data is stale
      */
     bool stale;
+    /**
+     * The time on air of the message, retransmissions included.
+     */
+    uint32_t airtime;
 } lorawan_tx_metadata;
 
 /**
@@ -676,4 +843,68 @@ typedef struct {
     uint32_t rx_toa;
 } lorawan_rx_metadata;
 
+/**
+ * Meta-data of the Class C reception
+ *
+ * The receiver on time is estimated from the check and sleep periods, plus
+ * the time on air of the frames received while checking.
+ */
+typedef struct {
+    /**
+     * Time a preamble check takes in microseconds, 0 if reception is continuous
+     */
+    uint32_t rx_period;
+    /**
+     * Time the receiver sleeps between two checks in microseconds
+     */
+    uint32_t sleep_period;
+    /**
+     * Time spent in Class C reception with preamble checks in milliseconds
+     */
+    uint32_t sniff_time;
+    /**
+     * Time spent in continuous Class C reception in milliseconds
+     */
+    uint32_t continuous_time;
+    /**
+     * Time the receiver was on, out of both, in milliseconds
+     */
+    uint32_t rx_on_time;
+    /**
+     * Frames received in Class C reception
+     */
+    uint32_t frames;
+    /**
+     * Share of the Class C reception time the receiver was off, per mille
+     */
+    uint16_t efficiency;
+} lorawan_rx_sniff_metadata;
+
+/**
+ * The last Class B beacon received
+ */
+typedef struct {
+    /**
+     * Beacon time, seconds since the GPS epoch
+     */
+    uint32_t time;
+    /**
+     * Gateway specific part: InfoDesc followed by Info, all zero if its
+     * CRC failed
+     */
+    uint8_t gw_specific[7];
+    /**
+     * The RSSI of the beacon
+     */
+    int16_t rssi;
+    /**
+     * The SNR of the beacon
+     */
+    int8_t snr;
+    /**
+     * Frequency the beacon was received on
+     */
+    uint32_t frequency;
+} lorawan_beacon_t;
+
 #endif /* MBED_LORAWAN_TYPES_H_ */
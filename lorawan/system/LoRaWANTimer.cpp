@@ -52,9 +52,10 @@ void LoRaWANTimeHandler::init(timer_event_t &obj, mbed::Callback<void()> callbac
     obj.timer_id = 0;
 }
 
-void LoRaWANTimeHandler::start(timer_event_t &obj, const uint32_t timeout)
+void LoRaWANTimeHandler::start(timer_event_t &obj, const uint32_t timeout,
+                               const uint32_t slack)
 {
-    obj.timer_id = _queue->call_in(timeout, obj.callback);
+    obj.timer_id = _queue->call_in_coalesced(timeout, slack, obj.callback);
     MBED_ASSERT(obj.timer_id != 0);
 }
 
@@ -67,8 +67,11 @@ public:
      *
      * @param [in] obj     The structure containing the timer object parameters.
      * @param [in] timeout The new timeout value.
+     * @param [in] slack   How late the timer may expire so it can share a
+     *                     wakeup with other pending events. Timers that
+     *                     open RX windows must keep the default of 0.
      */
-    void start(timer_event_t &obj, const uint32_t timeout);
+    void start(timer_event_t &obj, const uint32_t timeout, const uint32_t slack = 0);
 
     /** Stops and removes the timer object from the list of timer events.
      *
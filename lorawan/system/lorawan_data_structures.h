@@ -151,7 +151,11 @@ typedef enum {
     /*!
      * LoRaMAC class b ping slot window
      */
-    RX_SLOT_WIN_PING_SLOT
+    RX_SLOT_WIN_PING_SLOT,
+    /*!
+     * LoRaMAC class b beacon window
+     */
+    RX_SLOT_BEACON
 } rx_slot_t;
 
 /*!
@@ -230,6 +234,15 @@ typedef struct {
      * LoRaMac ADR control status
      */
     bool adr_on;
+
+    /*!
+     * Class B ping slot channel, set by PingSlotChannelReq
+     */
+    rx2_channel_params ping_slot_channel;
+    /*!
+     * Class B beacon frequency in Hz, set by BeaconFreqReq
+     */
+    uint32_t beacon_frequency;
 } lora_mac_system_params_t;
 
 /*!
@@ -302,6 +315,7 @@ typedef enum {
  * LoRaMAC mote MAC commands.
  *
  * LoRaWAN Specification V1.0.2, chapter 5, table 4.
+ * Class B commands: LoRaWAN Specification V1.0.3, chapter 14, table 21.
  */
 typedef enum {
     /*!
@@ -339,13 +353,30 @@ typedef enum {
     /*!
      * DlChannelAns
      */
-    MOTE_MAC_DL_CHANNEL_ANS          = 0x0A
+    MOTE_MAC_DL_CHANNEL_ANS          = 0x0A,
+    /*!
+     * DeviceTimeReq
+     */
+    MOTE_MAC_DEVICE_TIME_REQ         = 0x0D,
+    /*!
+     * PingSlotInfoReq
+     */
+    MOTE_MAC_PING_SLOT_INFO_REQ      = 0x10,
+    /*!
+     * PingSlotChannelAns
+     */
+    MOTE_MAC_PING_SLOT_CHANNEL_ANS   = 0x11,
+    /*!
+     * BeaconFreqAns
+     */
+    MOTE_MAC_BEACON_FREQ_ANS         = 0x13
 } mote_mac_cmds_t;
 
 /*!
  * LoRaMAC server MAC commands.
  *
  * LoRaWAN Specification V1.0.2 chapter 5, table 4.
+ * Class B commands: LoRaWAN Specification V1.0.3, chapter 14, table 21.
  */
 typedef enum {
     /*!
@@ -384,6 +415,22 @@ typedef enum {
      * DlChannelReq
      */
     SRV_MAC_DL_CHANNEL_REQ           = 0x0A,
+    /*!
+     * DeviceTimeAns
+     */
+    SRV_MAC_DEVICE_TIME_ANS          = 0x0D,
+    /*!
+     * PingSlotInfoAns
+     */
+    SRV_MAC_PING_SLOT_INFO_ANS       = 0x10,
+    /*!
+     * PingSlotChannelReq
+     */
+    SRV_MAC_PING_SLOT_CHANNEL_REQ    = 0x11,
+    /*!
+     * BeaconFreqReq
+     */
+    SRV_MAC_BEACON_FREQ_REQ          = 0x13,
 } server_mac_cmds_t;
 
 /*!
@@ -606,6 +653,10 @@ typedef struct {
      * The transmission time on air of the frame.
      */
     lorawan_time_t tx_toa;
+    /*!
+     * The time on air of all transmissions of the frame so far.
+     */
+    lorawan_time_t airtime;
     /*!
      * The uplink counter value related to the frame.
      */
@@ -6,6 +6,10 @@
 #include  "bspconfig.h"
 #include  "em_gpio.h"
 #include  "src/pg_retargetswo.h"
+#include  "src/power/power_manager.h"
+#include  "src/bridge/bridge.h"
+#include  "src/arbiter/radio_arbiter.h"
+#include  "src/session/session_store.h"
 #include  <cpu/include/cpu.h>
 #include  <kernel/include/os.h>
 #include  <kernel/include/os_trace.h>
@@ -51,6 +55,12 @@ using namespace events;
  */
 #define TX_TIMER                        10000
 
+/*
+ * Tolerance in ms for application timers, lets the event queue serve them
+ * from the same wakeup as the stack's own timers
+ */
+#define APP_TIMER_SLACK                 500
+
 /**
  * Maximum number of events for the event queue.
  * 10 is the safe number for the stack events, however, if application
@@ -63,6 +73,14 @@ using namespace events;
  */
 #define CONFIRMED_MSG_RETRY_COUNTER     3
 
+/**
+ * Uplinks without any downlink after which a LinkCheckReq rides along, and
+ * further uplinks without an answer after which the session is taken as lost:
+ * the stored session is dropped and the device joins again
+ */
+#define LINK_CHECK_INTERVAL             32
+#define LINK_CHECK_ATTEMPTS             4
+
 
 #define DEBUG_BREAK           __asm__("BKPT #0");
 
@@ -159,12 +177,55 @@ static void lora_event_handler(lorawan_event_t event);
  */
 static lorawan_app_callbacks_t callbacks;
 
+/**
+ * Receive window notifications, forwarded to the radio arbiter
+ */
+static void rx_window_handler(uint8_t slot, lorawan_rx_window_event_t event, int32_t value);
+
+/**
+ * Joined session, journaled to flash and restored after a reset
+ */
+static void session_handler(const lorawan_session_params_t *session, uint32_t ul_counter, uint32_t dl_counter);
+
+static lorawan_session_params_t stored_session;
+
+/**
+ * Join state, journaled next to the session so that the DevNonce keeps
+ * counting up across resets
+ */
+static void join_handler(const lorawan_join_params_t *params, uint16_t dev_nonce);
+
+/**
+ * Answer to a LinkCheckReq, the network still hears the device
+ */
+static void link_check_handler(uint8_t demod_margin, uint8_t num_gateways);
+
+// Uplinks sent since the last downlink of any kind
+static uint32_t uplinks_unanswered = 0;
+
 static LoRaWANInterface *p_lorawan;
 
 static SX126X_LoRaRadio *p_radio;
 
 void setup_pins_interrupts(void);
 
+/**
+ * Power manager requirements of the LoRa side
+ */
+static void events_power_req(power_req_t *req, void *ctx);
+
+static void radio_power_req(power_req_t *req, void *ctx);
+
+/**
+ * Records from the BLE bridge ingest, called in the BLE task
+ */
+static void bridge_data_ready(void);
+
+static void send_message();
+
+// An uplink carrying bridge records is scheduled and not done yet
+static bool tx_pending = false;
+
 
 void App_OS_TimeTickHook(void)
 {
@@ -210,6 +271,8 @@ static  void  LoRaTask (void  *p_arg)
 
 	p_lorawan = &lorawan;
 
+	session_store_init();
+
 	while (DEF_ON) {
 
 		// stores the status of a call to LoRaWAN protocol
@@ -225,8 +288,19 @@ static  void  LoRaTask (void  *p_arg)
 
 		// prepare application callbacks
 		callbacks.events = mbed::callback(lora_event_handler);
+		callbacks.rx_window = mbed::callback(rx_window_handler);
+		callbacks.session = mbed::callback(session_handler);
+		callbacks.join = mbed::callback(join_handler);
+		callbacks.link_check_resp = mbed::callback(link_check_handler);
 		p_lorawan->add_app_callbacks(&callbacks);
 
+		bridge_on_data(bridge_data_ready);
+
+		arbiter_init(MBED_CONF_LORA_MAX_SYS_RX_ERROR);
+
+		power_register(POWER_CLIENT_EVENTS, events_power_req, &ev_queue);
+		power_register(POWER_CLIENT_RADIO, radio_power_req, p_radio);
+
 		// Set number of retries in case of CONFIRMED messages
 		if (p_lorawan->set_confirmed_msg_retries(CONFIRMED_MSG_RETRY_COUNTER)
 				!= LORAWAN_STATUS_OK) {
@@ -243,15 +317,31 @@ static  void  LoRaTask (void  *p_arg)
 
 		printf("\r\n Adaptive data  rate (ADR) - Enabled \r\n");
 
-		retcode = p_lorawan->connect();
+		uint32_t ul_counter;
+		uint32_t dl_counter;
 
-		if (retcode == LORAWAN_STATUS_OK ||
-				retcode == LORAWAN_STATUS_CONNECT_IN_PROGRESS) {
+		// A session kept from before the reset saves the join
+		if (session_store_load(&stored_session, sizeof(stored_session), &ul_counter, &dl_counter)
+				&& p_lorawan->restore_session(stored_session, ul_counter, dl_counter) == LORAWAN_STATUS_OK) {
+			printf("\r\n Session restored, uplink counter %lu \r\n", (unsigned long)ul_counter);
 		} else {
-			printf("\r\n Connection error, code = %d \r\n", retcode);
-		}
+			lorawan_join_params_t join_params;
+			uint16_t dev_nonce;
+
+			if (session_store_join_load(&join_params, sizeof(join_params), &dev_nonce)) {
+				p_lorawan->set_join_state(join_params, dev_nonce);
+			}
+
+			retcode = p_lorawan->connect();
 
-		printf("\r\n Connection - In Progress ...\r\n");
+			if (retcode == LORAWAN_STATUS_OK ||
+					retcode == LORAWAN_STATUS_CONNECT_IN_PROGRESS) {
+			} else {
+				printf("\r\n Connection error, code = %d \r\n", retcode);
+			}
+
+			printf("\r\n Connection - In Progress ...\r\n");
+		}
 
 		// make your event queue dispatching events forever
 		ev_queue.dispatch_forever();
@@ -259,17 +349,100 @@ static  void  LoRaTask (void  *p_arg)
 }
 
 /**
- * Sends a message to the Network Server
+ * Event queue requirement: the next timed wakeup of the dispatch loop
+ */
+static void events_power_req(power_req_t *req, void *ctx)
+{
+	int ms = static_cast<EventQueue *>(ctx)->next_wakeup();
+
+	if (ms >= 0) {
+		req->deadline_ms = ms;
+	}
+}
+
+/**
+ * Radio requirement: TX done and RX done must be timestamped by the RTCC
+ * for the receive windows, which stops in EM3
+ */
+static void radio_power_req(power_req_t *req, void *ctx)
+{
+	if (static_cast<SX126X_LoRaRadio *>(ctx)->is_active()) {
+		req->deepest = sleepEM2;
+	}
+}
+
+static void rx_window_handler(uint8_t slot, lorawan_rx_window_event_t event, int32_t value)
+{
+	switch (event) {
+	case RX_WINDOW_SCHEDULED:
+		arbiter_rx_scheduled(slot, value);
+		break;
+	case RX_WINDOW_OPENED:
+		arbiter_rx_opened(slot, value);
+		break;
+	case RX_WINDOW_CLOSED:
+		arbiter_rx_closed(slot, value != 0);
+		break;
+	}
+}
+
+static void session_handler(const lorawan_session_params_t *session, uint32_t ul_counter, uint32_t dl_counter)
+{
+	session_store_update(session, sizeof(*session), ul_counter, dl_counter);
+}
+
+static void join_handler(const lorawan_join_params_t *params, uint16_t dev_nonce)
+{
+	session_store_join_update(params, sizeof(*params), dev_nonce);
+}
+
+static void link_check_handler(uint8_t demod_margin, uint8_t num_gateways)
+{
+	printf("\r\n Link check - margin %u dB, %u gateways \r\n", demod_margin, num_gateways);
+	uplinks_unanswered = 0;
+	p_lorawan->remove_link_check_request();
+}
+
+static void bridge_data_ready(void)
+{
+	ev_queue.call(send_message);
+}
+
+/**
+ * Sends the records waiting in the bridge to the Network Server
+ *
+ * The batch is packed when the previous uplink is done, so records keep
+ * accumulating while the stack backs off for the duty cycle, and is sized
+ * for the datarate of this uplink so the stack never has to split it.
  */
 static void send_message()
 {
-	uint16_t packet_len;
+	uint8_t packet_len;
 	int16_t retcode;
-	char buf[] = "LORAWANNODE";
 
-    packet_len = sprintf((char *) tx_buffer, buf);
+	if (tx_pending || bridge_empty()) {
+		return;
+	}
+
+	// Nothing heard back despite the link checks, the network has most
+	// likely forgotten the session: drop it and join again, see DISCONNECTED
+	if (uplinks_unanswered >= LINK_CHECK_INTERVAL + LINK_CHECK_ATTEMPTS) {
+		printf("\r\n Link lost, joining again \r\n");
+		uplinks_unanswered = 0;
+		p_lorawan->remove_link_check_request();
+		session_store_clear();
+		p_lorawan->disconnect();
+		return;
+	}
 
-    printf("\n Send_data = %s \n", tx_buffer);
+	if (uplinks_unanswered >= LINK_CHECK_INTERVAL) {
+		p_lorawan->add_link_check_request();
+	}
+
+	packet_len = bridge_uplink_build(tx_buffer, p_lorawan->get_max_possible_tx_size());
+	if (packet_len == 0) {
+		return;
+	}
 
 	retcode = p_lorawan->send(MBED_CONF_LORA_APP_PORT, tx_buffer, packet_len,
 			MSG_UNCONFIRMED_FLAG);
@@ -281,14 +454,14 @@ static void send_message()
 		if (retcode == LORAWAN_STATUS_WOULD_BLOCK) {
 			//retry in 3 seconds
 			if (MBED_CONF_LORA_DUTY_CYCLE_ON) {
-				ev_queue.call_in(3000, send_message);
+				ev_queue.call_in_coalesced(3000, APP_TIMER_SLACK, send_message);
 			}
 		}
 		return;
 	}
 
+	tx_pending = true;
 	printf("\r\n %d bytes scheduled for transmission \r\n", retcode);
-	memset(tx_buffer, 0, (unsigned int)sizeof(tx_buffer));
 }
 
 /**
@@ -323,19 +496,25 @@ static void lora_event_handler(lorawan_event_t event)
 	switch (event) {
 	case CONNECTED:
 		printf("\r\n Connection - Successful \r\n");
+		uplinks_unanswered = 0;
 		if (MBED_CONF_LORA_DUTY_CYCLE_ON) {
 			send_message();
 		} else {
-			ev_queue.call_every(TX_TIMER, send_message);
+			ev_queue.call_every_coalesced(TX_TIMER, APP_TIMER_SLACK, send_message);
 		}
 
 		break;
 	case DISCONNECTED:
+		tx_pending = false;
+		arbiter_reset();
 		ev_queue.break_dispatch();
 		printf("\r\n Disconnected Successfully \r\n");
 		break;
 	case TX_DONE:
 		printf("\r\n Message Sent to Network Server \r\n");
+		tx_pending = false;
+		uplinks_unanswered++;
+		bridge_uplink_done(true);
 		if (MBED_CONF_LORA_DUTY_CYCLE_ON) {
 			send_message();
 		}
@@ -345,13 +524,16 @@ static void lora_event_handler(lorawan_event_t event)
 	case TX_CRYPTO_ERROR:
 	case TX_SCHEDULING_ERROR:
 		printf("\r\n Transmission Error - EventCode = %d \r\n", event);
-		// try again
+		// the records stay in the bridge, try again
+		tx_pending = false;
+		bridge_uplink_done(false);
 		if (MBED_CONF_LORA_DUTY_CYCLE_ON) {
 			send_message();
 		}
 		break;
 	case RX_DONE:
 		printf("\r\n Received message from Network Server \r\n");
+		uplinks_unanswered = 0;
 		receive_message();
 		break;
 	case RX_TIMEOUT:
@@ -606,6 +788,8 @@ static  void  MainStartTask (void  *p_arg)
 
 	BSP_TickInit();                                             /* Initialize Kernel tick source.                       */
 
+	power_init();                                               /* Sleep from the idle task.                            */
+
 	OSStatTaskCPUUsageInit(&err);                               /* Initialize CPU Usage.                                */
 																/*   Check error code.                                  */
 	APP_RTOS_ASSERT_DBG((RTOS_ERR_CODE_GET(err) == RTOS_ERR_NONE), ;);
@@ -46,12 +46,19 @@
 #define MBED_CONF_APP_LORA_SPI_SCLK                                           8                                                                                                // set by application[EFR32BG12]
 #define MBED_CONF_APP_LORA_TCXO                                               NC                                                                                                 // set by application[EFR32BG12]
 #define MBED_CONF_APP_LORA_TXCTL                                              NC                                                                                                 // set by application[EFR32BG12]
+#define MBED_CONF_EVENTS_MAX_CAPTURE_SIZE                                     0                                                                                                  // set by library:events
+#define MBED_CONF_EVENTS_TRACE_BUFFER_SIZE                                    64                                                                                                 // set by library:events
+#define MBED_CONF_EVENTS_TRACE_ENABLED                                        0                                                                                                  // set by library:events
 #define MBED_CONF_LORA_ADR_ON                                                 1                                                                                                  // set by library:lora
 #define MBED_CONF_LORA_APPLICATION_EUI                                        { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x10 }                                                 // set by application[*]
 #define MBED_CONF_LORA_APPLICATION_KEY                                        { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x10, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x10 } // set by application[*]
 #define MBED_CONF_LORA_APPSKEY                                                { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x10, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x10 }   // set by library:lora
 #define MBED_CONF_LORA_APP_PORT                                               15                                                                                                 // set by library:lora
 #define MBED_CONF_LORA_AUTOMATIC_UPLINK_MESSAGE                               1                                                                                                  // set by library:lora
+#define MBED_CONF_LORA_CLASS_B_CLOCK_ACCURACY                                 40                                                                                                 // set by library:lora
+#define MBED_CONF_LORA_CLASS_C_SNIFF_PREAMBLE_LENGTH                          8                                                                                                  // set by library:lora
+#define MBED_CONF_LORA_CO_FRAME_SIZE                                          32                                                                                                 // set by library:lora
+#define MBED_CONF_LORA_CO_POOL_SIZE                                           2                                                                                                  // set by library:lora
 #define MBED_CONF_LORA_DEVICE_ADDRESS                                         0x00000010                                                                                         // set by library:lora
 #define MBED_CONF_LORA_DEVICE_EUI                                             { 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0xfe, 0x68 }                                                 // set by application[*]
 #define MBED_CONF_LORA_DEVICE_SELECT                                          1
@@ -638,8 +638,8 @@ private:
             &Callback::function_dtor<F>,
         };
 
-        /*MBED_STATIC_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
-                           "Type F must not exceed the size of the Callback class");*/
+        static_assert(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
+                      "Type F must not exceed the size of the Callback class");
         memset(this, 0, sizeof(Callback));
         new (this) F(f);
         _ops = &ops;
@@ -1264,8 +1264,8 @@ private:
             &Callback::function_dtor<F>,
         };
 
-        /*MBED_STATIC_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
-                           "Type F must not exceed the size of the Callback class");*/
+        static_assert(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
+                      "Type F must not exceed the size of the Callback class");
         memset(this, 0, sizeof(Callback));
         new (this) F(f);
         _ops = &ops;
@@ -1891,8 +1891,8 @@ private:
             &Callback::function_dtor<F>,
         };
 
-        /*MBED_STATIC_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
-                           "Type F must not exceed the size of the Callback class");*/
+        static_assert(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
+                      "Type F must not exceed the size of the Callback class");
         memset(this, 0, sizeof(Callback));
         new (this) F(f);
         _ops = &ops;
@@ -2519,8 +2519,8 @@ private:
             &Callback::function_dtor<F>,
         };
 
-        /*MBED_STATIC_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
-                           "Type F must not exceed the size of the Callback class");*/
+        static_assert(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
+                      "Type F must not exceed the size of the Callback class");
         memset(this, 0, sizeof(Callback));
         new (this) F(f);
         _ops = &ops;
@@ -3148,8 +3148,8 @@ private:
             &Callback::function_dtor<F>,
         };
 
-        /*MBED_STATIC_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
-                           "Type F must not exceed the size of the Callback class");*/
+        static_assert(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
+                      "Type F must not exceed the size of the Callback class");
         memset(this, 0, sizeof(Callback));
         new (this) F(f);
         _ops = &ops;
@@ -3778,8 +3778,8 @@ private:
             &Callback::function_dtor<F>,
         };
 
-        /*MBED_STATIC_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
-                           "Type F must not exceed the size of the Callback class");*/
+        static_assert(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
+                      "Type F must not exceed the size of the Callback class");
         memset(this, 0, sizeof(Callback));
         new (this) F(f);
         _ops = &ops;
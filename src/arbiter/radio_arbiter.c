@@ -0,0 +1,167 @@
+/**
+ * @file
+ * @brief radio_arbiter.c
+ * Receive window protection between the LoRa and Bluetooth tasks.
+ *******************************************************************************
+ *
+ * The window state is written by the LoRa task and read by the Bluetooth
+ * application task, due times are kept in RTCC wall clock ticks. The
+ * Bluetooth application task only ever changes its own priority, so a window
+ * closing while it is demoted is picked up on its next loop iteration.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "em_core.h"
+#include "rtcdriver.h"
+#include <src/arbiter/radio_arbiter.h>
+
+/* Class A windows, indexed by rx_slot_t RX_SLOT_WIN_1 and RX_SLOT_WIN_2 */
+#define ARBITER_SLOT_COUNT    2
+
+static const char *const causeNames[ARBITER_CAUSE_COUNT] = { "BLE bulk", "latency" };
+
+static uint32_t missMs;
+static uint8_t pending;
+static uint64_t due[ARBITER_SLOT_COUNT];
+static volatile bool bleBulk;
+
+// Bluetooth application task side
+static bool yielding;
+static OS_PRIO blePrio;
+
+static arbiter_stats_t stats;
+
+void arbiter_init(uint32_t miss_ms)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  missMs = miss_ms;
+  pending = 0;
+  memset(&stats, 0, sizeof(stats));
+  CORE_EXIT_CRITICAL();
+}
+
+void arbiter_rx_scheduled(uint8_t slot, int32_t delay_ms)
+{
+  uint64_t at;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (slot >= ARBITER_SLOT_COUNT) {
+    return;
+  }
+
+  at = RTCDRV_GetWallClockTicks64() + RTCDRV_MsecsToTicks(delay_ms > 0 ? delay_ms : 0);
+
+  CORE_ENTER_CRITICAL();
+  due[slot] = at;
+  pending |= 1 << slot;
+  stats.windows++;
+  CORE_EXIT_CRITICAL();
+}
+
+void arbiter_rx_opened(uint8_t slot, int32_t late_ms)
+{
+  arbiter_cause_t cause;
+
+  if (slot >= ARBITER_SLOT_COUNT) {
+    return;
+  }
+
+  stats.opened++;
+  if (late_ms > stats.late_max_ms) {
+    stats.late_max_ms = late_ms;
+  }
+  if (late_ms < 0 || (uint32_t)late_ms <= missMs) {
+    return;
+  }
+
+  cause = bleBulk ? ARBITER_CAUSE_BLE_BULK : ARBITER_CAUSE_LATENCY;
+  stats.missed++;
+  stats.missed_by[cause]++;
+  printf("\r\n RX%d window opened %ld ms late, cause: %s \r\n",
+         slot + 1, (long)late_ms, causeNames[cause]);
+}
+
+void arbiter_rx_closed(uint8_t slot, bool received)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  (void)received;
+  if (slot >= ARBITER_SLOT_COUNT) {
+    return;
+  }
+
+  CORE_ENTER_CRITICAL();
+  pending &= ~(1 << slot);
+  CORE_EXIT_CRITICAL();
+}
+
+void arbiter_reset(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  pending = 0;
+  CORE_EXIT_CRITICAL();
+}
+
+void arbiter_ble_bulk(bool active)
+{
+  bleBulk = active;
+}
+
+/* True if a pending window opens within the guard time or is open */
+static bool arbiter_window_near(void)
+{
+  uint64_t now = RTCDRV_GetWallClockTicks64();
+  uint64_t guard = RTCDRV_MsecsToTicks(ARBITER_GUARD_MS);
+  uint64_t hold = RTCDRV_MsecsToTicks(ARBITER_WINDOW_MAX_MS);
+  bool near = false;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  for (int i = 0; i < ARBITER_SLOT_COUNT; i++) {
+    if ((pending & (1 << i)) == 0) {
+      continue;
+    }
+    if (now > due[i] + hold) {
+      // Closure never reported, e.g. the MAC stopped its timers
+      pending &= ~(1 << i);
+    } else if (now + guard >= due[i]) {
+      near = true;
+    }
+  }
+  CORE_EXIT_CRITICAL();
+
+  return near;
+}
+
+bool arbiter_ble_yield(void)
+{
+  bool near = arbiter_window_near();
+  RTOS_ERR err;
+
+  if (near && !yielding) {
+    blePrio = OSTCBCurPtr->Prio;
+    OSTaskChangePrio(DEF_NULL, ARBITER_YIELD_PRIO, &err);
+    yielding = (RTOS_ERR_CODE_GET(err) == RTOS_ERR_NONE);
+    stats.yields++;
+  } else if (!near && yielding) {
+    OSTaskChangePrio(DEF_NULL, blePrio, &err);
+    yielding = false;
+  }
+
+  return near;
+}
+
+void arbiter_stats_get(arbiter_stats_t *out)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  *out = stats;
+  CORE_EXIT_CRITICAL();
+}
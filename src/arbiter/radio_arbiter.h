@@ -0,0 +1,83 @@
+/**
+ * @file
+ * @brief radio_arbiter.h
+ * Keeps BLE bulk traffic away from the LoRaWAN receive windows.
+ *******************************************************************************
+ *
+ * The Bluetooth application task runs above the LoRa and radio tasks and,
+ * during a throughput test, keeps the Bluetooth stack busy with notifications.
+ * A receive window opened late by the LoRa event queue or serviced late by the
+ * radio task misses the downlink preamble.
+ *
+ * The MAC reports when the windows of an uplink are due (see the rx_window
+ * callback of lorawan_app_callbacks_t). From ARBITER_GUARD_MS before a window
+ * until it closes, the Bluetooth application loop holds back its bulk
+ * notifications and runs below the LoRa tasks. Windows opened later than the
+ * receive error budget are counted as missed and logged with their likely
+ * cause.
+ *
+ ******************************************************************************/
+
+#ifndef RADIO_ARBITER_H
+#define RADIO_ARBITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <kernel/include/os.h>
+
+/* Lead time before a window opens from which BLE bulk traffic is held back */
+#ifndef ARBITER_GUARD_MS
+#define ARBITER_GUARD_MS            20
+#endif
+
+/* A window that was not reported closed by then is released anyway */
+#ifndef ARBITER_WINDOW_MAX_MS
+#define ARBITER_WINDOW_MAX_MS       3000
+#endif
+
+/* Priority of the Bluetooth application task while a window is protected,
+ * below the LoRa (12), radio (11) and BLE start (13) tasks */
+#ifndef ARBITER_YIELD_PRIO
+#define ARBITER_YIELD_PRIO          14u
+#endif
+
+typedef enum {
+  ARBITER_CAUSE_BLE_BULK = 0,   // a BLE bulk transfer was running
+  ARBITER_CAUSE_LATENCY,        // the LoRa side itself was late
+  ARBITER_CAUSE_COUNT
+} arbiter_cause_t;
+
+typedef struct {
+  uint32_t windows;                          // windows scheduled
+  uint32_t opened;                           // windows opened
+  uint32_t missed;                           // windows opened later than the error budget
+  uint32_t missed_by[ARBITER_CAUSE_COUNT];
+  uint32_t yields;                           // times the BLE application yielded to a window
+  int32_t  late_max_ms;                      // worst opening delay
+} arbiter_stats_t;
+
+/* miss_ms: opening delay from which a window counts as missed, usually the
+ * lora.max-sys-rx-error budget the windows are widened by */
+void arbiter_init(uint32_t miss_ms);
+
+/* LoRa side, from the rx_window callback in the LoRa task */
+void arbiter_rx_scheduled(uint8_t slot, int32_t delay_ms);
+void arbiter_rx_opened(uint8_t slot, int32_t late_ms);
+void arbiter_rx_closed(uint8_t slot, bool received);
+void arbiter_reset(void);
+
+/* BLE side, from the Bluetooth application task */
+void arbiter_ble_bulk(bool active);
+bool arbiter_ble_yield(void);
+
+void arbiter_stats_get(arbiter_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -28,14 +28,33 @@
 #include "em_emu.h"
 #include "em_rtcc.h"
 #include "rtos_bluetooth.h"
+#include <src/power/power_manager.h>
+#include <src/ble/app_bridge.h>
 
-/* Main application */
-void appMain(void *pconfig)
+/* Bluetooth stack requirement: the LL timers run from the LF clock */
+static void ble_power_req(power_req_t *req, void *ctx)
 {
+  (void)ctx;
 #if DISABLE_SLEEP > 0
-  pconfig->sleep.flags = 0;
+  req->deepest = sleepEM1;
+#else
+  req->deepest = sleepEM2;
 #endif
+  req->deadline_ms = gecko_can_sleep_ms();
+}
+
+/* Display requirement: none of its own. The PAL blocks EM2 while an LDMA
+   flush is on the wire, and EXTCOMIN is not toggled at all, the
+   PAL_TIMER_REPEAT_FUNCTION rtcIntCallbackRegister() is a stub. */
+static void display_power_req(power_req_t *req, void *ctx)
+{
+  (void)ctx;
+  req->deepest = sleepEM2;
+}
 
+/* Main application */
+void appMain(void *pconfig)
+{
   gecko_configuration_t *pcurrconfig;
 
   pcurrconfig = (gecko_configuration_t *) pconfig;
@@ -89,6 +108,11 @@ void appMain(void *pconfig)
   // Initialize display
   GRAPHICS_Init();
 
+  power_register(POWER_CLIENT_BLE, ble_power_req, NULL);
+  power_register(POWER_CLIENT_DISPLAY, display_power_req, NULL);
+
+  app_bridge_init();
+
   reset_variables();
   gecko_cmd_gatt_set_max_mtu(250);
   txPowerResp = gecko_cmd_system_set_tx_power(TX_POWER)->set_power; // 0.1 dBm count, stack may return something around the setpoint
@@ -22,7 +22,8 @@
 /* DEBUG_LEVEL is used to enable/disable debug prints. Set DEBUG_LEVEL to 1 to enable debug prints */
 #define DEBUG_LEVEL 0
 
-/* Set this value to 1 if you want to disable deep sleep completely */
+/* Set this value to 1 if you want to disable deep sleep completely, the power
+ * manager then keeps the MCU in EM1 */
 #define DISABLE_SLEEP 0
 
 #if DEBUG_LEVEL
@@ -0,0 +1,262 @@
+/**
+ * @file
+ * @brief app_bgapi.c
+ * Bounded FIFO of BGAPI commands retried from the application loop.
+ ******************************************************************************/
+
+#include <string.h>
+#include <cpu/include/cpu.h>
+#include <src/ble/app.h>
+#include <src/ble/app_bgapi.h>
+#include "rtos_gecko.h"
+
+typedef enum {
+  BGAPI_CMD_SET_SOFT_TIMER,
+  BGAPI_CMD_WRITE_WITHOUT_RESPONSE,
+  BGAPI_CMD_WRITE_ATTRIBUTE_VALUE,
+  BGAPI_CMD_SEND_NOTIFICATION
+} bgapi_cmd_t;
+
+typedef struct {
+  uint8_t cmd;
+  uint8_t connection;       // or soft timer handle
+  uint16_t characteristic;  // or soft timer single shot flag
+  uint32_t time;
+  uint16_t attempts;
+  uint8_t len;
+  int8_t longValue;         // index into longValues for values longer than BGAPI_MAX_VALUE_SIZE, or -1
+  uint8_t value[BGAPI_MAX_VALUE_SIZE];
+  const uint8_t *data;      // caller's buffer, NULL once the value is copied into the queue
+} bgapi_entry_t;
+
+static bgapi_entry_t queue[BGAPI_QUEUE_SIZE];
+static uint8_t queueHead = 0;
+static uint8_t queueCount = 0;
+static uint8_t longValues[BGAPI_LONG_VALUES][BGAPI_LONG_VALUE_SIZE];
+static uint8_t longValuesUsed = 0;    // bit per longValues buffer
+static bgapi_stats_t stats;
+
+/**
+ * @brief bgapi_issue
+ * Issues a queued command to the stack.
+ * @return stack result
+ */
+static uint16_t bgapi_issue(const bgapi_entry_t *e) {
+  const uint8_t *value = e->data;
+
+  if (value == NULL) {
+    value = (e->longValue >= 0) ? longValues[e->longValue] : e->value;
+  }
+
+  switch (e->cmd) {
+    case BGAPI_CMD_SET_SOFT_TIMER:
+      return gecko_cmd_hardware_set_soft_timer(e->time, e->connection, (uint8_t)e->characteristic)->result;
+    case BGAPI_CMD_WRITE_WITHOUT_RESPONSE:
+      return gecko_cmd_gatt_write_characteristic_value_without_response(e->connection, e->characteristic, e->len, value)->result;
+    case BGAPI_CMD_WRITE_ATTRIBUTE_VALUE:
+      return gecko_cmd_gatt_server_write_attribute_value(e->characteristic, 0, e->len, value)->result;
+    case BGAPI_CMD_SEND_NOTIFICATION:
+      return gecko_cmd_gatt_server_send_characteristic_notification(e->connection, e->characteristic, e->len, value)->result;
+    default:
+      return bg_err_invalid_param;
+  }
+}
+
+/**
+ * @brief bgapi_fail
+ * Reports a command that is given up on.
+ */
+static void bgapi_fail(const bgapi_entry_t *e, uint16_t result) {
+  stats.failed++;
+  stats.lastError = result;
+  printLog("BGAPI command %d dropped, result 0x%04x\r\n", e->cmd, result);
+}
+
+/**
+ * @brief bgapi_copy_value
+ * Copies the value of a command about to be queued, so the caller may reuse its buffer.
+ * @return false if the value is too long or all long value buffers are taken
+ */
+static bool bgapi_copy_value(bgapi_entry_t *e) {
+  uint8_t *copy = e->value;
+
+  e->longValue = -1;
+  if (e->len > BGAPI_MAX_VALUE_SIZE) {
+    if (e->len > BGAPI_LONG_VALUE_SIZE) {
+      return false;
+    }
+    for (int8_t i = 0; i < BGAPI_LONG_VALUES; i++) {
+      if (!(longValuesUsed & (1 << i))) {
+        e->longValue = i;
+        break;
+      }
+    }
+    if (e->longValue < 0) {
+      return false;
+    }
+    longValuesUsed |= 1 << e->longValue;
+    copy = longValues[e->longValue];
+  }
+
+  if (e->len != 0) {
+    memcpy(copy, e->data, e->len);
+  }
+  e->data = NULL;
+  return true;
+}
+
+/**
+ * @brief bgapi_release
+ * Releases the long value buffer of a command leaving the queue.
+ */
+static void bgapi_release(bgapi_entry_t *e) {
+  if (e->longValue >= 0) {
+    longValuesUsed &= ~(1 << e->longValue);
+    e->longValue = -1;
+  }
+}
+
+/**
+ * @brief bgapi_submit
+ * Issues the command right away if nothing is pending, otherwise or if the stack
+ * is out of buffers, appends it with a copy of its value to the queue so that
+ * commands keep their order. Any other error will not go away with a retry and
+ * is reported right away.
+ * @return bg_err_success if sent or queued, the error if the stack rejected the
+ * command or the queue is full
+ */
+static uint16_t bgapi_submit(bgapi_entry_t *e, const uint8_t *value) {
+  uint16_t result;
+  bgapi_entry_t *slot;
+
+  e->data = value;
+  e->longValue = -1;
+  e->attempts = 1;
+  stats.submitted++;
+
+  if (queueCount == 0) {
+    result = bgapi_issue(e);
+    if (result == bg_err_success) {
+      return result;
+    }
+    if (result != bg_err_out_of_memory) {
+      bgapi_fail(e, result);
+      return result;
+    }
+  } else {
+    result = bg_err_out_of_memory;
+  }
+
+  if (queueCount == BGAPI_QUEUE_SIZE) {
+    bgapi_fail(e, result);
+    return result;
+  }
+
+  slot = &queue[(queueHead + queueCount) % BGAPI_QUEUE_SIZE];
+  *slot = *e;
+  if (!bgapi_copy_value(slot)) {
+    bgapi_fail(e, bg_err_out_of_memory);
+    return bg_err_out_of_memory;
+  }
+
+  stats.deferred++;
+  queueCount++;
+  return bg_err_success;
+}
+
+uint16_t bgapi_set_soft_timer(uint32_t time, uint8_t handle, uint8_t singleShot) {
+  bgapi_entry_t e = { .cmd = BGAPI_CMD_SET_SOFT_TIMER, .connection = handle, .characteristic = singleShot, .time = time, .len = 0 };
+  return bgapi_submit(&e, NULL);
+}
+
+uint16_t bgapi_write_without_response(uint8_t connection, uint16_t characteristic, uint8_t len, const uint8_t *value) {
+  bgapi_entry_t e = { .cmd = BGAPI_CMD_WRITE_WITHOUT_RESPONSE, .connection = connection, .characteristic = characteristic, .len = len };
+  return bgapi_submit(&e, value);
+}
+
+uint16_t bgapi_write_attribute_value(uint16_t attribute, uint8_t len, const uint8_t *value) {
+  bgapi_entry_t e = { .cmd = BGAPI_CMD_WRITE_ATTRIBUTE_VALUE, .characteristic = attribute, .len = len };
+  return bgapi_submit(&e, value);
+}
+
+uint16_t bgapi_send_notification(uint8_t connection, uint16_t characteristic, uint8_t len, const uint8_t *value) {
+  bgapi_entry_t e = { .cmd = BGAPI_CMD_SEND_NOTIFICATION, .connection = connection, .characteristic = characteristic, .len = len };
+  return bgapi_submit(&e, value);
+}
+
+/**
+ * @brief bgapi_pending
+ * @return true if commands wait for a retry, the application loop must then not block indefinitely
+ */
+bool bgapi_pending(void) {
+  return queueCount != 0;
+}
+
+/**
+ * @brief bgapi_retry_pending
+ * Retries the pending commands in order until the stack is out of buffers again. A command
+ * the stack rejects for any other reason is dropped and reported. Called once per wakeup
+ * of the application loop, so the time taken from other tasks is bounded by BGAPI_QUEUE_SIZE
+ * commands per stack event or tick.
+ */
+void bgapi_retry_pending(void) {
+  CPU_TS32 start;
+  CPU_TS32 cycles;
+
+  if (queueCount == 0) {
+    return;
+  }
+
+  start = CPU_TS_Get32();
+  while (queueCount != 0) {
+    bgapi_entry_t *e = &queue[queueHead];
+    uint16_t result = bgapi_issue(e);
+
+    stats.retries++;
+    if (result == bg_err_out_of_memory && ++e->attempts < BGAPI_MAX_ATTEMPTS) {
+      break;
+    }
+    if (result != bg_err_success) {
+      bgapi_fail(e, result);
+    }
+
+    bgapi_release(e);
+    queueHead = (queueHead + 1) % BGAPI_QUEUE_SIZE;
+    queueCount--;
+  }
+
+  cycles = CPU_TS_Get32() - start;
+  stats.retryCycles += cycles;
+  if (cycles > stats.maxRetryCycles) {
+    stats.maxRetryCycles = cycles;
+  }
+}
+
+/**
+ * @brief bgapi_flush
+ * Drops the pending commands that refer to a connection, e.g. once it is closed.
+ * Soft timer commands are kept in order and retried, the display refresh relies on them.
+ */
+void bgapi_flush(void) {
+  uint8_t kept = 0;
+
+  for (uint8_t i = 0; i < queueCount; i++) {
+    bgapi_entry_t *e = &queue[(queueHead + i) % BGAPI_QUEUE_SIZE];
+
+    if (e->cmd == BGAPI_CMD_SET_SOFT_TIMER) {
+      queue[(queueHead + kept) % BGAPI_QUEUE_SIZE] = *e;
+      kept++;
+    } else {
+      bgapi_release(e);
+    }
+  }
+  queueCount = kept;
+}
+
+/**
+ * @brief bgapi_get_stats
+ * Copies the command statistics, retryCycles is in CPU timestamp ticks (see CPU_TS_TmrFreqGet).
+ */
+void bgapi_get_stats(bgapi_stats_t *out) {
+  *out = stats;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file
+ * @brief app_bgapi.h
+ * Deferred BGAPI commands for the throughput application.
+ *
+ * Commands that must not be lost (display timers, transmission_on writes,
+ * throughput result, indications) used to be retried in a busy loop until
+ * the stack accepted them. They are now tried once and, if the stack is out
+ * of buffers (bg_err_out_of_memory), queued and retried in order from the
+ * application loop on the next stack event or tick. Any other error, e.g. a
+ * stale connection or characteristic handle, is reported right away and
+ * does not hold up the commands behind it.
+ ******************************************************************************/
+
+#ifndef APP_BGAPI_H
+#define APP_BGAPI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "bg_types.h"
+#include <stdbool.h>
+
+#define BGAPI_QUEUE_SIZE          8      // Pending commands, further commands are reported as failed
+#define BGAPI_MAX_ATTEMPTS        500    // Attempts before a pending command is dropped and reported
+#define BGAPI_MAX_VALUE_SIZE      4      // Attribute values up to this size are kept in the queue entry
+#define BGAPI_LONG_VALUES         2      // Buffers for longer values, e.g. indications, waiting in the queue
+#define BGAPI_LONG_VALUE_SIZE     255    // Longest value that can be queued, ATT_MTU - 3 at the largest MTU
+
+typedef struct {
+  uint32_t submitted;      // Commands issued through the bgapi_ wrappers
+  uint32_t deferred;       // Commands queued behind others or for lack of stack buffers
+  uint32_t retries;        // Retry attempts from bgapi_retry_pending()
+  uint32_t failed;         // Commands dropped: rejected by the stack, queue full or out of attempts
+  uint16_t lastError;      // Stack result of the last dropped command
+  uint32_t retryCycles;    // CPU timestamp ticks spent in bgapi_retry_pending()
+  uint32_t maxRetryCycles; // Longest single bgapi_retry_pending() call
+} bgapi_stats_t;
+
+uint16_t bgapi_set_soft_timer(uint32_t time, uint8_t handle, uint8_t singleShot);
+uint16_t bgapi_write_without_response(uint8_t connection, uint16_t characteristic, uint8_t len, const uint8_t *value);
+uint16_t bgapi_write_attribute_value(uint16_t attribute, uint8_t len, const uint8_t *value);
+uint16_t bgapi_send_notification(uint8_t connection, uint16_t characteristic, uint8_t len, const uint8_t *value);
+
+bool bgapi_pending(void);
+void bgapi_retry_pending(void);
+void bgapi_flush(void);
+void bgapi_get_stats(bgapi_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
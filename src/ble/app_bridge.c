@@ -0,0 +1,165 @@
+/**
+ * @file
+ * @brief app_bridge.c
+ * GATT front end of the BLE to LoRaWAN bridge.
+ ******************************************************************************/
+
+#include <src/ble/app_utils.h>
+#include <src/ble/app_bridge.h>
+#include <src/bridge/bridge.h>
+
+static bool flowSubscribed = false;
+
+/**
+ * @brief bridge_flow_changed
+ * Flow callback of the bridge, may run in the LoRa task, so the
+ * notification is sent from the Bluetooth task.
+ */
+static void bridge_flow_changed(void) {
+  gecko_external_signal(BRIDGE_FLOW_CHANGED);
+}
+
+/**
+ * @brief bridge_record_dropped
+ * Drop callback of the bridge, may run in the LoRa task, so the drop is
+ * reported from the Bluetooth task.
+ */
+static void bridge_record_dropped(bridge_drop_t reason) {
+  (void)reason;
+  gecko_external_signal(BRIDGE_DROPPED);
+}
+
+/**
+ * @brief report_drops
+ * Logs the records dropped since the last report, by reason.
+ */
+static void report_drops(void) {
+  static uint32_t reported = 0;
+  bridge_stats_t stats;
+
+  bridge_stats_get(&stats);
+  if (stats.dropped == reported) {
+    return;
+  }
+  printLog("Bridge dropped %lu records: %lu bad length, %lu ring full, %lu too long for the datarate\r\n",
+           (unsigned long)(stats.dropped - reported), (unsigned long)stats.droppedLength,
+           (unsigned long)stats.droppedFull, (unsigned long)stats.droppedUplink);
+  reported = stats.dropped;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+  put_u16(p, (uint16_t)v);
+  put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+/**
+ * @brief send_flow_state
+ * Updates the flow control value and notifies the client if it subscribed.
+ */
+static void send_flow_state(void) {
+  uint8_t paused = bridge_paused() ? 1 : 0;
+
+  bgapi_write_attribute_value(gattdb_bridge_flow, 1, &paused);
+  if (flowSubscribed) {
+    bgapi_send_notification(connection, gattdb_bridge_flow, 1, &paused);
+  }
+}
+
+/**
+ * @brief send_read_response
+ * Answers a read of the occupancy or latency characteristic.
+ */
+static void send_read_response(uint8_t conn, uint16_t characteristic, uint16_t offset) {
+  bridge_stats_t stats;
+  uint8_t value[12];
+  uint8_t len;
+
+  bridge_stats_get(&stats);
+  if (characteristic == gattdb_bridge_occupancy) {
+    put_u16(&value[0], stats.occupancy);
+    put_u16(&value[2], stats.capacity);
+    put_u32(&value[4], stats.dropped);
+    len = 8;
+  } else {
+    put_u32(&value[0], stats.latencyLastMs);
+    put_u32(&value[4], stats.latencyMaxMs);
+    put_u32(&value[8], stats.uplinks);
+    len = 12;
+  }
+
+  if (offset > len) {
+    gecko_cmd_gatt_server_send_user_read_response(conn, characteristic, bg_err_att_invalid_offset & 0xFF, 0, NULL);
+    return;
+  }
+  gecko_cmd_gatt_server_send_user_read_response(conn, characteristic, 0, len - offset, &value[offset]);
+}
+
+/**
+ * @brief app_bridge_init
+ * Hooks the GATT front end to the bridge.
+ */
+void app_bridge_init(void) {
+  bridge_on_flow(bridge_flow_changed);
+  bridge_on_drop(bridge_record_dropped);
+}
+
+/**
+ * @brief app_bridge_handle_events
+ * Handles the bridge characteristics regardless of the throughput test state.
+ * @param evt - The same stack event processed by main event loop, may be NULL
+ */
+void app_bridge_handle_events(struct gecko_cmd_packet *evt) {
+  if (evt == NULL) {
+    return;
+  }
+
+  switch (BGLIB_MSG_ID(evt->header)) {
+    case gecko_evt_gatt_server_user_write_request_id:
+      if (evt->data.evt_gatt_server_user_write_request.characteristic == gattdb_bridge_ingest) {
+        // Refused records are counted and reported by the bridge, the client learns about it from the flow control
+        bridge_ingest(evt->data.evt_gatt_server_user_write_request.value.data,
+                      evt->data.evt_gatt_server_user_write_request.value.len);
+      }
+      break;
+
+    case gecko_evt_gatt_server_user_read_request_id:
+      if (evt->data.evt_gatt_server_user_read_request.characteristic == gattdb_bridge_occupancy
+          || evt->data.evt_gatt_server_user_read_request.characteristic == gattdb_bridge_latency) {
+        send_read_response(evt->data.evt_gatt_server_user_read_request.connection,
+                           evt->data.evt_gatt_server_user_read_request.characteristic,
+                           evt->data.evt_gatt_server_user_read_request.offset);
+      }
+      break;
+
+    case gecko_evt_gatt_server_characteristic_status_id:
+      if (evt->data.evt_gatt_server_characteristic_status.characteristic == gattdb_bridge_flow
+          && evt->data.evt_gatt_server_characteristic_status.status_flags == gatt_server_client_config) {
+        flowSubscribed = (evt->data.evt_gatt_server_characteristic_status.client_config_flags & gatt_notification) != 0;
+        if (flowSubscribed) {
+          send_flow_state();
+        }
+      }
+      break;
+
+    case gecko_evt_system_external_signal_id:
+      if (evt->data.evt_system_external_signal.extsignals & BRIDGE_FLOW_CHANGED) {
+        send_flow_state();
+      }
+      if (evt->data.evt_system_external_signal.extsignals & BRIDGE_DROPPED) {
+        report_drops();
+      }
+      break;
+
+    case gecko_evt_le_connection_closed_id:
+      flowSubscribed = false;
+      break;
+
+    default:
+      break;
+  }
+}
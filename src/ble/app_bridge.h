@@ -0,0 +1,34 @@
+/**
+ * @file
+ * @brief app_bridge.h
+ * GATT front end of the BLE to LoRaWAN bridge (see src/bridge/bridge.h).
+ *
+ * Clients write sensor records to the ingest characteristic without
+ * response. The flow control characteristic notifies 1 when the bridge
+ * buffer runs full and 0 once the LoRa side drained it, the occupancy and
+ * latency characteristics are read on demand:
+ *
+ *   occupancy  uint16 bytes used, uint16 capacity, uint32 records dropped
+ *   latency    uint32 last ms, uint32 max ms, uint32 uplinks sent
+ *
+ * All values little endian.
+ ******************************************************************************/
+
+#ifndef APP_BRIDGE_H
+#define APP_BRIDGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "bg_types.h"
+#include "rtos_gecko.h"
+
+void app_bridge_init(void);
+void app_bridge_handle_events(struct gecko_cmd_packet *evt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
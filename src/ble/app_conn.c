@@ -0,0 +1,191 @@
+/**
+ * @file
+ * @brief app_conn.c
+ * Connection table of the throughput slave.
+ ******************************************************************************/
+
+#include <string.h>
+#include <src/ble/app.h>
+#include <src/ble/app_utils.h>
+#include <src/ble/app_conn.h>
+#include <src/ble/app_stats.h>
+
+static conn_t conns[MAX_CONNECTIONS];
+
+/**
+ * @brief conn_update_payload
+ * Recalculates the notification payload once the MTU or the PDU size changed.
+ */
+static void conn_update_payload(conn_t *c) {
+  c->payloadSize = notification_size(c->pduSize, c->mtuSize);
+}
+
+/**
+ * @brief conn_reset
+ * Frees all slots.
+ */
+void conn_reset(void) {
+  memset(conns, 0, sizeof(conns));
+  for (int i = 0; i < MAX_CONNECTIONS; i++) {
+    conns[i].handle = CONN_HANDLE_NONE;
+  }
+}
+
+/**
+ * @brief conn_find
+ * @return the entry of the connection, NULL if it is not in the table
+ */
+conn_t *conn_find(uint8_t handle) {
+  for (int i = 0; i < MAX_CONNECTIONS; i++) {
+    if (conns[i].handle == handle && handle != CONN_HANDLE_NONE) {
+      return &conns[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief conn_at
+ * @return the entry in slot index, NULL if the slot is free
+ */
+conn_t *conn_at(uint8_t index) {
+  if (index >= MAX_CONNECTIONS || conns[index].handle == CONN_HANDLE_NONE) {
+    return NULL;
+  }
+  return &conns[index];
+}
+
+/**
+ * @brief conn_count
+ * @return number of open connections
+ */
+uint8_t conn_count(void) {
+  uint8_t count = 0;
+
+  for (int i = 0; i < MAX_CONNECTIONS; i++) {
+    if (conns[i].handle != CONN_HANDLE_NONE) {
+      count++;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief conn_update_subscriptions
+ * Derives the global subscription flags: notifications stream to every subscribed client,
+ * the indication test runs on the primary connection only.
+ */
+void conn_update_subscriptions(void) {
+  conn_t *primary = conn_find(connection);
+
+  notificationsSubscribed = false;
+  for (int i = 0; i < MAX_CONNECTIONS; i++) {
+    if (conns[i].handle != CONN_HANDLE_NONE && conns[i].notificationsSubscribed) {
+      notificationsSubscribed = true;
+    }
+  }
+  indicationsSubscribed = (primary != NULL) && primary->indicationsSubscribed;
+
+  notifyString = (char *)(notificationsSubscribed ? NOTIFY_ENABLED_STRING : NOTIFY_DISABLED_STRING);
+  indicateString = (char *)(indicationsSubscribed ? INDICATE_ENABLED_STRING : INDICATE_DISABLED_STRING);
+}
+
+/**
+ * @brief conn_reset_counters
+ * Starts the per connection accounting of a new transmission.
+ */
+void conn_reset_counters(void) {
+  for (int i = 0; i < MAX_CONNECTIONS; i++) {
+    conns[i].deficit = 0;
+    conns[i].bitsSent = 0;
+    conns[i].operationCount = 0;
+    conns[i].stalls = 0;
+  }
+}
+
+/**
+ * @brief conn_print_stats
+ * Logs the throughput of every connection that took part in a transmission.
+ * @param ticks - duration of the transmission in RTCC ticks
+ */
+void conn_print_stats(uint32_t ticks) {
+  for (int i = 0; i < MAX_CONNECTIONS; i++) {
+    if (conns[i].handle == CONN_HANDLE_NONE || conns[i].operationCount == 0) {
+      continue;
+    }
+    printLog("Connection %d: %lu bps, %lu notifications of %d bytes, %lu stalls\r\n",
+             conns[i].handle,
+             stats_throughput(conns[i].bitsSent, ticks),
+             conns[i].operationCount, conns[i].payloadSize, conns[i].stalls);
+  }
+}
+
+/**
+ * @brief conn_handle_events
+ * Keeps the table in sync with the stack, called before the slave state machine sees the event.
+ * @param evt - event struct from main loop passed in, may be NULL
+ */
+void conn_handle_events(struct gecko_cmd_packet *evt) {
+  conn_t *c;
+
+  if (evt == NULL) {
+    return;
+  }
+
+  switch (BGLIB_MSG_ID(evt->header)) {
+    case gecko_evt_le_connection_opened_id:
+      c = NULL;
+      for (int i = 0; c == NULL && i < MAX_CONNECTIONS; i++) {
+        if (conns[i].handle == CONN_HANDLE_NONE) {
+          c = &conns[i];
+        }
+      }
+      if (c != NULL) {
+        memset(c, 0, sizeof(*c));
+        c->handle = evt->data.evt_le_connection_opened.connection;
+        c->mtuSize = CONN_DEFAULT_MTU;
+        c->pduSize = CONN_DEFAULT_PDU;
+        conn_update_payload(c);
+      }
+      break;
+
+    case gecko_evt_le_connection_closed_id:
+      c = conn_find(evt->data.evt_le_connection_closed.connection);
+      if (c != NULL) {
+        c->handle = CONN_HANDLE_NONE;
+      }
+      break;
+
+    case gecko_evt_le_connection_parameters_id:
+      c = conn_find(evt->data.evt_le_connection_parameters.connection);
+      if (c != NULL) {
+        c->pduSize = evt->data.evt_le_connection_parameters.txsize;
+        c->interval = evt->data.evt_le_connection_parameters.interval;
+        conn_update_payload(c);
+      }
+      break;
+
+    case gecko_evt_gatt_mtu_exchanged_id:
+      c = conn_find(evt->data.evt_gatt_mtu_exchanged.connection);
+      if (c != NULL) {
+        c->mtuSize = evt->data.evt_gatt_mtu_exchanged.mtu;
+        conn_update_payload(c);
+      }
+      break;
+
+    case gecko_evt_gatt_server_characteristic_status_id:
+      c = conn_find(evt->data.evt_gatt_server_characteristic_status.connection);
+      if (c == NULL || evt->data.evt_gatt_server_characteristic_status.status_flags != gatt_server_client_config) {
+        break;
+      }
+      if (evt->data.evt_gatt_server_characteristic_status.characteristic == gattdb_throughput_notifications) {
+        c->notificationsSubscribed = (evt->data.evt_gatt_server_characteristic_status.client_config_flags == gatt_notification);
+      } else if (evt->data.evt_gatt_server_characteristic_status.characteristic == gattdb_throughput_indications) {
+        c->indicationsSubscribed = (evt->data.evt_gatt_server_characteristic_status.client_config_flags == gatt_indication);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
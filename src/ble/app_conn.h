@@ -0,0 +1,62 @@
+/**
+ * @file
+ * @brief app_conn.h
+ * Per connection state of the throughput slave.
+ *
+ * The slave accepts up to MAX_CONNECTIONS centrals. Each one negotiates its
+ * own MTU, PDU size and subscriptions, and the notification stream is spread
+ * over all subscribed connections by a deficit round robin scheduler (see
+ * pump_notifications()). The global connection, mtuSize, pduSize and
+ * interval variables keep describing the primary connection, which drives
+ * the display, the indication test and the master handshake.
+ ******************************************************************************/
+
+#ifndef APP_CONN_H
+#define APP_CONN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "bg_types.h"
+#include "rtos_gecko.h"
+#include <stdbool.h>
+
+// Also sizes the Bluetooth stack's connection table and heap in ble_main.c
+#ifndef MAX_CONNECTIONS
+#define MAX_CONNECTIONS 4
+#endif
+
+#define CONN_HANDLE_NONE          0xFF
+#define CONN_DEFAULT_MTU          23     // ATT MTU until the client exchanges a larger one
+#define CONN_DEFAULT_PDU          27     // LL payload until the data length update
+#define CONN_QUANTUM              DATA_SIZE  // Bytes added to a connection's deficit per scheduler round
+
+typedef struct {
+  uint8_t handle;             // CONN_HANDLE_NONE if the slot is free
+  uint16_t mtuSize;
+  uint16_t pduSize;
+  uint16_t interval;
+  uint16_t payloadSize;       // Notification payload for this connection's MTU and PDU
+  bool notificationsSubscribed;
+  bool indicationsSubscribed;
+  int32_t deficit;            // Bytes the scheduler still owes the connection
+  uint32_t bitsSent;          // Since the start of the current transmission
+  uint32_t operationCount;
+  uint32_t stalls;            // Scheduler rounds ended by a full TX queue
+} conn_t;
+
+void conn_reset(void);
+void conn_handle_events(struct gecko_cmd_packet *evt);
+conn_t *conn_find(uint8_t handle);
+conn_t *conn_at(uint8_t index);
+uint8_t conn_count(void);
+void conn_update_subscriptions(void);
+void conn_reset_counters(void);
+void conn_print_stats(uint32_t ticks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -6,6 +6,8 @@
  ******************************************************************************/
 
 #include <src/ble/app_utils.h>
+#include <src/ble/app_stats.h>
+#include <src/ble/app_scan.h>
 #include  <kernel/include/os.h>
 
 /**************************************************************************//**
@@ -25,6 +27,7 @@
 #define SUPERVISION_TIMEOUT_125KPHY 200       // 200 * 10ms = 2000ms
 
 const char DEVICE_NAME_STRING[] = "Throughput Tester";    // Device name to match against scan results.
+#define DEVICE_NAME_LEN             (sizeof(DEVICE_NAME_STRING) - 1)
 
 static int process_scan_response(struct gecko_msg_le_gap_scan_response_evt_t *pResp);
 
@@ -33,27 +36,24 @@ static int process_scan_response(struct gecko_msg_le_gap_scan_response_evt_t *pR
  **************************************************************************************************/
 void master_main(void) {
 
-	RTOS_ERR  err;
-
 //void master_main(struct gecko_cmd_packet *evt) {
   while (1) {
     /* Event pointer for handling events */
     struct gecko_cmd_packet *evt;
+    uint32_t evtId;
 
-    evt = gecko_peek_event();
-
-    /* Delay Start Task execution for                       */
-    OSTimeDly( 1,                                        /*   500 OS Ticks                                      */
-    		OS_OPT_TIME_DLY,                             /*   from now.                                          */
-			&err);
-
+    // Deferred BGAPI commands are retried on every event, or on the next tick if none arrives
+    evt = wait_bluetooth_event(bgapi_pending() ? 1 : BLE_WAIT_FOREVER);
+    bgapi_retry_pending();
+    stats_sample(bitsSent);
+    evtId = (evt != NULL) ? BGLIB_MSG_ID(evt->header) : 0;
 
     /* Main state loop */
     switch (state) {
 
       case ADV_SCAN:
 
-        switch (BGLIB_MSG_ID(evt->header) ) {
+        switch (evtId) {
 
           case gecko_evt_system_boot_id:
           case gecko_evt_le_connection_closed_id:
@@ -64,11 +64,19 @@ void master_main(void) {
             refresh_display();
             gecko_cmd_hardware_set_soft_timer(HW_TICKS_PER_SECOND, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0);
 
+            scan_init(2 + DEVICE_NAME_LEN); // Shortest advertising data holding the name record
             setup_adv_scan();
             break;
 
           case gecko_evt_le_gap_scan_response_id:
-            if (process_scan_response(&(evt->data.evt_le_gap_scan_response)) > 0) {
+            // Drop what can not be the tester before parsing it
+            if (!scan_filter(&(evt->data.evt_le_gap_scan_response))) {
+              break;
+            }
+            if (process_scan_response(&(evt->data.evt_le_gap_scan_response)) == 0) {
+              scan_remember(&(evt->data.evt_le_gap_scan_response));
+            } else {
+              scan_print_stats();
               gecko_cmd_le_gap_end_procedure(); // Stop scanning in the background.
               gecko_cmd_le_gap_connect(evt->data.evt_le_gap_scan_response.address,
                                       evt->data.evt_le_gap_scan_response.address_type,
@@ -94,7 +102,7 @@ void master_main(void) {
           gecko_cmd_le_connection_set_phy(connection, phyToUse);  // If change is needed, change PHY.
         }
 
-        switch (BGLIB_MSG_ID(evt->header) ) {
+        switch (evtId) {
           case gecko_evt_le_connection_phy_status_id:
             // Once a PHY change has been done, reset phyToUse and set conn parameters according to used PHY.
             // set_timing_parameters replaces connection_set_parameters in 2.12
@@ -190,7 +198,7 @@ void master_main(void) {
         break;
 
       case SUBSCRIBED_NOTIFICATIONS:
-        switch (BGLIB_MSG_ID(evt->header) ) {
+        switch (evtId) {
           // Master/Client waits for completion of subscribing to notifications.
           case gecko_evt_gatt_procedure_completed_id:
             gecko_cmd_gatt_set_characteristic_notification(connection, gattdb_throughput_indications, gatt_indication);
@@ -207,7 +215,7 @@ void master_main(void) {
         break;
 
       case SUBSCRIBED_INDICATIONS:
-        switch (BGLIB_MSG_ID(evt->header) ) {
+        switch (evtId) {
           case gecko_evt_gatt_procedure_completed_id:
             state = SUBSCRIBED;
             break;
@@ -226,7 +234,7 @@ void master_main(void) {
           gecko_cmd_le_connection_set_phy(connection, phyToUse);  // If change is needed, change PHY.
         }
 
-        switch (BGLIB_MSG_ID(evt->header) ) {
+        switch (evtId) {
           // Turn off display on master
           case gecko_evt_gatt_server_attribute_value_id:
             // Write GATT to signal that transmission starts and display should be turned off.
@@ -235,8 +243,9 @@ void master_main(void) {
                 bitsSent = 0;
                 throughput = 0;
                 timeElapsed = RTCC_CounterGet();
+                stats_start(bitsSent);
                 // Disable display refresh
-                while(gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0)->result != 0);
+                bgapi_set_soft_timer(0, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0);
                 state = RECEIVE;
               }
             }
@@ -289,17 +298,15 @@ void master_main(void) {
 
       case RECEIVE:
         // Master exclusive state
-        switch (BGLIB_MSG_ID(evt->header) ) {
+        switch (evtId) {
 
           case gecko_evt_gatt_server_attribute_value_id:
             // Slave has written to master's GATT to signal that transmission is ending and display should be turned on.
             if (evt->data.evt_gatt_server_attribute_value.attribute == gattdb_transmission_on) {
               if (evt->data.evt_gatt_server_attribute_value.value.data[0] == TRANSMISSION_OFF) {
-                timeElapsed = RTCC_CounterGet() - timeElapsed;
+                stop_measurement();
                 // Enable display refresh
-                while(gecko_cmd_hardware_set_soft_timer(HW_TICKS_PER_SECOND, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0)->result != 0);
-                // Calculate throughput
-                throughput = (uint32_t) ((float) bitsSent / (float) ((float) timeElapsed / (float) HW_TICKS_PER_SECOND ));
+                bgapi_set_soft_timer(HW_TICKS_PER_SECOND, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0);
                 state = SUBSCRIBED;
               }
             }
@@ -324,6 +331,7 @@ void master_main(void) {
         break;
     }
     handle_universal_events(evt);
+    release_bluetooth_event(evt);
   }
 }
 
@@ -350,9 +358,9 @@ static int process_scan_response(struct gecko_msg_le_gap_scan_response_evt_t *pR
     adType = pResp->data.data[i + 1];
 
     // Type 0x09 = Complete Local Name, 0x08 Shortened Name
-    if (adType == 0x09) {
+    if (adType == 0x09 && adLen >= DEVICE_NAME_LEN + 1 && i + 1 + adLen <= pResp->data.len) {
       // Check if device name is Throughput Tester
-      if (memcmp(pResp->data.data + i + 2, DEVICE_NAME_STRING, 17) == 0) {
+      if (memcmp(pResp->data.data + i + 2, DEVICE_NAME_STRING, DEVICE_NAME_LEN) == 0) {
         adMatchFound = 1;
         break;
       }
@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief app_scan.c
+ * Early reject and per address dedup of advertisements.
+ ******************************************************************************/
+
+#include <string.h>
+#include <src/ble/app.h>
+#include <src/ble/app_scan.h>
+
+#define SCAN_PACKET_TYPE_MASK          0x07
+#define SCAN_PACKET_SCANNABLE          0x02   // Scannable undirected, not connectable
+#define SCAN_PACKET_NONCONNECTABLE     0x03   // Non-connectable non-scannable undirected
+
+typedef struct {
+  bool used;
+  uint8_t type;
+  bd_addr address;
+} scan_entry_t;
+
+static scan_entry_t cache[SCAN_CACHE_SIZE];
+static uint8_t cacheCount;
+static uint8_t minDataLen;
+static scan_stats_t stats;
+
+/**
+ * @brief scan_hash
+ * FNV-1a over the address and its type.
+ */
+static uint32_t scan_hash(const bd_addr *address, uint8_t type) {
+  uint32_t h = 2166136261u;
+
+  for (int i = 0; i < 6; i++) {
+    h = (h ^ address->addr[i]) * 16777619u;
+  }
+  return (h ^ type) * 16777619u;
+}
+
+/**
+ * @brief scan_slot
+ * Looks up an address.
+ * @return slot holding the address, or the free slot it would go in
+ */
+static uint8_t scan_slot(const bd_addr *address, uint8_t type) {
+  uint8_t slot = scan_hash(address, type) & (SCAN_CACHE_SIZE - 1);
+
+  // The set never fills up, so the probe ends on a free slot
+  while (cache[slot].used) {
+    if (cache[slot].type == type && memcmp(&cache[slot].address, address, sizeof(bd_addr)) == 0) {
+      break;
+    }
+    slot = (slot + 1) & (SCAN_CACHE_SIZE - 1);
+  }
+  return slot;
+}
+
+/**
+ * @brief scan_init
+ * Sets up the filter for the name the master looks for.
+ * @param minLen - shortest advertising data that can hold a match
+ */
+void scan_init(uint8_t minLen) {
+  minDataLen = minLen;
+  scan_reset();
+}
+
+/**
+ * @brief scan_reset
+ * Forgets the devices seen so far, called whenever scanning starts.
+ */
+void scan_reset(void) {
+  memset(cache, 0, sizeof(cache));
+  cacheCount = 0;
+}
+
+/**
+ * @brief scan_filter
+ * Cheap checks done before the advertising data is parsed.
+ * @return true if the advertisement is worth parsing
+ */
+bool scan_filter(const struct gecko_msg_le_gap_scan_response_evt_t *resp) {
+  uint8_t packetType = resp->packet_type & SCAN_PACKET_TYPE_MASK;
+
+  stats.received++;
+
+  if (resp->data.len < minDataLen) {
+    stats.droppedShort++;
+    return false;
+  }
+  if (packetType == SCAN_PACKET_SCANNABLE || packetType == SCAN_PACKET_NONCONNECTABLE) {
+    stats.droppedType++;
+    return false;
+  }
+  if (cache[scan_slot(&resp->address, resp->address_type)].used) {
+    stats.droppedSeen++;
+    return false;
+  }
+
+  stats.parsed++;
+  return true;
+}
+
+/**
+ * @brief scan_remember
+ * Records a device whose advertisement did not match.
+ */
+void scan_remember(const struct gecko_msg_le_gap_scan_response_evt_t *resp) {
+  uint8_t slot;
+
+  if (cacheCount >= SCAN_CACHE_LOAD) {
+    scan_reset();
+    stats.cacheFlushes++;
+  }
+
+  slot = scan_slot(&resp->address, resp->address_type);
+  if (!cache[slot].used) {
+    cache[slot].used = true;
+    cache[slot].type = resp->address_type;
+    cache[slot].address = resp->address;
+    cacheCount++;
+  }
+}
+
+/**
+ * @brief scan_print_stats
+ * Logs how many advertisements were parsed and dropped.
+ */
+void scan_print_stats(void) {
+  printLog("Scan: %lu adverts, %lu parsed, dropped %lu short, %lu not connectable, %lu seen, %lu flushes\r\n",
+           stats.received, stats.parsed, stats.droppedShort, stats.droppedType, stats.droppedSeen, stats.cacheFlushes);
+}
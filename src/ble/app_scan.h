@@ -0,0 +1,49 @@
+/**
+ * @file
+ * @brief app_scan.h
+ * Advertisement filter of the throughput master.
+ *
+ * In a crowded band the master sees far more advertisements than its loop
+ * can parse. Advertisements that can not carry the complete local name of
+ * the tester or that can not be connected to are dropped before parsing,
+ * and so are devices whose advertisement was already parsed without a
+ * match. The latter are kept in a small open addressing hash set of
+ * addresses, which is cleared whenever scanning (re)starts, from
+ * setup_adv_scan() or on a scan PHY change, and whenever it fills up,
+ * so a device that changes its advertising data is seen again soon.
+ ******************************************************************************/
+
+#ifndef APP_SCAN_H
+#define APP_SCAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "bg_types.h"
+#include "rtos_gecko.h"
+#include <stdbool.h>
+
+#define SCAN_CACHE_SIZE           64     // Hash set slots, power of two
+#define SCAN_CACHE_LOAD           48     // Entries at which the set is cleared
+
+typedef struct {
+  uint32_t received;        // Scan responses delivered by the stack
+  uint32_t parsed;          // Advertisements that passed the filter
+  uint32_t droppedShort;    // Too short for the device name
+  uint32_t droppedType;     // Not connectable
+  uint32_t droppedSeen;     // Device already parsed without a match
+  uint32_t cacheFlushes;    // Times the hash set was full and cleared
+} scan_stats_t;
+
+void scan_init(uint8_t minLen);
+void scan_reset(void);
+bool scan_filter(const struct gecko_msg_le_gap_scan_response_evt_t *resp);
+void scan_remember(const struct gecko_msg_le_gap_scan_response_evt_t *resp);
+void scan_print_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
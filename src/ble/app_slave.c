@@ -7,6 +7,10 @@
 
 #include <src/ble/app_utils.h>
 #include  <kernel/include/os.h>
+#include <src/arbiter/radio_arbiter.h>
+#include <src/ble/app_tuner.h>
+#include <src/ble/app_conn.h>
+#include <src/ble/app_stats.h>
 
 static void check_subscription_status(struct gecko_cmd_packet *evt);
 static bool indicationTransmissionOngoing = false; // Tracks whether transmission is ongoing when triggered by other means besides buttons
@@ -16,23 +20,36 @@ static bool indicationTransmissionOngoing = false; // Tracks whether transmissio
  **************************************************************************************************/
 void slave_main(void) {
 
- RTOS_ERR  err;
+  bool notifyStalled = false; // Stack TX buffers were full after the last pump
 
   while (1) {
     /* Event pointer for handling events */
     struct gecko_cmd_packet *evt;
-
-    evt = gecko_peek_event();
-    													/* Delay Start Task execution for                    */
-    OSTimeDly(1,                                        /* 500 OS Ticks                                      */
-    		  OS_OPT_TIME_DLY,                          /* from now.                                         */
-			  &err);
+    uint32_t evtId;
+    // A LoRaWAN receive window is about to open, this task now runs below the LoRa tasks
+    bool yielding = arbiter_ble_yield();
+    // Notifications also fill the wait for indication confirmations
+    bool streaming = (state == NOTIFY) || (INDICATE_INTERLEAVE_NOTIFICATIONS && state == INDICATE && notificationsSubscribed);
+
+    // Only the notification stream keeps the loop spinning. Once the stack runs out of buffers,
+    // give the link layer a tick to drain instead of starving lower priority tasks. The stack
+    // has no event for freed TX buffers, so the pump resumes on the next event or tick.
+    // Deferred BGAPI commands are retried the same way, and the end of a receive window is polled.
+    if (!streaming) {
+      evt = wait_bluetooth_event((bgapi_pending() || yielding) ? 1 : BLE_WAIT_FOREVER);
+    } else {
+      evt = wait_bluetooth_event((notifyStalled || bgapi_pending() || yielding) ? 1 : 0);
+    }
+    bgapi_retry_pending();
+    stats_sample(bitsSent);
+    evtId = (evt != NULL) ? BGLIB_MSG_ID(evt->header) : 0;
+    conn_handle_events(evt);
 
     /* Main state loop */
     switch (state) {
       case ADV_SCAN:
 
-        switch (BGLIB_MSG_ID(evt->header) ) {
+        switch (evtId) {
 
           case gecko_evt_system_boot_id:
           case gecko_evt_le_connection_closed_id:
@@ -59,7 +76,7 @@ void slave_main(void) {
 
       case CONNECTED:
 
-        switch (BGLIB_MSG_ID(evt->header) ) {
+        switch (evtId) {
           case gecko_evt_le_connection_phy_status_id:
             update_displayed_phy(evt->data.evt_le_connection_phy_status.phy);
             break;
@@ -90,13 +107,13 @@ void slave_main(void) {
         break;
 
       case SUBSCRIBED_NOTIFICATIONS:
-        if (!advStopped) {
-          gecko_cmd_le_gap_stop_advertising(0); // Stop advertising both sets. (Multiple connections are allowed, so it will continue to advertise the unconnected set)
+        if (!advStopped && conn_count() >= MAX_CONNECTIONS) {
+          gecko_cmd_le_gap_stop_advertising(0); // Stop advertising both sets once no further central can connect
           gecko_cmd_le_gap_stop_advertising(1);
           advStopped = true;
         }
 
-        switch (BGLIB_MSG_ID(evt->header) ) {
+        switch (evtId) {
 
           case gecko_evt_gatt_server_attribute_value_id:
             if (evt->data.evt_gatt_server_attribute_value.attribute == gattdb_transmission_on) {
@@ -126,13 +143,13 @@ void slave_main(void) {
         break;
 
       case SUBSCRIBED_INDICATIONS:
-        if (!advStopped) {
-          gecko_cmd_le_gap_stop_advertising(0); // Stop advertising both sets. (Multiple connections are allowed, so it will continue to advertise the unconnected set)
+        if (!advStopped && conn_count() >= MAX_CONNECTIONS) {
+          gecko_cmd_le_gap_stop_advertising(0); // Stop advertising both sets once no further central can connect
           gecko_cmd_le_gap_stop_advertising(1);
           advStopped = true;
         }
 
-        switch (BGLIB_MSG_ID(evt->header) ) {
+        switch (evtId) {
 
           case gecko_evt_gatt_server_attribute_value_id:
             if (evt->data.evt_gatt_server_attribute_value.attribute == gattdb_transmission_on) {
@@ -142,8 +159,7 @@ void slave_main(void) {
                 indicationTransmissionOngoing = true;
                 state = INDICATE;
                 generate_indications_data();
-                while(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_indications, maxDataSizeIndications, indicationsData)->result != 0);
-                waitingForConfirmation = 1;
+                send_indication();
               }
             }
             break;
@@ -165,13 +181,16 @@ void slave_main(void) {
 
       case SUBSCRIBED:
 
-        if (!advStopped) {
-          gecko_cmd_le_gap_stop_advertising(0); // Stop advertising both sets. (Multiple connections are allowed, so it will continue to advertise the unconnected set)
+        if (!advStopped && conn_count() >= MAX_CONNECTIONS) {
+          gecko_cmd_le_gap_stop_advertising(0); // Stop advertising both sets once no further central can connect
           gecko_cmd_le_gap_stop_advertising(1);
           advStopped = true;
         }
 
-        switch (BGLIB_MSG_ID(evt->header) ) {
+        // Look for the fastest PHY and connection interval once per connection
+        tuner_arm();
+
+        switch (evtId) {
           case gecko_evt_le_connection_phy_status_id:
             update_displayed_phy(evt->data.evt_le_connection_phy_status.phy);
             break;
@@ -187,17 +206,15 @@ void slave_main(void) {
 
       case NOTIFY:
         // As slave, just send and move on.
-        switch (BGLIB_MSG_ID(evt->header)) {
+        switch (evtId) {
           case gecko_evt_gatt_server_attribute_value_id:
             if (evt->data.evt_gatt_server_attribute_value.attribute == gattdb_transmission_on) {
               if (evt->data.evt_gatt_server_attribute_value.value.data[0] == TRANSMISSION_OFF) {
-                timeElapsed = RTCC_CounterGet() - timeElapsed;
+                stop_measurement();
                 // Enable display refresh
-                while (gecko_cmd_hardware_set_soft_timer(HW_TICKS_PER_SECOND, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0)->result != 0);
-                // Calculate throughput
-                throughput = (uint32_t) ((float) bitsSent / (float) ((float) timeElapsed / (float) HW_TICKS_PER_SECOND ));
+                bgapi_set_soft_timer(HW_TICKS_PER_SECOND, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0);
                 // Write result to local GATT to be looked up on e.g. smart phone.
-                while(gecko_cmd_gatt_server_write_attribute_value(gattdb_throughput_result, 0, sizeof(throughput), (uint8_t *) (&throughput))->result != 0);
+                bgapi_write_attribute_value(gattdb_throughput_result, sizeof(throughput), (uint8_t *) (&throughput));
                 // Send result to subscribed NCP host or SoC master. Check for wrong state error, which means the client isn't subscribed to indications on the result.
                 if (gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_result, sizeof(throughput), (uint8_t *) (&throughput))->result != bg_err_wrong_state) {
                   gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_result, sizeof(throughput), (uint8_t *) (&throughput));
@@ -216,10 +233,10 @@ void slave_main(void) {
             break;
         }
 
-        if(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_notifications, maxDataSizeNotifications, notificationsData)->result == 0) {
-          bitsSent += (maxDataSizeNotifications * 8);
-          operationCount++;
-          generate_notifications_data();
+        // Top up the stack's TX buffers, unless the transmission was just stopped or the radio
+        // is listening for a LoRaWAN downlink. Indications are paced by the client and continue.
+        if (state == NOTIFY && !yielding) {
+          notifyStalled = (pump_notifications() != bg_err_success);
 #ifdef SEND_FIXED_TRANSFER_COUNT
           if (bitsSent >= (SEND_FIXED_TRANSFER_COUNT * 8)) {
             end_data_transmission();
@@ -234,19 +251,17 @@ void slave_main(void) {
         break;
 
       case INDICATE:
-        switch(BGLIB_MSG_ID(evt->header)) {
+        switch (evtId) {
 
           case gecko_evt_gatt_server_attribute_value_id:
             if (evt->data.evt_gatt_server_attribute_value.attribute == gattdb_transmission_on) {
               if (evt->data.evt_gatt_server_attribute_value.value.data[0] == TRANSMISSION_OFF) {
                 indicationTransmissionOngoing = false;
-                timeElapsed = RTCC_CounterGet() - timeElapsed;
+                stop_measurement();
                 // Enable display refresh
-                while(gecko_cmd_hardware_set_soft_timer(HW_TICKS_PER_SECOND, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0)->result != 0);
-                // Calculate throughput
-                throughput = (uint32_t) ((float) bitsSent / (float) ((float) timeElapsed / (float) HW_TICKS_PER_SECOND ));
+                bgapi_set_soft_timer(HW_TICKS_PER_SECOND, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0);
                 // Write result to local GATT to be looked up on e.g. smart phone.
-                while(gecko_cmd_gatt_server_write_attribute_value(gattdb_throughput_result, 0, sizeof(throughput), (uint8_t *) (&throughput))->result != 0);
+                bgapi_write_attribute_value(gattdb_throughput_result, sizeof(throughput), (uint8_t *) (&throughput));
                 // Send result to subscribed NCP host or SoC master. Check for wrong state error, which means the client isn't subscribed to indications on the result.
                 if (gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_result, sizeof(throughput), (uint8_t *) (&throughput))->result != bg_err_wrong_state) {
                   gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_result, sizeof(throughput), (uint8_t *) (&throughput));
@@ -278,9 +293,7 @@ void slave_main(void) {
                   }
                   break;
                 } else {
-                  generate_indications_data();
-                  while(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_indications, maxDataSizeIndications, indicationsData)->result != 0);
-                  waitingForConfirmation = 1;
+                  send_indication();
                   break;
                 }
 #endif
@@ -295,18 +308,14 @@ void slave_main(void) {
                   }
                   break;
                 } else {
-                  generate_indications_data();
-                  while(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_indications, maxDataSizeIndications, indicationsData)->result != 0);
-                  waitingForConfirmation = 1;
+                  send_indication();
                   break;
                 }
 #endif
               }
 
               if (indicationsSubscribed && (!buttonOneReleased || waitingForConfirmation || indicationTransmissionOngoing)) {
-                generate_indications_data();
-                while(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_indications, maxDataSizeIndications, indicationsData)->result != 0);
-                waitingForConfirmation = 1;
+                send_indication();
               } else {
                 end_data_transmission();
                 indicationTransmissionOngoing = false;
@@ -326,11 +335,19 @@ void slave_main(void) {
           default:
             break;
         }
+
+#if INDICATE_INTERLEAVE_NOTIFICATIONS
+        // Only one indication can be outstanding, keep the TX buffers busy until it is confirmed
+        if (state == INDICATE && waitingForConfirmation && notificationsSubscribed && !yielding) {
+          notifyStalled = (pump_notifications() != bg_err_success);
+        }
+#endif
         break;
       default:
         break;
     }
     handle_universal_events(evt);
+    release_bluetooth_event(evt);
   }
 }
 
@@ -340,49 +357,15 @@ void slave_main(void) {
  * @param evt - event struct from main loop passed in
  */
 static void check_subscription_status(struct gecko_cmd_packet *evt) {
+  uint16_t characteristic = evt->data.evt_gatt_server_characteristic_status.characteristic;
+
   // Check if Client Characteristic Configuration has been changed by client.
-  if (evt->data.evt_gatt_server_characteristic_status.characteristic == gattdb_throughput_notifications) {
-    if (evt->data.evt_gatt_server_characteristic_status.status_flags == gatt_server_client_config) {
-      // Notifications on.
-      if (evt->data.evt_gatt_server_characteristic_status.client_config_flags == gatt_notification) {
-          state = SUBSCRIBED_NOTIFICATIONS;
-          notificationsSubscribed = true;
-          notifyString = (char *)NOTIFY_ENABLED_STRING;
-      }
-      // Notifications off
-      if (evt->data.evt_gatt_server_characteristic_status.client_config_flags == gatt_disable) {
-        notificationsSubscribed = false;
-        notifyString = (char *)NOTIFY_DISABLED_STRING;
-
-        if (indicationsSubscribed) {
-          state = SUBSCRIBED_INDICATIONS;
-        } else {
-          state = CONNECTED;
-        }
-      }
-    }
+  if (evt->data.evt_gatt_server_characteristic_status.status_flags != gatt_server_client_config
+      || (characteristic != gattdb_throughput_notifications && characteristic != gattdb_throughput_indications)) {
+    return;
   }
 
-  if (evt->data.evt_gatt_server_characteristic_status.characteristic == gattdb_throughput_indications) {
-    if (evt->data.evt_gatt_server_characteristic_status.status_flags == gatt_server_client_config) {
-      // Indications on.
-      if (evt->data.evt_gatt_server_characteristic_status.client_config_flags == gatt_indication) {
-        state = SUBSCRIBED_INDICATIONS;
-        indicationsSubscribed = true;
-        indicateString = (char *)INDICATE_ENABLED_STRING;
-      }
-      // Indications off.
-      if (evt->data.evt_gatt_server_characteristic_status.client_config_flags == gatt_disable) {
-        indicateString = (char *)INDICATE_DISABLED_STRING;
-        indicationsSubscribed = false;
-
-        if (notificationsSubscribed) {
-          state = SUBSCRIBED_NOTIFICATIONS;
-        } else {
-          state = CONNECTED;
-        }
-
-      }
-    }
-  }
+  // The connection table already holds the new configuration of this client
+  conn_update_subscriptions();
+  state = subscription_state();
 }
@@ -0,0 +1,264 @@
+/**
+ * @file
+ * @brief app_stats.c
+ * Windowed byte counts and fixed point throughput figures.
+ ******************************************************************************/
+
+#include <string.h>
+#include <src/ble/app.h>
+#include <src/ble/app_utils.h>
+#include <src/ble/app_stats.h>
+
+static bool running = false;
+static uint32_t windowStart;         // RTCC tick the current window began at
+static uint32_t windowBits;          // bitsSent at the start of the current window
+
+static uint16_t samples[STATS_MAX_SAMPLES];   // Bytes per window, ring
+static uint16_t sampleNext;
+static uint32_t windows;
+static uint32_t stalls;
+static uint64_t totalBytes;
+static uint16_t minBytes;
+static uint16_t maxBytes;
+static uint32_t rollingBytes;        // Sum of the last STATS_ROLLING_WINDOWS windows
+
+static uint16_t sorted[STATS_MAX_SAMPLES];
+
+/**
+ * @brief stats_throughput
+ * Fixed point replacement of bits / (ticks / HW_TICKS_PER_SECOND).
+ * @return bits per second, 0 for an empty interval
+ */
+uint32_t stats_throughput(uint32_t bits, uint32_t ticks) {
+  if (ticks == 0) {
+    return 0;
+  }
+  return (uint32_t) (((uint64_t) bits * HW_TICKS_PER_SECOND + ticks / 2) / ticks);
+}
+
+/**
+ * @brief window_bps
+ * @return bits per second of a window that carried the given bytes
+ */
+static uint32_t window_bps(uint32_t bytes) {
+  return stats_throughput(bytes * 8, STATS_WINDOW_TICKS);
+}
+
+/**
+ * @brief stats_record
+ * Closes a window.
+ */
+static void stats_record(uint16_t bytes) {
+  if (windows >= STATS_ROLLING_WINDOWS) {
+    rollingBytes -= samples[(sampleNext + STATS_MAX_SAMPLES - STATS_ROLLING_WINDOWS) % STATS_MAX_SAMPLES];
+  }
+  rollingBytes += bytes;
+
+  samples[sampleNext] = bytes;
+  sampleNext = (sampleNext + 1) % STATS_MAX_SAMPLES;
+
+  if (windows == 0 || bytes < minBytes) {
+    minBytes = bytes;
+  }
+  if (bytes > maxBytes) {
+    maxBytes = bytes;
+  }
+  if (bytes == 0) {
+    stalls++;
+  }
+  totalBytes += bytes;
+  windows++;
+}
+
+/**
+ * @brief stats_kept
+ * @return number of windows still in the ring
+ */
+static uint16_t stats_kept(void) {
+  return (windows < STATS_MAX_SAMPLES) ? windows : STATS_MAX_SAMPLES;
+}
+
+/**
+ * @brief stats_start
+ * Starts sampling a transmission.
+ * @param bits - current value of the bit counter
+ */
+void stats_start(uint32_t bits) {
+  windowStart = RTCC_CounterGet();
+  windowBits = bits;
+  sampleNext = 0;
+  windows = 0;
+  stalls = 0;
+  totalBytes = 0;
+  minBytes = 0;
+  maxBytes = 0;
+  rollingBytes = 0;
+  running = true;
+}
+
+/**
+ * @brief stats_sample
+ * Closes all windows that ended since the last call. Called on every pass of the application
+ * loop, the data counted since the previous pass goes to the first window closed, so a loop
+ * that was held up shows up as empty windows.
+ * @param bits - current value of the bit counter
+ */
+void stats_sample(uint32_t bits) {
+  uint32_t now;
+
+  if (!running) {
+    return;
+  }
+
+  now = RTCC_CounterGet();
+  while ((uint32_t) (now - windowStart) >= STATS_WINDOW_TICKS) {
+    uint32_t bytes = (bits - windowBits) / 8;
+
+    stats_record((bytes > UINT16_MAX) ? UINT16_MAX : (uint16_t) bytes);
+    windowBits = bits;
+    windowStart += STATS_WINDOW_TICKS;
+  }
+}
+
+/**
+ * @brief stats_stop
+ * Ends the sampling, a partial last window is dropped.
+ * @param bits - current value of the bit counter
+ */
+void stats_stop(uint32_t bits) {
+  stats_sample(bits);
+  running = false;
+}
+
+/**
+ * @brief stats_percentile
+ * Nearest rank percentile of the sorted windows.
+ */
+static uint32_t stats_percentile(uint16_t count, uint8_t percent) {
+  uint32_t rank = ((uint32_t) count * percent + 99) / 100;
+
+  return window_bps(sorted[(rank > 0) ? rank - 1 : 0]);
+}
+
+/**
+ * @brief stats_get
+ * Computes the summary of the current or last transmission.
+ */
+void stats_get(stats_summary_t *summary) {
+  uint16_t count = stats_kept();
+
+  memset(summary, 0, sizeof(*summary));
+  summary->windows = windows;
+  summary->stalls = stalls;
+  if (windows == 0) {
+    return;
+  }
+
+  summary->meanBps = (uint32_t) ((totalBytes * 8 * HW_TICKS_PER_SECOND + (uint64_t) windows * STATS_WINDOW_TICKS / 2)
+                                 / ((uint64_t) windows * STATS_WINDOW_TICKS));
+  summary->minBps = window_bps(minBytes);
+  summary->maxBps = window_bps(maxBytes);
+  summary->rollingBps = stats_throughput(rollingBytes * 8,
+                                         STATS_WINDOW_TICKS * ((windows < STATS_ROLLING_WINDOWS) ? windows : STATS_ROLLING_WINDOWS));
+
+  // Insertion sort, the samples of a steady stream are nearly in order already
+  memcpy(sorted, samples, count * sizeof(sorted[0]));
+  for (uint16_t i = 1; i < count; i++) {
+    uint16_t v = sorted[i];
+    uint16_t j = i;
+
+    while (j > 0 && sorted[j - 1] > v) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = v;
+  }
+
+  summary->p50Bps = stats_percentile(count, 50);
+  summary->p95Bps = stats_percentile(count, 95);
+  summary->p99Bps = stats_percentile(count, 99);
+}
+
+/**
+ * @brief stats_print
+ * Logs the summary over SWO.
+ */
+void stats_print(void) {
+  stats_summary_t s;
+
+  stats_get(&s);
+  printLog("Throughput: mean %lu, min %lu, max %lu, rolling %lu bps\r\n",
+           s.meanBps, s.minBps, s.maxBps, s.rollingBps);
+  printLog("Throughput: p50 %lu, p95 %lu, p99 %lu bps, %lu of %lu windows empty\r\n",
+           s.p50Bps, s.p95Bps, s.p99Bps, s.stalls, s.windows);
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+  put_u16(p, (uint16_t)v);
+  put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+/**
+ * @brief send_read_response
+ * Answers a read of the statistics or samples characteristic.
+ */
+static void send_read_response(uint8_t conn, uint16_t characteristic, uint16_t offset) {
+  uint8_t value[STATS_GATT_SAMPLES * 2];
+  uint16_t len;
+
+  if (characteristic == gattdb_throughput_stats) {
+    stats_summary_t s;
+
+    stats_get(&s);
+    put_u32(&value[0], s.meanBps);
+    put_u32(&value[4], s.minBps);
+    put_u32(&value[8], s.maxBps);
+    put_u32(&value[12], s.p50Bps);
+    put_u32(&value[16], s.p95Bps);
+    put_u32(&value[20], s.p99Bps);
+    put_u32(&value[24], s.rollingBps);
+    put_u32(&value[28], s.windows);
+    put_u32(&value[32], s.stalls);
+    len = 36;
+  } else {
+    uint16_t count = stats_kept();
+
+    if (count > STATS_GATT_SAMPLES) {
+      count = STATS_GATT_SAMPLES;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+      put_u16(&value[i * 2], samples[(sampleNext + STATS_MAX_SAMPLES - count + i) % STATS_MAX_SAMPLES]);
+    }
+    len = count * 2;
+  }
+
+  if (offset > len) {
+    gecko_cmd_gatt_server_send_user_read_response(conn, characteristic, bg_err_att_invalid_offset & 0xFF, 0, NULL);
+    return;
+  }
+  gecko_cmd_gatt_server_send_user_read_response(conn, characteristic, 0, len - offset, &value[offset]);
+}
+
+/**
+ * @brief stats_handle_events
+ * Serves the statistics characteristics.
+ * @param evt - The same stack event processed by main event loop, may be NULL
+ */
+void stats_handle_events(struct gecko_cmd_packet *evt) {
+  if (evt == NULL) {
+    return;
+  }
+
+  if (BGLIB_MSG_ID(evt->header) == gecko_evt_gatt_server_user_read_request_id
+      && (evt->data.evt_gatt_server_user_read_request.characteristic == gattdb_throughput_stats
+          || evt->data.evt_gatt_server_user_read_request.characteristic == gattdb_throughput_samples)) {
+    send_read_response(evt->data.evt_gatt_server_user_read_request.connection,
+                       evt->data.evt_gatt_server_user_read_request.characteristic,
+                       evt->data.evt_gatt_server_user_read_request.offset);
+  }
+}
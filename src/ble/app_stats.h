@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @brief app_stats.h
+ * Throughput statistics of the BLE test.
+ *
+ * The bytes moved during a transmission are sampled in windows of
+ * STATS_WINDOW_TICKS RTCC ticks. Windows without any data show where the
+ * stream stalled. All figures are in bits per second and computed in fixed
+ * point:
+ *
+ *   throughput_stats    uint32 mean, min, max, p50, p95, p99, rolling mean,
+ *                       windows recorded, empty windows
+ *   throughput_samples  uint16 bytes per window, oldest first, up to the last
+ *                       STATS_GATT_SAMPLES windows
+ *
+ * All values little endian. Percentiles are over the last STATS_MAX_SAMPLES
+ * windows, the other figures over the whole transmission.
+ ******************************************************************************/
+
+#ifndef APP_STATS_H
+#define APP_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "bg_types.h"
+#include "rtos_gecko.h"
+#include <stdbool.h>
+
+#define STATS_WINDOW_TICKS        (HW_TICKS_PER_SECOND / 10)   // 100ms sample windows
+#define STATS_MAX_SAMPLES         600                          // Windows kept for the percentiles, 60s
+#define STATS_ROLLING_WINDOWS     10                           // Rolling mean over the last second
+#define STATS_GATT_SAMPLES        127                          // Windows served by throughput_samples
+
+typedef struct {
+  uint32_t meanBps;
+  uint32_t minBps;
+  uint32_t maxBps;
+  uint32_t p50Bps;
+  uint32_t p95Bps;
+  uint32_t p99Bps;
+  uint32_t rollingBps;
+  uint32_t windows;
+  uint32_t stalls;          // Windows without any data
+} stats_summary_t;
+
+uint32_t stats_throughput(uint32_t bits, uint32_t ticks);
+
+void stats_start(uint32_t bits);
+void stats_sample(uint32_t bits);
+void stats_stop(uint32_t bits);
+void stats_get(stats_summary_t *summary);
+void stats_print(void);
+void stats_handle_events(struct gecko_cmd_packet *evt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
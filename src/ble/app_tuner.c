@@ -0,0 +1,228 @@
+/**
+ * @file
+ * @brief app_tuner.c
+ * Goodput driven selection of the PHY and connection interval.
+ ******************************************************************************/
+
+#include <string.h>
+#include <src/ble/app.h>
+#include <src/ble/app_utils.h>
+#include <src/ble/app_tuner.h>
+#include <src/ble/app_stats.h>
+
+typedef enum {
+  TUNER_IDLE,
+  TUNER_ARMED,       // Waiting for TUNER_START_DELAY
+  TUNER_SETTLING,    // PHY or interval change requested
+  TUNER_MEASURING,   // Streaming notifications for TUNER_PROBE_TIME
+  TUNER_DONE
+} tuner_phase_t;
+
+typedef struct {
+  uint8_t phy;
+  uint16_t interval;   // 1.25ms units
+} tuner_config_t;
+
+// Grouped by PHY so that every PHY is switched to only once
+static const tuner_config_t candidates[] = {
+  { PHY_1M, 12 },      // 15ms
+  { PHY_1M, 24 },      // 30ms
+  { PHY_1M, 40 },      // 50ms
+#if defined(_SILICON_LABS_32B_SERIES_1_CONFIG_2) || defined(_SILICON_LABS_32B_SERIES_1_CONFIG_3) || defined(_SILICON_LABS_32B_SERIES_2_CONFIG_1)
+  { PHY_2M, 40 },
+  { PHY_2M, 24 },
+  { PHY_2M, 12 },
+#endif
+};
+
+#define CANDIDATE_COUNT   (sizeof(candidates) / sizeof(candidates[0]))
+
+static tuner_phase_t phase = TUNER_IDLE;
+static uint8_t current;              // Candidate being probed, CANDIDATE_COUNT while applying the best
+static uint8_t best;
+static uint32_t goodput[CANDIDATE_COUNT];
+static bool phyPending;
+
+static void tuner_settled(void);
+
+/**
+ * @brief tuner_target
+ * @return the configuration being probed or applied
+ */
+static const tuner_config_t *tuner_target(void) {
+  return &candidates[(current < CANDIDATE_COUNT) ? current : best];
+}
+
+/**
+ * @brief tuner_request_interval
+ * Second step of a change, asks the master for the target interval unless it is already in use.
+ */
+static void tuner_request_interval(void) {
+  const tuner_config_t *target = tuner_target();
+
+  if (interval == target->interval
+      || gecko_cmd_le_connection_set_timing_parameters(connection, target->interval, target->interval, 0,
+                                                       TUNER_SUPERVISION_TIMEOUT, 0, 0xFFFF)->result != bg_err_success) {
+    tuner_settled();
+  }
+}
+
+/**
+ * @brief tuner_apply
+ * Switches to the target PHY, then to the target interval. Either change may be refused by the
+ * peer, the configuration then measured is the one actually in use.
+ */
+static void tuner_apply(void) {
+  const tuner_config_t *target = tuner_target();
+
+  phase = TUNER_SETTLING;
+  bgapi_set_soft_timer(TUNER_SETTLE_TIME, SOFT_TIMER_TUNER_HANDLE, 1);
+
+  phyPending = (phyInUse != target->phy)
+               && (gecko_cmd_le_connection_set_phy(connection, target->phy)->result == bg_err_success);
+  if (!phyPending) {
+    tuner_request_interval();
+  }
+}
+
+/**
+ * @brief tuner_finish
+ * Leaves the notification stream once the best configuration is in place and reports its goodput.
+ */
+static void tuner_finish(void) {
+  phase = TUNER_DONE;
+  bgapi_set_soft_timer(0, SOFT_TIMER_TUNER_HANDLE, 1);
+
+  printLog("Tuner: PHY %d, interval %d, %lu bps\r\n",
+           candidates[best].phy, candidates[best].interval, goodput[best]);
+
+  state = subscription_state();
+  throughput = goodput[best];
+  finish_data_transmission();
+}
+
+/**
+ * @brief tuner_settled
+ * The change is done or timed out, starts the measurement or ends the run.
+ */
+static void tuner_settled(void) {
+  if (state != NOTIFY) {
+    // The stream was stopped under the tuner
+    bgapi_set_soft_timer(0, SOFT_TIMER_TUNER_HANDLE, 1);
+    phase = TUNER_DONE;
+    return;
+  }
+
+  if (current == CANDIDATE_COUNT) {
+    tuner_finish();
+    return;
+  }
+
+  phase = TUNER_MEASURING;
+  bitsSent = 0;
+  timeElapsed = RTCC_CounterGet();
+  bgapi_set_soft_timer(TUNER_PROBE_TIME, SOFT_TIMER_TUNER_HANDLE, 1);
+}
+
+/**
+ * @brief tuner_measured
+ * Records the goodput of the current candidate and moves on to the next one.
+ */
+static void tuner_measured(void) {
+  uint32_t elapsed = RTCC_CounterGet() - timeElapsed;
+
+  goodput[current] = stats_throughput(bitsSent, elapsed);
+  printLog("Tuner: PHY %d, interval %d, PDU %d, MTU %d: %lu bps\r\n",
+           phyInUse, interval, pduSize, mtuSize, goodput[current]);
+
+  if (goodput[current] > goodput[best]) {
+    best = current;
+  }
+
+  current++;
+  tuner_apply();
+}
+
+/**
+ * @brief tuner_arm
+ * Schedules a run once per connection, called while both characteristics are subscribed.
+ */
+void tuner_arm(void) {
+  if (TUNER_ENABLE && phase == TUNER_IDLE) {
+    phase = TUNER_ARMED;
+    bgapi_set_soft_timer(TUNER_START_DELAY, SOFT_TIMER_TUNER_HANDLE, 1);
+  }
+}
+
+/**
+ * @brief tuner_reset
+ * Forgets the results, e.g. once the connection is closed.
+ */
+void tuner_reset(void) {
+  phase = TUNER_IDLE;
+  current = 0;
+  best = 0;
+  memset(goodput, 0, sizeof(goodput));
+}
+
+/**
+ * @brief tuner_active
+ * @return true while the tuner owns the notification stream
+ */
+bool tuner_active(void) {
+  return phase == TUNER_SETTLING || phase == TUNER_MEASURING;
+}
+
+/**
+ * @brief tuner_handle_events
+ * Follows the PHY and connection parameter changes and the tuner soft timer.
+ * @param evt - event struct from main loop passed in
+ */
+void tuner_handle_events(struct gecko_cmd_packet *evt) {
+  switch (BGLIB_MSG_ID(evt->header)) {
+    case gecko_evt_le_connection_phy_status_id:
+      // The NOTIFY state of the slave loop does not follow PHY changes
+      if (tuner_active()) {
+        update_displayed_phy(evt->data.evt_le_connection_phy_status.phy);
+      }
+      if (phase == TUNER_SETTLING && phyPending) {
+        phyPending = false;
+        tuner_request_interval();
+      }
+      break;
+
+    case gecko_evt_le_connection_parameters_id:
+      if (phase == TUNER_SETTLING && !phyPending
+          && evt->data.evt_le_connection_parameters.interval == tuner_target()->interval) {
+        tuner_settled();
+      }
+      break;
+
+    case gecko_evt_hardware_soft_timer_id:
+      if (evt->data.evt_hardware_soft_timer.handle != SOFT_TIMER_TUNER_HANDLE) {
+        break;
+      }
+
+      if (phase == TUNER_ARMED) {
+        if (state == SUBSCRIBED) {
+          state = NOTIFY;
+          generate_notifications_data();
+          start_data_transmission();
+          tuner_apply();
+        } else {
+          phase = TUNER_IDLE;
+        }
+      } else if (tuner_active() && state != NOTIFY) {
+        // The stream was stopped under the tuner
+        phase = TUNER_DONE;
+      } else if (phase == TUNER_SETTLING) {
+        tuner_settled();
+      } else if (phase == TUNER_MEASURING) {
+        tuner_measured();
+      }
+      break;
+
+    default:
+      break;
+  }
+}
@@ -0,0 +1,48 @@
+/**
+ * @file
+ * @brief app_tuner.h
+ * Connection parameter and PHY auto-tuning for the throughput slave.
+ *
+ * Once a client subscribed to both throughput characteristics, the slave
+ * streams notifications over every candidate PHY and connection interval,
+ * measures the goodput of each with the bitsSent/RTCC accounting of the
+ * normal test, then settles on the fastest and reports its goodput through
+ * the throughput result characteristic.
+ *
+ * Off by default, the throughput test then runs as before. Build with
+ * TUNER_ENABLE defined to 1 to opt in.
+ *
+ * Data length and MTU are not probed: the stack negotiates the largest LL
+ * PDU by itself and the MTU exchange is up to the client, their outcome
+ * (pduSize, mtuSize) is logged with every result.
+ ******************************************************************************/
+
+#ifndef APP_TUNER_H
+#define APP_TUNER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "bg_types.h"
+#include "rtos_gecko.h"
+
+#ifndef TUNER_ENABLE
+#define TUNER_ENABLE              0
+#endif
+
+#define TUNER_START_DELAY         (HW_TICKS_PER_SECOND / 2)  // Lets the master finish subscribing before the run
+#define TUNER_SETTLE_TIME         (HW_TICKS_PER_SECOND)      // Longest wait for a PHY or interval change
+#define TUNER_PROBE_TIME          (HW_TICKS_PER_SECOND * 2)  // Measurement per candidate
+#define TUNER_SUPERVISION_TIMEOUT 100                        // 100 * 10ms = 1000ms
+
+void tuner_arm(void);
+void tuner_reset(void);
+bool tuner_active(void);
+void tuner_handle_events(struct gecko_cmd_packet *evt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
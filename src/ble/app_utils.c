@@ -4,6 +4,14 @@
  *******************************************************************************/
 
 #include <src/ble/app_utils.h>
+#include <kernel/include/os.h>
+#include "rtos_bluetooth.h"
+#include <src/ble/app_bridge.h>
+#include <src/ble/app_tuner.h>
+#include <src/ble/app_conn.h>
+#include <src/ble/app_stats.h>
+#include <src/ble/app_scan.h>
+#include <src/arbiter/radio_arbiter.h>
 
 /**************************************************************************//**
  * Common variable definitions
@@ -27,12 +35,16 @@ uint16_t mtuSize = 0;                            // Variable to hold the MTU siz
 uint16_t pduSize = 0;                            // Variable to hold PDU size once a new connection is formed
 uint16_t interval = 0;                           // Variable to hold connection interval
 
-uint8_t notificationsData[DATA_SIZE] = {0};
-uint8_t indicationsData[DATA_SIZE] = {0};
+uint8_t notificationsData[NOTIFY_PAYLOAD_BUFFERS][DATA_SIZE] = {{0}};
+static uint8_t notificationsIndex = 0;                   // Next payload sent by pump_notifications
+static uint8_t pumpFirst = 0;                            // Connection slot served first by the next pump_notifications
+uint8_t indicationsData[INDICATE_PAYLOAD_BUFFERS][DATA_SIZE] = {{0}};
+static uint8_t indicationsIndex = 0;                    // Payload sent by the next send_indication()
 uint16_t maxDataSizeIndications = DATA_SIZE;
 uint16_t maxDataSizeNotifications = DATA_SIZE;   // Variable to calculate maximum data size for optimal throughput
 uint32_t throughput = 0;
 uint32_t bitsSent = 0;
+static uint32_t interleavedBitsSent = 0;         // Notifications sent while an indication waits for its confirmation
 uint32_t timeElapsed = 0;
 uint32_t operationCount = 0;
 
@@ -85,6 +97,7 @@ void reset_variables(void) {
   connection = 0xFF;
   throughput = 0;
   bitsSent = 0;
+  interleavedBitsSent = 0;
   mtuSize = 0;
   pduSize = 0;
   interval = 0;
@@ -92,11 +105,68 @@ void reset_variables(void) {
   maxDataSizeNotifications = 0;
   maxDataSizeIndications = 0;
   state = ADV_SCAN;
-  memset(notificationsData, 0, DATA_SIZE);
-  memset(indicationsData, 0, DATA_SIZE);
+  memset(notificationsData, 0, sizeof(notificationsData));
+  notificationsIndex = 0;
+  memset(indicationsData, 0, sizeof(indicationsData));
+  indicationsIndex = 0;
   notificationsSubscribed = false;
   indicationsSubscribed = false;
   advStopped = false;
+  conn_reset();
+}
+
+/**
+ * @brief subscription_state
+ * @return the idle state matching the subscriptions of all connected clients
+ */
+State_t subscription_state(void) {
+  if (notificationsSubscribed && indicationsSubscribed) {
+    return SUBSCRIBED;
+  } else if (notificationsSubscribed) {
+    return SUBSCRIBED_NOTIFICATIONS;
+  } else if (indicationsSubscribed) {
+    return SUBSCRIBED_INDICATIONS;
+  }
+  return CONNECTED;
+}
+
+/**
+ * @brief close_secondary_connection
+ * Forgets a closed connection while other centrals stay connected. If it was the primary
+ * connection, the next one in the table takes over its role.
+ * @param closed - handle of the closed connection
+ */
+static void close_secondary_connection(uint8_t closed) {
+  conn_t *c = NULL;
+
+  if (closed == connection) {
+    for (int i = 0; c == NULL && i < MAX_CONNECTIONS; i++) {
+      c = conn_at(i);
+    }
+    connection = c->handle;
+    mtuSize = c->mtuSize;
+    pduSize = c->pduSize;
+    interval = c->interval;
+    calculate_indication_size();
+    calculate_notification_size();
+    sprintf(mtuSizeString + 5, "%03u", mtuSize);
+    sprintf(pduSizeString + 5, "%03u", pduSize);
+    sprintf(connIntervalString + 7, "%04u", (unsigned int) (interval * 5 / 4));
+    sprintf(maxDataSizeString + 11, "%03u", maxDataSizeNotifications);
+
+    // The confirmation of an indication to the closed connection never arrives
+    if (state == INDICATE) {
+      end_data_transmission();
+      state = CONNECTED;
+    }
+  }
+
+  conn_update_subscriptions();
+  if (state != NOTIFY && state != INDICATE) {
+    state = subscription_state();
+  }
+
+  setup_adv_scan();
 }
 
 /**
@@ -166,7 +236,8 @@ void setup_adv_scan(void) {
 
 	  advStopped = false;
   } else {
-
+      // Devices skipped in an earlier scan get parsed again
+      scan_reset();
       gecko_cmd_le_gap_set_discovery_type(5, 0);
       gecko_cmd_le_gap_set_discovery_timing(5, 16, 16);
       gecko_cmd_le_gap_start_discovery(le_gap_phy_1m, le_gap_discover_observation);
@@ -225,7 +296,8 @@ void handle_button_change(uint8_t pin) {
  * Routine to refresh the info on the display based on the Bluetooth connection status
  */
 void refresh_display(void) {
-  GRAPHICS_Clear();
+  // Only the characters that changed since the last refresh are drawn and sent
+  GRAPHICS_Home();
 
   GRAPHICS_AppendString(roleString);
   sprintf(txPowerString + 4, ((txPowerResp / 10) == 0) ? "%01d dBm" : "%+0d dBm", txPowerResp / 10); // 0 dBm without sign
@@ -255,28 +327,41 @@ void refresh_display(void) {
 }
 
 /**
- * @brief calculate_notification_size
- * Calculate optimal notification size given current PDU and MTU sizes. 
+ * @brief notification_size
+ * Calculate optimal notification size for the given PDU and MTU sizes.
+ * @return payload size, 0 while the PDU or MTU size is unknown
  */
-void calculate_notification_size(void) {
-  if (DATA_TRANSFER_SIZE_NOTIFICATIONS == 0 || DATA_TRANSFER_SIZE_NOTIFICATIONS > (mtuSize - NOTIFICATION_GATT_HEADER)) {
-    if ((pduSize != 0) && (mtuSize != 0)) {
+uint16_t notification_size(uint16_t pdu, uint16_t mtu) {
+  if (DATA_TRANSFER_SIZE_NOTIFICATIONS == 0 || DATA_TRANSFER_SIZE_NOTIFICATIONS > (mtu - NOTIFICATION_GATT_HEADER)) {
+    if ((pdu != 0) && (mtu != 0)) {
       // Optimally split over multiple over-the-air packets.
-      if (pduSize <= mtuSize) {
-        maxDataSizeNotifications = (pduSize - (L2CAP_HEADER + NOTIFICATION_GATT_HEADER))
-                                    + ((mtuSize - NOTIFICATION_GATT_HEADER - pduSize + (L2CAP_HEADER + NOTIFICATION_GATT_HEADER)) / pduSize * pduSize);
+      if (pdu <= mtu) {
+        return (pdu - (L2CAP_HEADER + NOTIFICATION_GATT_HEADER))
+               + ((mtu - NOTIFICATION_GATT_HEADER - pdu + (L2CAP_HEADER + NOTIFICATION_GATT_HEADER)) / pdu * pdu);
       } else {
         // Single over-the-air packet, but accommodate room for headers.
-        if ((pduSize - mtuSize) <= L2CAP_HEADER) {
-          maxDataSizeNotifications = pduSize - (L2CAP_HEADER + NOTIFICATION_GATT_HEADER); // LL PDU size - (L2CAP+GATT Headers)
+        if ((pdu - mtu) <= L2CAP_HEADER) {
+          return pdu - (L2CAP_HEADER + NOTIFICATION_GATT_HEADER); // LL PDU size - (L2CAP+GATT Headers)
         } else {
           // Room for the whole MTU, so data payload is MTU - Header of operation.
-          maxDataSizeNotifications = mtuSize - NOTIFICATION_GATT_HEADER; // MTU - GATT Header
+          return mtu - NOTIFICATION_GATT_HEADER; // MTU - GATT Header
         }
       }
     }
-  } else {
-    maxDataSizeNotifications = DATA_TRANSFER_SIZE_NOTIFICATIONS;
+    return 0;
+  }
+  return DATA_TRANSFER_SIZE_NOTIFICATIONS;
+}
+
+/**
+ * @brief calculate_notification_size
+ * Calculate optimal notification size given current PDU and MTU sizes of the primary connection.
+ */
+void calculate_notification_size(void) {
+  uint16_t size = notification_size(pduSize, mtuSize);
+
+  if (size != 0) {
+    maxDataSizeNotifications = size;
   }
 }
 
@@ -295,28 +380,129 @@ void calculate_indication_size(void) {
 
 /**
  * @brief generate_notifications_data
- * Function to generate circular data (0-255) in the data payload
+ * Function to generate circular data (0-255) in the notification payloads.
+ * Called once per transmission, pump_notifications() rotates through the payloads.
+ * The payloads are filled completely as every connection sends its own size.
  */
 void generate_notifications_data(void) {
+  uint8_t next = 0;
+
+  for (int buf = 0; buf < NOTIFY_PAYLOAD_BUFFERS; buf++) {
+    for (int i = 0; i < DATA_SIZE; i++) {
+      notificationsData[buf][i] = next++;
+    }
+  }
+  notificationsIndex = 0;
+}
 
-  notificationsData[0] = notificationsData[maxDataSizeNotifications - 1] + 1;
+/**
+ * @brief pump_notifications
+ * Sends notifications to all subscribed connections until the stack runs out of TX buffers,
+ * so the link layer always has data queued for the next connection event of every connection.
+ * Deficit round robin: each round credits every connection CONN_QUANTUM bytes, which it spends
+ * in payloads of its own size, so all connections get the same share of bytes whatever their
+ * MTU. The first connection served rotates from call to call.
+ * @return bg_err_out_of_memory once the TX buffers are full, bg_err_wrong_state if no
+ * connection is subscribed
+ */
+uint16_t pump_notifications(void) {
+  uint16_t result = bg_err_wrong_state;
+  uint8_t stalled = 0;
+  bool progress;
+
+  do {
+    progress = false;
+
+    for (int n = 0; n < MAX_CONNECTIONS; n++) {
+      uint8_t slot = (pumpFirst + n) % MAX_CONNECTIONS;
+      conn_t *c = conn_at(slot);
+
+      if (c == NULL || !c->notificationsSubscribed || c->payloadSize == 0 || (stalled & (1 << slot))) {
+        continue;
+      }
 
-  for (int i = 1; i < maxDataSizeNotifications; i++) {
-    notificationsData[i] = notificationsData[i - 1] + 1;
+      c->deficit += CONN_QUANTUM;
+      while (c->deficit >= c->payloadSize) {
+#ifdef SEND_FIXED_TRANSFER_COUNT
+        if (bitsSent >= (SEND_FIXED_TRANSFER_COUNT * 8)) {
+          return bg_err_success;
+        }
+#endif
+        if (gecko_cmd_gatt_server_send_characteristic_notification(c->handle,
+                                                                   gattdb_throughput_notifications,
+                                                                   c->payloadSize,
+                                                                   notificationsData[notificationsIndex])->result != bg_err_success) {
+          // Keep at most one round of credit so the connection does not burst once it drained
+          if (c->deficit > CONN_QUANTUM) {
+            c->deficit = CONN_QUANTUM;
+          }
+          c->stalls++;
+          stalled |= (1 << slot);
+          result = bg_err_out_of_memory;
+          break;
+        }
+
+        c->deficit -= c->payloadSize;
+        c->bitsSent += (c->payloadSize * 8);
+        c->operationCount++;
+        // Notifications interleaved with the indication test are not acknowledged, keep them out of its throughput
+        if (state == INDICATE) {
+          interleavedBitsSent += (c->payloadSize * 8);
+        } else {
+          bitsSent += (c->payloadSize * 8);
+        }
+        operationCount++;
+        notificationsIndex = (notificationsIndex + 1) % NOTIFY_PAYLOAD_BUFFERS;
+        progress = true;
+      }
+    }
+  } while (progress);
+
+  pumpFirst = (pumpFirst + 1) % MAX_CONNECTIONS;
+  return result;
+}
+
+/**
+ * @brief fill_indication
+ * Generates circular data (0-255) in an indication payload, continuing the sequence of the other payload.
+ */
+static void fill_indication(uint8_t buf) {
+  const uint8_t *prev = indicationsData[buf ^ 1];
+
+  if (maxDataSizeIndications == 0) {
+    return;
+  }
+
+  indicationsData[buf][0] = prev[maxDataSizeIndications - 1] + 1;
+  for (int i = 1; i < maxDataSizeIndications; i++) {
+    indicationsData[buf][i] = indicationsData[buf][i - 1] + 1;
   }
 }
 
 /**
  * @brief generate_indications_data
- * Function to generate circular data (0-255) in the data payload
+ * Function to generate circular data (0-255) in the first indication payload of a transmission.
  */
 void generate_indications_data(void) {
+  fill_indication(indicationsIndex);
+#if INDICATE_INTERLEAVE_NOTIFICATIONS
+  // The notifications sent while a confirmation is pending use their own payloads
+  generate_notifications_data();
+#endif
+}
 
-  indicationsData[0] = indicationsData[maxDataSizeIndications - 1] + 1;
+/**
+ * @brief send_indication
+ * Sends the prepared indication and generates the next payload while the confirmation is pending,
+ * so the next indication goes out as soon as the confirmation arrives. The payload just sent is left
+ * alone until then, a command deferred by the bgapi queue still refers to it.
+ */
+void send_indication(void) {
+  bgapi_send_notification(connection, gattdb_throughput_indications, maxDataSizeIndications, indicationsData[indicationsIndex]);
+  waitingForConfirmation = 1;
 
-  for (int i = 1; i < maxDataSizeIndications; i++) {
-    indicationsData[i] = indicationsData[i - 1] + 1;
-  }
+  indicationsIndex ^= 1;
+  fill_indication(indicationsIndex);
 }
 
 /**
@@ -326,13 +512,17 @@ void generate_indications_data(void) {
 void start_data_transmission(void) {
   // Slave tells master to turn off display refresh, resets counters and starts timing a new measurement.
   bitsSent = 0;
+  interleavedBitsSent = 0;
   throughput = 0;
   timeElapsed = RTCC_CounterGet();
+  conn_reset_counters();
+  stats_start(bitsSent);
+  arbiter_ble_bulk(true);
 
   // Turn OFF Display refresh on master side
-  while(gecko_cmd_gatt_write_characteristic_value_without_response(connection, gattdb_transmission_on, 1, &TRANSMISSION_ON)->result != 0);
+  bgapi_write_without_response(connection, gattdb_transmission_on, 1, &TRANSMISSION_ON);
   // Stop display refresh
-  while(gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0)->result != 0);
+  bgapi_set_soft_timer(0, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0);
 }
 
 /**
@@ -341,15 +531,39 @@ void start_data_transmission(void) {
  * enable display refresh in master side.
  */
 void end_data_transmission(void) {
+  stop_measurement();
+  finish_data_transmission();
+}
+
+/**
+ * @brief stop_measurement
+ * Stops timing the transmission, calculates the throughput and logs its statistics.
+ */
+void stop_measurement(void) {
   timeElapsed = RTCC_CounterGet() - timeElapsed;
-  // Turn ON Display on master side - stack is probably still busy pushing the last few notifications out so we need to check output
-  while(gecko_cmd_gatt_write_characteristic_value_without_response(connection, gattdb_transmission_on, 1, &TRANSMISSION_OFF)->result != 0);
-  // Resume display refresh - stack is probably still busy pushing the last few notifications out so we need to check output
-  while(gecko_cmd_hardware_set_soft_timer(HW_TICKS_PER_SECOND, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0)->result != 0);
-  // Calculate throughput
-  throughput = (uint32_t) ((float) bitsSent / (float) ((float) timeElapsed / (float) HW_TICKS_PER_SECOND ));
+  throughput = stats_throughput(bitsSent, timeElapsed);
+  stats_stop(bitsSent);
+  conn_print_stats(timeElapsed);
+  stats_print();
+  if (interleavedBitsSent != 0) {
+    printLog("Interleaved notifications: %lu bytes, %lu bps, not included above\r\n",
+             (unsigned long)(interleavedBitsSent / 8),
+             (unsigned long)stats_throughput(interleavedBitsSent, timeElapsed));
+  }
+}
+
+/**
+ * @brief finish_data_transmission
+ * Enables display refresh in master side again and reports the throughput value.
+ */
+void finish_data_transmission(void) {
+  arbiter_ble_bulk(false);
+  // Turn ON Display on master side - stack is probably still busy pushing the last few notifications out so the write may be deferred
+  bgapi_write_without_response(connection, gattdb_transmission_on, 1, &TRANSMISSION_OFF);
+  // Resume display refresh - stack is probably still busy pushing the last few notifications out so the timer may be deferred
+  bgapi_set_soft_timer(HW_TICKS_PER_SECOND, SOFT_TIMER_DISPLAY_REFRESH_HANDLE, 0);
   // Write result to local GATT to be looked up on e.g. smart phone.
-  while(gecko_cmd_gatt_server_write_attribute_value(gattdb_throughput_result, 0, sizeof(throughput), (uint8_t *) (&throughput))->result != 0);
+  bgapi_write_attribute_value(gattdb_throughput_result, sizeof(throughput), (uint8_t *) (&throughput));
   // Send result to subscribed NCP host or SoC master. Check for wrong state error, which means the client isn't subscribed to indications on the result.
   if (gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_result, sizeof(throughput), (uint8_t *) (&throughput))->result != bg_err_wrong_state) {
     gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_result, sizeof(throughput), (uint8_t *) (&throughput));
@@ -357,6 +571,52 @@ void end_data_transmission(void) {
 
 }
 
+/**
+ * @brief wait_bluetooth_event
+ * Blocks on the Bluetooth event flags until the Bluetooth task hands over an event.
+ * The Bluetooth task runs at a higher priority and fetches the next event as soon as
+ * the previous one is released, so a burst of events is drained without sleeping.
+ * @param ticks - OS ticks to wait, 0 to poll, BLE_WAIT_FOREVER to block
+ * @return the event or NULL on timeout, to be passed to release_bluetooth_event()
+ */
+struct gecko_cmd_packet *wait_bluetooth_event(int32_t ticks) {
+  RTOS_ERR err;
+  OS_OPT opt = OS_OPT_PEND_FLAG_SET_ANY + OS_OPT_PEND_FLAG_CONSUME;
+
+  if (ticks == 0) {
+    opt += OS_OPT_PEND_NON_BLOCKING;
+  } else {
+    opt += OS_OPT_PEND_BLOCKING;
+  }
+
+  OSFlagPend(&bluetooth_event_flags,
+             (OS_FLAGS)BLUETOOTH_EVENT_FLAG_EVT_WAITING,
+             (ticks > 0) ? (OS_TICK)ticks : 0,
+             opt,
+             NULL,
+             &err);
+  if (RTOS_ERR_CODE_GET(err) != RTOS_ERR_NONE) {
+    return NULL;
+  }
+
+  return (struct gecko_cmd_packet *)bluetooth_evt;
+}
+
+/**
+ * @brief release_bluetooth_event
+ * Hands the event buffer back to the Bluetooth task so it can fetch the next event.
+ * @param evt - event returned by wait_bluetooth_event(), may be NULL
+ */
+void release_bluetooth_event(struct gecko_cmd_packet *evt) {
+  RTOS_ERR err;
+
+  if (evt == NULL) {
+    return;
+  }
+
+  OSFlagPost(&bluetooth_event_flags, (OS_FLAGS)BLUETOOTH_EVENT_FLAG_EVT_HANDLED, OS_OPT_POST_FLAG_SET, &err);
+}
+
 /**
  * @brief handle_universal_events
  * This handles events that are 'universal' in the sense that 
@@ -364,6 +624,14 @@ void end_data_transmission(void) {
  * @param evt - The same stack event processed by main event loop
  */
 void handle_universal_events(struct gecko_cmd_packet *evt) {
+  if (evt == NULL) {
+    return;
+  }
+
+  app_bridge_handle_events(evt);
+  tuner_handle_events(evt);
+  stats_handle_events(evt);
+
   // Handle universal events
   switch (BGLIB_MSG_ID(evt->header)) {
     case gecko_evt_system_external_signal_id:
@@ -413,7 +681,7 @@ void handle_universal_events(struct gecko_cmd_packet *evt) {
             gecko_cmd_hardware_set_soft_timer(SEND_FIXED_TRANSFER_TIME, SOFT_TIMER_FIXED_TRANSFER_TIME_HANDLE, 1);
             fixedTimeExpired = false;
 #endif
-            while(gecko_cmd_gatt_server_send_characteristic_notification(connection, gattdb_throughput_indications, maxDataSizeIndications, indicationsData)->result != 0);
+            send_indication();
           }
 
           break;
@@ -454,6 +722,7 @@ void handle_universal_events(struct gecko_cmd_packet *evt) {
         case SCAN_PHY_CHANGE:
 					if (state == ADV_SCAN) {
 						gecko_cmd_le_gap_end_procedure();
+						scan_reset();
 						switch (phyInUse) {
 							case PHY_1M:
 #if defined(_SILICON_LABS_32B_SERIES_1_CONFIG_3) || defined(_SILICON_LABS_32B_SERIES_2_CONFIG_1)
@@ -512,17 +781,30 @@ void handle_universal_events(struct gecko_cmd_packet *evt) {
       }
       break;
 
+    case gecko_evt_le_connection_opened_id:
+      // Keep advertising for further centrals, the stack stops the set on every connection
+      if (roleIsSlave && conn_count() < MAX_CONNECTIONS) {
+        setup_adv_scan();
+      }
+      break;
+
     case gecko_evt_le_connection_parameters_id:
+      if (evt->data.evt_le_connection_parameters.connection != connection) {
+        break;
+      }
       pduSize = evt->data.evt_le_connection_parameters.txsize;
       interval = evt->data.evt_le_connection_parameters.interval;
       sprintf(pduSizeString + 5, "%03u", pduSize);
-      sprintf(connIntervalString + 7, "%04u", (unsigned int) ((float) interval * 1.25));
+      sprintf(connIntervalString + 7, "%04u", (unsigned int) (interval * 5 / 4));
       calculate_notification_size();
       sprintf(maxDataSizeString + 11, "%03u", maxDataSizeNotifications);
       statusString = (char *)statusConnectedString;
       break;
 
     case gecko_evt_gatt_mtu_exchanged_id:
+      if (evt->data.evt_gatt_mtu_exchanged.connection != connection) {
+        break;
+      }
       mtuSize = evt->data.evt_gatt_mtu_exchanged.mtu;
       sprintf(mtuSizeString + 5, "%03u", mtuSize);
       calculate_indication_size();
@@ -535,6 +817,15 @@ void handle_universal_events(struct gecko_cmd_packet *evt) {
       break;
 
     case gecko_evt_le_connection_closed_id:
+      if (conn_count() != 0) {
+        // Other centrals are still connected
+        close_secondary_connection(evt->data.evt_le_connection_closed.connection);
+        break;
+      }
+      // Commands still waiting for stack resources refer to the closed connection
+      bgapi_flush();
+      arbiter_ble_bulk(false);
+      tuner_reset();
       // Set key variables to defaults and state to ADV_SCAN.
       reset_variables(); 
       set_display_defaults();
@@ -23,10 +23,6 @@
 extern "C" {
 #endif
 
-#ifndef MAX_CONNECTIONS
-#define MAX_CONNECTIONS 4
-#endif
-
 #ifndef MAX_ADVERTISERS
 #define MAX_ADVERTISERS 4
 #endif
@@ -37,6 +33,8 @@ extern "C" {
 #include "em_rtcc.h"
 #include "graphics.h"
 #include "gpiointerrupt.h"
+#include "app_bgapi.h"
+#include "app_conn.h"
 #include <stdio.h>
 
 /* Device initialization header */
@@ -48,8 +46,11 @@ extern "C" {
 // Software timer handles
 #define SOFT_TIMER_DISPLAY_REFRESH_HANDLE       0
 #define SOFT_TIMER_FIXED_TRANSFER_TIME_HANDLE 	1
+#define SOFT_TIMER_TUNER_HANDLE                 2
 
 #define DATA_SIZE                           255		// Size of the arrays for sending and receiving data
+#define NOTIFY_PAYLOAD_BUFFERS              4       // Pre-generated notification payloads rotated by the notification pump
+#define INDICATE_PAYLOAD_BUFFERS            2       // The next indication is generated while the previous one waits for its confirmation
 #define DATA_TRANSFER_SIZE_INDICATIONS      0       // If == 0 or > MTU-3 then it will send MTU-3 bytes of data, otherwise it will use this value
 #define DATA_TRANSFER_SIZE_NOTIFICATIONS    0       // If == 0 or > MTU-3 then it will calculate the data amount to send for maximum over-the-air packet usage, otherwise it will use this value
 #define INDICATION_GATT_HEADER              3       // GATT operation header byte count
@@ -72,11 +73,23 @@ extern "C" {
 #define INDICATIONS_END     (uint32)(1 << 3)   // Bit flag to external signal command
 #define PHY_CHANGE          (uint32)(1 << 4)   // Bit flag to external signal command
 #define SCAN_PHY_CHANGE     (uint32)(1 << 5)   // Bit flag for scan PHY change 1M<->LE Coded
+#define BRIDGE_FLOW_CHANGED (uint32)(1 << 6)   // Bit flag for a LoRa bridge flow control change
+#define BRIDGE_DROPPED      (uint32)(1 << 7)   // Bit flag for records dropped by the LoRa bridge
+
+#define BLE_WAIT_FOREVER    (-1)               // wait_bluetooth_event() timeout to block until an event arrives
 
 /* COMPILE TIME OPTIONS FOR FIXED MODES BETWEEN TWO KITS. UNCOMMENT ONLY ONE. */
 //#define SEND_FIXED_TRANSFER_COUNT				10000 						          // Uncomment this if you want to send a fixed amount of indications/notifications on each button press
 #define SEND_FIXED_TRANSFER_TIME				((HW_TICKS_PER_SECOND)*5)     // Uncomment this if you want to send indications/notifications for a fixed amount of time
 
+/* Only one indication may be outstanding per connection. With this option the slave keeps the link busy
+ * with notifications to the subscribed clients while it waits for the confirmation. Their bytes are logged
+ * separately and not counted in the indication throughput. Indications keep their confirmation semantics.
+ * Off by default, so the indication test measures indications only. */
+#ifndef INDICATE_INTERLEAVE_NOTIFICATIONS
+#define INDICATE_INTERLEAVE_NOTIFICATIONS   0
+#endif
+
 // Main state enum
 typedef enum {
     ADV_SCAN,
@@ -99,8 +112,8 @@ extern uint16_t mtuSize ;                           // Variable to hold the MTU
 extern uint16_t pduSize;                            // Variable to hold PDU size once a new connection is formed
 extern uint16_t interval;                           // Variable to hold connection interval
 
-extern uint8_t notificationsData[DATA_SIZE];
-extern uint8_t indicationsData[DATA_SIZE];
+extern uint8_t notificationsData[NOTIFY_PAYLOAD_BUFFERS][DATA_SIZE];
+extern uint8_t indicationsData[INDICATE_PAYLOAD_BUFFERS][DATA_SIZE];
 extern uint16_t maxDataSizeIndications;
 extern uint16_t maxDataSizeNotifications;           // Variable to calculate maximum data size for optimal throughput
 extern uint32_t throughput;
@@ -157,19 +170,27 @@ const char ROLE_SCANNER_STRING[15];
  * Common function declarations
  *****************************************************************************/
 void reset_variables(void);
+State_t subscription_state(void);
 void setup_adv_scan(void);
 void handle_button_change(uint8_t pin);
 void refresh_display(void);
 void set_display_defaults(void);
 void update_displayed_phy(uint8_t currentPhy);
 
+uint16_t notification_size(uint16_t pdu, uint16_t mtu);
 void calculate_notification_size(void);
 void calculate_indication_size(void);
 void generate_notifications_data(void);
 void generate_indications_data(void);
+void send_indication(void);
+uint16_t pump_notifications(void);
 void start_data_transmission(void);
 void end_data_transmission(void);
+void stop_measurement(void);
+void finish_data_transmission(void);
 
+struct gecko_cmd_packet *wait_bluetooth_event(int32_t ticks);
+void release_bluetooth_event(struct gecko_cmd_packet *evt);
 void handle_universal_events(struct gecko_cmd_packet *evt);
 void slave_main(void);
 void master_main(void);
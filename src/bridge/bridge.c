@@ -0,0 +1,285 @@
+/**
+ * @file
+ * @brief bridge.c
+ * Lock free record ring between the BLE ingest and the LoRaWAN uplink.
+ *******************************************************************************
+ *
+ * head is only written by the producer and tail only by the consumer. A
+ * record is published by the barrier before head moves past it and released
+ * by the barrier before tail moves past it. Records are stored as
+ *
+ *   length (1) | ingest time in RTCC ticks (4) | data
+ *
+ ******************************************************************************/
+
+#include <string.h>
+#include "em_device.h"
+#include "em_core.h"
+#include "rtcdriver.h"
+#include <src/bridge/bridge.h>
+
+#define RECORD_HEADER_SIZE    5
+#define RING_MASK             (BRIDGE_RING_SIZE - 1)
+
+#define UPLINK_DELTA          0x80
+
+static uint8_t ring[BRIDGE_RING_SIZE];
+static volatile uint32_t head;
+static volatile uint32_t tail;
+static volatile bool paused;
+
+static bridge_fn dataFn;
+static bridge_fn flowFn;
+static bridge_drop_fn dropFn;
+
+// Producer statistics
+static uint32_t records;
+static uint32_t bytesIn;
+static uint32_t droppedLength;
+static uint32_t droppedFull;
+
+// Consumer state and statistics
+static uint32_t uplinkEnd;
+static uint32_t uplinkStamp;
+static uint8_t uplinkBytes;
+static uint32_t uplinks;
+static uint32_t bytesOut;
+static uint32_t droppedUplink;
+static uint32_t latencyLastMs;
+static uint32_t latencyMaxMs;
+
+static void ring_write(uint32_t pos, const uint8_t *data, uint32_t len)
+{
+  for (uint32_t i = 0; i < len; i++) {
+    ring[(pos + i) & RING_MASK] = data[i];
+  }
+}
+
+static void ring_read(uint32_t pos, uint8_t *data, uint32_t len)
+{
+  for (uint32_t i = 0; i < len; i++) {
+    data[i] = ring[(pos + i) & RING_MASK];
+  }
+}
+
+static void record_dropped(bridge_drop_t reason)
+{
+  if (dropFn != NULL) {
+    dropFn(reason);
+  }
+}
+
+static void flow_set(bool pause)
+{
+  bool changed = false;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (paused != pause) {
+    paused = pause;
+    changed = true;
+  }
+  CORE_EXIT_ATOMIC();
+
+  if (changed && flowFn != NULL) {
+    flowFn();
+  }
+}
+
+/* Consumer: frees the ring up to pos */
+static void ring_release(uint32_t pos)
+{
+  __DMB();
+  tail = pos;
+
+  if (paused && (head - pos) <= BRIDGE_FLOW_LOW) {
+    flow_set(false);
+  }
+}
+
+/* XORs rec with prev and codes the zero runs, returns the coded length or 0
+ * if it is not shorter than the raw record */
+static uint8_t delta_encode(const uint8_t *rec, const uint8_t *prev, uint8_t len, uint8_t *out)
+{
+  uint8_t n = 0;
+  uint8_t i = 0;
+
+  while (i < len) {
+    uint8_t d = rec[i] ^ prev[i];
+
+    if (d != 0) {
+      out[n++] = d;
+      i++;
+    } else {
+      uint8_t run = 0;
+      while (i < len && rec[i] == prev[i]) {
+        run++;
+        i++;
+      }
+      out[n++] = 0x00;
+      out[n++] = run;
+    }
+
+    if (n >= len) {
+      return 0;
+    }
+  }
+
+  return n;
+}
+
+void bridge_on_flow(bridge_fn fn)
+{
+  flowFn = fn;
+}
+
+void bridge_on_data(bridge_fn fn)
+{
+  dataFn = fn;
+}
+
+void bridge_on_drop(bridge_drop_fn fn)
+{
+  dropFn = fn;
+}
+
+bool bridge_ingest(const uint8_t *data, uint8_t len)
+{
+  uint32_t h = head;
+  uint32_t used = h - tail;
+  uint32_t need = RECORD_HEADER_SIZE + len;
+  uint32_t stamp;
+
+  if (len == 0 || len > BRIDGE_MAX_RECORD) {
+    droppedLength++;
+    record_dropped(BRIDGE_DROP_LENGTH);
+    return false;
+  }
+  if (BRIDGE_RING_SIZE - used < need) {
+    droppedFull++;
+    record_dropped(BRIDGE_DROP_FULL);
+    return false;
+  }
+
+  stamp = RTCDRV_GetWallClockTicks32();
+  ring_write(h, &len, 1);
+  ring_write(h + 1, (const uint8_t *)&stamp, sizeof(stamp));
+  ring_write(h + RECORD_HEADER_SIZE, data, len);
+  __DMB();
+  head = h + need;
+
+  records++;
+  bytesIn += len;
+
+  if (used == 0 && dataFn != NULL) {
+    dataFn();
+  }
+  if (used + need >= BRIDGE_FLOW_HIGH) {
+    flow_set(true);
+  }
+
+  return true;
+}
+
+bool bridge_paused(void)
+{
+  return paused;
+}
+
+bool bridge_empty(void)
+{
+  return head == tail;
+}
+
+uint8_t bridge_uplink_build(uint8_t *buf, uint8_t max)
+{
+  uint8_t rec[BRIDGE_MAX_RECORD];
+  uint8_t prev[BRIDGE_MAX_RECORD];
+  uint8_t coded[BRIDGE_MAX_RECORD + 1];   // a zero run may overshoot by one before giving up
+  uint8_t prevLen = 0;
+  uint8_t out = 0;
+  uint32_t h = head;
+  uint32_t pos = tail;
+
+  __DMB();
+
+  while (pos != h) {
+    uint8_t len;
+    uint8_t codedLen = 0;
+    uint32_t stamp;
+
+    ring_read(pos, &len, 1);
+    ring_read(pos + 1, (uint8_t *)&stamp, sizeof(stamp));
+    ring_read(pos + RECORD_HEADER_SIZE, rec, len);
+
+    if (len == prevLen) {
+      codedLen = delta_encode(rec, prev, len, coded);
+    }
+
+    if (codedLen != 0 && out + 1 + codedLen <= max) {
+      buf[out] = UPLINK_DELTA | len;
+      memcpy(&buf[out + 1], coded, codedLen);
+      out += 1 + codedLen;
+    } else if (out + 1 + len <= max) {
+      buf[out] = len;
+      memcpy(&buf[out + 1], rec, len);
+      out += 1 + len;
+    } else if (out == 0) {
+      // Does not fit even an empty uplink on the current datarate
+      pos += RECORD_HEADER_SIZE + len;
+      ring_release(pos);
+      droppedUplink++;
+      record_dropped(BRIDGE_DROP_UPLINK);
+      continue;
+    } else {
+      break;
+    }
+
+    if (prevLen == 0) {
+      uplinkStamp = stamp;
+    }
+    memcpy(prev, rec, len);
+    prevLen = len;
+    pos += RECORD_HEADER_SIZE + len;
+  }
+
+  uplinkEnd = pos;
+  uplinkBytes = out;
+  return out;
+}
+
+void bridge_uplink_done(bool sent)
+{
+  uint32_t latency;
+
+  if (!sent || uplinkBytes == 0) {
+    return;
+  }
+
+  latency = RTCDRV_TicksToMsec(RTCDRV_GetWallClockTicks32() - uplinkStamp);
+  latencyLastMs = latency;
+  if (latency > latencyMaxMs) {
+    latencyMaxMs = latency;
+  }
+  uplinks++;
+  bytesOut += uplinkBytes;
+  uplinkBytes = 0;
+
+  ring_release(uplinkEnd);
+}
+
+void bridge_stats_get(bridge_stats_t *stats)
+{
+  stats->occupancy = (uint16_t)(head - tail);
+  stats->capacity = BRIDGE_RING_SIZE;
+  stats->records = records;
+  stats->droppedLength = droppedLength;
+  stats->droppedFull = droppedFull;
+  stats->droppedUplink = droppedUplink;
+  stats->dropped = droppedLength + droppedFull + droppedUplink;
+  stats->uplinks = uplinks;
+  stats->bytesIn = bytesIn;
+  stats->bytesOut = bytesOut;
+  stats->latencyLastMs = latencyLastMs;
+  stats->latencyMaxMs = latencyMaxMs;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file
+ * @brief bridge.h
+ * Relays sensor records written over BLE to the LoRaWAN uplink.
+ *******************************************************************************
+ *
+ * The BLE task is the only producer and the LoRa task the only consumer, so
+ * the records are kept in a single producer / single consumer ring that needs
+ * no lock. The consumer packs as many records as fit into the next uplink and
+ * releases them only once the uplink went out, a failed transmission sends
+ * the same records again.
+ *
+ * Uplink payload, a sequence of records:
+ *
+ *   header  bit 7:    0 = raw, 1 = delta coded
+ *           bit 6..0: record length
+ *   raw     the record bytes
+ *   delta   the record XORed with the previous record of the uplink, which
+ *           has the same length, zero runs coded as 0x00 <count>
+ *
+ * Sensor records change little from one sample to the next, the delta coding
+ * is only used where it is shorter than the raw record.
+ *
+ ******************************************************************************/
+
+#ifndef BRIDGE_H
+#define BRIDGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Ring size in bytes, power of two */
+#ifndef BRIDGE_RING_SIZE
+#define BRIDGE_RING_SIZE            1024
+#endif
+
+/* Longest record accepted from a BLE client. With its header it fits the
+ * smallest EU868 payload (51 bytes at DR0 to DR2). Regions with a smaller
+ * payload at their lowest datarates, e.g. 11 bytes at US915 and AU915 DR0,
+ * cannot send longer records at those datarates: such a record is dropped
+ * when it is the first of an uplink and reported as BRIDGE_DROP_UPLINK. */
+#ifndef BRIDGE_MAX_RECORD
+#define BRIDGE_MAX_RECORD           48
+#endif
+
+/* Occupancy in bytes above which the clients are asked to pause and below
+ * which they are asked to resume */
+#ifndef BRIDGE_FLOW_HIGH
+#define BRIDGE_FLOW_HIGH            (BRIDGE_RING_SIZE * 3 / 4)
+#endif
+#ifndef BRIDGE_FLOW_LOW
+#define BRIDGE_FLOW_LOW             (BRIDGE_RING_SIZE / 4)
+#endif
+
+/* Called when records become available in an empty ring (producer context)
+ * or the flow state changed (either context). Must not block. */
+typedef void (*bridge_fn)(void);
+
+typedef enum {
+  BRIDGE_DROP_LENGTH,        // empty or longer than BRIDGE_MAX_RECORD (producer context)
+  BRIDGE_DROP_FULL,          // no room in the ring (producer context)
+  BRIDGE_DROP_UPLINK         // longer than the payload of the current datarate (consumer context)
+} bridge_drop_t;
+
+/* Called for every record dropped, from the context noted above. Must not block. */
+typedef void (*bridge_drop_fn)(bridge_drop_t reason);
+
+typedef struct {
+  uint16_t occupancy;        // bytes in the ring, including record headers
+  uint16_t capacity;         // BRIDGE_RING_SIZE
+  uint32_t records;          // records accepted
+  uint32_t dropped;          // records dropped, the sum of the three below
+  uint32_t droppedLength;    // BRIDGE_DROP_LENGTH
+  uint32_t droppedFull;      // BRIDGE_DROP_FULL
+  uint32_t droppedUplink;    // BRIDGE_DROP_UPLINK
+  uint32_t uplinks;          // uplinks sent
+  uint32_t bytesIn;          // record bytes accepted
+  uint32_t bytesOut;         // payload bytes sent
+  uint32_t latencyLastMs;    // ingest of the oldest record to TX done, last uplink
+  uint32_t latencyMaxMs;     // same, worst case
+} bridge_stats_t;
+
+/* Producer side */
+void bridge_on_flow(bridge_fn fn);
+void bridge_on_drop(bridge_drop_fn fn);
+bool bridge_ingest(const uint8_t *data, uint8_t len);
+bool bridge_paused(void);
+
+/* Consumer side */
+void bridge_on_data(bridge_fn fn);
+bool bridge_empty(void);
+uint8_t bridge_uplink_build(uint8_t *buf, uint8_t max);
+void bridge_uplink_done(bool sent);
+
+void bridge_stats_get(bridge_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
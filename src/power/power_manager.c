@@ -0,0 +1,174 @@
+/**
+ * @file
+ * @brief power_manager.c
+ * Energy mode arbitration from the Micrium OS idle hook.
+ *******************************************************************************
+ *
+ * The kernel runs with dynamic ticks on the RTCC, so every timed wait of a
+ * task (event queue, Bluetooth stack, OSTimeDly) is woken up by the RTCC and
+ * EM2 is safe as long as no client needs a high frequency peripheral.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+#include <kernel/include/os.h>
+#include "em_core.h"
+#include "rtcdriver.h"
+#include <src/power/power_manager.h>
+
+static struct {
+  power_req_fn fn;
+  void *ctx;
+} clients[POWER_CLIENT_COUNT];
+
+// Accounting in RTCC wall clock ticks
+static uint64_t statsSince;
+static uint64_t sleepStart;
+static uint64_t sleepTicks[POWER_EM_COUNT];
+static uint32_t sleepEntries[POWER_EM_COUNT];
+static uint32_t limitedBy[POWER_CLIENT_COUNT];
+
+static bool power_sleep_cb(SLEEP_EnergyMode_t emode)
+{
+  (void)emode;
+  sleepStart = RTCDRV_GetWallClockTicks64();
+  return true;
+}
+
+static void power_wakeup_cb(SLEEP_EnergyMode_t emode)
+{
+  if (emode >= POWER_EM_COUNT) {
+    return;
+  }
+
+  // The RTCC stops in EM3, only the entries are counted there
+  if (emode < sleepEM3) {
+    sleepTicks[emode] += RTCDRV_GetWallClockTicks64() - sleepStart;
+  }
+  sleepEntries[emode]++;
+}
+
+static void power_idle_hook(void)
+{
+  SLEEP_EnergyMode_t mode;
+  uint32_t deadline = POWER_NO_DEADLINE;
+  int limiter = POWER_CLIENT_COUNT;
+  int deadlineOwner = POWER_CLIENT_COUNT;
+  power_req_t req;
+  CORE_DECLARE_IRQ_STATE;
+
+  // Interrupts stay masked until after wakeup, so an event posted from an
+  // ISR while the requirements are collected cuts the sleep short
+  CORE_ENTER_CRITICAL();
+
+  mode = SLEEP_LowestEnergyModeGet();
+  for (int i = 0; i < POWER_CLIENT_COUNT; i++) {
+    if (clients[i].fn == NULL) {
+      continue;
+    }
+
+    req.deepest = sleepEM3;
+    req.deadline_ms = POWER_NO_DEADLINE;
+    clients[i].fn(&req, clients[i].ctx);
+
+    if (req.deepest < mode) {
+      mode = req.deepest;
+      limiter = i;
+    }
+    if (req.deadline_ms < deadline) {
+      deadline = req.deadline_ms;
+      deadlineOwner = i;
+    }
+  }
+
+  if (deadline == 0) {
+    mode = sleepEM0;
+    limiter = deadlineOwner;
+  } else if (deadline < POWER_EM2_MIN_SLEEP_MS && mode > sleepEM1) {
+    mode = sleepEM1;
+    limiter = deadlineOwner;
+  }
+
+  if (limiter < POWER_CLIENT_COUNT) {
+    limitedBy[limiter]++;
+  }
+
+  if (mode == sleepEM0) {
+    CORE_EXIT_CRITICAL();
+    return;
+  }
+
+  // Sleep blocks are counted, so a temporary one caps SLEEP_Sleep() without
+  // disturbing the blocks held by the drivers
+  if (mode < sleepEM3) {
+    SLEEP_SleepBlockBegin((SLEEP_EnergyMode_t)(mode + 1));
+  }
+  SLEEP_Sleep();
+  if (mode < sleepEM3) {
+    SLEEP_SleepBlockEnd((SLEEP_EnergyMode_t)(mode + 1));
+  }
+
+  CORE_EXIT_CRITICAL();
+}
+
+void power_init(void)
+{
+  static const SLEEP_Init_t sleepInit = {
+    .sleepCallback = power_sleep_cb,
+    .wakeupCallback = power_wakeup_cb,
+    .restoreCallback = NULL,
+  };
+
+  // Also called lazily by the BSP tick, repeated calls are harmless
+  RTCDRV_Init();
+  SLEEP_InitEx(&sleepInit);
+  power_stats_reset();
+
+  OS_AppIdleTaskHookPtr = power_idle_hook;
+}
+
+void power_register(power_client_t client, power_req_fn fn, void *ctx)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (client >= POWER_CLIENT_COUNT) {
+    return;
+  }
+
+  CORE_ENTER_CRITICAL();
+  clients[client].fn = fn;
+  clients[client].ctx = ctx;
+  CORE_EXIT_CRITICAL();
+}
+
+void power_stats_get(power_stats_t *stats)
+{
+  uint64_t total;
+  uint64_t asleep = 0;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  total = RTCDRV_GetWallClockTicks64() - statsSince;
+  for (int i = sleepEM1; i < POWER_EM_COUNT; i++) {
+    stats->time_ms[i] = (uint32_t)RTCDRV_TicksToMsec64(sleepTicks[i]);
+    stats->entries[i] = sleepEntries[i];
+    asleep += sleepTicks[i];
+  }
+  memcpy(stats->limited_by, limitedBy, sizeof(limitedBy));
+  CORE_EXIT_CRITICAL();
+
+  stats->time_ms[sleepEM0] = (uint32_t)RTCDRV_TicksToMsec64(total - asleep);
+  stats->entries[sleepEM0] = 0;
+}
+
+void power_stats_reset(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  statsSince = RTCDRV_GetWallClockTicks64();
+  memset(sleepTicks, 0, sizeof(sleepTicks));
+  memset(sleepEntries, 0, sizeof(sleepEntries));
+  memset(limitedBy, 0, sizeof(limitedBy));
+  CORE_EXIT_CRITICAL();
+}
@@ -0,0 +1,81 @@
+/**
+ * @file
+ * @brief power_manager.h
+ * Arbitrates energy mode entry between the LoRa, BLE and display subsystems.
+ *******************************************************************************
+ *
+ * Every subsystem registers a requirement callback. When the kernel has
+ * nothing to run, the idle hook polls all callbacks and enters the deepest
+ * energy mode that is allowed by all of them and by the sleep driver blocks
+ * (see sleep.h), unless a deadline is so close that a deep sleep cycle would
+ * cost more than it saves.
+ *
+ ******************************************************************************/
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "sleep.h"
+
+/* Deadlines closer than this keep the MCU in EM1, the HFXO restart after
+ * EM2/EM3 would eat most of the sleep time */
+#ifndef POWER_EM2_MIN_SLEEP_MS
+#define POWER_EM2_MIN_SLEEP_MS      2
+#endif
+
+/* Requirement without a deadline */
+#define POWER_NO_DEADLINE           UINT32_MAX
+
+/* Number of energy modes the idle hook can end up in, EM0 to EM3 */
+#define POWER_EM_COUNT              4
+
+typedef enum {
+  POWER_CLIENT_EVENTS = 0,   // LoRaWAN event queue
+  POWER_CLIENT_RADIO,        // SX126X transceiver
+  POWER_CLIENT_BLE,          // Bluetooth stack
+  POWER_CLIENT_DISPLAY,      // LS013B7DH03 memory LCD
+  POWER_CLIENT_COUNT
+} power_client_t;
+
+/* Requirement of a client at the time the idle hook runs */
+typedef struct {
+  SLEEP_EnergyMode_t deepest;   // deepest energy mode the client tolerates
+  uint32_t deadline_ms;         // ms until the client needs the CPU, or POWER_NO_DEADLINE
+} power_req_t;
+
+/* Requirement callback
+ *
+ * Called from the idle hook inside a critical section with req preset to
+ * { sleepEM3, POWER_NO_DEADLINE }. Must only tighten the fields it cares
+ * about and must not block. */
+typedef void (*power_req_fn)(power_req_t *req, void *ctx);
+
+/* Time and entries per energy mode, indexed by SLEEP_EnergyMode_t */
+typedef struct {
+  uint32_t time_ms[POWER_EM_COUNT];
+  uint32_t entries[POWER_EM_COUNT];
+  uint32_t limited_by[POWER_CLIENT_COUNT];   // idle entries where the client set the mode
+} power_stats_t;
+
+/* Installs the idle hook and starts the accounting. Call after OSInit(). */
+void power_init(void);
+
+/* Registers or, with a NULL fn, removes the requirement of a client */
+void power_register(power_client_t client, power_req_fn fn, void *ctx);
+
+/* Energy accounting since power_init() or the last power_stats_reset().
+ * Time in EM3 is not measured as the RTCC stops, time_ms[sleepEM3] stays 0
+ * and only entries[sleepEM3] counts. */
+void power_stats_get(power_stats_t *stats);
+void power_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,238 @@
+/**
+ * @file
+ * @brief power_cut.c
+ * Host test of the session journal against power cuts.
+ *******************************************************************************
+ *
+ * Runs session_store.c on the file-backed area of session_flash_host.c and
+ * plays a device that joins, sends uplinks, gets its session parameters
+ * changed by MAC commands and now and then forgets its session to join again.
+ * At random points the power is cut in the middle of the flash writes, the
+ * journal is read back like after a reset and checked against what went on
+ * air:
+ *
+ * - no uplink counter and no DevNonce is used twice,
+ * - the join state is never lost once a join request went out,
+ * - a restored session holds the parameters from before or after the write
+ *   that was cut, and a session that was cleared does not come back.
+ *
+ * See the Makefile in this directory for how to build and run it.
+ *
+ ******************************************************************************/
+
+#ifdef SESSION_FLASH_HOST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <src/session/session_flash.h>
+#include <src/session/session_store.h>
+
+#define TEST_STEPS            200000
+#define TEST_CUT_EVERY        1000      // steps between power cuts, on average
+#define TEST_CUT_BYTES        600       // cut within that many bytes written
+
+#define TEST_JOIN_ACCEPT      4         // 1 in that many join requests answered
+#define TEST_CLEAR_EVERY      2000      // uplinks between forced joins
+#define TEST_MAC_EVERY        300       // uplinks between parameter changes
+
+/* Session parameters, with an odd length so the record is padded */
+typedef struct {
+  uint32_t devAddr;
+  uint8_t keys[250];
+} test_session_t;
+
+#define TEST_SESSION_LEN      (sizeof(uint32_t) + 250)
+
+typedef struct {
+  uint8_t accepted;
+  uint8_t channel;
+  int8_t datarate;
+} test_join_t;
+
+/* What the store must give back, before and after the write in progress */
+typedef struct {
+  bool stored;                      // a session is in the store
+  test_session_t session;
+} test_state_t;
+
+static test_state_t state;
+static test_state_t pending;        // once the write in progress is done
+static bool joined;
+static uint32_t ulCounter;          // of the next uplink
+static uint32_t dlCounter;
+static test_join_t join;
+static uint16_t devNonce;           // of the next join request
+static bool nonceUsed;
+static uint16_t nonceLast;          // of the last join request sent
+
+static uint32_t failures;
+
+static uint32_t writeErrors(void)
+{
+  session_store_stats_t stats;
+
+  session_store_stats_get(&stats);
+  return stats.errors;
+}
+
+static void fail(const char *what, uint32_t found, uint32_t expected)
+{
+  printf("FAILED: %s, %lu instead of %lu\n", what,
+         (unsigned long)found, (unsigned long)expected);
+  failures++;
+}
+
+/* Sends a join request, false if the power was cut */
+static bool joinStep(void)
+{
+  uint32_t errors = writeErrors();
+
+  session_store_join_update(&join, sizeof(join), devNonce);
+  if (writeErrors() != errors) {
+    return false;
+  }
+  nonceUsed = true;
+  nonceLast = devNonce++;
+
+  if (rand() % TEST_JOIN_ACCEPT == 0) {
+    join.accepted = 1;
+    join.channel = rand() % 8;
+    join.datarate = rand() % 6;
+    session_store_join_update(&join, sizeof(join), devNonce);
+    if (writeErrors() != errors) {
+      return false;
+    }
+    joined = true;
+    pending.session.devAddr++;
+    pending.session.keys[rand() % sizeof(pending.session.keys)]++;
+    ulCounter = 0;
+    dlCounter = 0;
+  }
+
+  return true;
+}
+
+/* Sends an uplink, false if the power was cut */
+static bool uplinkStep(void)
+{
+  uint32_t errors = writeErrors();
+
+  if (rand() % TEST_CLEAR_EVERY == 0) {
+    pending.stored = false;
+    session_store_clear();
+    if (writeErrors() != errors) {
+      return false;
+    }
+    state = pending;
+    joined = false;
+    return true;
+  }
+
+  if (rand() % TEST_MAC_EVERY == 0) {
+    pending.session.keys[rand() % sizeof(pending.session.keys)]++;
+  }
+  if (rand() % 10 == 0) {
+    dlCounter += rand() % 3;
+  }
+
+  pending.stored = true;
+  session_store_update(&pending.session, TEST_SESSION_LEN, ulCounter, dlCounter);
+  if (writeErrors() != errors) {
+    return false;
+  }
+  state = pending;
+  ulCounter++;
+
+  return true;
+}
+
+static bool step(void)
+{
+  return joined ? uplinkStep() : joinStep();
+}
+
+/* Reads the journal back like after a reset and checks it */
+static void powerCycle(void)
+{
+  test_session_t session;
+  test_join_t joinLoaded;
+  uint32_t ul;
+  uint32_t dl;
+  uint16_t nonce;
+
+  session_flash_host_cut(-1);
+  session_store_init();
+
+  if (session_store_join_load(&joinLoaded, sizeof(joinLoaded), &nonce)) {
+    if (nonceUsed && (uint16_t)(nonce - nonceLast - 1) >= 0x8000) {
+      fail("DevNonce reused", nonce, nonceLast + 1);
+    }
+    join = joinLoaded;
+    devNonce = nonce;
+  } else if (nonceUsed) {
+    fail("join state lost, DevNonce", 0, nonceLast + 1);
+  }
+
+  memset(&session, 0, sizeof(session));
+  if (session_store_load(&session, TEST_SESSION_LEN, &ul, &dl)) {
+    if (!state.stored && !pending.stored) {
+      fail("cleared session restored, device address", session.devAddr, 0);
+    } else if (memcmp(&session, &state.session, TEST_SESSION_LEN) != 0
+               && memcmp(&session, &pending.session, TEST_SESSION_LEN) != 0) {
+      fail("session parameters differ, device address", session.devAddr,
+           pending.session.devAddr);
+    } else if (state.stored && ul < ulCounter) {
+      fail("uplink counter reused", ul, ulCounter);
+    }
+    joined = true;
+    ulCounter = ul;
+    dlCounter = dl;
+    state.stored = true;
+    state.session = session;
+  } else {
+    if (state.stored && pending.stored) {
+      fail("session lost, device address", 0, state.session.devAddr);
+    }
+    joined = false;
+    state.stored = false;
+  }
+  pending = state;
+}
+
+int main(int argc, char **argv)
+{
+  session_store_stats_t stats;
+  uint32_t cuts = 0;
+  uint32_t i;
+
+  srand(argc > 1 ? atoi(argv[1]) : 1);
+  remove(SESSION_FLASH_FILE);
+  devNonce = rand();
+  session_store_init();
+
+  for (i = 0; i < TEST_STEPS; i++) {
+    if (rand() % TEST_CUT_EVERY == 0) {
+      session_flash_host_cut(rand() % TEST_CUT_BYTES);
+      while (step()) {
+      }
+      powerCycle();
+      cuts++;
+    } else if (!step()) {
+      fail("flash write failed without a power cut", writeErrors(), 0);
+      break;
+    }
+  }
+
+  session_store_stats_get(&stats);
+  printf("%lu steps, %lu power cuts: %lu session, %lu counter and %lu join "
+         "records, %lu erases, %lu write errors\n",
+         (unsigned long)i, (unsigned long)cuts, (unsigned long)stats.sessions,
+         (unsigned long)stats.counters, (unsigned long)stats.joins,
+         (unsigned long)stats.erases, (unsigned long)stats.errors);
+  remove(SESSION_FLASH_FILE);
+
+  return failures != 0;
+}
+
+#endif /* SESSION_FLASH_HOST */
@@ -0,0 +1,63 @@
+/**
+ * @file
+ * @brief session_flash.h
+ * Flash area of the LoRaWAN session journal.
+ *******************************************************************************
+ *
+ * SESSION_FLASH_PAGES erasable pages reserved by the linker script right
+ * below the NVM of the Bluetooth stack (__loraSessionBase). Offsets are
+ * relative to the start of the area. Like the internal flash, a write can only
+ * clear bits and an erase sets a whole page to 0xff.
+ *
+ * With SESSION_FLASH_HOST defined the area is kept in a file instead, so the
+ * journal can run on a Linux host. The file (SESSION_FLASH_FILE) survives the
+ * process like the flash survives a reset.
+ *
+ ******************************************************************************/
+
+#ifndef SESSION_FLASH_H
+#define SESSION_FLASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef SESSION_FLASH_HOST
+#define SESSION_FLASH_PAGE_SIZE     2048
+#else
+#include "em_device.h"
+#define SESSION_FLASH_PAGE_SIZE     FLASH_PAGE_SIZE
+#endif
+
+/* Pages of the area, at least 2 */
+#ifndef SESSION_FLASH_PAGES
+#define SESSION_FLASH_PAGES         2
+#endif
+
+#define SESSION_FLASH_SIZE          (SESSION_FLASH_PAGES * SESSION_FLASH_PAGE_SIZE)
+
+#ifdef SESSION_FLASH_HOST
+#ifndef SESSION_FLASH_FILE
+#define SESSION_FLASH_FILE          "session_flash.bin"
+#endif
+#endif
+
+bool session_flash_erase(uint32_t page);
+
+/* offset and len must be multiples of 4 */
+bool session_flash_write(uint32_t offset, const void *data, uint32_t len);
+void session_flash_read(uint32_t offset, void *data, uint32_t len);
+
+#ifdef SESSION_FLASH_HOST
+/* Simulates a power cut: writes stop after that many more bytes, -1 never */
+void session_flash_host_cut(int32_t bytes);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
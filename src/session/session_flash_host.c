@@ -0,0 +1,99 @@
+/**
+ * @file
+ * @brief session_flash_host.c
+ * File-backed stand-in for the session journal area on a Linux host.
+ *******************************************************************************
+ *
+ * Built instead of session_flash_msc.c when SESSION_FLASH_HOST is defined.
+ * The area is mirrored in RAM and written back to SESSION_FLASH_FILE after
+ * every erase and write, writes clear bits only as they do in flash.
+ *
+ ******************************************************************************/
+
+#ifdef SESSION_FLASH_HOST
+
+#include <stdio.h>
+#include <string.h>
+#include <src/session/session_flash.h>
+
+static uint8_t area[SESSION_FLASH_SIZE];
+static bool loaded;
+static int32_t cutAfter = -1;
+
+static void area_load(void)
+{
+  FILE *file;
+  size_t len = 0;
+
+  if (loaded) {
+    return;
+  }
+
+  file = fopen(SESSION_FLASH_FILE, "rb");
+  if (file != NULL) {
+    len = fread(area, 1, sizeof(area), file);
+    fclose(file);
+  }
+  memset(&area[len], 0xff, sizeof(area) - len);
+  loaded = true;
+}
+
+static bool area_save(void)
+{
+  FILE *file = fopen(SESSION_FLASH_FILE, "wb");
+  bool ok;
+
+  if (file == NULL) {
+    return false;
+  }
+  ok = fwrite(area, 1, sizeof(area), file) == sizeof(area);
+  return (fclose(file) == 0) && ok;
+}
+
+bool session_flash_erase(uint32_t page)
+{
+  if (page >= SESSION_FLASH_PAGES || cutAfter == 0) {
+    return false;
+  }
+
+  area_load();
+  memset(&area[page * SESSION_FLASH_PAGE_SIZE], 0xff, SESSION_FLASH_PAGE_SIZE);
+  return area_save();
+}
+
+bool session_flash_write(uint32_t offset, const void *data, uint32_t len)
+{
+  const uint8_t *src = data;
+  bool ok = true;
+
+  if (offset + len > SESSION_FLASH_SIZE || ((offset | len) & 0x3) != 0) {
+    return false;
+  }
+
+  area_load();
+  for (uint32_t i = 0; i < len; i++) {
+    if (cutAfter == 0) {
+      ok = false;
+      break;
+    }
+    if (cutAfter > 0) {
+      cutAfter--;
+    }
+    area[offset + i] &= src[i];
+  }
+
+  return area_save() && ok;
+}
+
+void session_flash_read(uint32_t offset, void *data, uint32_t len)
+{
+  area_load();
+  memcpy(data, &area[offset], len);
+}
+
+void session_flash_host_cut(int32_t bytes)
+{
+  cutAfter = bytes;
+}
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file
+ * @brief session_flash_msc.c
+ * Session journal area in the internal flash, written through the MSC.
+ ******************************************************************************/
+
+#ifndef SESSION_FLASH_HOST
+
+#include <string.h>
+#include "em_device.h"
+#include "em_msc.h"
+#include <src/session/session_flash.h>
+
+/* Only sizes the .lorasession output section, which is not loaded. The area
+ * itself starts at __loraSessionBase, see the linker script. */
+static const uint8_t sessionArea[SESSION_FLASH_SIZE]
+__attribute__((section(".lorasession"), used));
+
+extern uint32_t __loraSessionBase;
+
+#define AREA_BASE             ((uint8_t *)&__loraSessionBase)
+
+bool session_flash_erase(uint32_t page)
+{
+  MSC_Status_TypeDef status;
+
+  if (page >= SESSION_FLASH_PAGES) {
+    return false;
+  }
+
+  MSC_Init();
+  status = MSC_ErasePage((uint32_t *)(AREA_BASE + page * SESSION_FLASH_PAGE_SIZE));
+  MSC_Deinit();
+
+  return status == mscReturnOk;
+}
+
+bool session_flash_write(uint32_t offset, const void *data, uint32_t len)
+{
+  MSC_Status_TypeDef status;
+
+  if (offset + len > SESSION_FLASH_SIZE || ((offset | len) & 0x3) != 0) {
+    return false;
+  }
+
+  MSC_Init();
+  status = MSC_WriteWord((uint32_t *)(AREA_BASE + offset), data, len);
+  MSC_Deinit();
+
+  return status == mscReturnOk;
+}
+
+void session_flash_read(uint32_t offset, void *data, uint32_t len)
+{
+  memcpy(data, AREA_BASE + offset, len);
+}
+
+#endif
@@ -0,0 +1,450 @@
+/**
+ * @file
+ * @brief session_store.c
+ * Wear-levelled journal of the LoRaWAN session in the internal flash.
+ *******************************************************************************
+ *
+ * Page:    sequence (4) | PAGE_MAGIC (4) | records
+ * Record:  header (4) | uplink counter or DevNonce reservation (4)
+ *          | downlink counter (4) | parameters, session and join records only,
+ *          padded to 4 | CRC (4)
+ * Header:  RECORD_MAGIC (8) | type (8) | payload length (16)
+ *
+ * A new page starts with a copy of the last session and join records and the
+ * counters, PAGE_MAGIC is written only after them. A valid page thus always
+ * holds the whole state and on boot only the valid page with the highest
+ * sequence number is replayed and written to.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+#include <src/session/session_flash.h>
+#include <src/session/session_store.h>
+
+#define PAGE_MAGIC            0x4c53534aUL
+#define PAGE_HEADER_SIZE      8
+
+#define RECORD_MAGIC          0xa5
+#define RECORD_SESSION        1
+#define RECORD_COUNTERS       2
+#define RECORD_JOIN           3
+#define RECORD_OVERHEAD       8    // header and CRC
+#define COUNTERS_SIZE         8
+
+#define PAD4(len)             (((len) + 3) & ~3UL)
+
+static bool mounted;
+static bool rotate;                 // next record goes to a fresh page
+static uint32_t page;               // page written to
+static uint32_t sequence;
+static uint32_t writeOffset;        // in the area
+
+static bool haveSession;
+static uint32_t sessionOffset;      // of the parameters of the last session record
+static uint16_t sessionLen;
+static uint32_t sessionCrc;         // of the parameters alone
+static uint32_t ulReserved;
+static uint32_t dlStored;
+
+static bool haveJoin;
+static uint32_t joinOffset;         // of the parameters of the last join record
+static uint16_t joinLen;
+static uint32_t joinCrc;
+static uint16_t nonceReserved;
+
+static session_store_stats_t stats;
+
+/* CRC-32 (IEEE 802.3), a nibble at a time */
+static uint32_t crc32(uint32_t crc, const void *data, uint32_t len)
+{
+  static const uint32_t table[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+    0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+  };
+  const uint8_t *p = data;
+
+  crc = ~crc;
+  while (len--) {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ table[crc & 0xf];
+    crc = (crc >> 4) ^ table[crc & 0xf];
+  }
+  return ~crc;
+}
+
+/* Replays the records of page p, returns the offset after the last valid one
+ * and sets *damaged if the page does not end with erased flash there */
+static uint32_t page_replay(uint32_t p, bool *damaged)
+{
+  uint32_t off = p * SESSION_FLASH_PAGE_SIZE + PAGE_HEADER_SIZE;
+  uint32_t end = (p + 1) * SESSION_FLASH_PAGE_SIZE;
+
+  *damaged = false;
+
+  for (;;) {
+    uint8_t buf[32];
+    uint32_t hdr;
+    uint32_t counters[2];
+    uint32_t len;
+    uint32_t type;
+    uint32_t crc;
+    uint32_t paramsCrc = 0;
+    uint32_t stored;
+
+    if (off == end) {
+      return off;
+    }
+
+    session_flash_read(off, &hdr, sizeof(hdr));
+    if (hdr == 0xffffffffUL) {
+      return off;
+    }
+
+    type = (hdr >> 16) & 0xff;
+    len = hdr & 0xffff;
+    if ((hdr >> 24) != RECORD_MAGIC
+        || (type == RECORD_COUNTERS && len != COUNTERS_SIZE)
+        || (type != RECORD_COUNTERS && len <= COUNTERS_SIZE)
+        || (type != RECORD_COUNTERS && type != RECORD_SESSION && type != RECORD_JOIN)
+        || off + RECORD_OVERHEAD + PAD4(len) > end) {
+      break;
+    }
+
+    session_flash_read(off + 4, counters, sizeof(counters));
+    crc = crc32(0, &hdr, sizeof(hdr));
+    crc = crc32(crc, counters, sizeof(counters));
+    for (uint32_t i = COUNTERS_SIZE; i < PAD4(len); i += sizeof(buf)) {
+      uint32_t n = PAD4(len) - i < sizeof(buf) ? PAD4(len) - i : sizeof(buf);
+
+      session_flash_read(off + 4 + i, buf, n);
+      crc = crc32(crc, buf, n);
+      paramsCrc = crc32(paramsCrc, buf, (i + n > len) ? len - i : n);
+    }
+
+    session_flash_read(off + 4 + PAD4(len), &stored, sizeof(stored));
+    if (stored != crc) {
+      break;
+    }
+
+    if (type == RECORD_JOIN) {
+      haveJoin = true;
+      joinOffset = off + 4 + COUNTERS_SIZE;
+      joinLen = len - COUNTERS_SIZE;
+      joinCrc = paramsCrc;
+      nonceReserved = (uint16_t)counters[0];
+    } else {
+      if (type == RECORD_SESSION) {
+        haveSession = true;
+        sessionOffset = off + 4 + COUNTERS_SIZE;
+        sessionLen = len - COUNTERS_SIZE;
+        sessionCrc = paramsCrc;
+      }
+      if (haveSession) {
+        ulReserved = counters[0];
+        dlStored = counters[1];
+      }
+    }
+
+    off += RECORD_OVERHEAD + PAD4(len);
+  }
+
+  *damaged = true;
+  stats.errors++;
+  return off;
+}
+
+/* Appends a record, the CRC goes last so a torn record never looks valid */
+static bool record_write(uint8_t type, uint32_t ul, uint32_t dl, const void *params, uint16_t len)
+{
+  uint32_t payload = COUNTERS_SIZE + len;
+  uint32_t words[3] = { ((uint32_t)RECORD_MAGIC << 24) | ((uint32_t)type << 16) | payload, ul, dl };
+  uint32_t whole = len & ~3UL;
+  uint32_t tail = 0;
+  uint32_t off = writeOffset;
+  uint32_t crc;
+
+  crc = crc32(0, words, sizeof(words));
+  if (!session_flash_write(off, words, sizeof(words))) {
+    return false;
+  }
+  off += sizeof(words);
+
+  if (whole != 0) {
+    crc = crc32(crc, params, whole);
+    if (!session_flash_write(off, params, whole)) {
+      return false;
+    }
+    off += whole;
+  }
+
+  if (len != whole) {
+    memcpy(&tail, (const uint8_t *)params + whole, len - whole);
+    crc = crc32(crc, &tail, sizeof(tail));
+    if (!session_flash_write(off, &tail, sizeof(tail))) {
+      return false;
+    }
+    off += sizeof(tail);
+  }
+
+  if (!session_flash_write(off, &crc, sizeof(crc))) {
+    return false;
+  }
+
+  writeOffset = off + sizeof(crc);
+  return true;
+}
+
+/* Copies a record of the current page to the end of the new one */
+static bool record_copy(uint32_t from, uint32_t size)
+{
+  uint32_t buf[8];
+
+  for (uint32_t i = 0; i < size; i += sizeof(buf)) {
+    uint32_t n = size - i < sizeof(buf) ? size - i : sizeof(buf);
+
+    session_flash_read(from + i, buf, n);
+    if (!session_flash_write(writeOffset + i, buf, n)) {
+      return false;
+    }
+  }
+
+  writeOffset += size;
+  return true;
+}
+
+/* Bytes a new page starts with */
+static uint32_t carried_size(void)
+{
+  uint32_t size = PAGE_HEADER_SIZE;
+
+  if (haveSession) {
+    size += RECORD_OVERHEAD + COUNTERS_SIZE + PAD4(sessionLen);
+    size += RECORD_OVERHEAD + COUNTERS_SIZE;
+  }
+  if (haveJoin) {
+    size += RECORD_OVERHEAD + COUNTERS_SIZE + PAD4(joinLen);
+  }
+  return size;
+}
+
+/* Copies the last session, its counters and the last join record to the
+ * start of the page at base and returns where their parameters went */
+static bool page_carry(uint32_t base, uint32_t *newSession, uint32_t *newJoin)
+{
+  writeOffset = base + PAGE_HEADER_SIZE;
+
+  *newSession = writeOffset + 4 + COUNTERS_SIZE;
+
+  if (haveSession) {
+    if (!record_copy(sessionOffset - 4 - COUNTERS_SIZE,
+                     RECORD_OVERHEAD + COUNTERS_SIZE + PAD4(sessionLen))
+        || !record_write(RECORD_COUNTERS, ulReserved, dlStored, NULL, 0)) {
+      return false;
+    }
+  }
+
+  *newJoin = writeOffset + 4 + COUNTERS_SIZE;
+  if (haveJoin) {
+    if (!record_copy(joinOffset - 4 - COUNTERS_SIZE,
+                     RECORD_OVERHEAD + COUNTERS_SIZE + PAD4(joinLen))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Erases the next page and carries the state over to it. The current page
+ * stays the valid one until the new page gets its PAGE_MAGIC. */
+static bool page_next(void)
+{
+  uint32_t next = (page + 1) % SESSION_FLASH_PAGES;
+  uint32_t header[2] = { sequence + 1, PAGE_MAGIC };
+  uint32_t base = next * SESSION_FLASH_PAGE_SIZE;
+  uint32_t newSession;
+  uint32_t newJoin;
+
+  stats.erases++;
+  if (!session_flash_erase(next)) {
+    stats.errors++;
+    return false;
+  }
+
+  if (!session_flash_write(base, &header[0], 4)
+      || !page_carry(base, &newSession, &newJoin)
+      || !session_flash_write(base + 4, &header[1], 4)) {
+    stats.errors++;
+    return false;
+  }
+
+  sessionOffset = newSession;
+  joinOffset = newJoin;
+  page = next;
+  sequence++;
+  rotate = false;
+  return true;
+}
+
+/* Appends a record, on a new page if the current one is full */
+static void journal_append(uint8_t type, const void *params, uint16_t len, uint32_t ul, uint32_t dl)
+{
+  uint32_t size = RECORD_OVERHEAD + COUNTERS_SIZE + PAD4(len);
+  uint32_t end = (page + 1) * SESSION_FLASH_PAGE_SIZE;
+
+  if (carried_size() + size > SESSION_FLASH_PAGE_SIZE) {
+    stats.errors++;
+    return;
+  }
+
+  if (rotate || writeOffset + size > end) {
+    if (!page_next()) {
+      rotate = true;
+      return;
+    }
+  }
+
+  if (!record_write(type, ul, dl, params, len)) {
+    stats.errors++;
+    rotate = true;
+    return;
+  }
+
+  if (type == RECORD_JOIN) {
+    haveJoin = true;
+    joinOffset = writeOffset - sizeof(uint32_t) - PAD4(len);
+    joinLen = len;
+    joinCrc = crc32(0, params, len);
+    nonceReserved = (uint16_t)ul;
+    stats.joins++;
+    return;
+  }
+
+  if (type == RECORD_SESSION) {
+    haveSession = true;
+    sessionOffset = writeOffset - sizeof(uint32_t) - PAD4(len);
+    sessionLen = len;
+    sessionCrc = crc32(0, params, len);
+    stats.sessions++;
+  } else {
+    stats.counters++;
+  }
+  ulReserved = ul;
+  dlStored = dl;
+}
+
+void session_store_init(void)
+{
+  bool found = false;
+
+  haveSession = false;
+  haveJoin = false;
+  rotate = true;
+  page = SESSION_FLASH_PAGES - 1;
+  sequence = 0;
+
+  // The newest valid page holds the whole state
+  for (uint32_t p = 0; p < SESSION_FLASH_PAGES; p++) {
+    uint32_t header[2];
+
+    session_flash_read(p * SESSION_FLASH_PAGE_SIZE, header, sizeof(header));
+    if (header[1] == PAGE_MAGIC && header[0] != 0xffffffffUL
+        && (!found || header[0] > sequence)) {
+      found = true;
+      page = p;
+      sequence = header[0];
+    }
+  }
+
+  if (found) {
+    bool damaged;
+
+    writeOffset = page_replay(page, &damaged);
+    rotate = damaged;
+  }
+
+  mounted = true;
+}
+
+bool session_store_load(void *params, uint16_t len, uint32_t *ulCounter, uint32_t *dlCounter)
+{
+  if (!mounted || !haveSession || sessionLen != len) {
+    return false;
+  }
+
+  session_flash_read(sessionOffset, params, len);
+  if (crc32(0, params, len) != sessionCrc) {
+    return false;
+  }
+
+  *ulCounter = ulReserved;
+  *dlCounter = dlStored;
+  return true;
+}
+
+void session_store_update(const void *params, uint16_t len, uint32_t ulCounter, uint32_t dlCounter)
+{
+  if (!mounted) {
+    return;
+  }
+
+  if (!haveSession || sessionLen != len || crc32(0, params, len) != sessionCrc) {
+    journal_append(RECORD_SESSION, params, len, ulCounter + SESSION_STORE_FCNT_STEP, dlCounter);
+  } else if (ulCounter >= ulReserved) {
+    journal_append(RECORD_COUNTERS, NULL, 0, ulCounter + SESSION_STORE_FCNT_STEP, dlCounter);
+  } else if (dlCounter - dlStored >= SESSION_STORE_FCNT_STEP) {
+    journal_append(RECORD_COUNTERS, NULL, 0, ulReserved, dlCounter);
+  }
+}
+
+bool session_store_join_load(void *params, uint16_t len, uint16_t *devNonce)
+{
+  if (!mounted || !haveJoin || joinLen != len) {
+    return false;
+  }
+
+  session_flash_read(joinOffset, params, len);
+  if (crc32(0, params, len) != joinCrc) {
+    return false;
+  }
+
+  *devNonce = nonceReserved;
+  return true;
+}
+
+void session_store_join_update(const void *params, uint16_t len, uint16_t devNonce)
+{
+  // DevNonce values wrap around, reached means less than half a cycle past
+  bool reached = haveJoin && (uint16_t)(devNonce - nonceReserved) < 0x8000;
+
+  if (!mounted) {
+    return;
+  }
+
+  if (!haveJoin || reached) {
+    journal_append(RECORD_JOIN, params, len, (uint16_t)(devNonce + SESSION_STORE_NONCE_STEP), 0);
+  } else if (joinLen != len || crc32(0, params, len) != joinCrc) {
+    journal_append(RECORD_JOIN, params, len, nonceReserved, 0);
+  }
+}
+
+void session_store_clear(void)
+{
+  if (!mounted) {
+    return;
+  }
+
+  // A page without the session, the join state goes along
+  haveSession = false;
+  if (!page_next()) {
+    rotate = true;
+  }
+}
+
+void session_store_stats_get(session_store_stats_t *out)
+{
+  *out = stats;
+  out->used = rotate ? 0 : (uint16_t)(writeOffset - page * SESSION_FLASH_PAGE_SIZE);
+  out->pageSize = SESSION_FLASH_PAGE_SIZE;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file
+ * @brief session_store.h
+ * Keeps the joined LoRaWAN session across resets.
+ *******************************************************************************
+ *
+ * Without it every reset costs a new OTAA join: up to lora.nb-trials join
+ * requests with the join duty cycle backoff in between. The session
+ * parameters (device address, session keys and what the network server set
+ * up by MAC commands) and the frame counters are journaled to the internal
+ * flash instead, and the session is restored on boot.
+ *
+ * The journal is appended to a page at a time, each page starting with a
+ * full session record followed by frame counter records. A record is written
+ * only when the session parameters change or a frame counter runs into its
+ * reservation: the uplink counter is stored SESSION_STORE_FCNT_STEP ahead of
+ * the counter in use and a restored session continues from there, so no
+ * counter value is ever sent twice and the flash sees one small record every
+ * SESSION_STORE_FCNT_STEP uplinks. When a page is full the next one is
+ * erased, pages are used in turn to spread the wear.
+ *
+ * The join state is kept the same way and outlives the session: where the
+ * last join-accept came from, and the DevNonce reserved
+ * SESSION_STORE_NONCE_STEP join requests ahead, so that a join after a reset
+ * never repeats a DevNonce the network server has seen.
+ *
+ * Every record carries a CRC, a record torn by a reset is ignored together
+ * with everything after it and the journal continues on the next page.
+ *
+ ******************************************************************************/
+
+#ifndef SESSION_STORE_H
+#define SESSION_STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Frame counter values reserved per counter record. A restored session skips
+ * up to this many uplink counter values, far below the maximum frame counter
+ * gap of the network server. */
+#ifndef SESSION_STORE_FCNT_STEP
+#define SESSION_STORE_FCNT_STEP     32
+#endif
+
+/* DevNonce values reserved per join record */
+#ifndef SESSION_STORE_NONCE_STEP
+#define SESSION_STORE_NONCE_STEP    8
+#endif
+
+typedef struct {
+  uint32_t sessions;         // session records written
+  uint32_t counters;         // frame counter records written
+  uint32_t joins;            // join records written
+  uint32_t erases;           // pages erased
+  uint32_t errors;           // failed flash writes and damaged records found
+  uint16_t used;             // bytes used in the current page
+  uint16_t pageSize;         // bytes per page
+} session_store_stats_t;
+
+/* Reads the journal, call once before the other functions */
+void session_store_init(void);
+
+/* Copies the stored session parameters into params and returns the frame
+ * counters to continue from, false if there is no session of length len */
+bool session_store_load(void *params, uint16_t len, uint32_t *ulCounter, uint32_t *dlCounter);
+
+/* Reports the current session, writes to flash only when needed */
+void session_store_update(const void *params, uint16_t len, uint32_t ulCounter, uint32_t dlCounter);
+
+/* Copies the stored join parameters into params and returns the DevNonce to
+ * continue from, false if there are none of length len */
+bool session_store_join_load(void *params, uint16_t len, uint16_t *devNonce);
+
+/* Reports the join state, writes to flash only when needed */
+void session_store_join_update(const void *params, uint16_t len, uint16_t devNonce);
+
+/* Forgets the session, e.g. to force a new join, the join state is kept */
+void session_store_clear(void);
+
+void session_store_stats_get(session_store_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+Decode event queue traces recorded with MBED_CONF_EVENTS_TRACE_ENABLED.
+
+Two input formats are accepted:
+
+  * the text dump printed over SWO by equeue_trace_dump()
+    ("EQTRACE 2 <ts_freq> <cycle_freq> <count> <total>" followed by
+    "EQT ..." lines)
+  * a raw RAM dump of the equeue_trace_buffer symbol, e.g. saved with
+    J-Link "savebin trace.bin <addr> <size>"; the dump is scanned for the
+    "EQTR" magic so it may also be a larger RAM image
+
+Post and dispatch times are wall clock ticks at ts_freq, which keep
+counting while the device sleeps, execution times are CPU ticks at
+cycle_freq. Prints per-callback execution time and queue latency
+percentiles in microseconds. With --elf the callback addresses are resolved to symbol
+names using arm-none-eabi-nm.
+"""
+
+import argparse
+import struct
+import subprocess
+import sys
+from collections import defaultdict
+
+MAGIC = 0x52545145
+HEADER = struct.Struct('<IIIII')
+RECORD = struct.Struct('<IIIII')
+
+
+def parse_text(data):
+    freqs = (None, None)
+    records = []
+    for line in data.decode('ascii', 'replace').splitlines():
+        fields = line.split()
+        if len(fields) >= 4 and fields[0] == 'EQTRACE' and fields[1] == '2':
+            freqs = (int(fields[2]), int(fields[3]))
+        elif len(fields) == 6 and fields[0] == 'EQT':
+            records.append((int(fields[1], 16),) + tuple(int(f) for f in fields[2:]))
+    return freqs, records
+
+
+def parse_binary(data):
+    offset = data.find(struct.pack('<I', MAGIC))
+    if offset < 0:
+        return (None, None), []
+
+    _, ts_freq, cycle_freq, capacity, head = HEADER.unpack_from(data, offset)
+    base = offset + HEADER.size
+    count = min(head, capacity)
+    records = []
+    for i in range(count):
+        slot = (head - count + i) % capacity
+        records.append(RECORD.unpack_from(data, base + slot * RECORD.size))
+    return (ts_freq or None, cycle_freq or None), records
+
+
+def load_symbols(elf, nm):
+    symbols = {}
+    out = subprocess.run([nm, '-C', elf], stdout=subprocess.PIPE,
+                         universal_newlines=True, check=True).stdout
+    for line in out.splitlines():
+        fields = line.split(None, 2)
+        if len(fields) == 3 and fields[1] in 'tTwW':
+            # thumb function pointers have bit 0 set
+            symbols[int(fields[0], 16) & ~1] = fields[2]
+    return symbols
+
+
+def percentile(values, p):
+    index = min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))
+    return values[index]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('trace', help='SWO text capture or raw RAM dump')
+    parser.add_argument('--ts-freq', type=int,
+                        help='wall clock frequency in Hz if not in the trace')
+    parser.add_argument('--cycle-freq', type=int,
+                        help='CPU timestamp frequency in Hz if not in the trace')
+    parser.add_argument('--elf', help='firmware image used to name callbacks')
+    parser.add_argument('--nm', default='arm-none-eabi-nm')
+    args = parser.parse_args()
+
+    with open(args.trace, 'rb') as f:
+        data = f.read()
+
+    (ts_freq, cycle_freq), records = parse_text(data)
+    if not records:
+        (ts_freq, cycle_freq), records = parse_binary(data)
+    ts_freq = args.ts_freq or ts_freq
+    cycle_freq = args.cycle_freq or cycle_freq
+    if not records:
+        sys.exit('no trace records found')
+    if not ts_freq or not cycle_freq:
+        sys.exit('timestamp frequency unknown, pass --ts-freq and --cycle-freq')
+
+    symbols = load_symbols(args.elf, args.nm) if args.elf else {}
+    ts_to_us = 1e6 / ts_freq
+    cycles_to_us = 1e6 / cycle_freq
+
+    durations = defaultdict(list)
+    latencies = defaultdict(list)
+    for cb, post_ts, delay_ms, dispatch_ts, duration in records:
+        wait = ((dispatch_ts - post_ts) & 0xffffffff) * ts_to_us - delay_ms * 1000
+        durations[cb].append(duration * cycles_to_us)
+        latencies[cb].append(max(0.0, wait))
+
+    print('%-40s %6s  %28s  %28s' % ('callback', 'count',
+                                     'exec us p50/p95/p99/max',
+                                     'latency us p50/p95/p99/max'))
+    for cb in sorted(durations, key=lambda c: -max(durations[c])):
+        name = symbols.get(cb & ~1, '0x%08x' % cb)
+        row = []
+        for values in (sorted(durations[cb]), sorted(latencies[cb])):
+            row.append('%6.0f/%6.0f/%6.0f/%6.0f' % (
+                percentile(values, 50), percentile(values, 95),
+                percentile(values, 99), values[-1]))
+        print('%-40s %6d  %28s  %28s' % (name[:40], len(durations[cb]), row[0], row[1]))
+
+
+if __name__ == '__main__':
+    main()